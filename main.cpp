@@ -48,6 +48,15 @@ int main(int argc, char *argv[])
 {
     int appResult = 0;
 
+    if (argc > 1) {
+        const std::string command = argv[1];
+        if (command == "--cook" || command == "--cook-textures" || command == "--cook-meshes") {
+            const bool textures = command != "--cook-meshes";
+            const bool meshes = command != "--cook-textures";
+            return engine::Engine::cookResources("../configs/engine.json", textures, meshes) ? 0 : 1;
+        }
+    }
+
 #ifdef ENABLE_EDITOR
     engine::Engine engine;
     engine.setUserComponentsBuilder(std::make_unique<EngineComponentBuilder>());
@@ -8,8 +8,10 @@ uniform sampler2D texture1;
 void main()
 {
    vec4 color = texture(texture1, TexCoords);
+#ifdef ALPHA_TEST
    if (color.a == 0.0) {
       discard;
    }
+#endif
    FragColor = color;
 }
\ No newline at end of file
@@ -1,12 +1,22 @@
 #version 410 core
 
 layout (location = 0) in vec3 aPos;
+// per instance, draws sharing the material are merged, see MultiDrawSubmitter
+layout (location = 3) in mat4 aModel;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 camera_position;
+    vec4 ambient_color;
+    vec4 cluster_scale;
+    uvec4 cluster_size;
+};
+
+// matches the depth pre-pass bit for bit, see Renderer
+invariant gl_Position;
 
 void main()
 {
-   gl_Position = projection * view * model * vec4(aPos, 1.0);
+   gl_Position = projection * view * aModel * vec4(aPos, 1.0);
 }
\ No newline at end of file
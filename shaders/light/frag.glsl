@@ -1,18 +1,75 @@
-#version 330 core
+#version 410 core
+
+in vec3 FragPos;
+in vec3 Normal;
 
 out vec4 color;
-  
-uniform vec3 object_color = vec3(1.0, 1.0, 1.0);
-uniform vec3 light_color = vec3(1.0, 1.0, 1.0);
-uniform vec3 light_position = vec3(1.0, 1.0, 1.0);
-uniform vec3 light_intensity = vec3(1.0, 1.0, 1.0);
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 camera_position;
+    vec4 ambient_color;
+    // xy - clusters per pixel, z - depth slice scale, w - depth slice bias
+    vec4 cluster_scale;
+    // xyz - cluster grid size, w - 1 for logarithmic depth slices
+    uvec4 cluster_size;
+};
+
+layout (std140) uniform ObjectData {
+    vec3 object_color;
+};
+
+struct Light {
+    // xyz - position, w - radius
+    vec4 position_radius;
+    // rgb - color, a - intensity
+    vec4 color_intensity;
+};
+
+// size must match MAX_LIGHTS
+layout (std140) uniform LightData {
+    Light lights[256];
+};
+
+// per cluster: x - offset into light_indices, y - light count
+uniform usamplerBuffer light_clusters;
+uniform usamplerBuffer light_indices;
+
+int clusterIndex()
+{
+    float depth = -(view * vec4(FragPos, 1.0)).z;
+    float slice = cluster_size.w == 1u ? log(max(depth, 1e-4)) * cluster_scale.z + cluster_scale.w
+                                       : depth * cluster_scale.z + cluster_scale.w;
+
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy * cluster_scale.xy), int(slice));
+    cluster = clamp(cluster, ivec3(0), ivec3(cluster_size.xyz) - 1);
+
+    return cluster.x + int(cluster_size.x) * (cluster.y + int(cluster_size.y) * cluster.z);
+}
 
 void main()
 {
-    //color = vec4(light_color * object_color, 1.0f);
-    float ambientStrength = 0.1f;
-    vec3 ambient = ambientStrength * light_color;
+    // meshes without normals are lit from every direction
+    bool has_normal = dot(Normal, Normal) > 0.0;
+    vec3 normal = has_normal ? normalize(Normal) : vec3(0.0);
+
+    vec3 lighting = ambient_color.rgb;
+
+    uvec2 cluster = texelFetch(light_clusters, clusterIndex()).xy;
+    for (uint i = 0u; i < cluster.y; ++i) {
+        Light light = lights[texelFetch(light_indices, int(cluster.x + i)).x];
+
+        vec3 to_light = light.position_radius.xyz - FragPos;
+        float light_distance = length(to_light);
+
+        float attenuation = clamp(1.0 - light_distance / light.position_radius.w, 0.0, 1.0);
+        attenuation *= attenuation;
+
+        float diffuse = has_normal ? max(dot(normal, to_light / max(light_distance, 1e-4)), 0.0) : 1.0;
+
+        lighting += light.color_intensity.rgb * light.color_intensity.a * diffuse * attenuation;
+    }
 
-    vec3 result = ambient * object_color;
-    color = vec4(result, 1.0f);
-}
\ No newline at end of file
+    color = vec4(lighting * object_color, 1.0);
+}
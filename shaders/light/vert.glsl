@@ -1,12 +1,33 @@
 #version 410 core
 
 layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec3 aNormal;
+// per instance, draws sharing the material are merged, see MultiDrawSubmitter
+layout (location = 3) in mat4 aModel;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+out vec3 FragPos;
+out vec3 Normal;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 camera_position;
+    vec4 ambient_color;
+    vec4 cluster_scale;
+    uvec4 cluster_size;
+};
+
+layout (std140) uniform ObjectData {
+    vec3 object_color;
+};
+
+// matches the depth pre-pass bit for bit, see Renderer
+invariant gl_Position;
 
 void main()
 {
-   gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+   FragPos = vec3(aModel * vec4(aPos, 1.0));
+   // transforms and sprites scale non-uniformly, the normals take the inverse transpose
+   Normal = transpose(inverse(mat3(aModel))) * aNormal;
+   gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+}
@@ -254,6 +254,27 @@ ComponentWidget* TreeWidgetBuilder::buildMaterialWidget(const std::shared_ptr<en
     auto shader_layout = createEditorBlockLayout("Shader", shader_data, m_engine_controller);
     layout->addLayout(shader_layout);
 
+    auto blendModeChangeHandler = [material](const std::string& value) {
+        auto blend_mode = engine::blendModeFromString(value);
+        if (blend_mode.has_value()) {
+            material->setBlendMode(blend_mode.value());
+        }
+    };
+
+    auto blendModeUpdater = [material]() {
+        if (!material->isValid()) {
+            return std::string();
+        }
+        return engine::blendModeToString(material->blendMode());
+    };
+
+    std::vector<std::string> blend_mode_values = { "auto", "opaque", "blended" };
+    std::vector<EditorBlockLayoutData> blend_mode_data = {
+        { "blend mode", engine::blendModeToString(material->blendMode()), blendModeChangeHandler, blendModeUpdater, false, true, blend_mode_values },
+    };
+    auto blend_mode_layout = createEditorBlockLayout("Blending", blend_mode_data, m_engine_controller);
+    layout->addLayout(blend_mode_layout);
+
     layout->addStretch();
 
     material_widget->setLayout(layout);
@@ -754,6 +775,22 @@ ComponentWidget* TreeWidgetBuilder::buildRenderScopeWidget(const std::shared_ptr
     auto sprite_layout = createEditorBlockLayout("Sprite", sprite_data, m_engine_controller);
     layout->addLayout(sprite_layout);
 
+    auto occluderChangeHandler = [render_scope, sprite_map](const std::string& value) {
+        render_scope->setIsOccluder(sprite_map.at(value));
+    };
+    auto occluderUpdater = [render_scope]() {
+        if (!render_scope->isValid()) {
+            return std::string();
+        }
+        return render_scope->isOccluder() ? std::string("Yes") : std::string("No");
+    };
+
+    std::vector<EditorBlockLayoutData> occluder_data = {
+        { "occluder", render_scope->isOccluder() ? std::string("Yes") : std::string("No"), occluderChangeHandler, occluderUpdater, false, true, sprite_values }
+    };
+    auto occluder_layout = createEditorBlockLayout("Occluder", occluder_data, m_engine_controller);
+    layout->addLayout(occluder_layout);
+
     auto make_sorted_uniform_names = [render_scope]() {
         std::vector<std::string> names;
         for (const auto& uniform : render_scope->renderData().uniforms) {
@@ -1295,8 +1332,21 @@ ComponentWidget* TreeWidgetBuilder::buildLightSourceWidget(const std::shared_ptr
         }
         return formatFloat(light_source->intensity());
     };
+    auto radiusChangeHandler = [light_source](const std::string& value) {
+        float param = 0.0f;
+        if (parseFloat(value, param)) {
+            light_source->setRadius(param);
+        }
+    };
+    auto radiusUpdater = [light_source]() {
+        if (!light_source->isValid()) {
+            return std::string();
+        }
+        return formatFloat(light_source->radius());
+    };
     std::vector<EditorBlockLayoutData> intensity_data = {
         { "intensity", formatFloat(light_source->intensity()), intensityChangeHandler, intensityUpdater, false, false, {}, true, 0.0f, std::numeric_limits<float>::max() },
+        { "radius", formatFloat(light_source->radius()), radiusChangeHandler, radiusUpdater, false, false, {}, true, 0.0f, std::numeric_limits<float>::max() },
     };
     auto intensity_layout = createEditorBlockLayout("Light source", intensity_data, m_engine_controller);
     layout->addLayout(intensity_layout);
@@ -168,6 +168,8 @@ void SceneNodeTree::onCustomContextMenu(const QPoint& pos)
         m_remove_component_action->setEnabled(false);
         m_paste->setEnabled(m_to_copy_item != nullptr);
         m_rename->setEnabled(true);
+        m_static->setEnabled(true);
+        m_static->setChecked(dynamic_cast<NodeWidget*>(widget)->node()->isStatic());
     }
 
     if (is_component_widget) {
@@ -177,6 +179,8 @@ void SceneNodeTree::onCustomContextMenu(const QPoint& pos)
         m_remove_component_action->setEnabled(true);
         m_paste->setEnabled(false);
         m_rename->setEnabled(false);
+        m_static->setEnabled(false);
+        m_static->setChecked(false);
     }
 
     m_context_menu->popup(m_scene_tree->viewport()->mapToGlobal(pos));
@@ -434,6 +438,17 @@ void SceneNodeTree::onDisable()
     changeActiveWidget(false);
 }
 
+void SceneNodeTree::onToggleStatic()
+{
+    auto widget = m_scene_tree->itemWidget(m_selected_item, 0);
+    NodeWidget* node_widget = dynamic_cast<NodeWidget*>(widget);
+    if (node_widget == nullptr) {
+        return;
+    }
+
+    node_widget->node()->setStatic(m_static->isChecked());
+}
+
 void SceneNodeTree::onSaveScene()
 {
     m_engine->saveScene(m_engine->getActiveSceneId());
@@ -1157,6 +1172,10 @@ void SceneNodeTree::initContextMenu()
     m_disable = m_context_menu->addAction("Disable");
     m_disable->setIcon(QIcon::fromTheme("object-visibility"));
     connect(m_disable, &QAction::triggered, this, &SceneNodeTree::onDisable);
+
+    m_static = m_context_menu->addAction("Static");
+    m_static->setCheckable(true);
+    connect(m_static, &QAction::triggered, this, &SceneNodeTree::onToggleStatic);
 }
 
 void SceneNodeTree::createComponentWidget(QTreeWidgetItem* item, const std::shared_ptr<engine::Component>& component)
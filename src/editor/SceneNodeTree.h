@@ -55,6 +55,7 @@ private slots:
     void onDuplicate();
     void onEnable();
     void onDisable();
+    void onToggleStatic();
 
     void onSaveScene();
     void onSelectScene();
@@ -113,6 +114,7 @@ private:
     QAction* m_duplicate;
     QAction* m_enable;
     QAction* m_disable;
+    QAction* m_static;
 };
 
 }
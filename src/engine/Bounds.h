@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+namespace engine {
+
+struct Aabb {
+    glm::vec3 min{0.0f};
+    glm::vec3 max{0.0f};
+
+    auto center() const -> glm::vec3
+    {
+        return (min + max) * 0.5f;
+    }
+
+    auto extent() const -> glm::vec3
+    {
+        return (max - min) * 0.5f;
+    }
+
+    auto surfaceArea() const -> float
+    {
+        const glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    auto contains(const Aabb& other) const -> bool
+    {
+        return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+    }
+
+    auto overlaps(const Aabb& other) const -> bool
+    {
+        return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+    }
+};
+
+inline auto mergeAabb(const Aabb& a, const Aabb& b) -> Aabb
+{
+    return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+}
+
+// box of the transformed box, using the absolute matrix to project the extent
+inline auto transformAabb(const glm::mat4& model, const Aabb& box) -> Aabb
+{
+    const glm::vec3 center = glm::vec3(model * glm::vec4(box.center(), 1.0f));
+    const glm::vec3 extent = box.extent();
+
+    glm::vec3 world_extent(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+        world_extent += glm::abs(glm::vec3(model[axis])) * extent[axis];
+    }
+
+    return { center - world_extent, center + world_extent };
+}
+
+}
@@ -37,6 +37,7 @@ bool Component::isActive() const
 void Component::setActive(bool active)
 {
     m_is_active = active;
+    markChanged();
     onActiveChange(m_is_active);
 }
 
@@ -87,6 +88,30 @@ void Component::update(uint64_t dt)
 void Component::setValid(bool valid)
 {
     m_is_valid = valid;
+    markChanged();
+}
+
+uint64_t Component::revision() const
+{
+    return m_revision;
+}
+
+void Component::setChangeLog(const std::weak_ptr<ChangeLog>& log, uint32_t key)
+{
+    m_change_log = log;
+    m_change_key = key;
+}
+
+void Component::markChanged()
+{
+    ++m_revision;
+}
+
+void Component::logChange()
+{
+    if (auto log = m_change_log.lock()) {
+        log->push_back(m_change_key);
+    }
 }
 
 void Component::onActiveChange(bool active)
@@ -3,6 +3,7 @@
 #include <memory>
 #include <string>
 #include <optional>
+#include <vector>
 
 namespace engine {
 
@@ -11,6 +12,9 @@ class Node;
 
 class Component {
 public:
+    // keys of components that changed since the reader last drained it, see Scene::updateSpatialIndex
+    using ChangeLog = std::vector<uint32_t>;
+
     explicit Component(uint32_t id, const std::string& name, uint32_t owner_node, uint32_t owner_scene);
     virtual ~Component() = default;
 
@@ -41,6 +45,11 @@ public:
     uint32_t ownerScene() const;
     [[nodiscard]]
     bool isValid() const;
+    // bumped by every change of the component's state, lets derived data be checked without comparing it
+    [[nodiscard]]
+    uint64_t revision() const;
+    // changes reported through logChange() are appended here as the reader's key while the log lives
+    void setChangeLog(const std::weak_ptr<ChangeLog>& log, uint32_t key);
 
     virtual void init() = 0;
 
@@ -58,6 +67,8 @@ public:
 
 protected:
     void setValid(bool valid);
+    void markChanged();
+    void logChange();
 
     virtual void onActiveChange(bool active);
 
@@ -72,6 +83,10 @@ private:
     uint32_t m_owner_scene;
 
     bool m_is_active = true;
+
+    uint64_t m_revision = 0;
+    std::weak_ptr<ChangeLog> m_change_log;
+    uint32_t m_change_key = 0;
 };
 
 }
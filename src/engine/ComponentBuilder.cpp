@@ -31,6 +31,23 @@ auto buildMaterialComponent(const rapidjson::Value& componentData) -> std::optio
     component->setShader(shader_id);
     component->setTexture(texture_id);
 
+    if (componentData.HasMember("blend_mode") && componentData["blend_mode"].IsString()) {
+        auto blend_mode = blendModeFromString(componentData["blend_mode"].GetString());
+        if (blend_mode.has_value()) {
+            component->setBlendMode(blend_mode.value());
+        }
+    }
+
+    if (componentData.HasMember("shader_features") && componentData["shader_features"].IsArray()) {
+        std::vector<std::string> features;
+        for (const auto& feature : componentData["shader_features"].GetArray()) {
+            if (feature.IsString()) {
+                features.emplace_back(feature.GetString());
+            }
+        }
+        component->setShaderFeatures(features);
+    }
+
     return component;
 }
 
@@ -45,6 +62,20 @@ auto saveMaterialComponent(const std::shared_ptr<MaterialComponent>& component,
     component_json.AddMember("owner_scene", component->ownerScene(), allocator);
     component_json.AddMember("shader", component->shaderId(), allocator);
     component_json.AddMember("texture", component->textureId(), allocator);
+
+    rapidjson::Value blend_mode;
+    blend_mode.SetString(blendModeToString(component->blendMode()).c_str(), allocator);
+    component_json.AddMember("blend_mode", blend_mode, allocator);
+
+    if (!component->shaderFeatures().empty()) {
+        rapidjson::Value features(rapidjson::kArrayType);
+        for (const auto& feature : component->shaderFeatures()) {
+            rapidjson::Value feature_value;
+            feature_value.SetString(feature.c_str(), allocator);
+            features.PushBack(feature_value, allocator);
+        }
+        component_json.AddMember("shader_features", features, allocator);
+    }
 }
 
 auto buildMeshComponent(const rapidjson::Value& componentData) -> std::optional<std::unique_ptr<MeshComponent>>
@@ -295,6 +326,9 @@ auto buildRenderScopeComponent(const rapidjson::Value& componentData) -> std::op
         if (render_data_obj.HasMember("is_sprite") && render_data_obj["is_sprite"].IsBool()) {
             render_data.is_sprite = render_data_obj["is_sprite"].GetBool();
         }
+        if (render_data_obj.HasMember("is_occluder") && render_data_obj["is_occluder"].IsBool()) {
+            render_data.is_occluder = render_data_obj["is_occluder"].GetBool();
+        }
         if (render_data_obj.HasMember("uniforms") && render_data_obj["uniforms"].IsObject()) {
             auto render_data_src = render_data_obj["uniforms"].GetObject();
             auto read_vec = [](const rapidjson::Value& value, int size) -> std::optional<std::vector<float>> {
@@ -429,6 +463,7 @@ void saveRenderScopeComponent(const std::shared_ptr<RenderScopeComponent>& compo
 
     rapidjson::Value render_data(rapidjson::kObjectType);
     render_data.AddMember("is_sprite", component->isSprite(), allocator);
+    render_data.AddMember("is_occluder", component->isOccluder(), allocator);
     rapidjson::Value uniforms_json(rapidjson::kObjectType);
     for (const auto& uniform : component->renderData().uniforms) {
         rapidjson::Value uniform_key;
@@ -560,6 +595,9 @@ auto buildLightSourceComponent(const rapidjson::Value& componentData) -> std::op
     auto component = std::make_unique<LightSourceComponent>(id, name, owner_node, owner_scene);
     component->setColor(glm::vec3(componentData["color"].GetArray()[0].GetFloat(), componentData["color"].GetArray()[1].GetFloat(), componentData["color"].GetArray()[2].GetFloat()));
     component->setIntensity(componentData["intensity"].GetFloat());
+    if (componentData.HasMember("radius")) {
+        component->setRadius(componentData["radius"].GetFloat());
+    }
 
     return component;
 }
@@ -579,6 +617,7 @@ void saveLightSourceComponent(const std::shared_ptr<LightSourceComponent>& compo
     color_value.PushBack(component->color().z, allocator);
     component_json.AddMember("color", color_value, allocator);
     component_json.AddMember("intensity", component->intensity(), allocator);
+    component_json.AddMember("radius", component->radius(), allocator);
 }
 
 auto ComponentBuilder::componentTypes() -> const std::vector<std::string>&
@@ -14,6 +14,11 @@ class InputManager;
 class UserComponentsBuilder;
 class EngineAccessor;
 class RenderPassStore;
+class Renderer;
+class GLStateCache;
+class PickingService;
+class ResourceReloader;
+class TextureStreamer;
 
 struct Context {
     std::unique_ptr<MeshStore> meshStore;
@@ -26,6 +31,13 @@ struct Context {
     std::unique_ptr<UserComponentsBuilder> userComponentsBuilder;
     std::unique_ptr<EngineAccessor> engineAccessor;
     std::unique_ptr<RenderPassStore> renderPassStore;
+    std::unique_ptr<GLStateCache> glState;
+    std::unique_ptr<Renderer> renderer;
+    std::unique_ptr<PickingService> picking;
+    // null unless "hot_reload" is set in engine.json
+    std::unique_ptr<ResourceReloader> resourceReloader;
+    // null unless "texture_streaming" is set in engine.json, textures then load synchronously
+    std::unique_ptr<TextureStreamer> textureStreamer;
 };
 
 }
@@ -3,19 +3,27 @@
 #include "Component.h"
 #include "Context.h"
 #include "FileSystem.h"
+#include "GLStateCache.h"
 #include "InputManager.h"
 #include "Logger.h"
+#include "MeshCooker.h"
 #include "MeshStore.h"
 #include "Node.h"
+#include "PickingService.h"
 #include "Renderer.h"
 #include "ResourcePackage.h"
 #include "ResourcePackageStore.h"
+#include "ResourceReloader.h"
 #include "Scene.h"
 #include "SceneStore.h"
 #include "SceneTransition.h"
+#include "ShaderCompiler.h"
 #include "ShaderStore.h"
+#include "TextureCooker.h"
 #include "TextureStore.h"
+#include "TextureStreamer.h"
 #include "RenderPassStore.h"
+#include "RenderThread.h"
 #include "UserComponentsBuilder.h"
 #include "Utils.h"
 #include "Window.h"
@@ -126,6 +134,42 @@ bool Engine::initialize(const std::filesystem::path& config_path)
     }
 
     m_context->inputManager = std::make_unique<InputManager>(m_context->window);
+    m_context->glState = std::make_unique<GLStateCache>();
+    m_context->renderer = std::make_unique<Renderer>();
+    if (settings.HasMember("occlusion_culling") && settings["occlusion_culling"].IsBool()) {
+        m_context->renderer->setOcclusionCulling(settings["occlusion_culling"].GetBool());
+    }
+    if (settings.HasMember("null_render_backend") && settings["null_render_backend"].IsBool()) {
+        m_context->renderer->setNullBackend(settings["null_render_backend"].GetBool());
+    }
+    auto lod_settings = m_context->renderer->lodSettings();
+    if (settings.HasMember("lod_pixel_error") && settings["lod_pixel_error"].IsNumber()) {
+        lod_settings.pixel_error = settings["lod_pixel_error"].GetFloat();
+    }
+    if (settings.HasMember("lod_hysteresis") && settings["lod_hysteresis"].IsNumber()) {
+        lod_settings.hysteresis = settings["lod_hysteresis"].GetFloat();
+    }
+    m_context->renderer->setLodSettings(lod_settings);
+    if (settings.HasMember("render_thread_latency") && settings["render_thread_latency"].IsUint()) {
+        m_render_thread_latency = settings["render_thread_latency"].GetUint();
+    }
+    if (settings.HasMember("hot_reload") && settings["hot_reload"].IsBool() && settings["hot_reload"].GetBool()) {
+        m_context->resourceReloader = std::make_unique<ResourceReloader>();
+    }
+    if (settings.HasMember("texture_budget_mb") && settings["texture_budget_mb"].IsUint()) {
+        m_context->textureStore->setBudget(static_cast<size_t>(settings["texture_budget_mb"].GetUint()) * 1024 * 1024);
+    }
+    if (settings.HasMember("texture_streaming") && settings["texture_streaming"].IsBool() && settings["texture_streaming"].GetBool()) {
+        size_t upload_budget = TextureStreamer::DEFAULT_UPLOAD_BUDGET;
+        if (settings.HasMember("texture_upload_budget_kb") && settings["texture_upload_budget_kb"].IsUint()) {
+            upload_budget = static_cast<size_t>(settings["texture_upload_budget_kb"].GetUint()) * 1024;
+        }
+        m_context->textureStreamer = std::make_unique<TextureStreamer>(upload_budget);
+    }
+    if (settings.HasMember("shader_cache") && settings["shader_cache"].IsString()) {
+        m_context->shaderStore->setProgramCache(std::make_unique<ProgramBinaryCache>(settings["shader_cache"].GetString()));
+    }
+    m_context->picking = std::make_unique<PickingService>(m_context);
 
     m_context->resourcePackageStore->initResourcePackagesInformation(settings["resource_packages"].GetString());
 
@@ -138,6 +182,45 @@ bool Engine::initialize(const std::filesystem::path& config_path)
     return m_sceneTransition->transition(m_scenes_info, -1, m_active_scene_id);
 }
 
+bool Engine::cookResources(const std::filesystem::path& config_path, bool textures, bool meshes)
+{
+    Logger::debug(__FUNCTION__);
+
+    EngineSettings engine_settings(config_path);
+    if (!engine_settings.load()) {
+        return false;
+    }
+
+    auto& settings = engine_settings.settings();
+
+    TextureCookOptions options;
+    if (settings.HasMember("texture_compression") && settings["texture_compression"].IsBool()) {
+        options.compress = settings["texture_compression"].GetBool();
+    }
+
+    ResourcePackageStore resource_package_store;
+    resource_package_store.initResourcePackagesInformation(settings["resource_packages"].GetString());
+
+    bool cooked = true;
+    for (const auto& [id, path] : resource_package_store.getResourcePackagesInformation()) {
+        auto package = buildResourcePackage(path);
+        if (!package.has_value()) {
+            Logger::error("{}: can not read resource package {}", __FUNCTION__, path.string());
+            cooked = false;
+            continue;
+        }
+
+        if (textures) {
+            cooked = cookPackageTextures(*package.value(), options).failed == 0 && cooked;
+        }
+        if (meshes) {
+            cooked = cookPackageMeshes(*package.value()).failed == 0 && cooked;
+        }
+    }
+
+    return cooked;
+}
+
 void Engine::setUserComponentsBuilder(std::unique_ptr<UserComponentsBuilder> userComponentsBuilder)
 {
     m_context->userComponentsBuilder = std::move(userComponentsBuilder);
@@ -147,6 +230,20 @@ void Engine::run()
 {
     m_run = true;
 
+    if (m_render_thread_latency > 0) {
+        m_render_thread = std::make_unique<RenderThread>(m_render_thread_latency, RenderThread::Callbacks{
+            [this] { m_context->window->makeContextCurrent(); },
+            [this] { m_context->window->releaseContext(); },
+            [this](Renderer::Frame& frame) {
+                m_context->renderer->submit(m_context, frame);
+                m_context->window->swapBuffer();
+            },
+        });
+        m_context->renderer->setGLInvoker([this](const std::function<void()>& job) {
+            m_render_thread->invoke(job);
+        });
+    }
+
     GLdouble update_time = glfwGetTime();
     uint64_t delta_time = 0;
 
@@ -158,6 +255,11 @@ void Engine::run()
 
         tick(delta_time);
     }
+
+    if (m_render_thread) {
+        m_context->renderer->setGLInvoker(nullptr);
+        m_render_thread.reset();
+    }
 }
 
 void Engine::performTick(uint64_t dt)
@@ -221,7 +323,9 @@ bool Engine::changeActiveScene(uint32_t id)
 
     uint32_t old_active_scene = m_active_scene_id;
     m_active_scene_id = id;
-    m_sceneTransition->transition(m_scenes_info, old_active_scene, m_active_scene_id);
+    runWithGL([this, old_active_scene] {
+        m_sceneTransition->transition(m_scenes_info, old_active_scene, m_active_scene_id);
+    });
 
     return true;
 }
@@ -240,7 +344,61 @@ void Engine::prepareTick()
         auto resource_package = m_context->resourcePackageStore->get(m_reload_resource_package_id);
 
         if (resource_package.has_value()) {
-            loadResourcePackage(m_context, resource_package.value());
+            runWithGL([this, &resource_package] {
+                loadResourcePackage(m_context, resource_package.value());
+            });
+
+            // mesh bounds and sprite sizes may have changed with the reloaded resources
+            auto scene = m_context->sceneStore->get(m_active_scene_id);
+            if (scene.has_value()) {
+                scene.value()->invalidateSpatialIndex();
+            }
+        }
+    }
+
+    if (m_context->resourceReloader) {
+        m_context->resourceReloader->update(m_context);
+
+        bool meshes_changed = false;
+        if (m_context->resourceReloader->hasWork()) {
+            runWithGL([this, &meshes_changed] {
+                meshes_changed = m_context->resourceReloader->apply(m_context);
+            });
+        }
+
+        // also rebuilds the static batches holding copies of the old vertices
+        auto scene = m_context->sceneStore->get(m_active_scene_id);
+        if (meshes_changed && scene.has_value()) {
+            scene.value()->invalidateSpatialIndex();
+        }
+    }
+
+    m_context->textureStore->beginFrame();
+    auto texture_misses = m_context->textureStore->takeMisses();
+    if (!texture_misses.empty() || m_context->textureStore->overBudget()) {
+        runWithGL([this, &texture_misses] {
+            m_context->textureStore->evict();
+
+            // evicted textures drawn last frame, their stand-ins are drawn until they are back
+            for (auto id : texture_misses) {
+                auto path = m_context->textureStore->sourcePath(id);
+                if (path.has_value()) {
+                    loadTexture(m_context, id, path.value());
+                }
+            }
+        });
+    }
+
+    if (m_context->textureStreamer && m_context->textureStreamer->hasWork()) {
+        bool textures_swapped = false;
+        runWithGL([this, &textures_swapped] {
+            textures_swapped = m_context->textureStreamer->upload(m_context);
+        });
+
+        // sprites are sized by their texture, which was 1x1 while the placeholder stood in
+        auto scene = m_context->sceneStore->get(m_active_scene_id);
+        if (textures_swapped && scene.has_value()) {
+            scene.value()->invalidateSpatialIndex();
         }
     }
 }
@@ -260,10 +418,35 @@ void Engine::tick(uint64_t dt)
             }
         }
 
-        Renderer::render(m_context, scene.value());
+        scene.value()->updateSpatialIndex();
+    }
+
+    if (!m_render_thread) {
+        if (scene.has_value()) {
+            m_context->renderer->render(m_context, scene.value());
+        }
+        m_context->window->swapBuffer();
+        return;
+    }
+
+    // the render thread submits and presents the frame while the next tick runs
+    auto& frame = m_render_thread->acquireFrame();
+    if (scene.has_value()) {
+        m_context->renderer->prepare(m_context, scene.value(), frame);
+    } else {
+        frame.has_camera = false;
+    }
+    m_render_thread->submitFrame();
+}
+
+void Engine::runWithGL(const std::function<void()>& job)
+{
+    if (m_render_thread) {
+        m_render_thread->invoke(job);
+        return;
     }
 
-    m_context->window->swapBuffer();
+    job();
 }
 
 }
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <filesystem>
+#include <functional>
 #include <unordered_map>
 
 namespace engine {
@@ -12,6 +13,7 @@ class UserComponentsBuilder;
 class Engine;
 class SceneConfig;
 class EngineSettings;
+class RenderThread;
 
 class EngineAccessor final {
 public:
@@ -40,6 +42,9 @@ public:
 
     bool initialize(const std::filesystem::path& config_path);
 
+    // cooks the textures and meshes of every resource package next to their sources, needs no window
+    static bool cookResources(const std::filesystem::path& config_path, bool textures, bool meshes);
+
     void setUserComponentsBuilder(std::unique_ptr<UserComponentsBuilder> userComponentsBuilder);
 
     void run();
@@ -65,6 +70,8 @@ public:
 private:
     void prepareTick();
     void tick(uint64_t dt);
+    // GL work of the simulation side, on the render thread while one runs
+    void runWithGL(const std::function<void()>& job);
 
     bool m_run = false;
 
@@ -83,6 +90,10 @@ private:
     bool m_need_reload_resource_package = false;
     uint32_t m_reload_resource_package_id = -1;
 
+    // frames run() lets the simulation get ahead of the render thread, 0 renders inline
+    uint32_t m_render_thread_latency = 0;
+    std::unique_ptr<RenderThread> m_render_thread;
+
     friend class EngineAccessor;
 };
 
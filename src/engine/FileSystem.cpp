@@ -89,6 +89,13 @@ bool FileSystem::removeFile(const std::filesystem::path& path)
     return std::filesystem::remove(path);
 }
 
+bool FileSystem::createDirectories(const std::filesystem::path& path)
+{
+    std::error_code error;
+    std::filesystem::create_directories(path, error);
+    return !error;
+}
+
 auto FileSystem::directory(const std::filesystem::path &path) -> Directory
 {
     return Directory(path);
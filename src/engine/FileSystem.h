@@ -50,6 +50,7 @@ public:
     static bool isDirectory(const std::filesystem::path& path);
     static bool isFile(const std::filesystem::path& path);
     static bool removeFile(const std::filesystem::path& path);
+    static bool createDirectories(const std::filesystem::path& path);
 
     static auto directory(const std::filesystem::path& path) -> Directory;
     static auto file(const std::filesystem::path& path, std::ios::openmode type) -> File;
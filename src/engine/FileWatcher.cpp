@@ -0,0 +1,150 @@
+#include "FileWatcher.h"
+#include "Logger.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace engine {
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher() :
+    m_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+    if (m_fd < 0) {
+        Logger::warning("FileWatcher: inotify unavailable, {}", std::strerror(errno));
+    }
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+void FileWatcher::watch(const std::filesystem::path& path)
+{
+    if (m_fd < 0) {
+        return;
+    }
+
+    std::error_code error;
+    const bool is_directory = std::filesystem::is_directory(path, error);
+    const auto directory = std::filesystem::absolute(is_directory ? path : path.parent_path(), error).lexically_normal().string();
+    const auto name = is_directory ? std::string() : path.filename().string();
+
+    auto it = m_directories.find(directory);
+    if (it == m_directories.end()) {
+        // saving through a temporary file and a rename replaces the watched file, so the directory is watched
+        const int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0) {
+            Logger::warning("FileWatcher: can not watch {}, {}", directory, std::strerror(errno));
+            return;
+        }
+        it = m_directories.emplace(directory, wd).first;
+    }
+
+    auto& targets = m_targets[it->second];
+    const auto target = std::make_pair(name, path);
+    if (std::ranges::find(targets, target) == targets.end()) {
+        targets.push_back(target);
+    }
+}
+
+auto FileWatcher::poll() -> std::vector<std::filesystem::path>
+{
+    std::vector<std::filesystem::path> changed;
+    if (m_fd < 0) {
+        return changed;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        const auto length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            auto it = m_targets.find(event->wd);
+            if (it == m_targets.end()) {
+                continue;
+            }
+
+            const std::string name = event->len > 0 ? event->name : "";
+            for (const auto& [target_name, target_path] : it->second) {
+                if ((target_name.empty() || target_name == name) && std::ranges::find(changed, target_path) == changed.end()) {
+                    changed.push_back(target_path);
+                }
+            }
+        }
+    }
+
+    return changed;
+}
+
+#else
+
+FileWatcher::FileWatcher() = default;
+
+FileWatcher::~FileWatcher() = default;
+
+void FileWatcher::watch(const std::filesystem::path& path)
+{
+    auto it = std::ranges::find_if(m_entries, [&path](const Entry& entry) {
+        return entry.path == path;
+    });
+    if (it == m_entries.end()) {
+        m_entries.push_back({ path, writeTime(path) });
+    }
+}
+
+auto FileWatcher::poll() -> std::vector<std::filesystem::path>
+{
+    std::vector<std::filesystem::path> changed;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now < m_next_poll) {
+        return changed;
+    }
+    m_next_poll = now + POLL_INTERVAL;
+
+    for (auto& entry : m_entries) {
+        const auto time = writeTime(entry.path);
+        if (time != entry.time) {
+            entry.time = time;
+            changed.push_back(entry.path);
+        }
+    }
+
+    return changed;
+}
+
+auto FileWatcher::writeTime(const std::filesystem::path& path) -> std::filesystem::file_time_type
+{
+    std::error_code error;
+    if (!std::filesystem::is_directory(path, error)) {
+        return std::filesystem::last_write_time(path, error);
+    }
+
+    auto latest = std::filesystem::file_time_type::min();
+    for (const auto& file : std::filesystem::directory_iterator(path, error)) {
+        latest = std::max(latest, std::filesystem::last_write_time(file.path(), error));
+    }
+    return latest;
+}
+
+#endif
+
+}
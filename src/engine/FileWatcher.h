@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+// Reports watched paths whose contents changed on disk. On Linux the parent
+// directories are watched with inotify, which also catches editors saving through
+// a rename; elsewhere poll() compares modification times twice a second.
+class FileWatcher final {
+public:
+    explicit FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher(FileWatcher&&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    FileWatcher& operator=(FileWatcher&&) = delete;
+
+    // a file, or a directory that changes with any of its files
+    void watch(const std::filesystem::path& path);
+
+    // never blocks, every changed path is reported once as given to watch()
+    auto poll() -> std::vector<std::filesystem::path>;
+
+private:
+#ifdef __linux__
+    int m_fd = -1;
+    // directory -> inotify watch
+    std::unordered_map<std::string, int> m_directories;
+    // inotify watch -> file name, empty for any file, and the path reported for it
+    std::unordered_map<int, std::vector<std::pair<std::string, std::filesystem::path>>> m_targets;
+#else
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{ 500 };
+
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+    };
+
+    static auto writeTime(const std::filesystem::path& path) -> std::filesystem::file_time_type;
+
+    std::vector<Entry> m_entries;
+    std::chrono::steady_clock::time_point m_next_poll;
+#endif
+};
+
+}
@@ -0,0 +1,156 @@
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_CULLING_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define ENGINE_CULLING_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace engine {
+
+Frustum::Frustum(const glm::mat4& view_projection)
+{
+    const auto row = [&view_projection](int i) {
+        return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+    };
+
+    m_planes[0] = row(3) + row(0);
+    m_planes[1] = row(3) - row(0);
+    m_planes[2] = row(3) + row(1);
+    m_planes[3] = row(3) - row(1);
+    m_planes[4] = row(3) + row(2);
+    m_planes[5] = row(3) - row(2);
+
+    for (auto& plane : m_planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+auto Frustum::planes() const -> const std::array<glm::vec4, 6>&
+{
+    return m_planes;
+}
+
+void WorldBounds::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_radius.clear();
+    m_size = 0;
+}
+
+void WorldBounds::add(const glm::vec3& center, float radius)
+{
+    m_x.push_back(center.x);
+    m_y.push_back(center.y);
+    m_z.push_back(center.z);
+    m_radius.push_back(radius);
+    ++m_size;
+}
+
+auto WorldBounds::size() const -> size_t
+{
+    return m_size;
+}
+
+void WorldBounds::pad()
+{
+    // padding lanes get a negative infinite radius and always fail the test
+    const size_t padded = (m_size + LANES - 1) / LANES * LANES;
+    m_x.resize(padded, 0.0f);
+    m_y.resize(padded, 0.0f);
+    m_z.resize(padded, 0.0f);
+    m_radius.resize(padded, -std::numeric_limits<float>::infinity());
+}
+
+void WorldBounds::trim()
+{
+    m_x.resize(m_size);
+    m_y.resize(m_size);
+    m_z.resize(m_size);
+    m_radius.resize(m_size);
+}
+
+void WorldBounds::cull(const Frustum& frustum, std::vector<uint8_t>& visible)
+{
+    pad();
+
+    const size_t padded = m_x.size();
+    visible.resize(padded);
+
+    const auto& planes = frustum.planes();
+
+    for (size_t i = 0; i < padded; i += LANES) {
+#if defined(ENGINE_CULLING_SSE)
+        const __m128 x = _mm_loadu_ps(m_x.data() + i);
+        const __m128 y = _mm_loadu_ps(m_y.data() + i);
+        const __m128 z = _mm_loadu_ps(m_z.data() + i);
+        const __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(m_radius.data() + i));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto& plane : planes) {
+            __m128 distance = _mm_mul_ps(x, _mm_set1_ps(plane.x));
+            distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+            distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            visible[i + lane] = (mask >> lane) & 1;
+        }
+#elif defined(ENGINE_CULLING_NEON)
+        const float32x4_t x = vld1q_f32(m_x.data() + i);
+        const float32x4_t y = vld1q_f32(m_y.data() + i);
+        const float32x4_t z = vld1q_f32(m_z.data() + i);
+        const float32x4_t negative_radius = vnegq_f32(vld1q_f32(m_radius.data() + i));
+
+        uint32x4_t inside = vdupq_n_u32(~0u);
+        for (const auto& plane : planes) {
+            float32x4_t distance = vdupq_n_f32(plane.w);
+            distance = vmlaq_n_f32(distance, x, plane.x);
+            distance = vmlaq_n_f32(distance, y, plane.y);
+            distance = vmlaq_n_f32(distance, z, plane.z);
+            inside = vandq_u32(inside, vcgeq_f32(distance, negative_radius));
+        }
+
+        uint32_t lanes[LANES];
+        vst1q_u32(lanes, inside);
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            visible[i + lane] = lanes[lane] != 0;
+        }
+#else
+        for (size_t lane = i; lane < i + LANES; ++lane) {
+            bool inside = true;
+            for (const auto& plane : planes) {
+                const float distance = plane.x * m_x[lane] + plane.y * m_y[lane] + plane.z * m_z[lane] + plane.w;
+                inside = inside && distance >= -m_radius[lane];
+            }
+            visible[lane] = inside;
+        }
+#endif
+    }
+
+    trim();
+    visible.resize(m_size);
+}
+
+auto transformSphere(const glm::mat4& model, const glm::vec3& center, float radius) -> glm::vec4
+{
+    const glm::vec3 world_center = glm::vec3(model * glm::vec4(center, 1.0f));
+    const float max_scale = std::max({
+        glm::length(glm::vec3(model[0])),
+        glm::length(glm::vec3(model[1])),
+        glm::length(glm::vec3(model[2]))
+    });
+    return glm::vec4(world_center, radius * max_scale);
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+
+// Six normalized planes extracted from a view-projection matrix, normals pointing inside
+class Frustum final {
+public:
+    explicit Frustum(const glm::mat4& view_projection);
+
+    auto planes() const -> const std::array<glm::vec4, 6>&;
+
+private:
+    std::array<glm::vec4, 6> m_planes;
+};
+
+// World space bounding spheres stored as structure of arrays so the frustum
+// test runs on four spheres per iteration (SSE or NEON, scalar otherwise)
+class WorldBounds final {
+public:
+    static constexpr size_t LANES = 4;
+
+    WorldBounds() = default;
+    ~WorldBounds() = default;
+    WorldBounds(const WorldBounds&) = delete;
+    WorldBounds(WorldBounds&&) = delete;
+    WorldBounds& operator=(const WorldBounds&) = delete;
+    WorldBounds& operator=(WorldBounds&&) = delete;
+
+    void clear();
+    void add(const glm::vec3& center, float radius);
+
+    auto size() const -> size_t;
+
+    // writes 1 for every sphere intersecting the frustum, 0 otherwise
+    void cull(const Frustum& frustum, std::vector<uint8_t>& visible);
+
+private:
+    void pad();
+    void trim();
+
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<float> m_radius;
+
+    size_t m_size = 0;
+};
+
+// bounding sphere of a mesh transformed by a model matrix, the radius grows with the largest axis scale
+auto transformSphere(const glm::mat4& model, const glm::vec3& center, float radius) -> glm::vec4;
+
+}
@@ -0,0 +1,176 @@
+#include "GLStateCache.h"
+
+namespace engine {
+
+GLStateCache::GLStateCache()
+{
+    invalidate();
+}
+
+void GLStateCache::invalidate()
+{
+    m_program = UNKNOWN;
+    m_vao = UNKNOWN;
+    m_active_texture = UNKNOWN;
+
+    for (auto& unit : m_textures) {
+        unit.fill(UNKNOWN);
+    }
+    m_capabilities.fill(Tracked::Unknown);
+
+    m_blend_src = UNKNOWN_ENUM;
+    m_blend_dst = UNKNOWN_ENUM;
+    m_depth_mask = Tracked::Unknown;
+    m_depth_func = UNKNOWN_ENUM;
+    m_color_mask = Tracked::Unknown;
+}
+
+void GLStateCache::useProgram(GLuint program)
+{
+    if (skip(m_program == program)) {
+        return;
+    }
+    m_program = program;
+    glUseProgram(program);
+}
+
+void GLStateCache::activeTexture(uint32_t unit)
+{
+    if (skip(m_active_texture == unit)) {
+        return;
+    }
+    m_active_texture = unit;
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLStateCache::bindTexture(uint32_t unit, GLenum target, GLuint texture)
+{
+    const int target_index = textureTargetIndex(target);
+    if (unit >= MAX_TEXTURE_UNITS || target_index < 0) {
+        activeTexture(unit);
+        ++m_stats.issued;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    auto& bound = m_textures[unit][target_index];
+    if (skip(bound == texture)) {
+        return;
+    }
+
+    activeTexture(unit);
+    bound = texture;
+    glBindTexture(target, texture);
+}
+
+void GLStateCache::bindVertexArray(GLuint vao)
+{
+    if (skip(m_vao == vao)) {
+        return;
+    }
+    m_vao = vao;
+    glBindVertexArray(vao);
+}
+
+void GLStateCache::setEnabled(GLenum capability, bool enabled)
+{
+    const auto wanted = enabled ? Tracked::On : Tracked::Off;
+
+    const int index = capabilityIndex(capability);
+    if (index >= 0) {
+        if (skip(m_capabilities[index] == wanted)) {
+            return;
+        }
+        m_capabilities[index] = wanted;
+    } else {
+        ++m_stats.issued;
+    }
+
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+}
+
+void GLStateCache::blendFunc(GLenum src, GLenum dst)
+{
+    if (skip(m_blend_src == src && m_blend_dst == dst)) {
+        return;
+    }
+    m_blend_src = src;
+    m_blend_dst = dst;
+    glBlendFunc(src, dst);
+}
+
+void GLStateCache::depthMask(bool enabled)
+{
+    const auto wanted = enabled ? Tracked::On : Tracked::Off;
+    if (skip(m_depth_mask == wanted)) {
+        return;
+    }
+    m_depth_mask = wanted;
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::depthFunc(GLenum func)
+{
+    if (skip(m_depth_func == func)) {
+        return;
+    }
+    m_depth_func = func;
+    glDepthFunc(func);
+}
+
+void GLStateCache::colorMask(bool enabled)
+{
+    const auto wanted = enabled ? Tracked::On : Tracked::Off;
+    if (skip(m_color_mask == wanted)) {
+        return;
+    }
+    m_color_mask = wanted;
+    const GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+    glColorMask(mask, mask, mask, mask);
+}
+
+auto GLStateCache::stats() const -> const Stats&
+{
+    return m_stats;
+}
+
+void GLStateCache::resetStats()
+{
+    m_stats = {};
+}
+
+auto GLStateCache::textureTargetIndex(GLenum target) -> int
+{
+    switch (target) {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_BUFFER: return 1;
+        default: return -1;
+    }
+}
+
+auto GLStateCache::capabilityIndex(GLenum capability) -> int
+{
+    switch (capability) {
+        case GL_DEPTH_TEST: return 0;
+        case GL_BLEND: return 1;
+        case GL_CULL_FACE: return 2;
+        case GL_SCISSOR_TEST: return 3;
+        default: return -1;
+    }
+}
+
+auto GLStateCache::skip(bool same) -> bool
+{
+    if (same) {
+        ++m_stats.skipped;
+    } else {
+        ++m_stats.issued;
+    }
+    return same;
+}
+
+}
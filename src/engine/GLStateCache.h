@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+
+namespace engine {
+
+// Shadow copy of the GL state touched by the renderer. Calls matching the
+// shadowed value are skipped. The shadow is only trusted between invalidate()
+// calls: anything that may issue raw GL (resource loading, the editor making
+// another context current) has to be followed by invalidate().
+class GLStateCache final {
+public:
+    struct Stats {
+        uint64_t issued = 0;
+        uint64_t skipped = 0;
+    };
+
+    static constexpr uint32_t MAX_TEXTURE_UNITS = 16;
+
+    GLStateCache();
+    ~GLStateCache() = default;
+    GLStateCache(const GLStateCache&) = delete;
+    GLStateCache(GLStateCache&&) = delete;
+    GLStateCache& operator=(const GLStateCache&) = delete;
+    GLStateCache& operator=(GLStateCache&&) = delete;
+
+    void invalidate();
+
+    void useProgram(GLuint program);
+    void activeTexture(uint32_t unit);
+    void bindTexture(uint32_t unit, GLenum target, GLuint texture);
+    void bindVertexArray(GLuint vao);
+
+    void setEnabled(GLenum capability, bool enabled);
+    void blendFunc(GLenum src, GLenum dst);
+    void depthMask(bool enabled);
+    void depthFunc(GLenum func);
+    // all four channels at once, the depth pre-pass is the only user
+    void colorMask(bool enabled);
+
+    auto stats() const -> const Stats&;
+    void resetStats();
+
+private:
+    enum class Tracked : int8_t {
+        Unknown = -1,
+        Off = 0,
+        On = 1,
+    };
+
+    static constexpr GLuint UNKNOWN = ~0u;
+    static constexpr GLenum UNKNOWN_ENUM = ~0u;
+
+    static auto textureTargetIndex(GLenum target) -> int;
+    static auto capabilityIndex(GLenum capability) -> int;
+
+    auto skip(bool same) -> bool;
+
+    GLuint m_program = UNKNOWN;
+    GLuint m_vao = UNKNOWN;
+    uint32_t m_active_texture = UNKNOWN;
+
+    // GL_TEXTURE_2D and GL_TEXTURE_BUFFER per unit
+    std::array<std::array<GLuint, 2>, MAX_TEXTURE_UNITS> m_textures{};
+
+    // GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST
+    std::array<Tracked, 4> m_capabilities{};
+
+    GLenum m_blend_src = UNKNOWN_ENUM;
+    GLenum m_blend_dst = UNKNOWN_ENUM;
+    Tracked m_depth_mask = Tracked::Unknown;
+    GLenum m_depth_func = UNKNOWN_ENUM;
+    Tracked m_color_mask = Tracked::Unknown;
+
+    Stats m_stats;
+};
+
+}
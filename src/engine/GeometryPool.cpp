@@ -0,0 +1,267 @@
+#include "GeometryPool.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <ranges>
+
+namespace engine {
+
+GeometryPool::~GeometryPool()
+{
+    for (auto& arena : m_arenas | std::views::values) {
+        destroyArena(arena);
+    }
+}
+
+auto GeometryPool::allocate(const MeshConfig& layout, const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices) -> std::optional<Allocation>
+{
+    if (layout.stride == 0 || vertices.empty() || indices.empty()) {
+        return std::nullopt;
+    }
+
+    const auto vertex_count = static_cast<uint32_t>((vertices.size() + layout.stride - 1) / layout.stride);
+    const auto index_count = static_cast<uint32_t>(indices.size());
+    const GLenum index_type = vertex_count <= std::numeric_limits<GLushort>::max() + 1u ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const size_t index_size = indexSize(index_type);
+    const size_t vertex_size = packedVertexSize(layout);
+
+    std::optional<uint32_t> arena_id;
+    std::optional<uint32_t> vertex_offset;
+    std::optional<uint32_t> index_offset;
+
+    for (auto& [id, arena] : m_arenas) {
+        if (arena.layout != layout || arena.index_type != index_type) {
+            continue;
+        }
+
+        vertex_offset = arena.vertices.allocate(vertex_count);
+        if (!vertex_offset.has_value()) {
+            continue;
+        }
+
+        index_offset = arena.indices.allocate(index_count);
+        if (!index_offset.has_value()) {
+            arena.vertices.release(vertex_offset.value(), vertex_count);
+            continue;
+        }
+
+        arena_id = id;
+        break;
+    }
+
+    if (!arena_id.has_value()) {
+        const auto arena_vertices = std::max<uint32_t>(vertex_count, static_cast<uint32_t>(ARENA_VERTEX_BYTES / vertex_size));
+        const auto arena_indices = std::max<uint32_t>(index_count, static_cast<uint32_t>(ARENA_INDEX_BYTES / index_size));
+        arena_id = createArena(layout, index_type, arena_vertices, arena_indices);
+
+        auto& arena = m_arenas.at(arena_id.value());
+        vertex_offset = arena.vertices.allocate(vertex_count);
+        index_offset = arena.indices.allocate(index_count);
+    }
+
+    auto& arena = m_arenas.at(arena_id.value());
+    ++arena.allocations;
+
+    // the copy targets leave the VAO element binding and the array binding alone
+    const auto packed = packVertices(vertices, layout);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER,
+        static_cast<GLintptr>(vertex_offset.value() * vertex_size),
+        static_cast<GLsizeiptr>(packed.size()), packed.data());
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.ebo);
+    if (index_type == GL_UNSIGNED_SHORT) {
+        const std::vector<GLushort> short_indices(indices.begin(), indices.end());
+        glBufferSubData(GL_COPY_WRITE_BUFFER,
+            static_cast<GLintptr>(index_offset.value() * index_size),
+            static_cast<GLsizeiptr>(short_indices.size() * index_size), short_indices.data());
+    } else {
+        glBufferSubData(GL_COPY_WRITE_BUFFER,
+            static_cast<GLintptr>(index_offset.value() * index_size),
+            static_cast<GLsizeiptr>(indices.size() * index_size), indices.data());
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    Allocation allocation;
+    allocation.arena = arena_id.value();
+    allocation.vao = arena.vao;
+    allocation.base_vertex = static_cast<GLint>(vertex_offset.value());
+    allocation.vertex_count = vertex_count;
+    allocation.first_index = index_offset.value();
+    allocation.index_count = index_count;
+    allocation.index_type = index_type;
+
+    return allocation;
+}
+
+void GeometryPool::release(const Allocation& allocation)
+{
+    auto it = m_arenas.find(allocation.arena);
+    if (it == m_arenas.end()) {
+        return;
+    }
+
+    auto& arena = it->second;
+    arena.vertices.release(static_cast<uint32_t>(allocation.base_vertex), allocation.vertex_count);
+    arena.indices.release(allocation.first_index, allocation.index_count);
+
+    if (--arena.allocations == 0) {
+        destroyArena(arena);
+        m_arenas.erase(it);
+    }
+}
+
+auto GeometryPool::beginRead(const Allocation& allocation) const -> std::optional<Readback>
+{
+    auto it = m_arenas.find(allocation.arena);
+    if (it == m_arenas.end()) {
+        return std::nullopt;
+    }
+
+    const auto& arena = it->second;
+    const size_t vertex_size = packedVertexSize(arena.layout);
+    const size_t index_size = indexSize(allocation.index_type);
+
+    Readback readback;
+    readback.layout = arena.layout;
+    readback.index_type = allocation.index_type;
+    readback.vertex_bytes = allocation.vertex_count * vertex_size;
+    readback.index_bytes = allocation.index_count * index_size;
+
+    // copied on the GPU, glGetBufferSubData here would wait for every queued draw
+    glGenBuffers(1, &readback.buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, readback.buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(readback.vertex_bytes + readback.index_bytes), nullptr, GL_STREAM_READ);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, arena.vbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+        static_cast<GLintptr>(allocation.base_vertex * vertex_size), 0,
+        static_cast<GLsizeiptr>(readback.vertex_bytes));
+    glBindBuffer(GL_COPY_READ_BUFFER, arena.ebo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+        static_cast<GLintptr>(allocation.first_index * index_size), static_cast<GLintptr>(readback.vertex_bytes),
+        static_cast<GLsizeiptr>(readback.index_bytes));
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    return readback;
+}
+
+auto GeometryPool::finishRead(Readback& readback, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices) -> bool
+{
+    if (readback.fence == nullptr) {
+        return false;
+    }
+
+    const GLenum status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+
+    vertices.clear();
+    indices.clear();
+
+    glBindBuffer(GL_COPY_READ_BUFFER, readback.buffer);
+    const auto* data = status == GL_WAIT_FAILED ? nullptr : static_cast<const std::byte*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0,
+        static_cast<GLsizeiptr>(readback.vertex_bytes + readback.index_bytes), GL_MAP_READ_BIT));
+    if (data != nullptr) {
+        vertices = unpackVertices(std::span(data, readback.vertex_bytes), readback.layout);
+
+        const auto* index_data = data + readback.vertex_bytes;
+        if (readback.index_type == GL_UNSIGNED_SHORT) {
+            std::vector<GLushort> short_indices(readback.index_bytes / sizeof(GLushort));
+            std::memcpy(short_indices.data(), index_data, readback.index_bytes);
+            indices.assign(short_indices.begin(), short_indices.end());
+        } else {
+            indices.resize(readback.index_bytes / sizeof(GLuint));
+            std::memcpy(indices.data(), index_data, readback.index_bytes);
+        }
+
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+    } else {
+        Logger::error("GeometryPool: can not read back {} vertex and {} index bytes", readback.vertex_bytes, readback.index_bytes);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    cancelRead(readback);
+
+    // a failed read back ends with no geometry rather than being retried every frame
+    return true;
+}
+
+void GeometryPool::cancelRead(Readback& readback)
+{
+    if (readback.fence != nullptr) {
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+    }
+    if (readback.buffer != 0) {
+        glDeleteBuffers(1, &readback.buffer);
+        readback.buffer = 0;
+    }
+}
+
+auto GeometryPool::layout(const Allocation& allocation) const -> const MeshConfig&
+{
+    return m_arenas.at(allocation.arena).layout;
+}
+
+auto GeometryPool::stats() const -> Stats
+{
+    Stats stats;
+    for (const auto& arena : m_arenas | std::views::values) {
+        const size_t vertex_bytes = packedVertexSize(arena.layout);
+        const size_t index_bytes = indexSize(arena.index_type);
+        ++stats.arenas;
+        stats.reserved_bytes += arena.vertices.capacity() * vertex_bytes + arena.indices.capacity() * index_bytes;
+        stats.used_bytes += arena.vertices.used() * vertex_bytes + arena.indices.used() * index_bytes;
+    }
+
+    return stats;
+}
+
+auto GeometryPool::indexSize(GLenum index_type) -> size_t
+{
+    return index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+auto GeometryPool::createArena(const MeshConfig& layout, GLenum index_type, uint32_t vertex_count, uint32_t index_count) -> uint32_t
+{
+    const uint32_t id = m_next_arena++;
+    auto& arena = m_arenas.emplace(id, Arena{ layout, index_type, 0, 0, 0, RangeAllocator(vertex_count), RangeAllocator(index_count), 0 }).first->second;
+
+    glGenVertexArrays(1, &arena.vao);
+    glGenBuffers(1, &arena.vbo);
+    glGenBuffers(1, &arena.ebo);
+
+    glBindVertexArray(arena.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, arena.vbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertex_count * packedVertexSize(layout)), nullptr, GL_STATIC_DRAW);
+    setVertexAttributes(layout);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(index_count * indexSize(index_type)), nullptr, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    Logger::debug("GeometryPool: arena {} created, vertex size: {}, vertices: {}, indices: {} of {} bytes", id, packedVertexSize(layout), vertex_count, index_count, indexSize(index_type));
+
+    return id;
+}
+
+void GeometryPool::destroyArena(Arena& arena)
+{
+    glDeleteVertexArrays(1, &arena.vao);
+    glDeleteBuffers(1, &arena.vbo);
+    glDeleteBuffers(1, &arena.ebo);
+}
+
+}
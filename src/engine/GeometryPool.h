@@ -0,0 +1,111 @@
+#pragma once
+
+#include "RangeAllocator.h"
+#include "VertexFormat.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+
+// interleaved vertex layout, offsets and sizes in floats, and the format each
+// attribute is packed to on the GPU
+struct MeshConfig {
+    GLuint stride;
+    std::optional<GLuint> vertices_offset;
+    std::optional<GLuint> vertices_size;
+    std::optional<GLuint> texture_coords_offset;
+    std::optional<GLuint> texture_coords_size;
+    std::optional<GLuint> normals_offset;
+    std::optional<GLuint> normals_size;
+    VertexFormat vertices_format = VertexFormat::Float;
+    VertexFormat texture_coords_format = VertexFormat::Float;
+    VertexFormat normals_format = VertexFormat::Float;
+
+    bool operator==(const MeshConfig&) const = default;
+};
+
+// Large shared vertex and index buffers meshes are suballocated from. Meshes with
+// the same vertex layout live in the same arena and share its VAO, so switching
+// between them costs no VAO bind; draws address them with a base vertex and an
+// index offset. Indices are relative to the base vertex, so meshes of up to 65536
+// vertices are stored with 16-bit indices, in arenas of their own since one draw
+// reads one index type. Arenas grow by adding new ones and are deleted once empty.
+class GeometryPool final {
+public:
+    struct Allocation {
+        uint32_t arena = 0;
+        GLuint vao = 0;
+        GLint base_vertex = 0;
+        uint32_t vertex_count = 0;
+        uint32_t first_index = 0;
+        uint32_t index_count = 0;
+        // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, first_index counts indices of this type
+        GLenum index_type = GL_UNSIGNED_INT;
+    };
+
+    // a copy of one allocation into a staging buffer, fenced so it is mapped only once the GPU wrote it
+    struct Readback {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        MeshConfig layout{};
+        GLenum index_type = GL_UNSIGNED_INT;
+        size_t vertex_bytes = 0;
+        size_t index_bytes = 0;
+    };
+
+    struct Stats {
+        uint32_t arenas = 0;
+        size_t reserved_bytes = 0;
+        size_t used_bytes = 0;
+    };
+
+    GeometryPool() = default;
+    ~GeometryPool();
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool(GeometryPool&&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+    GeometryPool& operator=(GeometryPool&&) = delete;
+
+    auto allocate(const MeshConfig& layout, const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices) -> std::optional<Allocation>;
+    void release(const Allocation& allocation);
+
+    // asynchronous GPU read back for the rare consumers of the geometry on the CPU,
+    // finishRead never waits and returns false until the copy has landed
+    auto beginRead(const Allocation& allocation) const -> std::optional<Readback>;
+    static auto finishRead(Readback& readback, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices) -> bool;
+    static void cancelRead(Readback& readback);
+
+    auto layout(const Allocation& allocation) const -> const MeshConfig&;
+    auto stats() const -> Stats;
+
+    static auto indexSize(GLenum index_type) -> size_t;
+
+private:
+    struct Arena {
+        MeshConfig layout;
+        GLenum index_type = GL_UNSIGNED_INT;
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLuint ebo = 0;
+        RangeAllocator vertices;
+        RangeAllocator indices;
+        uint32_t allocations = 0;
+    };
+
+    auto createArena(const MeshConfig& layout, GLenum index_type, uint32_t vertex_count, uint32_t index_count) -> uint32_t;
+    void destroyArena(Arena& arena);
+
+    std::unordered_map<uint32_t, Arena> m_arenas;
+    uint32_t m_next_arena = 1;
+
+    static constexpr size_t ARENA_VERTEX_BYTES = 8 * 1024 * 1024;
+    static constexpr size_t ARENA_INDEX_BYTES = 4 * 1024 * 1024;
+};
+
+}
@@ -0,0 +1,247 @@
+#include "LightRegistry.h"
+#include "Scene.h"
+#include "Node.h"
+#include "SceneRequesterHelper.h"
+#include "TransformComponent.h"
+#include "CameraComponent.h"
+#include "LightSourceComponent.h"
+#include "GLStateCache.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ranges>
+
+namespace engine {
+
+namespace {
+
+void createTextureBuffer(GLuint& buffer, GLuint& texture, GLenum format, GLsizeiptr size)
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void uploadTextureBuffer(GLuint buffer, const void* data, GLsizeiptr size)
+{
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    // orphan the previous storage so the driver does not stall on the last frame
+    glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+auto clusterCoordinate(float ndc, uint32_t clusters) -> uint32_t
+{
+    const float coordinate = (ndc * 0.5f + 0.5f) * static_cast<float>(clusters);
+    return static_cast<uint32_t>(std::clamp(coordinate, 0.0f, static_cast<float>(clusters - 1)));
+}
+
+}
+
+LightRegistry::LightRegistry() :
+    m_light_uniform_buffer(std::make_unique<UniformBuffer>(sizeof(LightUniform) * MAX_LIGHTS, LIGHT_UNIFORMS_BINDING))
+{
+    m_cluster_cursors.resize(CLUSTERS_COUNT);
+
+    createTextureBuffer(m_clusters_buffer, m_clusters_texture, GL_RG32UI, sizeof(glm::uvec2) * CLUSTERS_COUNT);
+    createTextureBuffer(m_indices_buffer, m_indices_texture, GL_R32UI, sizeof(uint32_t));
+}
+
+LightRegistry::~LightRegistry()
+{
+    glDeleteTextures(1, &m_clusters_texture);
+    glDeleteTextures(1, &m_indices_texture);
+    glDeleteBuffers(1, &m_clusters_buffer);
+    glDeleteBuffers(1, &m_indices_buffer);
+}
+
+void LightRegistry::gather(const std::shared_ptr<Scene>& scene, Clusters& clusters)
+{
+    auto& lights = clusters.lights;
+    lights.clear();
+
+    for (const auto& component : scene->getComponents() | std::views::values) {
+        auto light_source = std::dynamic_pointer_cast<LightSourceComponent>(component);
+        if (!light_source || !light_source->isActive()) {
+            continue;
+        }
+
+        auto light_source_node = scene->getNode(light_source->ownerNode());
+        if (!light_source_node.has_value() || !light_source_node.value()->isActive()) {
+            continue;
+        }
+
+        auto light_source_transform = SceneRequesterHelper::getComponent<TransformComponent>(scene, light_source_node.value()->components());
+        if (!light_source_transform.has_value()) {
+            continue;
+        }
+
+        if (lights.size() == MAX_LIGHTS) {
+            if (!m_overflow_reported) {
+                Logger::warning("LightRegistry: more than {} active lights, the rest are ignored", MAX_LIGHTS);
+                m_overflow_reported = true;
+            }
+            break;
+        }
+
+        lights.push_back({
+            glm::vec4(light_source_transform.value()->getPosition(), light_source->radius()),
+            glm::vec4(light_source->color(), light_source->intensity())
+        });
+    }
+}
+
+void LightRegistry::buildClusters(const std::shared_ptr<CameraComponent>& camera, const std::pair<int, int>& viewport,
+                                  Clusters& clusters, FrameUniforms& frame_uniforms)
+{
+    const auto& lights = clusters.lights;
+    auto& grid = clusters.clusters;
+    auto& light_indices = clusters.light_indices;
+
+    const auto& view = camera->getView();
+    const auto& projection = camera->getProjection();
+    const float near = camera->getNear();
+    const float far = camera->getFar();
+
+    const bool logarithmic = camera->projectionType() == CameraComponent::ProjectionType::Perspective && near > 0.0f;
+
+    float slice_scale = 0.0f;
+    float slice_bias = 0.0f;
+    if (logarithmic) {
+        slice_scale = static_cast<float>(CLUSTERS_Z) / std::log(far / near);
+        slice_bias = -std::log(near) * slice_scale;
+    } else {
+        slice_scale = static_cast<float>(CLUSTERS_Z) / (far - near);
+        slice_bias = -near * slice_scale;
+    }
+
+    auto depthSlice = [&](float depth) {
+        const float slice = logarithmic ? std::log(depth) * slice_scale + slice_bias : depth * slice_scale + slice_bias;
+        return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(CLUSTERS_Z - 1)));
+    };
+
+    m_light_ranges.clear();
+    grid.assign(CLUSTERS_COUNT, glm::uvec2(0));
+
+    // first pass: cluster range of every light and the light count of every cluster
+    glm::vec3 ambient(0.0f);
+    for (const auto& light : lights) {
+        ambient += glm::vec3(light.color_intensity) * light.color_intensity.w;
+
+        const glm::vec3 view_position = glm::vec3(view * glm::vec4(glm::vec3(light.position_radius), 1.0f));
+        const float radius = light.position_radius.w;
+        const float depth = -view_position.z;
+
+        const float min_depth = std::max(depth - radius, near);
+        const float max_depth = std::min(depth + radius, far);
+        if (radius <= 0.0f || min_depth > max_depth) {
+            m_light_ranges.push_back({ 1, 0, 1, 0, 1, 0 });
+            continue;
+        }
+
+        // the projected extent of the sphere is bounded by its box corners on the nearest and farthest depth
+        glm::vec2 ndc_min(std::numeric_limits<float>::max());
+        glm::vec2 ndc_max(std::numeric_limits<float>::lowest());
+        for (float corner_depth : { min_depth, max_depth }) {
+            for (float x : { view_position.x - radius, view_position.x + radius }) {
+                for (float y : { view_position.y - radius, view_position.y + radius }) {
+                    const glm::vec4 clip = projection * glm::vec4(x, y, -corner_depth, 1.0f);
+                    const glm::vec2 ndc = glm::vec2(clip) / std::max(clip.w, 1e-6f);
+                    ndc_min = glm::min(ndc_min, ndc);
+                    ndc_max = glm::max(ndc_max, ndc);
+                }
+            }
+        }
+
+        if (ndc_min.x > 1.0f || ndc_min.y > 1.0f || ndc_max.x < -1.0f || ndc_max.y < -1.0f) {
+            m_light_ranges.push_back({ 1, 0, 1, 0, 1, 0 });
+            continue;
+        }
+
+        const ClusterRange range = {
+            clusterCoordinate(ndc_min.x, CLUSTERS_X), clusterCoordinate(ndc_max.x, CLUSTERS_X),
+            clusterCoordinate(ndc_min.y, CLUSTERS_Y), clusterCoordinate(ndc_max.y, CLUSTERS_Y),
+            depthSlice(min_depth), depthSlice(max_depth)
+        };
+        m_light_ranges.push_back(range);
+
+        for (uint32_t z = range.min_z; z <= range.max_z; ++z) {
+            for (uint32_t y = range.min_y; y <= range.max_y; ++y) {
+                for (uint32_t x = range.min_x; x <= range.max_x; ++x) {
+                    ++grid[x + CLUSTERS_X * (y + CLUSTERS_Y * z)].y;
+                }
+            }
+        }
+    }
+
+    // offsets from the counts, the index list is truncated if it does not fit
+    uint32_t total = 0;
+    for (auto& cluster : grid) {
+        const uint32_t count = std::min(cluster.y, MAX_LIGHT_INDICES - total);
+        if (count != cluster.y && !m_overflow_reported) {
+            Logger::warning("LightRegistry: light index list exceeds {} entries", MAX_LIGHT_INDICES);
+            m_overflow_reported = true;
+        }
+        cluster = glm::uvec2(total, count);
+        total += count;
+    }
+
+    // second pass: scatter light indices into the ranges reserved for every cluster
+    light_indices.resize(total);
+    std::ranges::fill(m_cluster_cursors, 0);
+    for (uint32_t light_index = 0; light_index < m_light_ranges.size(); ++light_index) {
+        const auto& range = m_light_ranges[light_index];
+        for (uint32_t z = range.min_z; z <= range.max_z; ++z) {
+            for (uint32_t y = range.min_y; y <= range.max_y; ++y) {
+                for (uint32_t x = range.min_x; x <= range.max_x; ++x) {
+                    const uint32_t cluster_index = x + CLUSTERS_X * (y + CLUSTERS_Y * z);
+                    auto& cursor = m_cluster_cursors[cluster_index];
+                    if (cursor < grid[cluster_index].y) {
+                        light_indices[grid[cluster_index].x + cursor++] = light_index;
+                    }
+                }
+            }
+        }
+    }
+    if (!lights.empty()) {
+        ambient /= static_cast<float>(lights.size());
+    }
+    frame_uniforms.ambient_color = glm::vec4(ambient * AMBIENT_STRENGTH, 1.0f);
+    frame_uniforms.cluster_scale = glm::vec4(
+        static_cast<float>(CLUSTERS_X) / static_cast<float>(std::max(viewport.first, 1)),
+        static_cast<float>(CLUSTERS_Y) / static_cast<float>(std::max(viewport.second, 1)),
+        slice_scale,
+        slice_bias
+    );
+    frame_uniforms.cluster_size = glm::uvec4(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z, logarithmic ? 1 : 0);
+}
+
+void LightRegistry::bind(GLStateCache& state) const
+{
+    state.bindTexture(LIGHT_CLUSTERS_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_clusters_texture);
+    state.bindTexture(LIGHT_INDICES_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_indices_texture);
+}
+
+void LightRegistry::upload(const Clusters& clusters)
+{
+    if (!clusters.lights.empty()) {
+        m_light_uniform_buffer->update(clusters.lights.data(), sizeof(LightUniform) * clusters.lights.size());
+    }
+
+    uploadTextureBuffer(m_clusters_buffer, clusters.clusters.data(), sizeof(glm::uvec2) * clusters.clusters.size());
+
+    if (!clusters.light_indices.empty()) {
+        uploadTextureBuffer(m_indices_buffer, clusters.light_indices.data(), sizeof(uint32_t) * clusters.light_indices.size());
+    }
+}
+
+}
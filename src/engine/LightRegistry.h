@@ -0,0 +1,103 @@
+#pragma once
+
+#include "UniformBuffer.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace engine {
+
+class Scene;
+class CameraComponent;
+class GLStateCache;
+
+constexpr GLuint LIGHT_UNIFORMS_BINDING = 2;
+constexpr const char* LIGHT_UNIFORMS_BLOCK = "LightData";
+
+// must match the array size of the LightData block in the shaders
+constexpr uint32_t MAX_LIGHTS = 256;
+
+// cluster grid and light index list are texture buffers, GL 4.1 has no storage buffers
+constexpr const char* LIGHT_CLUSTERS_SAMPLER = "light_clusters";
+constexpr const char* LIGHT_INDICES_SAMPLER = "light_indices";
+constexpr GLint LIGHT_CLUSTERS_TEXTURE_UNIT = 14;
+constexpr GLint LIGHT_INDICES_TEXTURE_UNIT = 15;
+
+// std140 element of the LightData block
+struct LightUniform {
+    // xyz - world position, w - radius
+    glm::vec4 position_radius{0.0f};
+    // rgb - color, a - intensity
+    glm::vec4 color_intensity{0.0f};
+};
+
+// Lights of the active scene gathered once per frame and binned on the CPU into
+// a view space cluster grid: screen tiles in xy, depth slices in z
+// (logarithmic for perspective cameras, linear for orthographic ones).
+// Each cluster stores an offset and count into one flat light index list.
+class LightRegistry final {
+public:
+    static constexpr uint32_t CLUSTERS_X = 16;
+    static constexpr uint32_t CLUSTERS_Y = 9;
+    static constexpr uint32_t CLUSTERS_Z = 24;
+    static constexpr uint32_t CLUSTERS_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+    // GL_MAX_TEXTURE_BUFFER_SIZE is at least 65536 texels
+    static constexpr uint32_t MAX_LIGHT_INDICES = 65536;
+
+    static constexpr float AMBIENT_STRENGTH = 0.1f;
+
+    explicit LightRegistry();
+    ~LightRegistry();
+    LightRegistry(const LightRegistry&) = delete;
+    LightRegistry(LightRegistry&&) = delete;
+    LightRegistry& operator=(const LightRegistry&) = delete;
+    LightRegistry& operator=(LightRegistry&&) = delete;
+
+    // lights of one frame binned into the grid, filled by gather() and
+    // buildClusters() without GL and uploaded by upload()
+    struct Clusters {
+        std::vector<LightUniform> lights;
+        // uvec2 per cluster: offset into light_indices and light count
+        std::vector<glm::uvec2> clusters;
+        std::vector<uint32_t> light_indices;
+    };
+
+    void gather(const std::shared_ptr<Scene>& scene, Clusters& clusters);
+
+    // bins the gathered lights and fills the cluster parameters of the frame block
+    void buildClusters(const std::shared_ptr<CameraComponent>& camera, const std::pair<int, int>& viewport,
+                       Clusters& clusters, FrameUniforms& frame_uniforms);
+
+    void upload(const Clusters& clusters);
+    void bind(GLStateCache& state) const;
+
+private:
+    struct ClusterRange {
+        uint32_t min_x;
+        uint32_t max_x;
+        uint32_t min_y;
+        uint32_t max_y;
+        uint32_t min_z;
+        uint32_t max_z;
+    };
+
+    std::vector<ClusterRange> m_light_ranges;
+    std::vector<uint32_t> m_cluster_cursors;
+
+    std::unique_ptr<UniformBuffer> m_light_uniform_buffer;
+
+    GLuint m_clusters_buffer = 0;
+    GLuint m_clusters_texture = 0;
+    GLuint m_indices_buffer = 0;
+    GLuint m_indices_texture = 0;
+
+    bool m_overflow_reported = false;
+};
+
+}
@@ -6,7 +6,8 @@ namespace engine {
 LightSourceComponent::LightSourceComponent(uint32_t id, const std::string& name, uint32_t owner_node, uint32_t owner_scene) :
     Component(id, name, owner_node, owner_scene),
     m_color(glm::vec3(1.0f, 1.0f, 1.0f)),
-    m_intensity(1.0f)
+    m_intensity(1.0f),
+    m_radius(DEFAULT_RADIUS)
 {
 }
 
@@ -46,6 +47,7 @@ auto LightSourceComponent::clone(uint32_t owner_node_id) const -> std::unique_pt
 
     clone_component->setColor(m_color);
     clone_component->setIntensity(m_intensity);
+    clone_component->setRadius(m_radius);
 
     return clone_component;
 }
@@ -60,6 +62,11 @@ void LightSourceComponent::setIntensity(float intensity)
     m_intensity = intensity;
 }
 
+void LightSourceComponent::setRadius(float radius)
+{
+    m_radius = radius;
+}
+
 auto LightSourceComponent::color() const -> glm::vec3
 {
     return m_color;
@@ -70,4 +77,9 @@ auto LightSourceComponent::intensity() const -> float
     return m_intensity;
 }
 
+auto LightSourceComponent::radius() const -> float
+{
+    return m_radius;
+}
+
 }
\ No newline at end of file
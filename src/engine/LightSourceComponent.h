@@ -25,13 +25,18 @@ public:
 
     void setColor(const glm::vec3& color);
     void setIntensity(float intensity);
+    void setRadius(float radius);
 
     auto color() const -> glm::vec3;
     auto intensity() const -> float;
+    auto radius() const -> float;
 
 private:
     glm::vec3 m_color;
     float m_intensity;
+    float m_radius;
+
+    constexpr static float DEFAULT_RADIUS = 10.0f;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "LodSelection.h"
+#include "MeshStore.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace engine {
+
+auto selectLod(std::span<const float> errors, float pixels_per_unit, uint32_t current, const LodSettings& settings) -> uint32_t
+{
+    if (errors.empty() || settings.pixel_error <= 0.0f) {
+        return 0;
+    }
+
+    // errors grow with the level, so the first one over the limit ends the search
+    auto coarsest = [&errors, pixels_per_unit](float limit) {
+        uint32_t level = 0;
+        while (level + 1 < errors.size() && errors[level + 1] * pixels_per_unit <= limit) {
+            ++level;
+        }
+        return level;
+    };
+
+    const uint32_t level = coarsest(settings.pixel_error);
+    if (current >= errors.size() || level <= current) {
+        return level;
+    }
+
+    return std::max(current, coarsest(settings.pixel_error * (1.0f - settings.hysteresis)));
+}
+
+auto projectedPixelsPerUnit(const glm::mat4& projection, float viewport_height, float distance) -> float
+{
+    const float scale = projection[1][1] * viewport_height * 0.5f;
+
+    // orthographic projections keep the size whatever the distance
+    if (projection[2][3] == 0.0f) {
+        return scale;
+    }
+
+    return scale / std::max(distance, std::numeric_limits<float>::epsilon());
+}
+
+void LodSelector::setSettings(const LodSettings& settings)
+{
+    m_settings = settings;
+}
+
+auto LodSelector::settings() const -> const LodSettings&
+{
+    return m_settings;
+}
+
+void LodSelector::beginFrame(const glm::mat4& projection, const glm::vec3& camera_position, int viewport_height)
+{
+    m_projection = projection;
+    m_camera_position = camera_position;
+    m_viewport_height = static_cast<float>(viewport_height);
+    ++m_frame;
+}
+
+auto LodSelector::select(uint32_t node_id, const MeshData& mesh, const glm::mat4& model) -> uint32_t
+{
+    if (mesh.lods.empty() || m_settings.pixel_error <= 0.0f) {
+        return 0;
+    }
+
+    // errors are in object space, the largest axis scale bounds them in world space
+    const float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+    const auto center = glm::vec3(model * glm::vec4(mesh.sphere_center, 1.0f));
+    const float distance = glm::length(center - m_camera_position) - mesh.sphere_radius * scale;
+
+    m_errors.clear();
+    m_errors.push_back(0.0f);
+    for (const auto& lod : mesh.lods) {
+        m_errors.push_back(lod.error);
+    }
+
+    auto& node = m_levels.try_emplace(node_id, NodeLod{ NO_LOD, m_frame }).first->second;
+
+    // from inside the sphere any level may be right in front of the camera
+    const uint32_t level = distance <= 0.0f
+        ? 0
+        : selectLod(m_errors, projectedPixelsPerUnit(m_projection, m_viewport_height, distance) * scale, node.level, m_settings);
+
+    node.level = level;
+    node.frame = m_frame;
+    return level;
+}
+
+void LodSelector::endFrame()
+{
+    std::erase_if(m_levels, [this](const auto& entry) {
+        return entry.second.frame != m_frame;
+    });
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+
+struct MeshData;
+
+struct LodSettings {
+    // how many pixels a level's error may cover on screen, 0 always draws the full meshes
+    float pixel_error = 1.0f;
+    // a coarser level is only switched to once its error is this share below pixel_error
+    float hysteresis = 0.25f;
+};
+
+constexpr uint32_t NO_LOD = std::numeric_limits<uint32_t>::max();
+
+// errors[0] belongs to the full mesh and is 0. Gives the coarsest level whose error
+// stays under the pixel error, moving coarser than current needs the hysteresis
+// margin and NO_LOD as current picks without one.
+auto selectLod(std::span<const float> errors, float pixels_per_unit, uint32_t current, const LodSettings& settings) -> uint32_t;
+
+// pixels one world unit covers at distance, the projection's vertical scale is used
+auto projectedPixelsPerUnit(const glm::mat4& projection, float viewport_height, float distance) -> float;
+
+// Chooses the level of detail a node's mesh is drawn with from the screen size of
+// the levels' errors, projected at the near side of the mesh's bounding sphere. The
+// level of every node is kept from frame to frame for the hysteresis; nodes that
+// were not drawn in a frame are forgotten. No GL is involved.
+class LodSelector final {
+public:
+    LodSelector() = default;
+    ~LodSelector() = default;
+    LodSelector(const LodSelector&) = delete;
+    LodSelector(LodSelector&&) = delete;
+    LodSelector& operator=(const LodSelector&) = delete;
+    LodSelector& operator=(LodSelector&&) = delete;
+
+    void setSettings(const LodSettings& settings);
+    auto settings() const -> const LodSettings&;
+
+    void beginFrame(const glm::mat4& projection, const glm::vec3& camera_position, int viewport_height);
+    // 0 is the mesh itself, n its lods[n - 1]
+    auto select(uint32_t node_id, const MeshData& mesh, const glm::mat4& model) -> uint32_t;
+    void endFrame();
+
+private:
+    struct NodeLod {
+        uint32_t level = 0;
+        uint64_t frame = 0;
+    };
+
+    LodSettings m_settings;
+    glm::mat4 m_projection{1.0f};
+    glm::vec3 m_camera_position{0.0f};
+    float m_viewport_height = 0.0f;
+    uint64_t m_frame = 0;
+    std::unordered_map<uint32_t, NodeLod> m_levels;
+    std::vector<float> m_errors;
+};
+
+}
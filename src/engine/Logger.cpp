@@ -3,6 +3,7 @@
 #include <iostream>
 #include <format>
 #include <chrono>
+#include <mutex>
 
 namespace engine {
 
@@ -27,6 +28,10 @@ void Logger::logImpl(Level level, const std::string& message)
         return;
     }
 
+    // the render thread logs too, lines must not interleave
+    static std::mutex mutex;
+    std::lock_guard lock(mutex);
+
     switch (level) {
         case Level::INFO:
             std::cout << timestamp() << " [INFO] " << message << std::endl;
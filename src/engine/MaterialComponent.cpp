@@ -6,6 +6,8 @@
 #include "Shader.h"
 #include "Utils.h"
 
+#include <span>
+
 namespace engine {
 
 MaterialComponent::MaterialComponent(uint32_t id, const std::string& name, uint32_t owner_node, uint32_t owner_scene) :
@@ -54,6 +56,8 @@ auto MaterialComponent::clone(uint32_t owner_node_id) const -> std::unique_ptr<C
 
     clone_component->setShader(m_shader_id);
     clone_component->setTexture(m_texture_id);
+    clone_component->setShaderFeatures(m_shader_features);
+    clone_component->setBlendMode(m_blend_mode);
 
     return clone_component;
 }
@@ -91,6 +95,8 @@ void MaterialComponent::setTexture(uint32_t texture_id)
         m_texture_id = texture_id;
         m_dirty = true;
         setValid(true);
+        // sprites are indexed at the size of their texture
+        logChange();
     } else {
         setValid(false);
     }
@@ -103,6 +109,8 @@ void MaterialComponent::setTexture(const std::string& texture_name)
         m_texture_id = texture.value();
         m_dirty = true;
         setValid(true);
+        // sprites are indexed at the size of their texture
+        logChange();
     } else {
         setValid(false);
     }
@@ -148,5 +156,89 @@ auto MaterialComponent::textureSize() const -> std::pair<uint32_t, uint32_t>
     return {texture.value()->width(), texture.value()->height()};
 }
 
+void MaterialComponent::setShaderFeatures(const std::vector<std::string>& features)
+{
+    m_shader_features = features;
+    m_dirty = true;
+    markChanged();
+}
+
+auto MaterialComponent::shaderFeatures() const -> const std::vector<std::string>&
+{
+    return m_shader_features;
+}
+
+auto MaterialComponent::shaderVariant() const -> uint32_t
+{
+    auto ctx = context().lock();
+    if (!ctx) {
+        return 0;
+    }
+
+    uint32_t variant = ctx->shaderStore->variantMask(m_shader_id, m_shader_features);
+
+    const auto texture = ctx->textureStore->get(m_texture_id);
+    if (texture.has_value() && texture.value()->hasTransparentTexels()) {
+        static const std::string alpha_test = ALPHA_TEST_FEATURE;
+        variant |= ctx->shaderStore->variantMask(m_shader_id, std::span(&alpha_test, 1));
+    }
+
+    return variant;
+}
+
+auto MaterialComponent::blendMode() const -> BlendMode
+{
+    return m_blend_mode;
+}
+
+void MaterialComponent::setBlendMode(BlendMode blend_mode)
+{
+    m_blend_mode = blend_mode;
+    m_dirty = true;
+    markChanged();
+}
+
+auto MaterialComponent::isBlended() const -> bool
+{
+    if (m_blend_mode != BlendMode::Auto) {
+        return m_blend_mode == BlendMode::Blended;
+    }
+
+    auto ctx = context().lock();
+    if (!ctx) {
+        return false;
+    }
+
+    const auto texture = ctx->textureStore->get(m_texture_id);
+    return texture.has_value() && texture.value()->isTranslucent();
+}
+
+auto blendModeToString(MaterialComponent::BlendMode blend_mode) -> std::string
+{
+    switch (blend_mode) {
+        case MaterialComponent::BlendMode::Opaque:
+            return "opaque";
+        case MaterialComponent::BlendMode::Blended:
+            return "blended";
+        case MaterialComponent::BlendMode::Auto:
+        default:
+            return "auto";
+    }
+}
+
+auto blendModeFromString(const std::string& value) -> std::optional<MaterialComponent::BlendMode>
+{
+    if (value == "auto") {
+        return MaterialComponent::BlendMode::Auto;
+    }
+    if (value == "opaque") {
+        return MaterialComponent::BlendMode::Opaque;
+    }
+    if (value == "blended") {
+        return MaterialComponent::BlendMode::Blended;
+    }
+
+    return std::nullopt;
+}
 
 }
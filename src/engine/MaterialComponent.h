@@ -2,10 +2,25 @@
 
 #include "Component.h"
 
+#include <optional>
+#include <string>
+#include <vector>
+
 namespace engine {
 
 class MaterialComponent final : public Component {
 public:
+    // Auto blends only when the texture has translucent texels
+    enum class BlendMode {
+        Auto,
+        Opaque,
+        Blended,
+    };
+
+    // selected for textures with transparent texels, shaders declare it to compile
+    // their alpha test out of the variant opaque textures use
+    static constexpr const char* ALPHA_TEST_FEATURE = "ALPHA_TEST";
+
     explicit MaterialComponent(uint32_t id, const std::string& name, uint32_t owner_node, uint32_t owner_scene);
 
     void init() override;
@@ -34,11 +49,27 @@ public:
 
     auto textureSize() const -> std::pair<uint32_t, uint32_t>;
 
+    // defines the material wants from the shader's variants, see ShaderVariants
+    void setShaderFeatures(const std::vector<std::string>& features);
+    auto shaderFeatures() const -> const std::vector<std::string>&;
+    // the cheapest variant of the shader covering the features and the texture
+    auto shaderVariant() const -> uint32_t;
+
+    auto blendMode() const -> BlendMode;
+    void setBlendMode(BlendMode blend_mode);
+    auto isBlended() const -> bool;
+
 private:
     uint32_t m_shader_id = 0;
     uint32_t m_texture_id = 0;
+    std::vector<std::string> m_shader_features;
+
+    BlendMode m_blend_mode = BlendMode::Auto;
 
     bool m_dirty = true;
 };
 
+auto blendModeToString(MaterialComponent::BlendMode blend_mode) -> std::string;
+auto blendModeFromString(const std::string& value) -> std::optional<MaterialComponent::BlendMode>;
+
 }
\ No newline at end of file
@@ -1,69 +1,120 @@
 #include "MeshBuilder.h"
 #include "MeshStore.h"
 #include "FileSystem.h"
+#include "MeshCooker.h"
 
 #include <glad/glad.h>
 #include <rapidjson/document.h>
+#include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <cstdint>
+#include <limits>
 
 namespace engine {
 
-struct MeshConfig {
-    GLuint stride;
-    std::optional<GLuint> vertices_offset;
-    std::optional<GLuint> vertices_size;
-    std::optional<GLuint> texture_coords_offset;
-    std::optional<GLuint> texture_coords_size;
-    std::optional<GLuint> normals_offset;
-    std::optional<GLuint> normals_size;
-};
-
-auto buildMeshGL(const std::string& name,
-    const std::vector<GLfloat>& vertices,
-    const std::vector<GLuint>& indices,
-    const MeshConfig& mesh_config) -> std::unique_ptr<MeshData>
+auto extractPositions(const std::vector<GLfloat>& vertices, const MeshConfig& mesh_config) -> std::vector<glm::vec3>
 {
-    auto data = std::make_unique<MeshData>();
+    if (!mesh_config.vertices_offset.has_value() || !mesh_config.vertices_size.has_value() || mesh_config.stride == 0) {
+        return {};
+    }
 
-    data->name = name;
+    const size_t offset = mesh_config.vertices_offset.value();
+    const size_t components = std::min<size_t>(mesh_config.vertices_size.value(), 3);
+    const size_t stride = mesh_config.stride;
+
+    const size_t vertex_count = vertices.size() >= offset + components ? (vertices.size() - offset - components) / stride + 1 : 0;
 
-    glGenVertexArrays(1, &data->VAO);
-    glGenBuffers(1, &data->VBO);
-    glGenBuffers(1, &data->EBO);
+    std::vector<glm::vec3> positions(vertex_count, glm::vec3(0.0f));
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t i = 0; i < components; ++i) {
+            positions[vertex][i] = vertices[vertex * stride + offset + i];
+        }
+    }
 
-    glBindVertexArray(data->VAO);
+    return positions;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, data->VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+void computeBounds(MeshData& data, const std::vector<glm::vec3>& positions)
+{
+    if (positions.empty()) {
+        return;
+    }
 
-    if (mesh_config.vertices_size.has_value() && mesh_config.vertices_offset.has_value()) {
-        glVertexAttribPointer(0, mesh_config.vertices_size.value(), GL_FLOAT, GL_FALSE, mesh_config.stride * sizeof(GLfloat), (void*)(uintptr_t)mesh_config.vertices_offset.value());
-        glEnableVertexAttribArray(0);
+    data.aabb_min = glm::vec3(std::numeric_limits<float>::max());
+    data.aabb_max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const auto& point : positions) {
+        data.aabb_min = glm::min(data.aabb_min, point);
+        data.aabb_max = glm::max(data.aabb_max, point);
     }
 
-    if (mesh_config.texture_coords_size.has_value() && mesh_config.texture_coords_offset.has_value()) {
-        glVertexAttribPointer(1, mesh_config.texture_coords_size.value(), GL_FLOAT, GL_FALSE, mesh_config.stride * sizeof(GLfloat), (void*)(uintptr_t)mesh_config.texture_coords_offset.value());
-        glEnableVertexAttribArray(1);
+    // centered on the box, the radius is the farthest vertex which is tighter than the half diagonal
+    data.sphere_center = (data.aabb_min + data.aabb_max) * 0.5f;
+    float radius_squared = 0.0f;
+    for (const auto& point : positions) {
+        const auto delta = point - data.sphere_center;
+        radius_squared = std::max(radius_squared, glm::dot(delta, delta));
     }
+    data.sphere_radius = std::sqrt(radius_squared);
+}
 
-    if (mesh_config.normals_size.has_value() && mesh_config.normals_offset.has_value()) {
-        glVertexAttribPointer(2, mesh_config.normals_size.value(), GL_FLOAT, GL_FALSE, mesh_config.stride * sizeof(GLfloat), (void*)(uintptr_t)mesh_config.normals_offset.value());
-        glEnableVertexAttribArray(2);
+auto buildMeshGL(const std::string& name,
+    const std::vector<GLfloat>& vertices,
+    const std::vector<GLuint>& indices,
+    const MeshConfig& mesh_config,
+    const std::shared_ptr<GeometryPool>& pool) -> std::optional<std::unique_ptr<MeshData>>
+{
+    auto allocation = pool->allocate(mesh_config, vertices, indices);
+    if (!allocation.has_value()) {
+        return std::nullopt;
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data->EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    auto data = std::make_unique<MeshData>();
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    data->name = name;
+    data->pool = pool;
+    data->allocation = allocation.value();
+
+    // bounds are the only thing kept from the CPU side geometry, taken from the
+    // positions as the GPU sees them when they are quantized
+    if (mesh_config.vertices_format == VertexFormat::Float) {
+        computeBounds(*data, extractPositions(vertices, mesh_config));
+    } else {
+        computeBounds(*data, extractPositions(unpackVertices(packVertices(vertices, mesh_config), mesh_config), mesh_config));
+    }
 
     return data;
 }
 
-auto buildMesh(const std::filesystem::path& path) -> std::optional<std::unique_ptr<MeshData>>
+auto buildMeshGL(const MeshSource& source, const std::shared_ptr<GeometryPool>& pool) -> std::optional<std::unique_ptr<MeshData>>
+{
+    auto mesh = buildMeshGL(source.name, source.vertices, source.indices, source.config, pool);
+    if (!mesh.has_value()) {
+        return std::nullopt;
+    }
+
+    auto& data = mesh.value();
+    for (size_t level = 0; level < source.lods.size(); ++level) {
+        const auto& lod = source.lods[level];
+        auto lod_mesh = buildMeshGL(source.name + "_lod" + std::to_string(level + 1), lod.vertices, lod.indices, source.config, pool);
+        if (!lod_mesh.has_value()) {
+            break;
+        }
+
+        auto& lod_data = lod_mesh.value();
+        lod_data->aabb_min = data->aabb_min;
+        lod_data->aabb_max = data->aabb_max;
+        lod_data->sphere_center = data->sphere_center;
+        lod_data->sphere_radius = data->sphere_radius;
+        data->lods.push_back({ std::move(lod_data), lod.error });
+    }
+
+    return mesh;
+}
+
+auto loadMeshSource(const std::filesystem::path& path, bool use_cooked) -> std::optional<MeshSource>
 {
     auto pathVertices = path / "vertices.bin";
     auto pathIndices = path / "indices.bin";
@@ -99,6 +150,22 @@ auto buildMesh(const std::filesystem::path& path) -> std::optional<std::unique_p
     std::optional<GLuint> normals_offset;
     std::optional<GLuint> normals_size;
 
+    // "format" is optional and defaults to float, the packed 10_10_10_2 format holds at most four components
+    auto read_format = [](const auto& attribute_config, std::optional<GLuint> size) -> std::optional<VertexFormat> {
+        if (!attribute_config.HasMember("format")) {
+            return VertexFormat::Float;
+        }
+        const auto& format_value = attribute_config["format"];
+        if (!format_value.IsString()) {
+            return std::nullopt;
+        }
+        auto format = parseVertexFormat(format_value.GetString());
+        if (format == VertexFormat::Snorm10_10_10_2 && size.value_or(0) > 4) {
+            return std::nullopt;
+        }
+        return format;
+    };
+
     if (vertices_config.HasMember("offset") && vertices_config.HasMember("size")) {
         vertices_offset = vertices_config["offset"].GetUint();
         vertices_size = vertices_config["size"].GetUint();
@@ -111,7 +178,23 @@ auto buildMesh(const std::filesystem::path& path) -> std::optional<std::unique_p
         normals_offset = normals_config["offset"].GetUint();
         normals_size = normals_config["size"].GetUint();
     }
-    MeshConfig mesh_config = { stride, vertices_offset, vertices_size, texture_coords_offset, texture_coords_size, normals_offset, normals_size };
+
+    const auto vertices_format = read_format(vertices_config, vertices_size);
+    const auto texture_coords_format = read_format(texture_coords_config, texture_coords_size);
+    const auto normals_format = read_format(normals_config, normals_size);
+    if (!vertices_format.has_value() || !texture_coords_format.has_value() || !normals_format.has_value()) {
+        return std::nullopt;
+    }
+
+    MeshConfig mesh_config = { stride, vertices_offset, vertices_size, texture_coords_offset, texture_coords_size, normals_offset, normals_size,
+        vertices_format.value(), texture_coords_format.value(), normals_format.value() };
+
+    if (use_cooked && hasCookedMesh(path)) {
+        MeshSource cooked{ path.stem().string(), {}, {}, mesh_config, {} };
+        if (loadCookedMesh(cookedMeshPath(path), cooked)) {
+            return cooked;
+        }
+    }
 
     auto vertices_file = FileSystem::file(pathVertices, std::ios::in | std::ios::binary);
     auto vertices_data = vertices_file.readBinary();
@@ -131,7 +214,17 @@ auto buildMesh(const std::filesystem::path& path) -> std::optional<std::unique_p
     std::vector<GLuint> indices_data_gl(indices_data.size() / sizeof(GLuint), 0);
     std::memcpy(indices_data_gl.data(), indices_data.data(), indices_data.size());
 
-    return buildMeshGL(path.stem().string(), vertices_data_gl, indices_data_gl, mesh_config);
+    return MeshSource{ path.stem().string(), std::move(vertices_data_gl), std::move(indices_data_gl), mesh_config, {} };
+}
+
+auto buildMesh(const std::filesystem::path& path, const std::shared_ptr<GeometryPool>& pool) -> std::optional<std::unique_ptr<MeshData>>
+{
+    auto source = loadMeshSource(path);
+    if (!source.has_value()) {
+        return std::nullopt;
+    }
+
+    return buildMeshGL(source.value(), pool);
 }
 
 }
@@ -1,13 +1,51 @@
 #pragma once
 
+#include "GeometryPool.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace engine {
 
 struct MeshData;
+class GeometryPool;
+
+// a simplified version of a mesh in the layout of its config, error is how far it
+// strays from the full mesh in object space units
+struct MeshLodSource {
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    float error = 0.0f;
+};
+
+// contents of a mesh directory, loading them needs no GL context
+struct MeshSource {
+    std::string name;
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    MeshConfig config;
+    // the LOD chain of the cooker, coarsest last, empty for meshes that were not cooked
+    std::vector<MeshLodSource> lods;
+};
+
+// reads the cooked vertices and indices when they are up to date, see MeshCooker
+auto loadMeshSource(const std::filesystem::path& path, bool use_cooked = true) -> std::optional<MeshSource>;
+auto buildMesh(const std::filesystem::path& path, const std::shared_ptr<GeometryPool>& pool) -> std::optional<std::unique_ptr<MeshData>>;
+// the mesh and its LOD levels, a level that fails to upload ends the chain there
+auto buildMeshGL(const MeshSource& source, const std::shared_ptr<GeometryPool>& pool) -> std::optional<std::unique_ptr<MeshData>>;
+// uploads into the pool, the CPU vertices and indices can be dropped afterwards
+auto buildMeshGL(const std::string& name,
+    const std::vector<GLfloat>& vertices,
+    const std::vector<GLuint>& indices,
+    const MeshConfig& mesh_config,
+    const std::shared_ptr<GeometryPool>& pool) -> std::optional<std::unique_ptr<MeshData>>;
 
-auto buildMesh(const std::filesystem::path& path) -> std::optional<std::unique_ptr<MeshData>>;
+auto extractPositions(const std::vector<GLfloat>& vertices, const MeshConfig& mesh_config) -> std::vector<glm::vec3>;
 
 }
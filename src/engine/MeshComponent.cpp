@@ -65,7 +65,7 @@ void MeshComponent::bind() const
     auto mesh = ctx->meshStore->get(m_id);
 
     if (mesh.has_value()) {
-        mesh.value()->bind();
+        mesh.value()->bind(*ctx->glState);
     }
 }
 
@@ -79,7 +79,7 @@ void MeshComponent::unbind() const
     auto mesh =ctx->meshStore->get(m_id);
 
     if (mesh.has_value()) {
-        mesh.value()->unbind();
+        mesh.value()->unbind(*ctx->glState);
     }
 }
 
@@ -87,6 +87,8 @@ void MeshComponent::setMesh(uint32_t meshId)
 {
     m_id = meshId;
     markDirty();
+    markChanged();
+    logChange();
 }
 
 void MeshComponent::setMesh(const std::string& mesh_name)
@@ -101,6 +103,8 @@ void MeshComponent::setMesh(const std::string& mesh_name)
     if (mesh.has_value()) {
         m_id = mesh.value();
         markDirty();
+        markChanged();
+        logChange();
     }
 }
 
@@ -0,0 +1,590 @@
+#include "MeshCooker.h"
+#include "FileSystem.h"
+#include "Logger.h"
+#include "MeshBuilder.h"
+#include "MeshSimplifier.h"
+#include "ResourcePackage.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace engine {
+
+namespace {
+
+auto packFormats(const MeshConfig& config) -> uint32_t
+{
+    return static_cast<uint32_t>(config.vertices_format) |
+           static_cast<uint32_t>(config.texture_coords_format) << 8 |
+           static_cast<uint32_t>(config.normals_format) << 16;
+}
+
+constexpr uint32_t COOKED_MAGIC = 0x48534D43; // "CMSH"
+constexpr uint32_t COOKED_VERSION = 3;
+
+// vertices are stored packed to the formats of the config, a config that changed the formats invalidates the file
+struct CookedHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t stride;
+    uint32_t formats;
+    uint32_t vertex_size;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t index_size;
+    // of LOD levels, how far they stray from the full mesh, 0 for the mesh itself
+    float error;
+};
+
+auto writeCookedMesh(const MeshConfig& config, std::span<const GLfloat> vertices, std::span<const GLuint> indices, float error,
+                     const std::filesystem::path& path) -> bool
+{
+    const auto stride = config.stride;
+    const auto vertex_count = static_cast<uint32_t>(stride > 0 ? vertices.size() / stride : 0);
+    const uint32_t index_size = vertex_count <= std::numeric_limits<GLushort>::max() + 1u ? sizeof(GLushort) : sizeof(GLuint);
+
+    const auto vertex_size = static_cast<uint32_t>(packedVertexSize(config));
+    const CookedHeader header = { COOKED_MAGIC, COOKED_VERSION, stride, packFormats(config), vertex_size,
+        vertex_count, static_cast<uint32_t>(indices.size()), index_size, error };
+
+    const auto packed = packVertices(vertices.first(static_cast<size_t>(vertex_count) * stride), config);
+    const size_t vertex_bytes = packed.size();
+    std::vector<uint8_t> bytes(sizeof(header) + vertex_bytes + indices.size() * index_size);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    std::memcpy(bytes.data() + sizeof(header), packed.data(), vertex_bytes);
+
+    auto* index_data = bytes.data() + sizeof(header) + vertex_bytes;
+    if (index_size == sizeof(GLushort)) {
+        const std::vector<GLushort> short_indices(indices.begin(), indices.end());
+        std::memcpy(index_data, short_indices.data(), short_indices.size() * sizeof(GLushort));
+    } else {
+        std::memcpy(index_data, indices.data(), indices.size() * sizeof(GLuint));
+    }
+
+    return FileSystem::file(path, std::ios::out | std::ios::binary | std::ios::trunc).writeBinary(bytes);
+}
+
+auto readCookedMesh(const std::filesystem::path& path, const MeshConfig& config, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices,
+                    float& error) -> bool
+{
+    const auto bytes = FileSystem::file(path, std::ios::in | std::ios::binary).readBinary();
+
+    CookedHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    const size_t vertex_bytes = static_cast<size_t>(header.vertex_count) * header.vertex_size;
+    const size_t index_bytes = static_cast<size_t>(header.index_count) * header.index_size;
+    if (header.magic != COOKED_MAGIC || header.version != COOKED_VERSION || header.stride != config.stride ||
+        header.formats != packFormats(config) || header.vertex_size != packedVertexSize(config) ||
+        (header.index_size != sizeof(GLushort) && header.index_size != sizeof(GLuint)) ||
+        bytes.size() != sizeof(header) + vertex_bytes + index_bytes) {
+        Logger::warning("loadCookedMesh: {} does not match its mesh, using the exported data", path.string());
+        return false;
+    }
+
+    const auto* vertex_data = reinterpret_cast<const std::byte*>(bytes.data() + sizeof(header));
+    vertices = unpackVertices(std::span(vertex_data, vertex_bytes), config);
+
+    const auto* index_data = bytes.data() + sizeof(header) + vertex_bytes;
+    indices.resize(header.index_count);
+    if (header.index_size == sizeof(GLushort)) {
+        std::vector<GLushort> short_indices(header.index_count);
+        std::memcpy(short_indices.data(), index_data, index_bytes);
+        std::ranges::copy(short_indices, indices.begin());
+    } else {
+        std::memcpy(indices.data(), index_data, index_bytes);
+    }
+
+    error = header.error;
+    return true;
+}
+
+// the cache the ordering optimizes for, larger than the one reported on so it still helps on big caches
+constexpr uint32_t OPTIMIZE_CACHE_SIZE = 32;
+constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+
+auto hashVertex(const GLfloat* vertex, size_t stride) -> uint64_t
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(vertex);
+    for (size_t i = 0; i < stride * sizeof(GLfloat); ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// exporters write one vertex per face corner, identical ones collapse into one
+auto deduplicateVertices(MeshSource& source) -> void
+{
+    const size_t stride = source.config.stride;
+    const size_t vertex_count = source.vertices.size() / stride;
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+    std::vector<uint32_t> remap(vertex_count);
+    std::vector<GLfloat> vertices;
+    vertices.reserve(source.vertices.size());
+
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        const GLfloat* data = source.vertices.data() + vertex * stride;
+        auto& bucket = buckets[hashVertex(data, stride)];
+
+        auto it = std::ranges::find_if(bucket, [&](uint32_t unique) {
+            return std::memcmp(vertices.data() + unique * stride, data, stride * sizeof(GLfloat)) == 0;
+        });
+        if (it != bucket.end()) {
+            remap[vertex] = *it;
+            continue;
+        }
+
+        const auto unique = static_cast<uint32_t>(vertices.size() / stride);
+        vertices.insert(vertices.end(), data, data + stride);
+        bucket.push_back(unique);
+        remap[vertex] = unique;
+    }
+
+    for (auto& index : source.indices) {
+        index = remap[index];
+    }
+    source.vertices = std::move(vertices);
+}
+
+auto vertexScore(int32_t cache_position, uint32_t remaining_triangles) -> float
+{
+    if (remaining_triangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        // the last triangle's vertices score the same whatever their order, so it is not favoured
+        if (cache_position < 3) {
+            score = 0.75f;
+        } else {
+            const float scale = 1.0f / static_cast<float>(OPTIMIZE_CACHE_SIZE - 3);
+            score = std::pow(1.0f - static_cast<float>(cache_position - 3) * scale, 1.5f);
+        }
+    }
+
+    // vertices with few triangles left are finished first, so they leave the working set
+    score += 2.0f / std::sqrt(static_cast<float>(remaining_triangles));
+    return score;
+}
+
+// Forsyth, "Linear-speed vertex cache optimisation"
+auto optimizeVertexCache(const std::vector<GLuint>& indices, uint32_t vertex_count) -> std::vector<GLuint>
+{
+    const size_t triangle_count = indices.size() / 3;
+
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (auto index : indices) {
+        ++remaining[index];
+    }
+
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        offsets[vertex + 1] = offsets[vertex] + remaining[vertex];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t triangle = 0; triangle < triangle_count; ++triangle) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            adjacency[filled[indices[triangle * 3 + corner]]++] = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    std::vector<int32_t> cache_position(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        vertex_scores[vertex] = vertexScore(-1, remaining[vertex]);
+    }
+
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    for (size_t triangle = 0; triangle < triangle_count; ++triangle) {
+        triangle_scores[triangle] = vertex_scores[indices[triangle * 3]] + vertex_scores[indices[triangle * 3 + 1]] + vertex_scores[indices[triangle * 3 + 2]];
+    }
+
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next_cache;
+    cache.reserve(OPTIMIZE_CACHE_SIZE + 3);
+    next_cache.reserve(OPTIMIZE_CACHE_SIZE + 3);
+
+    uint32_t best = UNUSED;
+    size_t scan = 0;
+
+    for (size_t emitted_count = 0; emitted_count < triangle_count; ++emitted_count) {
+        if (best == UNUSED) {
+            // nothing in the cache has triangles left, start over at the best remaining one
+            float best_score = -1.0f;
+            for (size_t triangle = scan; triangle < triangle_count; ++triangle) {
+                if (!emitted[triangle] && triangle_scores[triangle] > best_score) {
+                    best_score = triangle_scores[triangle];
+                    best = static_cast<uint32_t>(triangle);
+                }
+            }
+            while (scan < triangle_count && emitted[scan]) {
+                ++scan;
+            }
+        }
+
+        emitted[best] = true;
+
+        next_cache.clear();
+        for (size_t corner = 0; corner < 3; ++corner) {
+            const auto vertex = indices[best * 3 + corner];
+            result.push_back(vertex);
+            next_cache.push_back(vertex);
+
+            // the triangle leaves the vertex's list of remaining triangles
+            auto begin = adjacency.begin() + offsets[vertex];
+            auto end = begin + remaining[vertex];
+            auto it = std::find(begin, end, best);
+            std::iter_swap(it, end - 1);
+            --remaining[vertex];
+        }
+
+        for (auto vertex : cache) {
+            if (std::ranges::find(next_cache, vertex) == next_cache.end()) {
+                next_cache.push_back(vertex);
+            }
+        }
+
+        for (size_t position = 0; position < next_cache.size(); ++position) {
+            const auto vertex = next_cache[position];
+            cache_position[vertex] = position < OPTIMIZE_CACHE_SIZE ? static_cast<int32_t>(position) : -1;
+            vertex_scores[vertex] = vertexScore(cache_position[vertex], remaining[vertex]);
+        }
+
+        // only triangles of the cached and just evicted vertices changed their scores
+        best = UNUSED;
+        float best_score = -1.0f;
+        for (auto vertex : next_cache) {
+            for (uint32_t i = 0; i < remaining[vertex]; ++i) {
+                const auto triangle = adjacency[offsets[vertex] + i];
+                const float score = vertex_scores[indices[triangle * 3]] + vertex_scores[indices[triangle * 3 + 1]] + vertex_scores[indices[triangle * 3 + 2]];
+                triangle_scores[triangle] = score;
+                if (score > best_score) {
+                    best_score = score;
+                    best = triangle;
+                }
+            }
+        }
+
+        if (next_cache.size() > OPTIMIZE_CACHE_SIZE) {
+            next_cache.resize(OPTIMIZE_CACHE_SIZE);
+        }
+        cache.swap(next_cache);
+    }
+
+    return result;
+}
+
+// Triangles are split where the cache ordering restarted, a triangle missing the cache with
+// all three vertices, so reordering the runs costs little cache efficiency. Runs facing away
+// from the mesh center go first: seen from outside they are the front ones.
+auto optimizeOverdraw(const std::vector<GLuint>& indices, const std::vector<glm::vec3>& positions) -> std::vector<GLuint>
+{
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0 || positions.empty()) {
+        return indices;
+    }
+
+    std::vector<size_t> cluster_starts;
+    std::vector<uint32_t> cache_time(positions.size(), 0);
+    uint32_t time = VERTEX_CACHE_SIZE + 1;
+    for (size_t triangle = 0; triangle < triangle_count; ++triangle) {
+        uint32_t misses = 0;
+        for (size_t corner = 0; corner < 3; ++corner) {
+            const auto vertex = indices[triangle * 3 + corner];
+            if (time - cache_time[vertex] > VERTEX_CACHE_SIZE) {
+                cache_time[vertex] = time++;
+                ++misses;
+            }
+        }
+
+        if (misses == 3 || triangle == 0) {
+            cluster_starts.push_back(triangle);
+        }
+    }
+    cluster_starts.push_back(triangle_count);
+
+    glm::vec3 mesh_center(0.0f);
+    float mesh_area = 0.0f;
+
+    struct Cluster {
+        size_t begin;
+        size_t end;
+        float sort_key;
+    };
+
+    std::vector<Cluster> clusters;
+    std::vector<glm::vec3> centers;
+    std::vector<glm::vec3> normals;
+    for (size_t i = 0; i + 1 < cluster_starts.size(); ++i) {
+        glm::vec3 center(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+
+        for (size_t triangle = cluster_starts[i]; triangle < cluster_starts[i + 1]; ++triangle) {
+            const auto& a = positions[indices[triangle * 3]];
+            const auto& b = positions[indices[triangle * 3 + 1]];
+            const auto& c = positions[indices[triangle * 3 + 2]];
+
+            const auto cross = glm::cross(b - a, c - a);
+            const float triangle_area = glm::length(cross);
+            center += (a + b + c) * (triangle_area / 3.0f);
+            normal += cross;
+            area += triangle_area;
+        }
+
+        mesh_center += center;
+        mesh_area += area;
+
+        centers.push_back(area > 0.0f ? center / area : center);
+        normals.push_back(glm::length(normal) > 0.0f ? glm::normalize(normal) : normal);
+        clusters.push_back({ cluster_starts[i], cluster_starts[i + 1], 0.0f });
+    }
+
+    if (mesh_area > 0.0f) {
+        mesh_center /= mesh_area;
+    }
+
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        clusters[i].sort_key = glm::dot(centers[i] - mesh_center, normals[i]);
+    }
+
+    std::ranges::stable_sort(clusters, [](const Cluster& a, const Cluster& b) {
+        return a.sort_key > b.sort_key;
+    });
+
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    for (const auto& cluster : clusters) {
+        result.insert(result.end(), indices.begin() + static_cast<std::ptrdiff_t>(cluster.begin * 3),
+                      indices.begin() + static_cast<std::ptrdiff_t>(cluster.end * 3));
+    }
+
+    return result;
+}
+
+// vertices in the order the triangles first reference them, unreferenced ones are dropped
+auto optimizeVertexFetch(MeshSource& source) -> void
+{
+    const size_t stride = source.config.stride;
+    const size_t vertex_count = source.vertices.size() / stride;
+
+    std::vector<uint32_t> remap(vertex_count, UNUSED);
+    std::vector<GLfloat> vertices;
+    vertices.reserve(source.vertices.size());
+
+    for (auto& index : source.indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<uint32_t>(vertices.size() / stride);
+            vertices.insert(vertices.end(), source.vertices.begin() + static_cast<std::ptrdiff_t>(index * stride),
+                            source.vertices.begin() + static_cast<std::ptrdiff_t>((index + 1) * stride));
+        }
+        index = remap[index];
+    }
+
+    source.vertices = std::move(vertices);
+}
+
+}
+
+auto vertexCacheMissRatio(std::span<const GLuint> indices, uint32_t vertex_count, uint32_t cache_size) -> float
+{
+    if (indices.size() < 3) {
+        return 0.0f;
+    }
+
+    std::vector<uint32_t> cache_time(vertex_count, 0);
+    uint32_t time = cache_size + 1;
+    uint32_t misses = 0;
+    for (auto index : indices) {
+        if (time - cache_time[index] > cache_size) {
+            cache_time[index] = time++;
+            ++misses;
+        }
+    }
+
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+auto optimizeMesh(MeshSource& source) -> MeshOptimizeStats
+{
+    MeshOptimizeStats stats;
+
+    const size_t stride = source.config.stride;
+    if (stride == 0 || source.indices.size() < 3) {
+        return stats;
+    }
+
+    const auto vertex_count = static_cast<uint32_t>(source.vertices.size() / stride);
+    source.indices.resize(source.indices.size() - source.indices.size() % 3);
+    if (std::ranges::any_of(source.indices, [vertex_count](GLuint index) { return index >= vertex_count; })) {
+        Logger::warning("optimizeMesh: {} indexes past its {} vertices, left as is", source.name, vertex_count);
+        return stats;
+    }
+
+    stats.vertices_before = vertex_count;
+    stats.acmr_before = vertexCacheMissRatio(source.indices, vertex_count, VERTEX_CACHE_SIZE);
+
+    deduplicateVertices(source);
+    const auto unique_count = static_cast<uint32_t>(source.vertices.size() / stride);
+
+    source.indices = optimizeVertexCache(source.indices, unique_count);
+    source.indices = optimizeOverdraw(source.indices, extractPositions(source.vertices, source.config));
+    optimizeVertexFetch(source);
+
+    stats.vertices_after = static_cast<uint32_t>(source.vertices.size() / stride);
+    stats.acmr_after = vertexCacheMissRatio(source.indices, stats.vertices_after, VERTEX_CACHE_SIZE);
+
+    return stats;
+}
+
+auto cookedMeshPath(const std::filesystem::path& mesh_directory) -> std::filesystem::path
+{
+    return mesh_directory / "cooked.bin";
+}
+
+auto cookedLodPath(const std::filesystem::path& mesh_directory, uint32_t level) -> std::filesystem::path
+{
+    return mesh_directory / ("lod" + std::to_string(level) + ".bin");
+}
+
+auto hasCookedMesh(const std::filesystem::path& mesh_directory) -> bool
+{
+    std::error_code error;
+    const auto cooked_time = std::filesystem::last_write_time(cookedMeshPath(mesh_directory), error);
+    if (error) {
+        return false;
+    }
+
+    for (const auto* name : { "vertices.bin", "indices.bin", "config.json" }) {
+        const auto source_time = std::filesystem::last_write_time(mesh_directory / name, error);
+        if (error || source_time > cooked_time) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto saveCookedMesh(const MeshSource& source, const std::filesystem::path& path) -> bool
+{
+    if (!writeCookedMesh(source.config, source.vertices, source.indices, 0.0f, path)) {
+        return false;
+    }
+
+    const auto directory = path.parent_path();
+    for (size_t level = 0; level < source.lods.size(); ++level) {
+        const auto& lod = source.lods[level];
+        if (!writeCookedMesh(source.config, lod.vertices, lod.indices, lod.error, cookedLodPath(directory, static_cast<uint32_t>(level + 1)))) {
+            return false;
+        }
+    }
+
+    // levels of an earlier cook that this one did not reach
+    std::error_code error;
+    auto stale_level = static_cast<uint32_t>(source.lods.size() + 1);
+    while (std::filesystem::remove(cookedLodPath(directory, stale_level), error)) {
+        ++stale_level;
+    }
+
+    return true;
+}
+
+auto loadCookedMesh(const std::filesystem::path& path, MeshSource& source) -> bool
+{
+    float error = 0.0f;
+    if (!readCookedMesh(path, source.config, source.vertices, source.indices, error)) {
+        return false;
+    }
+
+    source.lods.clear();
+    const auto directory = path.parent_path();
+    for (uint32_t level = 1; FileSystem::exists(cookedLodPath(directory, level)); ++level) {
+        MeshLodSource lod;
+        if (!readCookedMesh(cookedLodPath(directory, level), source.config, lod.vertices, lod.indices, lod.error)) {
+            break;
+        }
+        source.lods.push_back(std::move(lod));
+    }
+
+    return true;
+}
+
+auto cookPackageMeshes(const ResourcePackage& package) -> MeshCookStats
+{
+    MeshCookStats stats;
+
+    for (const auto& meshInfo : package.meshes) {
+        auto source = loadMeshSource(meshInfo.path, false);
+        if (!source.has_value()) {
+            Logger::warning("cookPackageMeshes: can not read {}", meshInfo.path.string());
+            ++stats.failed;
+            continue;
+        }
+
+        const size_t bytes_before = source->vertices.size() * sizeof(GLfloat) + source->indices.size() * sizeof(GLuint);
+
+        // quantized before optimizing, so vertices that only differ below the format's precision merge
+        const auto quantized = unpackVertices(packVertices(source->vertices, source->config), source->config);
+        float max_error = 0.0f;
+        for (size_t i = 0; i < std::min(quantized.size(), source->vertices.size()); ++i) {
+            max_error = std::max(max_error, std::abs(quantized[i] - source->vertices[i]));
+        }
+        source->vertices = quantized;
+
+        const auto optimized = optimizeMesh(source.value());
+        source->lods = buildLodChain(source.value());
+
+        const auto cooked_path = cookedMeshPath(meshInfo.path);
+        if (!saveCookedMesh(source.value(), cooked_path)) {
+            Logger::warning("cookPackageMeshes: can not write {}", cooked_path.string());
+            ++stats.failed;
+            continue;
+        }
+
+        std::error_code error;
+        const size_t bytes_after = std::filesystem::file_size(cooked_path, error);
+
+        Logger::info("cookPackageMeshes: {} vertices {} -> {}, ACMR {:.3f} -> {:.3f}, {} -> {} bytes, vertex size {} bytes, max quantization error {:.6f}",
+                     meshInfo.path.string(), optimized.vertices_before, optimized.vertices_after,
+                     optimized.acmr_before, optimized.acmr_after, bytes_before, bytes_after,
+                     packedVertexSize(source->config), max_error);
+
+        for (size_t level = 0; level < source->lods.size(); ++level) {
+            const auto& lod = source->lods[level];
+            const size_t lod_bytes = std::filesystem::file_size(cookedLodPath(meshInfo.path, static_cast<uint32_t>(level + 1)), error);
+            Logger::info("cookPackageMeshes: {} LOD {}: {} triangles, {} vertices, error {:.5f}, {} bytes",
+                         meshInfo.path.string(), level + 1, lod.indices.size() / 3, lod.vertices.size() / source->config.stride, lod.error, lod_bytes);
+            stats.lod_bytes += lod_bytes;
+        }
+
+        ++stats.meshes;
+        stats.lod_levels += static_cast<uint32_t>(source->lods.size());
+        stats.bytes_before += bytes_before;
+        stats.bytes_after += bytes_after;
+    }
+
+    Logger::info("cookPackageMeshes: package {}, {} meshes cooked, {} failed, {} -> {} bytes, {} LOD levels in {} bytes",
+                 package.name, stats.meshes, stats.failed, stats.bytes_before, stats.bytes_after, stats.lod_levels, stats.lod_bytes);
+
+    return stats;
+}
+
+}
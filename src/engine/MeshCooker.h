@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace engine {
+
+struct MeshConfig;
+struct MeshSource;
+struct ResourcePackage;
+
+struct MeshOptimizeStats {
+    uint32_t vertices_before = 0;
+    uint32_t vertices_after = 0;
+    // average transformed vertices per triangle with a FIFO cache of VERTEX_CACHE_SIZE entries
+    float acmr_before = 0.0f;
+    float acmr_after = 0.0f;
+};
+
+struct MeshCookStats {
+    uint32_t meshes = 0;
+    uint32_t failed = 0;
+    size_t bytes_before = 0;
+    size_t bytes_after = 0;
+    uint32_t lod_levels = 0;
+    size_t lod_bytes = 0;
+};
+
+// the cache the ACMR is reported for, smaller than what current GPUs have
+constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+// Merges bitwise identical vertices, orders triangles for the post-transform vertex
+// cache (Forsyth's greedy scoring), then orders the runs the cache ordering starts
+// afresh by how much they face outwards so front faces tend to be drawn first, and
+// finally renumbers vertices in the order the triangles first use them.
+auto optimizeMesh(MeshSource& source) -> MeshOptimizeStats;
+
+auto vertexCacheMissRatio(std::span<const GLuint> indices, uint32_t vertex_count, uint32_t cache_size) -> float;
+
+// "meshes/cube" is cooked into "meshes/cube/cooked.bin"
+auto cookedMeshPath(const std::filesystem::path& mesh_directory) -> std::filesystem::path;
+// "meshes/cube" keeps its LOD levels in "meshes/cube/lod1.bin", "lod2.bin", ... next to the exported data
+auto cookedLodPath(const std::filesystem::path& mesh_directory, uint32_t level) -> std::filesystem::path;
+// a cooked file at least as new as the vertices, indices and config it was made from
+auto hasCookedMesh(const std::filesystem::path& mesh_directory) -> bool;
+
+// vertices are written packed to the formats of the config, indices with 16 bits when the
+// vertex count allows; the LOD levels of source go next to it, stale ones are removed
+auto saveCookedMesh(const MeshSource& source, const std::filesystem::path& path) -> bool;
+// fills the vertices, indices and LOD levels of source, its config comes from config.json
+auto loadCookedMesh(const std::filesystem::path& path, MeshSource& source) -> bool;
+
+// optimizes every mesh of the package, builds its LOD chain and cooks both
+auto cookPackageMeshes(const ResourcePackage& package) -> MeshCookStats;
+
+}
@@ -0,0 +1,387 @@
+#include "MeshSimplifier.h"
+#include "Logger.h"
+#include "MeshBuilder.h"
+#include "MeshCooker.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+
+namespace engine {
+
+namespace {
+
+// a level that got stuck short of its target is kept when it still has this share of the previous triangles removed
+constexpr double MIN_STALLED_REDUCTION = 0.1;
+
+// symmetric 4x4 matrix of summed plane equations, error(p) = p^T Q p is the sum of
+// the squared distances of p to the planes
+struct Quadric {
+    double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+    double b2 = 0.0, bc = 0.0, bd = 0.0;
+    double c2 = 0.0, cd = 0.0;
+    double d2 = 0.0;
+
+    static auto plane(const glm::dvec3& normal, double d) -> Quadric
+    {
+        return { normal.x * normal.x, normal.x * normal.y, normal.x * normal.z, normal.x * d,
+                 normal.y * normal.y, normal.y * normal.z, normal.y * d,
+                 normal.z * normal.z, normal.z * d,
+                 d * d };
+    }
+
+    void add(const Quadric& other)
+    {
+        a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+        b2 += other.b2; bc += other.bc; bd += other.bd;
+        c2 += other.c2; cd += other.cd;
+        d2 += other.d2;
+    }
+
+    auto error(const glm::dvec3& p) const -> double
+    {
+        return a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x +
+               b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y +
+               c2 * p.z * p.z + 2.0 * cd * p.z +
+               d2;
+    }
+};
+
+struct Collapse {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+    // the versions of both vertices when the cost was computed, a collapse into either makes it stale
+    uint32_t from_version;
+    uint32_t to_version;
+
+    bool operator>(const Collapse& other) const
+    {
+        return std::tie(cost, from, to) > std::tie(other.cost, other.from, other.to);
+    }
+};
+
+class EdgeCollapser final {
+public:
+    EdgeCollapser(const MeshSource& source, const std::vector<glm::vec3>& positions) :
+        m_triangles(source.indices.begin(), source.indices.end() - static_cast<std::ptrdiff_t>(source.indices.size() % 3)),
+        m_positions(positions.begin(), positions.end()),
+        m_quadrics(positions.size()),
+        m_locked(positions.size(), false),
+        m_removed(positions.size(), false),
+        m_versions(positions.size(), 0),
+        m_vertex_triangles(positions.size()),
+        m_alive(m_triangles.size() / 3, true)
+    {
+        for (size_t triangle = 0; triangle < m_alive.size(); ++triangle) {
+            const auto* corners = &m_triangles[triangle * 3];
+            if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0]) {
+                m_alive[triangle] = false;
+                continue;
+            }
+
+            ++m_alive_count;
+            for (size_t i = 0; i < 3; ++i) {
+                m_vertex_triangles[corners[i]].push_back(static_cast<uint32_t>(triangle));
+            }
+
+            const auto normal = glm::cross(m_positions[corners[1]] - m_positions[corners[0]], m_positions[corners[2]] - m_positions[corners[0]]);
+            const double length = glm::length(normal);
+            if (length == 0.0) {
+                continue;
+            }
+
+            const auto unit = normal / length;
+            const auto plane = Quadric::plane(unit, -glm::dot(unit, m_positions[corners[0]]));
+            for (size_t i = 0; i < 3; ++i) {
+                m_quadrics[corners[i]].add(plane);
+            }
+        }
+
+        lockSeamsAndBorders(positions);
+
+        for (uint32_t vertex = 0; vertex < m_positions.size(); ++vertex) {
+            for (auto neighbour : neighbours(vertex)) {
+                if (neighbour > vertex) {
+                    queueEdge(vertex, neighbour);
+                }
+            }
+        }
+    }
+
+    // false once no collapse is left
+    auto simplifyTo(size_t target_index_count) -> bool
+    {
+        while (m_alive_count * 3 > target_index_count) {
+            if (m_queue.empty()) {
+                return false;
+            }
+
+            const auto collapse = m_queue.top();
+            m_queue.pop();
+
+            if (m_removed[collapse.from] || m_removed[collapse.to] ||
+                m_versions[collapse.from] != collapse.from_version || m_versions[collapse.to] != collapse.to_version ||
+                !canCollapse(collapse.from, collapse.to)) {
+                continue;
+            }
+
+            apply(collapse);
+        }
+
+        return true;
+    }
+
+    auto indexCount() const -> size_t
+    {
+        return m_alive_count * 3;
+    }
+
+    auto capture() const -> SimplifiedMesh
+    {
+        SimplifiedMesh mesh;
+        mesh.indices.reserve(m_alive_count * 3);
+        for (size_t triangle = 0; triangle < m_alive.size(); ++triangle) {
+            if (m_alive[triangle]) {
+                mesh.indices.insert(mesh.indices.end(), m_triangles.begin() + static_cast<std::ptrdiff_t>(triangle * 3),
+                                    m_triangles.begin() + static_cast<std::ptrdiff_t>(triangle * 3 + 3));
+            }
+        }
+        mesh.error = static_cast<float>(std::sqrt(std::max(m_max_cost, 0.0)));
+        return mesh;
+    }
+
+private:
+    // moving these would tear the surface open or stretch the UVs across the seam
+    void lockSeamsAndBorders(const std::vector<glm::vec3>& positions)
+    {
+        std::map<std::tuple<float, float, float>, uint32_t> first_at;
+        for (uint32_t vertex = 0; vertex < positions.size(); ++vertex) {
+            const auto& position = positions[vertex];
+            auto [it, inserted] = first_at.try_emplace({ position.x, position.y, position.z }, vertex);
+            if (!inserted) {
+                m_locked[vertex] = true;
+                m_locked[it->second] = true;
+            }
+        }
+
+        std::unordered_map<uint64_t, uint32_t> edge_triangles;
+        for (size_t triangle = 0; triangle < m_alive.size(); ++triangle) {
+            if (!m_alive[triangle]) {
+                continue;
+            }
+            for (size_t i = 0; i < 3; ++i) {
+                const auto a = m_triangles[triangle * 3 + i];
+                const auto b = m_triangles[triangle * 3 + (i + 1) % 3];
+                ++edge_triangles[static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b)];
+            }
+        }
+
+        // open borders and non-manifold edges alike
+        for (const auto& [edge, count] : edge_triangles) {
+            if (count != 2) {
+                m_locked[static_cast<uint32_t>(edge >> 32)] = true;
+                m_locked[static_cast<uint32_t>(edge)] = true;
+            }
+        }
+    }
+
+    auto neighbours(uint32_t vertex) const -> std::vector<uint32_t>
+    {
+        std::vector<uint32_t> result;
+        for (auto triangle : m_vertex_triangles[vertex]) {
+            if (!m_alive[triangle]) {
+                continue;
+            }
+            for (size_t i = 0; i < 3; ++i) {
+                const auto corner = m_triangles[triangle * 3 + i];
+                if (corner != vertex) {
+                    result.push_back(corner);
+                }
+            }
+        }
+
+        std::ranges::sort(result);
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    void queueEdge(uint32_t a, uint32_t b)
+    {
+        Quadric quadric = m_quadrics[a];
+        quadric.add(m_quadrics[b]);
+
+        if (!m_locked[a]) {
+            m_queue.push({ quadric.error(m_positions[b]), a, b, m_versions[a], m_versions[b] });
+        }
+        if (!m_locked[b]) {
+            m_queue.push({ quadric.error(m_positions[a]), b, a, m_versions[b], m_versions[a] });
+        }
+    }
+
+    auto contains(uint32_t triangle, uint32_t vertex) const -> bool
+    {
+        const auto* corners = &m_triangles[triangle * 3];
+        return corners[0] == vertex || corners[1] == vertex || corners[2] == vertex;
+    }
+
+    auto canCollapse(uint32_t from, uint32_t to) const -> bool
+    {
+        // the edge's own triangles have to be the only ones the two vertices share,
+        // otherwise the collapse pinches the surface into a non-manifold one
+        uint32_t shared_triangles = 0;
+        for (auto triangle : m_vertex_triangles[from]) {
+            if (m_alive[triangle] && contains(triangle, to)) {
+                ++shared_triangles;
+            }
+        }
+        if (shared_triangles == 0) {
+            return false;
+        }
+
+        const auto from_neighbours = neighbours(from);
+        const auto to_neighbours = neighbours(to);
+        std::vector<uint32_t> shared_neighbours;
+        std::ranges::set_intersection(from_neighbours, to_neighbours, std::back_inserter(shared_neighbours));
+        if (shared_neighbours.size() != shared_triangles) {
+            return false;
+        }
+
+        for (auto triangle : m_vertex_triangles[from]) {
+            if (!m_alive[triangle] || contains(triangle, to)) {
+                continue;
+            }
+
+            glm::dvec3 before[3];
+            glm::dvec3 after[3];
+            for (size_t i = 0; i < 3; ++i) {
+                const auto corner = m_triangles[triangle * 3 + i];
+                before[i] = m_positions[corner];
+                after[i] = m_positions[corner == from ? to : corner];
+            }
+
+            const auto normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const auto normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+            const double length_after = glm::length(normal_after);
+            if (length_after == 0.0 || glm::dot(normal_before, normal_after) <= 0.0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void apply(const Collapse& collapse)
+    {
+        for (auto triangle : m_vertex_triangles[collapse.from]) {
+            if (!m_alive[triangle]) {
+                continue;
+            }
+
+            if (contains(triangle, collapse.to)) {
+                m_alive[triangle] = false;
+                --m_alive_count;
+                continue;
+            }
+
+            for (size_t i = 0; i < 3; ++i) {
+                if (m_triangles[triangle * 3 + i] == collapse.from) {
+                    m_triangles[triangle * 3 + i] = collapse.to;
+                }
+            }
+            m_vertex_triangles[collapse.to].push_back(triangle);
+        }
+
+        m_vertex_triangles[collapse.from].clear();
+        std::erase_if(m_vertex_triangles[collapse.to], [this](uint32_t triangle) {
+            return !m_alive[triangle];
+        });
+
+        m_quadrics[collapse.to].add(m_quadrics[collapse.from]);
+        m_removed[collapse.from] = true;
+        ++m_versions[collapse.to];
+        m_max_cost = std::max(m_max_cost, collapse.cost);
+
+        for (auto neighbour : neighbours(collapse.to)) {
+            queueEdge(collapse.to, neighbour);
+        }
+    }
+
+    std::vector<GLuint> m_triangles;
+    std::vector<glm::dvec3> m_positions;
+    std::vector<Quadric> m_quadrics;
+    std::vector<bool> m_locked;
+    std::vector<bool> m_removed;
+    std::vector<uint32_t> m_versions;
+    std::vector<std::vector<uint32_t>> m_vertex_triangles;
+    std::vector<bool> m_alive;
+    size_t m_alive_count = 0;
+    double m_max_cost = 0.0;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> m_queue;
+};
+
+}
+
+auto simplifyMesh(const MeshSource& source, std::span<const size_t> target_index_counts) -> std::vector<SimplifiedMesh>
+{
+    std::vector<SimplifiedMesh> levels;
+
+    const auto positions = extractPositions(source.vertices, source.config);
+    if (positions.empty() || source.indices.size() < 3) {
+        return levels;
+    }
+
+    if (std::ranges::any_of(source.indices, [&positions](GLuint index) { return index >= positions.size(); })) {
+        Logger::warning("simplifyMesh: {} indexes past its {} vertices, not simplified", source.name, positions.size());
+        return levels;
+    }
+
+    EdgeCollapser collapser(source, positions);
+    size_t previous_count = source.indices.size();
+
+    for (auto target : target_index_counts) {
+        if (collapser.simplifyTo(target)) {
+            levels.push_back(collapser.capture());
+            previous_count = collapser.indexCount();
+            continue;
+        }
+
+        // out of collapses short of the target, what was reached may still be worth a level
+        if (static_cast<double>(collapser.indexCount()) <= static_cast<double>(previous_count) * (1.0 - MIN_STALLED_REDUCTION)) {
+            levels.push_back(collapser.capture());
+        }
+        break;
+    }
+
+    return levels;
+}
+
+auto buildLodChain(const MeshSource& source) -> std::vector<MeshLodSource>
+{
+    std::vector<MeshLodSource> lods;
+
+    std::vector<size_t> targets;
+    for (size_t triangles = source.indices.size() / 3 / 2; targets.size() < MAX_LOD_LEVELS && triangles >= MIN_LOD_TRIANGLES; triangles /= 2) {
+        targets.push_back(triangles * 3);
+    }
+    if (targets.empty()) {
+        return lods;
+    }
+
+    for (auto& level : simplifyMesh(source, targets)) {
+        MeshSource lod{ source.name, source.vertices, std::move(level.indices), source.config, {} };
+        optimizeMesh(lod);
+        lods.push_back({ std::move(lod.vertices), std::move(lod.indices), level.error });
+    }
+
+    return lods;
+}
+
+}
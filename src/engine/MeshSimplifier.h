@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine {
+
+struct MeshLodSource;
+struct MeshSource;
+
+struct SimplifiedMesh {
+    // into the vertices of the source mesh, unreferenced ones are left for the caller to drop
+    std::vector<GLuint> indices;
+    // square root of the largest quadric error of a collapse so far, an upper bound
+    // of the distance to the planes of the source triangles
+    float error = 0.0f;
+};
+
+// LOD levels halve the triangle count until it falls below this or the mesh stops simplifying
+constexpr uint32_t MAX_LOD_LEVELS = 4;
+constexpr uint32_t MIN_LOD_TRIANGLES = 128;
+
+// Quadric error metric simplification (Garland and Heckbert). Edges collapse onto
+// one of their vertices, cheapest first, so every level keeps the positions and
+// attributes of the source vertices. Vertices on open borders or UV seams, where
+// several vertices share a position, never move. Collapses that would flip a
+// triangle or make the surface non-manifold are skipped. One pass produces every
+// level: the mesh is captured as it reaches each target, so the levels nest. No GL
+// is involved and ties are broken by vertex index, so the result is deterministic.
+auto simplifyMesh(const MeshSource& source, std::span<const size_t> target_index_counts) -> std::vector<SimplifiedMesh>;
+
+// the levels below the full mesh, optimized for the vertex cache like the mesh itself
+auto buildLodChain(const MeshSource& source) -> std::vector<MeshLodSource>;
+
+}
@@ -1,17 +1,98 @@
 #include "MeshStore.h"
+#include "GLStateCache.h"
+#include "MeshBuilder.h"
 
 #include <ranges>
 
 namespace engine {
 
-void MeshData::bind() const
+MeshData::~MeshData()
 {
-    glBindVertexArray(VAO);
+    if (m_readback.has_value()) {
+        GeometryPool::cancelRead(m_readback.value());
+    }
+    if (pool) {
+        pool->release(allocation);
+    }
+}
+
+void MeshData::requestGeometry() const
+{
+    if (m_geometry || !pool) {
+        return;
+    }
+
+    if (!m_readback.has_value()) {
+        m_readback = pool->beginRead(allocation);
+        return;
+    }
+
+    auto geometry = std::make_unique<Geometry>();
+    if (!GeometryPool::finishRead(m_readback.value(), geometry->vertices, geometry->indices)) {
+        return;
+    }
+    m_readback.reset();
+
+    geometry->positions = extractPositions(geometry->vertices, layout());
+    m_geometry = std::move(geometry);
+}
+
+auto MeshData::geometry() const -> const Geometry&
+{
+    static const Geometry empty{};
+    return m_geometry ? *m_geometry : empty;
+}
+
+auto MeshData::hasGeometry() const -> bool
+{
+    return m_geometry != nullptr;
+}
+
+auto MeshData::layout() const -> const MeshConfig&
+{
+    static const MeshConfig empty{};
+    return pool ? pool->layout(allocation) : empty;
+}
+
+auto MeshData::indexCount() const -> GLsizei
+{
+    return static_cast<GLsizei>(allocation.index_count);
+}
+
+auto MeshData::indexType() const -> GLenum
+{
+    return allocation.index_type;
+}
+
+auto MeshData::gpuBytes() const -> size_t
+{
+    size_t bytes = static_cast<size_t>(allocation.vertex_count) * packedVertexSize(layout()) +
+                   static_cast<size_t>(allocation.index_count) * GeometryPool::indexSize(allocation.index_type);
+    for (const auto& lod : lods) {
+        bytes += lod.mesh->gpuBytes();
+    }
+    return bytes;
+}
+
+void MeshData::bind(GLStateCache& state) const
+{
+    state.bindVertexArray(allocation.vao);
+}
+
+void MeshData::unbind(GLStateCache& state) const
+{
+    state.bindVertexArray(0);
 }
 
-void MeshData::unbind() const
+void MeshData::draw() const
+{
+    glDrawElementsBaseVertex(GL_TRIANGLES, indexCount(), allocation.index_type,
+        (void*)(uintptr_t)(allocation.first_index * GeometryPool::indexSize(allocation.index_type)), allocation.base_vertex);
+}
+
+MeshStore::MeshStore() :
+    m_geometry_pool(std::make_shared<GeometryPool>())
 {
-    glBindVertexArray(0);
 }
 
 auto MeshStore::get(uint32_t id) const -> std::optional<std::shared_ptr<MeshData>>
@@ -43,14 +124,16 @@ auto MeshStore::getIdByName(const std::string &name) const -> std::optional<uint
     return std::nullopt;
 }
 
-void MeshStore::add(uint32_t id, const std::shared_ptr<MeshData>& meshData)
+void MeshStore::add(uint32_t id, const std::shared_ptr<MeshData>& meshData, const std::string& package)
 {
     m_meshes[id] = meshData;
+    m_packages[id] = package;
 }
 
 void MeshStore::remove(uint32_t id)
 {
     m_meshes.erase(id);
+    m_packages.erase(id);
 }
 
 auto MeshStore::names() const -> std::vector<std::string>
@@ -61,4 +144,31 @@ auto MeshStore::names() const -> std::vector<std::string>
     }
     return names;
 }
+
+auto MeshStore::geometryPool() const -> const std::shared_ptr<GeometryPool>&
+{
+    return m_geometry_pool;
+}
+
+auto MeshStore::gpuBytes(const std::string& package) const -> size_t
+{
+    size_t bytes = 0;
+    for (const auto& [id, meshData] : m_meshes) {
+        auto it = m_packages.find(id);
+        if (it != m_packages.end() && it->second == package) {
+            bytes += meshData->gpuBytes();
+        }
+    }
+    return bytes;
+}
+
+auto MeshStore::gpuBytes() const -> size_t
+{
+    size_t bytes = 0;
+    for (const auto& meshData : m_meshes | std::views::values) {
+        bytes += meshData->gpuBytes();
+    }
+    return bytes;
+}
+
 }
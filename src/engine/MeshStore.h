@@ -1,5 +1,7 @@
 #pragma once
 
+#include "GeometryPool.h"
+
 #include <glad/glad.h>
 
 #include <vector>
@@ -12,20 +14,72 @@
 
 namespace engine {
 
+class GLStateCache;
+
 struct MeshData {
+    MeshData() = default;
+    ~MeshData();
+    MeshData(const MeshData&) = delete;
+    MeshData(MeshData&&) = delete;
+    MeshData& operator=(const MeshData&) = delete;
+    MeshData& operator=(MeshData&&) = delete;
+
     std::string name;
 
-    GLuint VAO = 0;
-    GLuint VBO = 0;
-    GLuint EBO = 0;
+    // range of the shared buffers of the pool, released with the mesh
+    std::shared_ptr<GeometryPool> pool;
+    GeometryPool::Allocation allocation;
+
+    // object space bounds of the vertex positions, computed when the mesh is built
+    glm::vec3 aabb_min{0.0f};
+    glm::vec3 aabb_max{0.0f};
+    glm::vec3 sphere_center{0.0f};
+    float sphere_radius = 0.0f;
+
+    struct Lod {
+        std::shared_ptr<MeshData> mesh;
+        // how far the level strays from this mesh, in object space units
+        float error = 0.0f;
+    };
+
+    // coarser levels from the cooker, coarsest last; they carry the bounds of this
+    // mesh so culling and sorting do not depend on the level drawn
+    std::vector<Lod> lods;
+
+    struct Geometry {
+        // interleaved in the mesh layout, unpacked to floats
+        std::vector<GLfloat> vertices;
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+    };
 
-    void bind() const;
-    void unbind() const;
+    // no CPU copy is kept after the upload; the occlusion rasterizer and static batching
+    // request one, it is read back without stalling and kept from then on. Needs the GL
+    // context, the first call starts the copy and a later one picks it up.
+    void requestGeometry() const;
+    auto hasGeometry() const -> bool;
+    // empty until hasGeometry()
+    auto geometry() const -> const Geometry&;
+
+    auto layout() const -> const MeshConfig&;
+    auto indexCount() const -> GLsizei;
+    // GL_UNSIGNED_SHORT for meshes of up to 65536 vertices
+    auto indexType() const -> GLenum;
+    // the LOD levels included
+    auto gpuBytes() const -> size_t;
+
+    void bind(GLStateCache& state) const;
+    void unbind(GLStateCache& state) const;
+    void draw() const;
+
+private:
+    mutable std::unique_ptr<Geometry> m_geometry;
+    mutable std::optional<GeometryPool::Readback> m_readback;
 };
 
 class MeshStore final {
 public:
-    MeshStore() = default;
+    MeshStore();
     ~MeshStore() = default;
     MeshStore(const MeshStore&) = delete;
     MeshStore(MeshStore&&) = delete;
@@ -35,13 +89,21 @@ public:
     auto get(uint32_t id) const -> std::optional<std::shared_ptr<MeshData>>;
     auto get(const std::string& name) const -> std::optional<std::shared_ptr<MeshData>>;
     auto getIdByName(const std::string& name) const -> std::optional<uint32_t>;
-    void add(uint32_t id, const std::shared_ptr<MeshData>& meshData);
+    void add(uint32_t id, const std::shared_ptr<MeshData>& meshData, const std::string& package = {});
     void remove(uint32_t id);
 
     auto names() const -> std::vector<std::string>;
 
+    auto geometryPool() const -> const std::shared_ptr<GeometryPool>&;
+
+    // bytes of the shared buffers used by the meshes of one package, and by all meshes
+    auto gpuBytes(const std::string& package) const -> size_t;
+    auto gpuBytes() const -> size_t;
+
 private:
     std::unordered_map<uint32_t, std::shared_ptr<MeshData>> m_meshes;
+    std::unordered_map<uint32_t, std::string> m_packages;
+    std::shared_ptr<GeometryPool> m_geometry_pool;
 };
 
 }
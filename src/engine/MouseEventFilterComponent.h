@@ -8,14 +8,10 @@
 
 namespace engine {
 
-class TransformComponent;
-class MaterialComponent;
-class NodePositioningHelper;
-
 class MouseEventFilterComponent final : public Component {
 public:
     explicit MouseEventFilterComponent(uint32_t id, const std::string& name, uint32_t owner_node, uint32_t owner_scene);
-    ~MouseEventFilterComponent() override = default;
+    ~MouseEventFilterComponent() override;
 
     void init() override;
 
@@ -40,12 +36,12 @@ public:
     void setMouseClickCallback(const std::function<void(int, int)>& callback);
     void clearMouseClickCallback();
 
+    // called by the picking service when a click of the filtered key and action hits the node
+    void onMouseClick(int x, int y);
+
 private:
     void registerMouseHandler();
-
-    std::shared_ptr<TransformComponent> m_transform;
-    std::shared_ptr<MaterialComponent> m_material;
-    std::shared_ptr<NodePositioningHelper> m_node_positioning_helper;
+    void unregisterMouseHandler();
 
     int m_key = 0;
     int m_action = 0;
@@ -0,0 +1,107 @@
+#include "MultiDraw.h"
+#include "GLStateCache.h"
+#include "Logger.h"
+#include "MeshStore.h"
+#include "renderpasses/RenderPass.h"
+
+namespace engine {
+
+MultiDrawSubmitter::MultiDrawSubmitter() :
+    m_indirect_supported(GLAD_GL_VERSION_4_3 != 0)
+{
+    if (m_indirect_supported) {
+        glGenBuffers(1, &m_indirect_buffer);
+        glGenBuffers(1, &m_model_buffer);
+    }
+
+    Logger::info("MultiDrawSubmitter: indirect multi draw {}", m_indirect_supported ? "enabled" : "unavailable, drawing one by one");
+}
+
+MultiDrawSubmitter::~MultiDrawSubmitter()
+{
+    glDeleteBuffers(1, &m_indirect_buffer);
+    glDeleteBuffers(1, &m_model_buffer);
+}
+
+auto MultiDrawSubmitter::indirectSupported() const -> bool
+{
+    return m_indirect_supported;
+}
+
+auto MultiDrawSubmitter::submit(GLStateCache& state, std::span<const DrawItem* const> items) -> uint32_t
+{
+    if (items.empty()) {
+        return 0;
+    }
+
+    if (!m_indirect_supported) {
+        // no attribute array is ever enabled on these locations here, so the constant is read
+        for (const auto* item : items) {
+            item->mesh->bind(state);
+            for (GLuint column = 0; column < 4; ++column) {
+                glVertexAttrib4fv(MODEL_ATTRIBUTE + column, &item->model[column][0]);
+            }
+            item->mesh->draw();
+        }
+        return static_cast<uint32_t>(items.size());
+    }
+
+    m_commands.resize(items.size());
+    m_models.resize(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        const auto& allocation = items[i]->mesh->allocation;
+        m_commands[i] = { allocation.index_count, 1, allocation.first_index, allocation.base_vertex, static_cast<GLuint>(i) };
+        m_models[i] = items[i]->model;
+    }
+
+    const auto& allocation = items.front()->mesh->allocation;
+    prepareArena(state, allocation.arena, allocation.vao);
+
+    // orphaned every submit, the driver hands out fresh storage instead of stalling
+    glBindBuffer(GL_ARRAY_BUFFER, m_model_buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_models.size() * sizeof(glm::mat4)), m_models.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirect_buffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, static_cast<GLsizeiptr>(m_commands.size() * sizeof(DrawElementsIndirectCommand)), m_commands.data(), GL_STREAM_DRAW);
+
+    // the items share an arena, and with it the index type
+    glMultiDrawElementsIndirect(GL_TRIANGLES, allocation.index_type, nullptr, static_cast<GLsizei>(m_commands.size()), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    ++m_stats.indirect_calls;
+    m_stats.indirect_commands += static_cast<uint32_t>(m_commands.size());
+
+    return 1;
+}
+
+auto MultiDrawSubmitter::stats() const -> const Stats&
+{
+    return m_stats;
+}
+
+void MultiDrawSubmitter::resetStats()
+{
+    m_stats = {};
+}
+
+void MultiDrawSubmitter::prepareArena(GLStateCache& state, uint32_t arena, GLuint vao)
+{
+    state.bindVertexArray(vao);
+
+    if (m_prepared_arenas.contains(arena)) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_model_buffer);
+    for (GLuint column = 0; column < 4; ++column) {
+        glEnableVertexAttribArray(MODEL_ATTRIBUTE + column);
+        glVertexAttribPointer(MODEL_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(uintptr_t)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(MODEL_ATTRIBUTE + column, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_prepared_arenas.insert(arena);
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+namespace engine {
+
+class GLStateCache;
+struct DrawItem;
+
+// Submits draws that share program, material and geometry arena. With GL 4.3 the
+// draws become DrawElementsIndirectCommand entries issued by one
+// glMultiDrawElementsIndirect, each command picking its model matrix through its
+// base instance from a per-instance attribute. Older contexts (4.1, the version
+// the engine asks for by default) draw one by one with the model as a constant
+// vertex attribute.
+class MultiDrawSubmitter final {
+public:
+    // the mat4 takes this location and the three following
+    static constexpr GLuint MODEL_ATTRIBUTE = 3;
+
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first_index;
+        GLint base_vertex;
+        GLuint base_instance;
+    };
+
+    struct Stats {
+        uint32_t indirect_calls = 0;
+        uint32_t indirect_commands = 0;
+    };
+
+    MultiDrawSubmitter();
+    ~MultiDrawSubmitter();
+    MultiDrawSubmitter(const MultiDrawSubmitter&) = delete;
+    MultiDrawSubmitter(MultiDrawSubmitter&&) = delete;
+    MultiDrawSubmitter& operator=(const MultiDrawSubmitter&) = delete;
+    MultiDrawSubmitter& operator=(MultiDrawSubmitter&&) = delete;
+
+    auto indirectSupported() const -> bool;
+
+    // all items have to live in the same geometry arena, returns the GL draw calls issued
+    auto submit(GLStateCache& state, std::span<const DrawItem* const> items) -> uint32_t;
+
+    auto stats() const -> const Stats&;
+    void resetStats();
+
+private:
+    void prepareArena(GLStateCache& state, uint32_t arena, GLuint vao);
+
+    bool m_indirect_supported = false;
+
+    GLuint m_indirect_buffer = 0;
+    GLuint m_model_buffer = 0;
+
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    std::vector<glm::mat4> m_models;
+
+    // arenas whose VAO already sources the model attribute from m_model_buffer,
+    // arena ids are never reused so a deleted arena can not alias a new one
+    std::unordered_set<uint32_t> m_prepared_arenas;
+
+    Stats m_stats;
+};
+
+}
@@ -37,6 +37,25 @@ void Node::setActive(bool active)
     }
 }
 
+bool Node::isStatic() const
+{
+    return m_is_static;
+}
+
+void Node::setStatic(bool is_static)
+{
+    if (m_is_static == is_static) {
+        return;
+    }
+
+    m_is_static = is_static;
+
+    auto scene = getScene();
+    if (scene.has_value() && scene.value()) {
+        scene.value()->markStructureChanged();
+    }
+}
+
 void Node::setContext(const std::weak_ptr<Context>& context)
 {
     m_context = context;
@@ -98,6 +117,7 @@ auto Node::clone(uint32_t owner_node_id) const -> std::optional<std::shared_ptr<
 
     auto clone_node = std::make_shared<Node>(generateUniqueId(), m_name, owner_node_id, m_owner_scene);
     clone_node->setContext(m_context);
+    clone_node->m_is_static = m_is_static;
 
     for (const auto& child_id : m_children_id) {
         auto child = getChild(child_id);
@@ -333,6 +353,10 @@ auto buildNode(const rapidjson::Value& node_json) -> std::optional<std::unique_p
     for (auto& component : components) {
         node->addComponent(component.GetUint());
     }
+
+    if (node_json.HasMember("static") && node_json["static"].IsBool()) {
+        node->setStatic(node_json["static"].GetBool());
+    }
     return std::move(node);
 }
 
@@ -344,6 +368,7 @@ void saveNode(const std::shared_ptr<Node>& node, rapidjson::Value& node_json, ra
     node_json.AddMember("name", value, allocator);
     node_json.AddMember("parent", node->getParentId(), allocator);
     node_json.AddMember("owner_scene", node->ownerScene(), allocator);
+    node_json.AddMember("static", node->isStatic(), allocator);
 
     rapidjson::Value children(rapidjson::kArrayType);
     for (const auto child : node->children()) {
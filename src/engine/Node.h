@@ -32,6 +32,11 @@ public:
     bool isActive() const;
     void setActive(bool active);
 
+    // static nodes are expected not to move, the renderer merges their meshes into batches
+    [[nodiscard]]
+    bool isStatic() const;
+    void setStatic(bool is_static);
+
     void setContext(const std::weak_ptr<Context>& context);
 
     std::uint32_t id() const;
@@ -133,6 +138,7 @@ public:
 
 private:
     bool m_is_active = true;
+    bool m_is_static = false;
 
     std::weak_ptr<Context> m_context;
 
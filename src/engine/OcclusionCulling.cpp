@@ -0,0 +1,404 @@
+#include "OcclusionCulling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_OCCLUSION_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define ENGINE_OCCLUSION_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace engine {
+
+namespace {
+
+// the operations the rasterizer runs on four pixels at once, the scalar lanes are
+// always built so the SIMD ones can be checked against them at runtime
+struct ScalarLanes {
+    struct Floats {
+        float v[4];
+    };
+    struct Mask {
+        bool v[4];
+    };
+
+    template<typename T, typename F>
+    static auto lanes(F&& f) -> T
+    {
+        T result;
+        for (int i = 0; i < 4; ++i) {
+            result.v[i] = f(i);
+        }
+        return result;
+    }
+
+    static auto splat(float value) -> Floats { return lanes<Floats>([&](int) { return value; }); }
+    static auto laneOffsets() -> Floats { return lanes<Floats>([](int i) { return static_cast<float>(i); }); }
+    static auto load(const float* data) -> Floats { return lanes<Floats>([&](int i) { return data[i]; }); }
+    static void store(float* data, Floats value) { std::copy(value.v, value.v + 4, data); }
+    static auto add(Floats a, Floats b) -> Floats { return lanes<Floats>([&](int i) { return a.v[i] + b.v[i]; }); }
+    static auto mul(Floats a, Floats b) -> Floats { return lanes<Floats>([&](int i) { return a.v[i] * b.v[i]; }); }
+    static auto min(Floats a, Floats b) -> Floats { return lanes<Floats>([&](int i) { return std::min(a.v[i], b.v[i]); }); }
+    static auto greaterEqual(Floats a, Floats b) -> Mask { return lanes<Mask>([&](int i) { return a.v[i] >= b.v[i]; }); }
+    static auto maskAnd(Mask a, Mask b) -> Mask { return lanes<Mask>([&](int i) { return a.v[i] && b.v[i]; }); }
+    static auto select(Mask mask, Floats a, Floats b) -> Floats { return lanes<Floats>([&](int i) { return mask.v[i] ? a.v[i] : b.v[i]; }); }
+    static auto maskBits(Mask mask) -> uint32_t
+    {
+        return (mask.v[0] ? 1u : 0u) | (mask.v[1] ? 2u : 0u) | (mask.v[2] ? 4u : 0u) | (mask.v[3] ? 8u : 0u);
+    }
+};
+
+#if defined(ENGINE_OCCLUSION_SSE)
+
+struct SimdLanes {
+    using Floats = __m128;
+    using Mask = __m128;
+
+    static auto splat(float value) -> Floats { return _mm_set1_ps(value); }
+    static auto laneOffsets() -> Floats { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+    static auto load(const float* data) -> Floats { return _mm_loadu_ps(data); }
+    static void store(float* data, Floats value) { _mm_storeu_ps(data, value); }
+    static auto add(Floats a, Floats b) -> Floats { return _mm_add_ps(a, b); }
+    static auto mul(Floats a, Floats b) -> Floats { return _mm_mul_ps(a, b); }
+    static auto min(Floats a, Floats b) -> Floats { return _mm_min_ps(a, b); }
+    static auto greaterEqual(Floats a, Floats b) -> Mask { return _mm_cmpge_ps(a, b); }
+    static auto maskAnd(Mask a, Mask b) -> Mask { return _mm_and_ps(a, b); }
+    static auto select(Mask mask, Floats a, Floats b) -> Floats { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static auto maskBits(Mask mask) -> uint32_t { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+};
+
+#elif defined(ENGINE_OCCLUSION_NEON)
+
+struct SimdLanes {
+    using Floats = float32x4_t;
+    using Mask = uint32x4_t;
+
+    static auto splat(float value) -> Floats { return vdupq_n_f32(value); }
+    static auto laneOffsets() -> Floats
+    {
+        const float offsets[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        return vld1q_f32(offsets);
+    }
+    static auto load(const float* data) -> Floats { return vld1q_f32(data); }
+    static void store(float* data, Floats value) { vst1q_f32(data, value); }
+    static auto add(Floats a, Floats b) -> Floats { return vaddq_f32(a, b); }
+    static auto mul(Floats a, Floats b) -> Floats { return vmulq_f32(a, b); }
+    static auto min(Floats a, Floats b) -> Floats { return vminq_f32(a, b); }
+    static auto greaterEqual(Floats a, Floats b) -> Mask { return vcgeq_f32(a, b); }
+    static auto maskAnd(Mask a, Mask b) -> Mask { return vandq_u32(a, b); }
+    static auto select(Mask mask, Floats a, Floats b) -> Floats { return vbslq_f32(mask, a, b); }
+    static auto maskBits(Mask mask) -> uint32_t
+    {
+        uint32_t lanes[4];
+        vst1q_u32(lanes, mask);
+        return (lanes[0] & 1u) | (lanes[1] & 2u) | (lanes[2] & 4u) | (lanes[3] & 8u);
+    }
+};
+
+#else
+
+using SimdLanes = ScalarLanes;
+
+#endif
+
+auto toScreen(const glm::vec4& clip) -> glm::vec3
+{
+    const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    return {
+        (ndc.x * 0.5f + 0.5f) * static_cast<float>(OcclusionCuller::WIDTH),
+        (ndc.y * 0.5f + 0.5f) * static_cast<float>(OcclusionCuller::HEIGHT),
+        ndc.z * 0.5f + 0.5f
+    };
+}
+
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t worker_count, Path path) :
+    m_path(path)
+{
+    if (worker_count == 0) {
+        const uint32_t hardware_threads = std::thread::hardware_concurrency();
+        worker_count = std::min(MAX_WORKERS, hardware_threads > 1 ? hardware_threads - 1 : 0);
+    }
+
+    // the calling thread takes band 0
+    m_band_count = worker_count + 1;
+    for (uint32_t band = 1; band < m_band_count; ++band) {
+        m_workers.emplace_back(&OcclusionCuller::workerLoop, this, band);
+    }
+
+    m_depth.assign(WIDTH * HEIGHT, 1.0f);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& view_projection)
+{
+    m_view_projection = view_projection;
+    m_triangles.clear();
+    std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+}
+
+void OcclusionCuller::addOccluder(const glm::mat4& model, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+{
+    const glm::mat4 model_view_projection = m_view_projection * model;
+
+    m_clip.resize(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        m_clip[i] = model_view_projection * glm::vec4(positions[i], 1.0f);
+    }
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        if (indices[i] >= m_clip.size() || indices[i + 1] >= m_clip.size() || indices[i + 2] >= m_clip.size()) {
+            continue;
+        }
+
+        const glm::vec4 clip[3] = { m_clip[indices[i]], m_clip[indices[i + 1]], m_clip[indices[i + 2]] };
+
+        // no clipping: triangles crossing the near plane are dropped
+        bool crosses_near = false;
+        for (const auto& vertex : clip) {
+            crosses_near = crosses_near || vertex.w < NEAR_W || vertex.z < -vertex.w;
+        }
+        if (crosses_near) {
+            continue;
+        }
+
+        glm::vec3 v0 = toScreen(clip[0]);
+        glm::vec3 v1 = toScreen(clip[1]);
+        glm::vec3 v2 = toScreen(clip[2]);
+
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if (std::fabs(area) < 1e-6f) {
+            continue;
+        }
+
+        // both windings are occluders, make them counter-clockwise
+        if (area < 0.0f) {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        Triangle triangle{};
+        triangle.min_x = std::max(0, static_cast<int32_t>(std::floor(std::min({ v0.x, v1.x, v2.x }))));
+        triangle.max_x = std::min(static_cast<int32_t>(WIDTH) - 1, static_cast<int32_t>(std::ceil(std::max({ v0.x, v1.x, v2.x }))));
+        triangle.min_y = std::max(0, static_cast<int32_t>(std::floor(std::min({ v0.y, v1.y, v2.y }))));
+        triangle.max_y = std::min(static_cast<int32_t>(HEIGHT) - 1, static_cast<int32_t>(std::ceil(std::max({ v0.y, v1.y, v2.y }))));
+        if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) {
+            continue;
+        }
+
+        const glm::vec3* vertices[3] = { &v0, &v1, &v2 };
+        for (int edge = 0; edge < 3; ++edge) {
+            const auto& a = *vertices[edge];
+            const auto& b = *vertices[(edge + 1) % 3];
+            triangle.edges[edge] = { a.y - b.y, b.x - a.x, a.x * b.y - b.x * a.y };
+        }
+
+        // depth is linear in screen space after the perspective divide
+        const float depth_x = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        const float depth_y = ((v1.x - v0.x) * (v2.z - v0.z) - (v2.x - v0.x) * (v1.z - v0.z)) / area;
+        triangle.depth = { depth_x, depth_y, v0.z - depth_x * v0.x - depth_y * v0.y };
+
+        m_triangles.push_back(triangle);
+    }
+}
+
+void OcclusionCuller::rasterize()
+{
+    if (m_triangles.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        ++m_generation;
+        m_pending = static_cast<uint32_t>(m_workers.size());
+    }
+    m_start.notify_all();
+
+    rasterizeBand(0);
+
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] {
+        return m_pending == 0;
+    });
+}
+
+auto OcclusionCuller::isVisible(const Aabb& box) const -> bool
+{
+    glm::vec2 screen_min(std::numeric_limits<float>::max());
+    glm::vec2 screen_max(std::numeric_limits<float>::lowest());
+    float nearest = std::numeric_limits<float>::max();
+
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec3 point(
+            corner & 1 ? box.max.x : box.min.x,
+            corner & 2 ? box.max.y : box.min.y,
+            corner & 4 ? box.max.z : box.min.z);
+        const glm::vec4 clip = m_view_projection * glm::vec4(point, 1.0f);
+
+        // a box reaching the camera plane can not be proven hidden
+        if (clip.w < NEAR_W || clip.z < -clip.w) {
+            return true;
+        }
+
+        const glm::vec3 screen = toScreen(clip);
+        screen_min = glm::min(screen_min, glm::vec2(screen));
+        screen_max = glm::max(screen_max, glm::vec2(screen));
+        nearest = std::min(nearest, screen.z);
+    }
+
+    const int32_t min_x = std::max(0, static_cast<int32_t>(std::floor(screen_min.x)));
+    const int32_t max_x = std::min(static_cast<int32_t>(WIDTH) - 1, static_cast<int32_t>(std::ceil(screen_max.x)) - 1);
+    const int32_t min_y = std::max(0, static_cast<int32_t>(std::floor(screen_min.y)));
+    const int32_t max_y = std::min(static_cast<int32_t>(HEIGHT) - 1, static_cast<int32_t>(std::ceil(screen_max.y)) - 1);
+    if (min_x > max_x || min_y > max_y) {
+        return true;
+    }
+
+    const ScreenRect rect{ min_x, max_x, min_y, max_y };
+    return m_path == Path::Scalar ? isRectVisible<ScalarLanes>(rect, nearest) : isRectVisible<SimdLanes>(rect, nearest);
+}
+
+auto OcclusionCuller::triangleCount() const -> size_t
+{
+    return m_triangles.size();
+}
+
+auto OcclusionCuller::depth() const -> const std::vector<float>&
+{
+    return m_depth;
+}
+
+void OcclusionCuller::rasterizeBand(uint32_t band)
+{
+    if (m_path == Path::Scalar) {
+        rasterizeBandWith<ScalarLanes>(band);
+    } else {
+        rasterizeBandWith<SimdLanes>(band);
+    }
+}
+
+template<typename Lanes>
+void OcclusionCuller::rasterizeBandWith(uint32_t band)
+{
+    using Floats = typename Lanes::Floats;
+    using Mask = typename Lanes::Mask;
+
+    const int32_t rows_per_band = static_cast<int32_t>((HEIGHT + m_band_count - 1) / m_band_count);
+    const int32_t band_min_y = static_cast<int32_t>(band) * rows_per_band;
+    const int32_t band_max_y = std::min(static_cast<int32_t>(HEIGHT), band_min_y + rows_per_band) - 1;
+
+    const Floats offsets = Lanes::laneOffsets();
+
+    for (const auto& triangle : m_triangles) {
+        const int32_t min_y = std::max(triangle.min_y, band_min_y);
+        const int32_t max_y = std::min(triangle.max_y, band_max_y);
+        if (min_y > max_y) {
+            continue;
+        }
+
+        const Floats edge_x[3] = { Lanes::splat(triangle.edges[0].x), Lanes::splat(triangle.edges[1].x), Lanes::splat(triangle.edges[2].x) };
+        const Floats depth_x = Lanes::splat(triangle.depth.x);
+        const Floats zero = Lanes::splat(0.0f);
+
+        // WIDTH is a multiple of LANES, so an aligned start never runs past the row
+        const int32_t start_x = triangle.min_x & ~static_cast<int32_t>(LANES - 1);
+
+        for (int32_t y = min_y; y <= max_y; ++y) {
+            const float pixel_y = static_cast<float>(y) + 0.5f;
+            const Floats edge_row[3] = {
+                Lanes::splat(triangle.edges[0].y * pixel_y + triangle.edges[0].z),
+                Lanes::splat(triangle.edges[1].y * pixel_y + triangle.edges[1].z),
+                Lanes::splat(triangle.edges[2].y * pixel_y + triangle.edges[2].z)
+            };
+            const Floats depth_row = Lanes::splat(triangle.depth.y * pixel_y + triangle.depth.z);
+
+            float* row = m_depth.data() + static_cast<size_t>(y) * WIDTH;
+            for (int32_t x = start_x; x <= triangle.max_x; x += LANES) {
+                const Floats pixel_x = Lanes::add(Lanes::splat(static_cast<float>(x) + 0.5f), offsets);
+
+                Mask inside = Lanes::greaterEqual(Lanes::add(Lanes::mul(edge_x[0], pixel_x), edge_row[0]), zero);
+                inside = Lanes::maskAnd(inside, Lanes::greaterEqual(Lanes::add(Lanes::mul(edge_x[1], pixel_x), edge_row[1]), zero));
+                inside = Lanes::maskAnd(inside, Lanes::greaterEqual(Lanes::add(Lanes::mul(edge_x[2], pixel_x), edge_row[2]), zero));
+
+                const Floats depth = Lanes::add(Lanes::mul(depth_x, pixel_x), depth_row);
+                const Floats current = Lanes::load(row + x);
+                Lanes::store(row + x, Lanes::select(inside, Lanes::min(current, depth), current));
+            }
+        }
+    }
+}
+
+template<typename Lanes>
+auto OcclusionCuller::isRectVisible(const ScreenRect& rect, float nearest) const -> bool
+{
+    const auto nearest_lanes = Lanes::splat(nearest);
+    const int32_t start_x = rect.min_x & ~static_cast<int32_t>(LANES - 1);
+
+    for (int32_t y = rect.min_y; y <= rect.max_y; ++y) {
+        const float* row = m_depth.data() + static_cast<size_t>(y) * WIDTH;
+        for (int32_t x = start_x; x <= rect.max_x; x += LANES) {
+            // equal depth keeps coplanar boxes visible
+            uint32_t bits = Lanes::maskBits(Lanes::greaterEqual(Lanes::load(row + x), nearest_lanes));
+
+            // drop the lanes outside of the box
+            if (x < rect.min_x) {
+                bits &= ~0u << (rect.min_x - x);
+            }
+            if (x + static_cast<int32_t>(LANES) - 1 > rect.max_x) {
+                bits &= (1u << (rect.max_x - x + 1)) - 1u;
+            }
+
+            if (bits != 0) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void OcclusionCuller::workerLoop(uint32_t band)
+{
+    uint64_t generation = 0;
+
+    while (true) {
+        std::unique_lock lock(m_mutex);
+        m_start.wait(lock, [this, generation] {
+            return m_stop || m_generation != generation;
+        });
+
+        if (m_stop) {
+            return;
+        }
+
+        generation = m_generation;
+        lock.unlock();
+
+        rasterizeBand(band);
+
+        lock.lock();
+        if (--m_pending == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Bounds.h"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+// Software occlusion culling. Occluder triangles are rasterized on the CPU into a
+// low resolution depth buffer, four pixels per iteration (SSE or NEON, scalar
+// otherwise or on request). The buffer is split in horizontal bands, each band is owned by one
+// thread, so the result does not depend on scheduling. Occludee boxes are then
+// tested against the buffer with their nearest depth.
+class OcclusionCuller final {
+public:
+    static constexpr uint32_t WIDTH = 256;
+    static constexpr uint32_t HEIGHT = 144;
+    static constexpr uint32_t LANES = 4;
+
+    // Simd falls back to the scalar lanes where neither SSE nor NEON is available,
+    // Scalar lets the tests compare the two
+    enum class Path {
+        Simd,
+        Scalar,
+    };
+
+    // 0 picks the worker count from the hardware concurrency
+    explicit OcclusionCuller(uint32_t worker_count = 0, Path path = Path::Simd);
+    ~OcclusionCuller();
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller(OcclusionCuller&&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(OcclusionCuller&&) = delete;
+
+    void beginFrame(const glm::mat4& view_projection);
+    void addOccluder(const glm::mat4& model, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+    void rasterize();
+
+    // false only when the whole box is behind the rasterized occluders
+    auto isVisible(const Aabb& box) const -> bool;
+
+    auto triangleCount() const -> size_t;
+    // depth in [0, 1] per pixel, row 0 at the bottom of the screen
+    auto depth() const -> const std::vector<float>&;
+
+private:
+    struct Triangle {
+        // edge functions a * x + b * y + c, positive inside
+        glm::vec3 edges[3];
+        // depth plane a * x + b * y + c
+        glm::vec3 depth;
+        int32_t min_x;
+        int32_t max_x;
+        int32_t min_y;
+        int32_t max_y;
+    };
+
+    struct ScreenRect {
+        int32_t min_x;
+        int32_t max_x;
+        int32_t min_y;
+        int32_t max_y;
+    };
+
+    void rasterizeBand(uint32_t band);
+    template<typename Lanes>
+    void rasterizeBandWith(uint32_t band);
+    template<typename Lanes>
+    auto isRectVisible(const ScreenRect& rect, float nearest) const -> bool;
+    void workerLoop(uint32_t band);
+
+    Path m_path;
+
+    glm::mat4 m_view_projection{1.0f};
+
+    std::vector<Triangle> m_triangles;
+    std::vector<float> m_depth;
+    std::vector<glm::vec4> m_clip;
+
+    uint32_t m_band_count = 1;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    uint32_t m_pending = 0;
+    bool m_stop = false;
+
+    // triangles with a vertex closer than this in clip w are skipped,
+    // dropping an occluder only costs culling efficiency
+    static constexpr float NEAR_W = 1e-3f;
+    static constexpr uint32_t MAX_WORKERS = 3;
+};
+
+}
@@ -0,0 +1,65 @@
+#include "OverdrawMeter.h"
+
+namespace engine {
+
+OverdrawMeter::OverdrawMeter()
+{
+    glGenQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+}
+
+OverdrawMeter::~OverdrawMeter()
+{
+    glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+}
+
+void OverdrawMeter::begin()
+{
+    collect();
+
+    // every query still in flight, skip measuring this frame rather than stall
+    if (m_pending[m_next]) {
+        m_active = false;
+        return;
+    }
+
+    glBeginQuery(GL_SAMPLES_PASSED, m_queries[m_next]);
+    m_active = true;
+}
+
+void OverdrawMeter::end()
+{
+    if (!m_active) {
+        return;
+    }
+
+    glEndQuery(GL_SAMPLES_PASSED);
+    m_pending[m_next] = true;
+    m_next = (m_next + 1) % QUERY_COUNT;
+    m_active = false;
+}
+
+auto OverdrawMeter::samplesPassed() const -> std::optional<uint64_t>
+{
+    return m_samples_passed;
+}
+
+void OverdrawMeter::collect()
+{
+    // results become available in submission order
+    while (m_pending[m_oldest]) {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(m_queries[m_oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE) {
+            return;
+        }
+
+        GLuint64 samples = 0;
+        glGetQueryObjectui64v(m_queries[m_oldest], GL_QUERY_RESULT, &samples);
+        m_samples_passed = samples;
+
+        m_pending[m_oldest] = false;
+        m_oldest = (m_oldest + 1) % QUERY_COUNT;
+    }
+}
+
+}
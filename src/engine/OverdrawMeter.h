@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace engine {
+
+// Counts the fragments passing the depth test during the color passes with
+// GL_SAMPLES_PASSED queries. Results are read a few frames later from a ring
+// of queries so the CPU never waits on the GPU; divided by the viewport area
+// this is the average number of shaded fragments per pixel.
+class OverdrawMeter final {
+public:
+    static constexpr size_t QUERY_COUNT = 4;
+
+    OverdrawMeter();
+    ~OverdrawMeter();
+    OverdrawMeter(const OverdrawMeter&) = delete;
+    OverdrawMeter(OverdrawMeter&&) = delete;
+    OverdrawMeter& operator=(const OverdrawMeter&) = delete;
+    OverdrawMeter& operator=(OverdrawMeter&&) = delete;
+
+    void begin();
+    void end();
+
+    // samples of the most recent frame the GPU has finished
+    auto samplesPassed() const -> std::optional<uint64_t>;
+
+private:
+    void collect();
+
+    std::array<GLuint, QUERY_COUNT> m_queries{};
+    std::array<bool, QUERY_COUNT> m_pending{};
+
+    size_t m_next = 0;
+    size_t m_oldest = 0;
+    bool m_active = false;
+
+    std::optional<uint64_t> m_samples_passed;
+};
+
+}
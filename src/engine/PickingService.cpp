@@ -0,0 +1,189 @@
+#include "PickingService.h"
+#include "Context.h"
+#include "InputManager.h"
+#include "Logger.h"
+#include "MouseEventFilterComponent.h"
+#include "Node.h"
+#include "Scene.h"
+#include "SceneRequester.h"
+#include "SceneRequesterHelper.h"
+#include "SceneStore.h"
+#include "TransformComponent.h"
+
+#include <algorithm>
+#include <limits>
+#include <ranges>
+
+namespace engine {
+
+PickingService::PickingService(const std::weak_ptr<Context>& context) :
+    m_context(context)
+{
+}
+
+void PickingService::addFilter(MouseEventFilterComponent* filter)
+{
+    if (isRegistered(filter->ownerNode(), filter)) {
+        return;
+    }
+
+    m_node_filters[filter->ownerNode()].push_back(filter);
+    ++m_scene_filter_count[filter->ownerScene()];
+
+    if (m_key_filter_count[filter->key()]++ != 0) {
+        return;
+    }
+
+    // headless contexts, e.g. the tests, have no input manager and call pick() themselves
+    auto ctx = m_context.lock();
+    if (ctx == nullptr || ctx->inputManager == nullptr) {
+        return;
+    }
+
+    const int key = filter->key();
+    ctx->inputManager->registerMouseHandler(key, [this, key](int action, int x, int y) {
+        pick(key, action, x, y);
+    });
+}
+
+void PickingService::removeFilter(MouseEventFilterComponent* filter)
+{
+    auto it = m_node_filters.find(filter->ownerNode());
+    if (it == m_node_filters.end()) {
+        return;
+    }
+
+    auto& filters = it->second;
+    auto filter_it = std::ranges::find(filters, filter);
+    if (filter_it == filters.end()) {
+        return;
+    }
+
+    filters.erase(filter_it);
+    if (filters.empty()) {
+        m_node_filters.erase(it);
+    }
+
+    if (--m_scene_filter_count[filter->ownerScene()] == 0) {
+        m_scene_filter_count.erase(filter->ownerScene());
+    }
+
+    if (--m_key_filter_count[filter->key()] != 0) {
+        return;
+    }
+
+    m_key_filter_count.erase(filter->key());
+
+    auto ctx = m_context.lock();
+    if (ctx != nullptr && ctx->inputManager != nullptr) {
+        ctx->inputManager->unregisterMouseHandler(filter->key());
+    }
+}
+
+void PickingService::pick(int key, int action, int x, int y)
+{
+    Logger::debug("{}: key: {}, action: {}, x: {}, y: {}", __FUNCTION__, key, action, x, y);
+
+    // callbacks may load or unload scenes, so iterate over a snapshot
+    std::vector<uint32_t> scene_ids;
+    scene_ids.reserve(m_scene_filter_count.size());
+    for (auto scene_id : m_scene_filter_count | std::views::keys) {
+        scene_ids.push_back(scene_id);
+    }
+
+    for (auto scene_id : scene_ids) {
+        pickScene(scene_id, key, action, x, y);
+    }
+}
+
+void PickingService::pickScene(uint32_t scene_id, int key, int action, int x, int y)
+{
+    auto ctx = m_context.lock();
+    if (ctx == nullptr) {
+        return;
+    }
+
+    auto scene = ctx->sceneStore->get(scene_id);
+    if (!scene.has_value() || !scene.value()->isActive()) {
+        return;
+    }
+
+    auto scene_value = scene.value();
+
+    auto requester = SceneRequester(ctx);
+    auto camera_nodes = requester.GetNodes(scene_value, ComponentType::Camera).GetNodes(ComponentType::Transform).Unwrap();
+    if (camera_nodes.empty() || !camera_nodes.front() || !camera_nodes.front()->isActive()) {
+        return;
+    }
+
+    auto camera_transform = SceneRequesterHelper::getComponent<TransformComponent>(scene_value, camera_nodes.front()->components());
+    if (!camera_transform.has_value()) {
+        return;
+    }
+
+    // mouse coordinates are relative to the camera position
+    const auto camera_position = camera_transform.value()->getPosition();
+    const glm::vec2 point(static_cast<float>(x) + camera_position.x, static_cast<float>(y) + camera_position.y);
+
+    constexpr float depth_range = std::numeric_limits<float>::max();
+    m_candidates.clear();
+    scene_value->queryNodes(Aabb{ { point, -depth_range }, { point, depth_range } }, m_candidates);
+
+    m_hits.clear();
+    for (auto node_id : m_candidates) {
+        if (!m_node_filters.contains(node_id)) {
+            continue;
+        }
+
+        auto indexed = scene_value->indexedNode(node_id);
+        if (!indexed.has_value()) {
+            continue;
+        }
+
+        // exact test in the local space of the mesh or texture rect, handles rotated and scaled rects
+        const auto& model = indexed.value().model;
+        const float depth = model[3].z;
+        const glm::vec3 local = glm::vec3(glm::inverse(model) * glm::vec4(point, depth, 1.0f));
+        const auto& bounds = indexed.value().local_bounds;
+        if (local.x < bounds.min.x || local.x > bounds.max.x || local.y < bounds.min.y || local.y > bounds.max.y) {
+            continue;
+        }
+
+        m_hits.push_back({ node_id, depth });
+    }
+
+    std::ranges::sort(m_hits, [](const Hit& a, const Hit& b) {
+        return a.depth != b.depth ? a.depth > b.depth : a.node_id < b.node_id;
+    });
+
+    m_dispatch.clear();
+    for (const auto& hit : m_hits) {
+        auto node = scene_value->getNode(hit.node_id);
+        if (!node.has_value() || !node.value()->isActive()) {
+            continue;
+        }
+
+        for (auto* filter : m_node_filters.at(hit.node_id)) {
+            if (filter->key() == key && filter->action() == action && filter->isActive() && filter->isValid()) {
+                m_dispatch.push_back({ hit.node_id, filter });
+            }
+        }
+    }
+
+    // a callback may destroy filters queued after it, so each one is checked
+    // against the registry by address before being touched
+    const auto dispatch = m_dispatch;
+    for (const auto& [node_id, filter] : dispatch) {
+        if (isRegistered(node_id, filter)) {
+            filter->onMouseClick(x, y);
+        }
+    }
+}
+
+auto PickingService::isRegistered(uint32_t node_id, const MouseEventFilterComponent* filter) const -> bool
+{
+    auto it = m_node_filters.find(node_id);
+    return it != m_node_filters.end() && std::ranges::find(it->second, filter) != it->second.end();
+}
+
+}
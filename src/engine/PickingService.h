@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+struct Context;
+class Scene;
+class MouseEventFilterComponent;
+
+// Resolves mouse clicks against the scene spatial index once per click and
+// dispatches them to the mouse event filters of the hit nodes, topmost first.
+// Nodes without a mesh are indexed by the rect of their material's texture.
+// Filters register themselves, one input handler is kept per mouse key.
+class PickingService final {
+public:
+    explicit PickingService(const std::weak_ptr<Context>& context);
+    ~PickingService() = default;
+    PickingService(const PickingService&) = delete;
+    PickingService(PickingService&&) = delete;
+    PickingService& operator=(const PickingService&) = delete;
+    PickingService& operator=(PickingService&&) = delete;
+
+    void addFilter(MouseEventFilterComponent* filter);
+    void removeFilter(MouseEventFilterComponent* filter);
+
+    // resolves one click, called by the mouse handler of its key
+    void pick(int key, int action, int x, int y);
+
+private:
+    struct Hit {
+        uint32_t node_id;
+        float depth;
+    };
+
+    void pickScene(uint32_t scene_id, int key, int action, int x, int y);
+
+    auto isRegistered(uint32_t node_id, const MouseEventFilterComponent* filter) const -> bool;
+
+    std::weak_ptr<Context> m_context;
+
+    std::unordered_map<uint32_t, std::vector<MouseEventFilterComponent*>> m_node_filters;
+    std::unordered_map<uint32_t, size_t> m_scene_filter_count;
+    std::unordered_map<int, size_t> m_key_filter_count;
+
+    std::vector<uint32_t> m_candidates;
+    std::vector<Hit> m_hits;
+    std::vector<std::pair<uint32_t, MouseEventFilterComponent*>> m_dispatch;
+};
+
+}
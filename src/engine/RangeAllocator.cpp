@@ -0,0 +1,65 @@
+#include "RangeAllocator.h"
+
+#include <iterator>
+
+namespace engine {
+
+RangeAllocator::RangeAllocator(uint32_t capacity) :
+    m_capacity(capacity)
+{
+    m_free.emplace(0, capacity);
+}
+
+auto RangeAllocator::allocate(uint32_t size) -> std::optional<uint32_t>
+{
+    for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+        if (it->second < size) {
+            continue;
+        }
+
+        const uint32_t offset = it->first;
+        const uint32_t remaining = it->second - size;
+        m_free.erase(it);
+        if (remaining > 0) {
+            m_free.emplace(offset + size, remaining);
+        }
+
+        m_used += size;
+        return offset;
+    }
+
+    return std::nullopt;
+}
+
+void RangeAllocator::release(uint32_t offset, uint32_t size)
+{
+    m_used -= size;
+
+    auto next = m_free.lower_bound(offset);
+    if (next != m_free.end() && offset + size == next->first) {
+        size += next->second;
+        next = m_free.erase(next);
+    }
+
+    if (next != m_free.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += size;
+            return;
+        }
+    }
+
+    m_free.emplace(offset, size);
+}
+
+auto RangeAllocator::capacity() const -> uint32_t
+{
+    return m_capacity;
+}
+
+auto RangeAllocator::used() const -> uint32_t
+{
+    return m_used;
+}
+
+}
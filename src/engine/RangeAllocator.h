@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace engine {
+
+// First fit over free ranges kept sorted by offset, neighbours merge on release.
+// Sizes and offsets are in elements, see GeometryPool.
+class RangeAllocator final {
+public:
+    explicit RangeAllocator(uint32_t capacity);
+
+    auto allocate(uint32_t size) -> std::optional<uint32_t>;
+    void release(uint32_t offset, uint32_t size);
+
+    auto capacity() const -> uint32_t;
+    auto used() const -> uint32_t;
+
+private:
+    std::map<uint32_t, uint32_t> m_free;
+    uint32_t m_capacity;
+    uint32_t m_used = 0;
+};
+
+}
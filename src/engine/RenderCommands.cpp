@@ -0,0 +1,341 @@
+#include "RenderCommands.h"
+#include "GLStateCache.h"
+#include "MeshStore.h"
+#include "MultiDraw.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "UniformBlock.h"
+#include "UniformBuffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace engine {
+
+namespace {
+
+// header of one packed render data value, the value bytes follow it
+struct UniformValue {
+    GLint location;
+    Uniform::Type type;
+    uint32_t size;
+};
+
+}
+
+void CommandList::clear()
+{
+    m_commands.clear();
+    m_data.clear();
+    m_items.clear();
+}
+
+void CommandList::useProgram(const Shader& shader)
+{
+    RenderCommand command{};
+    command.type = RenderCommand::Type::UseProgram;
+    command.shader = &shader;
+    m_commands.push_back(command);
+}
+
+void CommandList::setDepthState(GLenum function, bool mask)
+{
+    RenderCommand command{};
+    command.type = RenderCommand::Type::SetDepthState;
+    command.location = static_cast<GLint>(function);
+    command.size = mask ? 1 : 0;
+    m_commands.push_back(command);
+}
+
+void CommandList::setMatrix(const Shader& shader, GLint location, const glm::mat4& value)
+{
+    RenderCommand command{};
+    command.type = RenderCommand::Type::SetMatrix;
+    command.shader = &shader;
+    command.location = location;
+    command.offset = store(&value, sizeof(glm::mat4));
+    command.size = sizeof(glm::mat4);
+    m_commands.push_back(command);
+}
+
+void CommandList::pushObjectData(const void* data, size_t size)
+{
+    RenderCommand command{};
+    command.type = RenderCommand::Type::PushObjectData;
+    command.offset = store(data, size);
+    command.size = static_cast<uint32_t>(size);
+    m_commands.push_back(command);
+}
+
+void CommandList::uploadUniforms(const UniformBlockBinding& binding, const UniformBlock& block)
+{
+    RenderCommand command{};
+    command.type = RenderCommand::Type::UploadUniforms;
+    command.offset = static_cast<uint32_t>(m_data.size());
+
+    for (const auto& upload : binding.uploads()) {
+        const UniformValue value = { upload.location, upload.type, uniformTypeSize(upload.type) };
+        store(&value, sizeof(value));
+        store(block.data() + upload.offset, value.size);
+    }
+
+    command.size = static_cast<uint32_t>(m_data.size()) - command.offset;
+    m_commands.push_back(command);
+}
+
+void CommandList::bindTexture(const Texture& texture)
+{
+    RenderCommand command{};
+    command.type = RenderCommand::Type::BindTexture;
+    command.texture = &texture;
+    m_commands.push_back(command);
+}
+
+void CommandList::draw(const MeshData& mesh)
+{
+    RenderCommand command{};
+    command.type = RenderCommand::Type::Draw;
+    command.mesh = &mesh;
+    m_commands.push_back(command);
+}
+
+void CommandList::multiDraw(std::span<const DrawItem* const> items)
+{
+    RenderCommand command{};
+    command.type = RenderCommand::Type::MultiDraw;
+    command.offset = static_cast<uint32_t>(m_items.size());
+    command.size = static_cast<uint32_t>(items.size());
+    m_items.insert(m_items.end(), items.begin(), items.end());
+    m_commands.push_back(command);
+}
+
+auto CommandList::commands() const -> std::span<const RenderCommand>
+{
+    return m_commands;
+}
+
+auto CommandList::data(const RenderCommand& command) const -> const std::byte*
+{
+    return m_data.data() + command.offset;
+}
+
+auto CommandList::items(const RenderCommand& command) const -> std::span<const DrawItem* const>
+{
+    return std::span<const DrawItem* const>(m_items).subspan(command.offset, command.size);
+}
+
+auto CommandList::dataBytes() const -> size_t
+{
+    return m_data.size();
+}
+
+auto CommandList::store(const void* data, size_t size) -> uint32_t
+{
+    const auto offset = static_cast<uint32_t>(m_data.size());
+    m_data.resize(m_data.size() + size);
+    std::memcpy(m_data.data() + offset, data, size);
+    return offset;
+}
+
+GLRenderBackend::GLRenderBackend(UniformRingBuffer& object_uniforms, MultiDrawSubmitter& multi_draw) :
+    m_object_uniforms(object_uniforms),
+    m_multi_draw(multi_draw)
+{
+}
+
+auto GLRenderBackend::execute(GLStateCache& state, const CommandList& commands) -> uint32_t
+{
+    uint32_t draw_calls = 0;
+    // a full ring drops the draws up to the next program, as drawing them
+    // would read another object's data
+    bool skip_draws = false;
+
+    for (const auto& command : commands.commands()) {
+        switch (command.type) {
+            case RenderCommand::Type::UseProgram:
+                command.shader->use(state);
+                skip_draws = false;
+                break;
+            case RenderCommand::Type::SetDepthState:
+                state.depthFunc(static_cast<GLenum>(command.location));
+                state.depthMask(command.size != 0);
+                break;
+            case RenderCommand::Type::SetMatrix: {
+                glm::mat4 value;
+                std::memcpy(&value, commands.data(command), sizeof(glm::mat4));
+                command.shader->setUniform4mat(command.location, value);
+                break;
+            }
+            case RenderCommand::Type::PushObjectData:
+                skip_draws = !m_object_uniforms.push(commands.data(command), command.size).has_value();
+                break;
+            case RenderCommand::Type::UploadUniforms: {
+                const std::byte* data = commands.data(command);
+                const std::byte* end = data + command.size;
+                while (data < end) {
+                    UniformValue value;
+                    std::memcpy(&value, data, sizeof(value));
+                    data += sizeof(value);
+
+                    alignas(16) std::array<std::byte, sizeof(glm::mat4)> bytes;
+                    std::memcpy(bytes.data(), data, value.size);
+                    data += value.size;
+
+                    UniformBlockBinding::uploadValue(value.location, value.type, bytes.data());
+                }
+                break;
+            }
+            case RenderCommand::Type::BindTexture:
+                command.texture->bind(state);
+                break;
+            case RenderCommand::Type::Draw:
+                if (skip_draws) {
+                    break;
+                }
+                command.mesh->bind(state);
+                command.mesh->draw();
+                ++draw_calls;
+                break;
+            case RenderCommand::Type::MultiDraw:
+                if (skip_draws) {
+                    break;
+                }
+                draw_calls += m_multi_draw.submit(state, commands.items(command));
+                break;
+        }
+    }
+
+    return draw_calls;
+}
+
+auto NullRenderBackend::execute(GLStateCache&, const CommandList& commands) -> uint32_t
+{
+    ++m_stats.lists;
+    m_stats.commands += static_cast<uint32_t>(commands.commands().size());
+    m_stats.data_bytes += commands.dataBytes();
+
+    for (const auto& command : commands.commands()) {
+        if (command.type == RenderCommand::Type::Draw) {
+            ++m_stats.draws;
+        } else if (command.type == RenderCommand::Type::MultiDraw) {
+            m_stats.draws += command.size;
+        }
+    }
+
+    return 0;
+}
+
+auto NullRenderBackend::stats() const -> const Stats&
+{
+    return m_stats;
+}
+
+void NullRenderBackend::resetStats()
+{
+    m_stats = {};
+}
+
+CommandRecorder::CommandRecorder(uint32_t worker_count)
+{
+    if (worker_count == 0) {
+        const uint32_t hardware_threads = std::thread::hardware_concurrency();
+        worker_count = std::min(MAX_WORKERS, hardware_threads > 1 ? hardware_threads - 1 : 0);
+    }
+
+    // the calling thread records chunk 0
+    for (uint32_t chunk = 1; chunk <= worker_count; ++chunk) {
+        m_workers.emplace_back(&CommandRecorder::workerLoop, this, chunk);
+    }
+}
+
+CommandRecorder::~CommandRecorder()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void CommandRecorder::record(size_t count, const Job& job, std::vector<CommandList>& lists)
+{
+    const size_t wanted_chunks = std::max<size_t>(1, count / MIN_CHUNK_SIZE);
+    m_chunk_count = static_cast<uint32_t>(std::min(wanted_chunks, m_workers.size() + 1));
+    m_count = count;
+    m_job = &job;
+    m_lists = &lists;
+
+    // the lists keep their storage between frames
+    lists.resize(m_chunk_count);
+    for (auto& commands : lists) {
+        commands.clear();
+    }
+
+    if (m_chunk_count > 1) {
+        {
+            std::lock_guard lock(m_mutex);
+            ++m_generation;
+            m_pending = m_chunk_count - 1;
+        }
+        m_start.notify_all();
+
+        recordChunk(0);
+
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [this] {
+            return m_pending == 0;
+        });
+    } else {
+        recordChunk(0);
+    }
+
+    m_job = nullptr;
+    m_lists = nullptr;
+}
+
+void CommandRecorder::recordChunk(uint32_t chunk)
+{
+    const size_t chunk_size = (m_count + m_chunk_count - 1) / m_chunk_count;
+    const size_t begin = std::min(m_count, chunk * chunk_size);
+    const size_t end = std::min(m_count, begin + chunk_size);
+    if (begin < end) {
+        (*m_job)((*m_lists)[chunk], begin, end);
+    }
+}
+
+void CommandRecorder::workerLoop(uint32_t chunk)
+{
+    uint64_t generation = 0;
+
+    while (true) {
+        std::unique_lock lock(m_mutex);
+        m_start.wait(lock, [this, generation] {
+            return m_stop || m_generation != generation;
+        });
+
+        if (m_stop) {
+            return;
+        }
+
+        generation = m_generation;
+        // frames with fewer chunks than workers leave the last workers idle
+        if (chunk >= m_chunk_count) {
+            continue;
+        }
+        lock.unlock();
+
+        recordChunk(chunk);
+
+        lock.lock();
+        if (--m_pending == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+}
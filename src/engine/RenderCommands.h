@@ -0,0 +1,184 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace engine {
+
+class GLStateCache;
+class MultiDrawSubmitter;
+class Shader;
+class Texture;
+class UniformBlock;
+class UniformBlockBinding;
+class UniformRingBuffer;
+struct DrawItem;
+struct MeshData;
+
+// One GL operation of a recorded draw. Packets point at shaders, textures and meshes
+// that the stores and the frame's draw list keep alive until the replay, values
+// (matrices, object data, render data uniforms) are copied into the byte arena of
+// their list, so later changes to the scene do not reach a recorded frame.
+struct RenderCommand {
+    enum class Type : uint8_t {
+        UseProgram,
+        // location holds the depth function, size the depth mask
+        SetDepthState,
+        SetMatrix,
+        PushObjectData,
+        // offset and size select packed location, type and value records
+        UploadUniforms,
+        BindTexture,
+        Draw,
+        // offset and size select the list's item range
+        MultiDraw
+    };
+
+    Type type;
+    GLint location;
+    uint32_t offset;
+    uint32_t size;
+    union {
+        const Shader* shader;
+        const Texture* texture;
+        const MeshData* mesh;
+    };
+};
+
+static_assert(std::is_trivially_copyable_v<RenderCommand>);
+
+// Commands of a part of the frame in the order they have to reach GL. Recording
+// never calls GL, so a list can be filled on any thread as long as every thread
+// owns its list.
+class CommandList final {
+public:
+    void clear();
+
+    void useProgram(const Shader& shader);
+    void setDepthState(GLenum function, bool mask);
+    void setMatrix(const Shader& shader, GLint location, const glm::mat4& value);
+    void pushObjectData(const void* data, size_t size);
+    void uploadUniforms(const UniformBlockBinding& binding, const UniformBlock& block);
+    void bindTexture(const Texture& texture);
+    void draw(const MeshData& mesh);
+    // items sharing program, material and geometry arena, see MultiDrawSubmitter
+    void multiDraw(std::span<const DrawItem* const> items);
+
+    auto commands() const -> std::span<const RenderCommand>;
+    auto data(const RenderCommand& command) const -> const std::byte*;
+    auto items(const RenderCommand& command) const -> std::span<const DrawItem* const>;
+    auto dataBytes() const -> size_t;
+
+private:
+    auto store(const void* data, size_t size) -> uint32_t;
+
+    std::vector<RenderCommand> m_commands;
+    std::vector<std::byte> m_data;
+    std::vector<const DrawItem*> m_items;
+};
+
+// Replays command lists, execute() returns the GL draw calls issued
+class RenderBackend {
+public:
+    explicit RenderBackend() = default;
+    virtual ~RenderBackend() = default;
+
+    virtual auto execute(GLStateCache& state, const CommandList& commands) -> uint32_t = 0;
+};
+
+class GLRenderBackend final : public RenderBackend {
+public:
+    explicit GLRenderBackend(UniformRingBuffer& object_uniforms, MultiDrawSubmitter& multi_draw);
+    ~GLRenderBackend() override = default;
+    GLRenderBackend(const GLRenderBackend&) = delete;
+    GLRenderBackend(GLRenderBackend&&) = delete;
+    GLRenderBackend& operator=(const GLRenderBackend&) = delete;
+    GLRenderBackend& operator=(GLRenderBackend&&) = delete;
+
+    auto execute(GLStateCache& state, const CommandList& commands) -> uint32_t override;
+
+private:
+    UniformRingBuffer& m_object_uniforms;
+    MultiDrawSubmitter& m_multi_draw;
+};
+
+// Walks the lists without touching GL, the frame then costs only scene traversal,
+// draw preparation and recording
+class NullRenderBackend final : public RenderBackend {
+public:
+    struct Stats {
+        uint32_t lists = 0;
+        uint32_t commands = 0;
+        uint32_t draws = 0;
+        size_t data_bytes = 0;
+    };
+
+    explicit NullRenderBackend() = default;
+    ~NullRenderBackend() override = default;
+    NullRenderBackend(const NullRenderBackend&) = delete;
+    NullRenderBackend(NullRenderBackend&&) = delete;
+    NullRenderBackend& operator=(const NullRenderBackend&) = delete;
+    NullRenderBackend& operator=(NullRenderBackend&&) = delete;
+
+    auto execute(GLStateCache& state, const CommandList& commands) -> uint32_t override;
+
+    auto stats() const -> const Stats&;
+    void resetStats();
+
+private:
+    Stats m_stats;
+};
+
+// Records a range of work into command lists on persistent worker threads. The
+// range is split into contiguous chunks with one list each, so replaying the
+// lists in order keeps the order of the range.
+class CommandRecorder final {
+public:
+    using Job = std::function<void(CommandList& commands, size_t begin, size_t end)>;
+
+    // 0 picks a count from the hardware threads, the calling thread records a chunk too
+    explicit CommandRecorder(uint32_t worker_count = 0);
+    ~CommandRecorder();
+    CommandRecorder(const CommandRecorder&) = delete;
+    CommandRecorder(CommandRecorder&&) = delete;
+    CommandRecorder& operator=(const CommandRecorder&) = delete;
+    CommandRecorder& operator=(CommandRecorder&&) = delete;
+
+    // lists gets one list per chunk; the job runs concurrently for different
+    // chunks and must not call GL
+    void record(size_t count, const Job& job, std::vector<CommandList>& lists);
+
+private:
+    static constexpr uint32_t MAX_WORKERS = 3;
+    // below this the wake up costs more than the recording
+    static constexpr size_t MIN_CHUNK_SIZE = 64;
+
+    void recordChunk(uint32_t chunk);
+    void workerLoop(uint32_t chunk);
+
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    uint32_t m_pending = 0;
+    bool m_stop = false;
+
+    const Job* m_job = nullptr;
+    std::vector<CommandList>* m_lists = nullptr;
+    size_t m_count = 0;
+    uint32_t m_chunk_count = 0;
+};
+
+}
@@ -0,0 +1,424 @@
+#include "RenderGraph.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <numeric>
+
+namespace engine {
+
+RenderGraph::PassBuilder::PassBuilder(RenderGraph& graph, uint32_t pass) :
+    m_graph(graph),
+    m_pass(pass)
+{
+}
+
+auto RenderGraph::PassBuilder::createTarget(const std::string& name, const TargetDesc& desc) -> ResourceId
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    m_graph.m_resources.push_back(std::move(resource));
+
+    const auto id = static_cast<ResourceId>(m_graph.m_resources.size() - 1);
+    write(id);
+    return id;
+}
+
+void RenderGraph::PassBuilder::read(ResourceId resource)
+{
+    m_graph.m_passes[m_pass].reads.push_back(resource);
+}
+
+void RenderGraph::PassBuilder::write(ResourceId resource)
+{
+    m_graph.m_passes[m_pass].writes.push_back(resource);
+}
+
+void RenderGraph::PassBuilder::setSideEffect()
+{
+    m_graph.m_passes[m_pass].side_effect = true;
+}
+
+RenderGraph::Resources::Resources(const RenderGraph& graph) :
+    m_graph(graph)
+{
+}
+
+auto RenderGraph::Resources::texture(ResourceId resource) const -> GLuint
+{
+    const auto& value = m_graph.m_resources[resource];
+    if (value.imported || value.physical == NO_PHYSICAL) {
+        return 0;
+    }
+    return m_graph.m_physical[value.physical].color;
+}
+
+auto RenderGraph::Resources::framebuffer(ResourceId resource) const -> GLuint
+{
+    const auto& value = m_graph.m_resources[resource];
+    if (value.imported || value.physical == NO_PHYSICAL) {
+        return 0;
+    }
+    return m_graph.m_physical[value.physical].framebuffer;
+}
+
+auto RenderGraph::Resources::size(ResourceId resource) const -> std::pair<uint32_t, uint32_t>
+{
+    const auto& value = m_graph.m_resources[resource];
+    if (value.imported || value.physical == NO_PHYSICAL) {
+        return { m_graph.m_backbuffer_width, m_graph.m_backbuffer_height };
+    }
+    const auto& physical = m_graph.m_physical[value.physical];
+    return { physical.width, physical.height };
+}
+
+RenderGraph::~RenderGraph()
+{
+    clear();
+}
+
+auto RenderGraph::importBackbuffer(const std::string& name) -> ResourceId
+{
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    m_resources.push_back(std::move(resource));
+
+    m_compiled = false;
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+
+void RenderGraph::addPass(const std::string& name, const Setup& setup, const Execute& execute)
+{
+    Pass pass;
+    pass.name = name;
+    pass.execute = execute;
+    m_passes.push_back(std::move(pass));
+
+    PassBuilder builder(*this, static_cast<uint32_t>(m_passes.size() - 1));
+    setup(builder);
+
+    m_compiled = false;
+}
+
+void RenderGraph::compile(uint32_t backbuffer_width, uint32_t backbuffer_height)
+{
+    if (m_compiled && backbuffer_width == m_backbuffer_width && backbuffer_height == m_backbuffer_height) {
+        return;
+    }
+
+    m_backbuffer_width = backbuffer_width;
+    m_backbuffer_height = backbuffer_height;
+
+    cullPasses();
+    releaseTargets();
+    allocateTargets();
+
+    m_timings.clear();
+    m_stats = {};
+    for (auto& pass : m_passes) {
+        ++m_stats.passes;
+        if (pass.culled) {
+            ++m_stats.culled_passes;
+            continue;
+        }
+
+        if (pass.queries.front() == 0) {
+            glGenQueries(static_cast<GLsizei>(pass.queries.size()), pass.queries.data());
+        }
+        m_timings.push_back({ pass.name });
+    }
+
+    for (const auto& resource : m_resources) {
+        if (!resource.imported && resource.physical != NO_PHYSICAL) {
+            ++m_stats.transient_targets;
+        }
+    }
+    m_stats.physical_targets = static_cast<uint32_t>(m_physical.size());
+
+    m_compiled = true;
+
+    Logger::info("RenderGraph: compiled {} passes, culled: {}, transient targets: {}, physical targets: {}",
+                 m_stats.passes, m_stats.culled_passes, m_stats.transient_targets, m_stats.physical_targets);
+}
+
+auto RenderGraph::isCompiled() const -> bool
+{
+    return m_compiled;
+}
+
+void RenderGraph::execute()
+{
+    if (!m_compiled) {
+        return;
+    }
+
+    const Resources resources(*this);
+    const size_t slot = m_frame % TIMER_FRAMES;
+
+    size_t timing = 0;
+    for (auto& pass : m_passes) {
+        if (pass.culled) {
+            continue;
+        }
+
+        collectTimings(pass, timing);
+        bindTarget(pass);
+
+        // a query still in flight keeps its slot, this frame just goes unmeasured on the GPU
+        const bool measure_gpu = !pass.pending[slot];
+        if (measure_gpu) {
+            glBeginQuery(GL_TIME_ELAPSED, pass.queries[slot]);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        pass.execute(resources);
+        const auto end = std::chrono::steady_clock::now();
+
+        if (measure_gpu) {
+            glEndQuery(GL_TIME_ELAPSED);
+            pass.pending[slot] = true;
+        }
+
+        m_timings[timing].cpu_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        ++timing;
+    }
+
+    // whatever runs after the graph expects the backbuffer
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, static_cast<GLsizei>(m_backbuffer_width), static_cast<GLsizei>(m_backbuffer_height));
+
+    ++m_frame;
+}
+
+void RenderGraph::clear()
+{
+    for (auto& pass : m_passes) {
+        if (pass.queries.front() != 0) {
+            glDeleteQueries(static_cast<GLsizei>(pass.queries.size()), pass.queries.data());
+        }
+    }
+
+    releaseTargets();
+
+    m_passes.clear();
+    m_resources.clear();
+    m_timings.clear();
+    m_stats = {};
+    m_compiled = false;
+}
+
+auto RenderGraph::timings() const -> const std::vector<PassTiming>&
+{
+    return m_timings;
+}
+
+auto RenderGraph::stats() const -> const Stats&
+{
+    return m_stats;
+}
+
+void RenderGraph::cullPasses()
+{
+    std::vector<std::vector<uint32_t>> producers(m_resources.size());
+
+    for (auto& resource : m_resources) {
+        resource.reader_count = 0;
+    }
+
+    for (uint32_t i = 0; i < m_passes.size(); ++i) {
+        auto& pass = m_passes[i];
+        pass.culled = false;
+        pass.references = static_cast<uint32_t>(pass.writes.size());
+        for (auto resource : pass.reads) {
+            ++m_resources[resource].reader_count;
+        }
+        for (auto resource : pass.writes) {
+            producers[resource].push_back(i);
+        }
+    }
+
+    // imported resources are read outside the graph, so they are never unused
+    std::vector<ResourceId> unused;
+    for (ResourceId id = 0; id < m_resources.size(); ++id) {
+        if (!m_resources[id].imported && m_resources[id].reader_count == 0) {
+            unused.push_back(id);
+        }
+    }
+
+    const auto cull = [this, &unused](Pass& pass) {
+        pass.culled = true;
+        for (auto read : pass.reads) {
+            auto& resource = m_resources[read];
+            if (--resource.reader_count == 0 && !resource.imported) {
+                unused.push_back(read);
+            }
+        }
+    };
+
+    for (auto& pass : m_passes) {
+        if (pass.references == 0 && !pass.side_effect) {
+            cull(pass);
+        }
+    }
+
+    while (!unused.empty()) {
+        const auto id = unused.back();
+        unused.pop_back();
+
+        for (auto producer : producers[id]) {
+            auto& pass = m_passes[producer];
+            if (pass.culled || pass.side_effect) {
+                continue;
+            }
+            if (--pass.references == 0) {
+                cull(pass);
+            }
+        }
+    }
+}
+
+void RenderGraph::allocateTargets()
+{
+    for (auto& resource : m_resources) {
+        resource.physical = NO_PHYSICAL;
+        resource.first_use = ~0u;
+        resource.last_use = 0;
+    }
+
+    for (uint32_t i = 0; i < m_passes.size(); ++i) {
+        const auto& pass = m_passes[i];
+        if (pass.culled) {
+            continue;
+        }
+
+        const auto touch = [this, i](ResourceId id) {
+            auto& resource = m_resources[id];
+            resource.first_use = std::min(resource.first_use, i);
+            resource.last_use = std::max(resource.last_use, i);
+        };
+        std::ranges::for_each(pass.reads, touch);
+        std::ranges::for_each(pass.writes, touch);
+    }
+
+    std::vector<ResourceId> order(m_resources.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::sort(order, {}, [this](ResourceId id) {
+        return m_resources[id].first_use;
+    });
+
+    for (auto id : order) {
+        auto& resource = m_resources[id];
+        if (resource.imported || resource.first_use == ~0u) {
+            continue;
+        }
+
+        const uint32_t width = resource.desc.width != 0 ? resource.desc.width : m_backbuffer_width;
+        const uint32_t height = resource.desc.height != 0 ? resource.desc.height : m_backbuffer_height;
+
+        // a target whose last user already ran can take over the framebuffer
+        auto physical = std::ranges::find_if(m_physical, [&](const PhysicalTarget& target) {
+            return target.desc == resource.desc && target.width == width && target.height == height &&
+                   target.free_after < resource.first_use;
+        });
+
+        if (physical == m_physical.end()) {
+            PhysicalTarget target;
+            target.desc = resource.desc;
+            target.width = width;
+            target.height = height;
+
+            glGenTextures(1, &target.color);
+            glBindTexture(GL_TEXTURE_2D, target.color);
+            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(resource.desc.color_format), static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            glGenFramebuffers(1, &target.framebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.color, 0);
+
+            if (resource.desc.depth) {
+                glGenRenderbuffers(1, &target.depth);
+                glBindRenderbuffer(GL_RENDERBUFFER, target.depth);
+                glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+                glBindRenderbuffer(GL_RENDERBUFFER, 0);
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+            }
+
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                Logger::error("RenderGraph: framebuffer for {} is incomplete", resource.name);
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            m_physical.push_back(target);
+            physical = std::prev(m_physical.end());
+        }
+
+        physical->free_after = resource.last_use;
+        resource.physical = static_cast<uint32_t>(std::distance(m_physical.begin(), physical));
+    }
+}
+
+void RenderGraph::releaseTargets()
+{
+    for (auto& target : m_physical) {
+        glDeleteFramebuffers(1, &target.framebuffer);
+        glDeleteTextures(1, &target.color);
+        if (target.depth != 0) {
+            glDeleteRenderbuffers(1, &target.depth);
+        }
+    }
+    m_physical.clear();
+
+    for (auto& resource : m_resources) {
+        resource.physical = NO_PHYSICAL;
+    }
+}
+
+void RenderGraph::bindTarget(const Pass& pass)
+{
+    for (auto id : pass.writes) {
+        const auto& resource = m_resources[id];
+        if (resource.imported || resource.physical == NO_PHYSICAL) {
+            continue;
+        }
+
+        const auto& physical = m_physical[resource.physical];
+        glBindFramebuffer(GL_FRAMEBUFFER, physical.framebuffer);
+        glViewport(0, 0, static_cast<GLsizei>(physical.width), static_cast<GLsizei>(physical.height));
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, static_cast<GLsizei>(m_backbuffer_width), static_cast<GLsizei>(m_backbuffer_height));
+}
+
+void RenderGraph::collectTimings(Pass& pass, size_t pass_index)
+{
+    for (size_t i = 0; i < TIMER_FRAMES; ++i) {
+        // oldest slot first so the newest finished frame wins
+        const size_t slot = (m_frame + 1 + i) % TIMER_FRAMES;
+        if (!pass.pending[slot]) {
+            continue;
+        }
+
+        GLint available = 0;
+        glGetQueryObjectiv(pass.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(pass.queries[slot], GL_QUERY_RESULT, &elapsed);
+        pass.pending[slot] = false;
+        m_timings[pass_index].gpu_ms = static_cast<double>(elapsed) / 1'000'000.0;
+    }
+}
+
+}
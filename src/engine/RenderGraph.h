@@ -0,0 +1,160 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace engine {
+
+// Frame level render graph. Passes declare the resources they read and write when
+// they are added and run in that order. compile() drops passes whose results
+// nobody uses and gives every transient render target a physical framebuffer,
+// sharing one between targets of the same description whose lifetimes do not
+// overlap. execute() runs the surviving passes with their target bound and
+// measures each of them on the CPU and the GPU.
+class RenderGraph final {
+public:
+    using ResourceId = uint32_t;
+
+    struct TargetDesc {
+        // 0 follows the backbuffer size
+        uint32_t width = 0;
+        uint32_t height = 0;
+        GLenum color_format = GL_RGBA8;
+        bool depth = true;
+
+        bool operator==(const TargetDesc&) const = default;
+    };
+
+    class PassBuilder final {
+    public:
+        auto createTarget(const std::string& name, const TargetDesc& desc) -> ResourceId;
+        void read(ResourceId resource);
+        // a pass renders into the first target it writes
+        void write(ResourceId resource);
+        // kept even when nothing reads its outputs, e.g. readbacks and queries
+        void setSideEffect();
+
+    private:
+        friend class RenderGraph;
+
+        PassBuilder(RenderGraph& graph, uint32_t pass);
+
+        RenderGraph& m_graph;
+        uint32_t m_pass;
+    };
+
+    class Resources final {
+    public:
+        // color texture of a transient target, 0 for the backbuffer
+        auto texture(ResourceId resource) const -> GLuint;
+        // 0 for the backbuffer, e.g. to blit a transient target from
+        auto framebuffer(ResourceId resource) const -> GLuint;
+        auto size(ResourceId resource) const -> std::pair<uint32_t, uint32_t>;
+
+    private:
+        friend class RenderGraph;
+
+        explicit Resources(const RenderGraph& graph);
+
+        const RenderGraph& m_graph;
+    };
+
+    using Setup = std::function<void(PassBuilder&)>;
+    using Execute = std::function<void(const Resources&)>;
+
+    struct PassTiming {
+        std::string name;
+        double cpu_ms = 0.0;
+        // from a frame the GPU finished a few frames ago
+        std::optional<double> gpu_ms{};
+    };
+
+    struct Stats {
+        uint32_t passes = 0;
+        uint32_t culled_passes = 0;
+        uint32_t transient_targets = 0;
+        uint32_t physical_targets = 0;
+    };
+
+    RenderGraph() = default;
+    ~RenderGraph();
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph(RenderGraph&&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+    RenderGraph& operator=(RenderGraph&&) = delete;
+
+    auto importBackbuffer(const std::string& name) -> ResourceId;
+    void addPass(const std::string& name, const Setup& setup, const Execute& execute);
+
+    // culls and allocates, again only when the backbuffer size changes
+    void compile(uint32_t backbuffer_width, uint32_t backbuffer_height);
+    auto isCompiled() const -> bool;
+    void execute();
+    // drops passes, resources and their framebuffers
+    void clear();
+
+    auto timings() const -> const std::vector<PassTiming>&;
+    auto stats() const -> const Stats&;
+
+private:
+    static constexpr size_t TIMER_FRAMES = 4;
+    static constexpr uint32_t NO_PHYSICAL = ~0u;
+
+    struct Resource {
+        std::string name;
+        bool imported = false;
+        TargetDesc desc;
+        uint32_t reader_count = 0;
+        uint32_t physical = NO_PHYSICAL;
+        uint32_t first_use = ~0u;
+        uint32_t last_use = 0;
+    };
+
+    struct Pass {
+        std::string name;
+        Execute execute;
+        std::vector<ResourceId> reads;
+        std::vector<ResourceId> writes;
+        bool side_effect = false;
+        bool culled = false;
+        uint32_t references = 0;
+        std::array<GLuint, TIMER_FRAMES> queries{};
+        std::array<bool, TIMER_FRAMES> pending{};
+    };
+
+    struct PhysicalTarget {
+        TargetDesc desc;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        GLuint framebuffer = 0;
+        GLuint color = 0;
+        GLuint depth = 0;
+        uint32_t free_after = 0;
+    };
+
+    void cullPasses();
+    void allocateTargets();
+    void releaseTargets();
+    void bindTarget(const Pass& pass);
+    void collectTimings(Pass& pass, size_t pass_index);
+
+    std::vector<Pass> m_passes;
+    std::vector<Resource> m_resources;
+    std::vector<PhysicalTarget> m_physical;
+
+    uint32_t m_backbuffer_width = 0;
+    uint32_t m_backbuffer_height = 0;
+    bool m_compiled = false;
+
+    size_t m_frame = 0;
+    std::vector<PassTiming> m_timings;
+    Stats m_stats;
+};
+
+}
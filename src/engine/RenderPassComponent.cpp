@@ -1,5 +1,7 @@
 #include "RenderPassComponent.h"
 #include "Utils.h"
+#include "Context.h"
+#include "RenderPassStore.h"
 
 #include <memory>
 
@@ -52,6 +54,8 @@ auto RenderPassComponent::clone(uint32_t owner_node_id) const -> std::unique_ptr
 void RenderPassComponent::setRenderPassName(const std::string& render_pass_name)
 {
     m_render_pass_name = render_pass_name;
+    m_render_pass.reset();
+    markChanged();
 }
 
 auto RenderPassComponent::renderPassName() const -> const std::string&
@@ -59,4 +63,24 @@ auto RenderPassComponent::renderPassName() const -> const std::string&
     return m_render_pass_name;
 }
 
-}
\ No newline at end of file
+auto RenderPassComponent::renderPass() const -> std::optional<std::shared_ptr<RenderPass>>
+{
+    if (m_render_pass) {
+        return m_render_pass;
+    }
+
+    auto ctx = context().lock();
+    if (!ctx) {
+        return std::nullopt;
+    }
+
+    auto render_pass = ctx->renderPassStore->get(m_render_pass_name);
+    if (!render_pass.has_value()) {
+        return std::nullopt;
+    }
+
+    m_render_pass = render_pass.value();
+    return m_render_pass;
+}
+
+}
@@ -2,8 +2,13 @@
 
 #include "Component.h"
 
+#include <memory>
+#include <optional>
+
 namespace engine {
 
+class RenderPass;
+
 class RenderPassComponent final : public Component {
 public:
     explicit RenderPassComponent(uint32_t id, const std::string& name, uint32_t owner_node, uint32_t owner_scene);
@@ -27,8 +32,12 @@ public:
     [[nodiscard]]
     auto renderPassName() const -> const std::string&;
 
+    // resolved through the RenderPassStore once, again after the name changes
+    auto renderPass() const -> std::optional<std::shared_ptr<RenderPass>>;
+
 private:
     std::string m_render_pass_name;
+    mutable std::shared_ptr<RenderPass> m_render_pass;
 };
 
 }
\ No newline at end of file
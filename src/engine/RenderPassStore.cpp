@@ -9,8 +9,9 @@ namespace engine {
 
 RenderPassStore::RenderPassStore()
 {
-    m_renderPasses["base_render_pass"] = std::make_shared<BaseRenderPass>();
-    m_renderPasses["base_light_render_pass"] = std::make_shared<BaseLightRenderPass>();
+    auto base_render_pass = std::make_shared<BaseRenderPass>();
+    m_renderPasses["base_render_pass"] = base_render_pass;
+    m_renderPasses["base_light_render_pass"] = std::make_shared<BaseLightRenderPass>(base_render_pass);
 }
 
 bool RenderPassStore::contains(std::string name) const
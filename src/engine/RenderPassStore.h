@@ -4,6 +4,7 @@
 #include <optional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace engine {
 
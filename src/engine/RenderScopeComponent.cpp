@@ -57,7 +57,19 @@ auto RenderScopeComponent::isSprite() const -> bool
 void RenderScopeComponent::setIsSprite(bool is_sprite)
 {
     m_render_data.is_sprite = is_sprite;
-}   
+    markChanged();
+}
+
+auto RenderScopeComponent::isOccluder() const -> bool
+{
+    return m_render_data.is_occluder;
+}
+
+void RenderScopeComponent::setIsOccluder(bool is_occluder)
+{
+    m_render_data.is_occluder = is_occluder;
+    markChanged();
+}
 
 auto RenderScopeComponent::renderData() const -> const RenderData&
 {
@@ -67,6 +79,7 @@ auto RenderScopeComponent::renderData() const -> const RenderData&
 void RenderScopeComponent::setRenderData(const RenderData& render_data)
 {
     m_render_data = render_data;
+    invalidateUniformBlock();
 }
 
 auto RenderScopeComponent::renderData(const std::string& name) const -> std::optional<std::any>
@@ -81,6 +94,33 @@ auto RenderScopeComponent::renderData(const std::string& name) const -> std::opt
 void RenderScopeComponent::addRenderData(const std::string& name, const std::any& value)
 {
     m_render_data.uniforms[name] = value;
+    invalidateUniformBlock();
+}
+
+auto RenderScopeComponent::uniformBlock() const -> const UniformBlock&
+{
+    if (m_uniform_block_dirty) {
+        m_uniform_block = UniformBlock(m_render_data.uniforms);
+        m_uniform_block_dirty = false;
+    }
+    return m_uniform_block;
+}
+
+auto RenderScopeComponent::uniformBinding(const std::shared_ptr<Shader>& shader) const -> const UniformBlockBinding&
+{
+    // an expired pointer means the program was rebuilt even if the address is reused
+    if (m_uniform_binding_shader.lock() != shader) {
+        m_uniform_binding = UniformBlockBinding(uniformBlock(), *shader);
+        m_uniform_binding_shader = shader;
+    }
+    return m_uniform_binding;
+}
+
+void RenderScopeComponent::invalidateUniformBlock()
+{
+    m_uniform_block_dirty = true;
+    m_uniform_binding_shader.reset();
+    markChanged();
 }
 
 }
@@ -1,19 +1,25 @@
 #pragma once
 
 #include "Component.h"
+#include "UniformBlock.h"
 
 #include <string>
 #include <cstdint>
 #include <unordered_map>
 #include <any>
+#include <memory>
 
 namespace engine {
 
+class Shader;
+
 class RenderScopeComponent final : public Component {
 public:
     struct RenderData {
         std::unordered_map<std::string, std::any> uniforms{};
         bool is_sprite = false;
+        // rasterized into the software occlusion buffer when occlusion culling is on
+        bool is_occluder = false;
     };
 
     explicit RenderScopeComponent(uint32_t id, const std::string& name, uint32_t owner_node, uint32_t owner_scene);
@@ -35,6 +41,10 @@ public:
     auto isSprite() const -> bool;
     void setIsSprite(bool is_sprite);
 
+    [[nodiscard]]
+    auto isOccluder() const -> bool;
+    void setIsOccluder(bool is_occluder);
+
     [[nodiscard]]
     auto renderData() const -> const RenderData&;
     void setRenderData(const RenderData& render_data);
@@ -43,8 +53,22 @@ public:
     auto renderData(const std::string& name) const -> std::optional<std::any>;
     void addRenderData(const std::string& name, const std::any& value);
 
+    [[nodiscard]]
+    auto uniformBlock() const -> const UniformBlock&;
+    [[nodiscard]]
+    auto uniformBinding(const std::shared_ptr<Shader>& shader) const -> const UniformBlockBinding&;
+
 private:
+    void invalidateUniformBlock();
+
     RenderData m_render_data;
+
+    // packed form of m_render_data.uniforms, rebuilt only when the uniforms change
+    mutable UniformBlock m_uniform_block;
+    mutable bool m_uniform_block_dirty = true;
+
+    mutable UniformBlockBinding m_uniform_binding;
+    mutable std::weak_ptr<Shader> m_uniform_binding_shader;
 };
 
 }
@@ -0,0 +1,122 @@
+#include "RenderThread.h"
+#include "Logger.h"
+
+#include <algorithm>
+
+namespace engine {
+
+RenderThread::RenderThread(uint32_t frame_latency, Callbacks callbacks) :
+    m_callbacks(std::move(callbacks)),
+    m_frame_latency(std::max<uint32_t>(frame_latency, 1))
+{
+    // one frame is filled while the others are in flight
+    for (uint32_t i = 0; i <= m_frame_latency; ++i) {
+        m_frames.push_back(std::make_unique<Renderer::Frame>());
+    }
+
+    m_callbacks.release_context();
+    m_thread = std::thread(&RenderThread::loop, this);
+
+    Logger::info("RenderThread: started, frame latency: {}", m_frame_latency);
+}
+
+RenderThread::~RenderThread()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+
+    m_thread.join();
+    m_callbacks.make_context_current();
+
+    Logger::info("RenderThread: stopped");
+}
+
+void RenderThread::invoke(const std::function<void()>& job)
+{
+    bool finished = false;
+
+    push([this, &job, &finished] {
+        job();
+
+        std::lock_guard lock(m_mutex);
+        finished = true;
+        m_done.notify_all();
+    });
+
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [&finished] {
+        return finished;
+    });
+}
+
+auto RenderThread::acquireFrame() -> Renderer::Frame&
+{
+    // frames are submitted in order, with at most frame_latency of them in flight
+    // the one submitted frame_latency + 1 frames ago is done
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] {
+        return m_in_flight <= m_frame_latency;
+    });
+
+    return *m_frames[m_next_frame];
+}
+
+void RenderThread::submitFrame()
+{
+    auto& frame = *m_frames[m_next_frame];
+    m_next_frame = (m_next_frame + 1) % m_frames.size();
+
+    {
+        std::lock_guard lock(m_mutex);
+        ++m_in_flight;
+    }
+
+    push([this, &frame] {
+        m_callbacks.present(frame);
+
+        std::lock_guard lock(m_mutex);
+        --m_in_flight;
+        m_done.notify_all();
+    });
+}
+
+void RenderThread::push(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+void RenderThread::loop()
+{
+    m_callbacks.make_context_current();
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] {
+                return m_stop || !m_tasks.empty();
+            });
+
+            // queued frames are still presented before stopping
+            if (m_tasks.empty()) {
+                break;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+
+    m_callbacks.release_context();
+}
+
+}
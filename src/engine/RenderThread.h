@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Renderer.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+// Owns the GL context and submits the frames the simulation thread prepares.
+// Up to frame_latency frames may wait or be submitted while the simulation
+// fills the next one, so a frame costs about the longer of simulation and
+// submission instead of their sum. GL work the simulation can not avoid, like
+// resource loading, goes through invoke() and runs between two submits.
+class RenderThread final {
+public:
+    // the GL side of the thread, Engine binds them to the window and the renderer
+    struct Callbacks {
+        std::function<void()> make_context_current;
+        std::function<void()> release_context;
+        // submits and presents a frame, runs on the render thread
+        std::function<void(Renderer::Frame& frame)> present;
+    };
+
+    explicit RenderThread(uint32_t frame_latency, Callbacks callbacks);
+    // finishes the queued frames and hands the context back to the calling thread
+    ~RenderThread();
+    RenderThread(const RenderThread&) = delete;
+    RenderThread(RenderThread&&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+    RenderThread& operator=(RenderThread&&) = delete;
+
+    // blocks until the job ran on the render thread
+    void invoke(const std::function<void()>& job);
+
+    // a frame the render thread is done with, blocks while frame_latency frames are in flight
+    auto acquireFrame() -> Renderer::Frame&;
+    // queues the acquired frame for submission and presentation
+    void submitFrame();
+
+private:
+    void loop();
+    void push(std::function<void()> task);
+
+    Callbacks m_callbacks;
+    uint32_t m_frame_latency = 1;
+
+    std::vector<std::unique_ptr<Renderer::Frame>> m_frames;
+    size_t m_next_frame = 0;
+    uint32_t m_in_flight = 0;
+
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_stop = false;
+
+    std::thread m_thread;
+};
+
+}
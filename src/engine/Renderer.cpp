@@ -10,21 +10,132 @@
 #include "renderpasses/BaseRenderPass.h"
 #include "RenderPassStore.h"
 #include "RenderPassComponent.h"
+#include "Window.h"
+#include "MeshComponent.h"
+#include "MeshStore.h"
+#include "MaterialComponent.h"
+#include "RenderScopeComponent.h"
+#include "Shader.h"
+#include "ShaderStore.h"
+#include "StaticBatching.h"
+#include "TextureStore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
 
 namespace engine {
 
+namespace {
+
+auto uniformBlockHash(const UniformBlock& block) -> size_t
+{
+    size_t hash = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(block.data()), block.size()));
+    for (const auto& entry : block.entries()) {
+        hash = hash * 31 + std::hash<std::string>{}(entry.name);
+    }
+    return hash;
+}
+
+auto sameUniformBlock(const UniformBlock& a, const UniformBlock& b) -> bool
+{
+    if (&a == &b) {
+        return true;
+    }
+    if (a.size() != b.size() || a.entries().size() != b.entries().size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.entries().size(); ++i) {
+        if (a.entries()[i].name != b.entries()[i].name) {
+            return false;
+        }
+    }
+    return std::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+// gl_Position has to be computed the same way as in the shaders opting into the pre-pass,
+// their color pass then runs with GL_LEQUAL against this depth
+constexpr auto DEPTH_PREPASS_VERTEX = R"(#version 410 core
+layout (location = 0) in vec3 aPos;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 camera_position;
+    vec4 ambient_color;
+    vec4 cluster_scale;
+    uvec4 cluster_size;
+};
+
+uniform mat4 model;
+
+// material vertex shaders declare it too and compute gl_Position with the same expression,
+// their aModel attribute holding the same matrix, otherwise the main pass may fail
+// GL_LEQUAL against the depth laid down here
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
+)";
+
+constexpr auto DEPTH_PREPASS_FRAGMENT = R"(#version 410 core
+void main()
+{
+}
+)";
+
+}
+
+Renderer::Renderer() :
+    m_frame_uniform_buffer(std::make_unique<UniformBuffer>(sizeof(FrameUniforms), FRAME_UNIFORMS_BINDING)),
+    m_object_uniform_buffer(std::make_unique<UniformRingBuffer>(OBJECT_UNIFORMS_MAX_SIZE, OBJECT_SLOTS_PER_FRAME, OBJECT_UNIFORMS_BINDING)),
+    m_light_registry(std::make_unique<LightRegistry>()),
+    m_depth_prepass_shader(std::make_unique<Shader>("depth_prepass", DEPTH_PREPASS_VERTEX, DEPTH_PREPASS_FRAGMENT, "")),
+    m_overdraw_meter(std::make_unique<OverdrawMeter>()),
+    m_static_batcher(std::make_unique<StaticBatcher>()),
+    m_lod_selector(std::make_unique<LodSelector>()),
+    m_multi_draw(std::make_unique<MultiDrawSubmitter>()),
+    m_render_graph(std::make_unique<RenderGraph>()),
+    m_command_recorder(std::make_unique<CommandRecorder>()),
+    m_render_backend(std::make_unique<GLRenderBackend>(*m_object_uniform_buffer, *m_multi_draw)),
+    m_gl_invoker([](const std::function<void()>& job) { job(); }),
+    m_frame(createFrame())
+{
+    buildRenderGraph();
+}
+
+Renderer::~Renderer() = default;
+
 void Renderer::render(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene)
+{
+    prepare(context, scene, *m_frame);
+    submit(context, *m_frame);
+}
+
+auto Renderer::createFrame() -> std::unique_ptr<Frame>
+{
+    return std::make_unique<Frame>();
+}
+
+void Renderer::prepare(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene, Frame& frame)
 {
     Logger::info(__FUNCTION__);
 
-     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    frame.stats = {};
+    frame.has_camera = false;
+    frame.viewport = context->window->size();
 
-    static auto requester = SceneRequester(context);
-    auto nodes = requester.GetNodes(scene, ComponentType::Mesh).
-                                                 GetNodes(ComponentType::Material).
-                                                 GetNodes(ComponentType::Transform).Unwrap();
+    // a rebuild uploads into the geometry pool, the check alone stays here
+    if (m_static_batcher->needsRebuild(scene)) {
+        m_gl_invoker([this, &context, &scene] {
+            m_static_batcher->build(context, scene);
+        });
+    }
 
+    static auto requester = SceneRequester(context);
     auto camera_nodes = requester.GetNodes(scene, ComponentType::Camera).GetNodes(ComponentType::Transform).Unwrap();
     if (camera_nodes.empty()) {
         return;
@@ -50,24 +161,656 @@ void Renderer::render(const std::shared_ptr<Context>& context, const std::shared
     auto camera = camera_component.value();
     camera->setPosition(camera_position);
 
-    for (const auto& node : nodes) {
-        if (!node->isActive()) {
+    frame.has_camera = true;
+    updateFrameUniforms(scene, camera, frame);
+
+    // the scene index gives a conservative box test, the sphere test refines the candidates
+    const glm::mat4 view_projection = camera->getProjection() * camera->getView();
+    const Frustum frustum(view_projection);
+    m_candidates.clear();
+    scene->queryNodes(frustum, m_candidates);
+    // texture rects are only indexed for picking, they are neither drawn nor culled
+    std::erase_if(m_candidates, [&scene](uint32_t node_id) {
+        auto indexed = scene->indexedNode(node_id);
+        return !indexed.has_value() || indexed->mesh_id == 0;
+    });
+
+    m_lod_selector->beginFrame(camera->getProjection(), camera_position, frame.viewport.second);
+    collectDrawItems(context, scene, frame);
+    m_lod_selector->endFrame();
+    // the box test of the scene index rejected the meshes it did not return
+    frame.stats.culled = static_cast<uint32_t>(scene->spatialMeshCount() - m_candidates.size());
+    cullDrawItems(frustum, frame);
+    if (m_occlusion_culler) {
+        occludeDrawItems(view_projection, frame);
+    }
+
+    sortDrawItems(camera->getView(), frame);
+    mergeDrawItems(frame);
+    recordDrawItems(context, scene, camera, frame);
+
+    // the frame may outlive the nodes, only what the commands point at is kept
+    for (auto& draw : frame.draws) {
+        draw.item.node.reset();
+    }
+}
+
+void Renderer::submit(const std::shared_ptr<Context>& context, Frame& frame)
+{
+    Logger::info(__FUNCTION__);
+
+    m_frame_stats = frame.stats;
+
+    // resource loading and the editor issue GL calls outside the cache,
+    // so the shadow state is only trusted within one frame
+    auto& state = *context->glState;
+    state.invalidate();
+    state.resetStats();
+
+    state.setEnabled(GL_DEPTH_TEST, true);
+    state.depthMask(true);
+    state.setEnabled(GL_BLEND, true);
+    state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (!frame.has_camera) {
+        frame.draws.clear();
+        return;
+    }
+
+    m_frame_uniforms = frame.uniforms;
+    m_frame_uniform_buffer->update(&m_frame_uniforms, sizeof(FrameUniforms));
+    m_light_registry->upload(frame.lights);
+    m_light_registry->bind(state);
+
+    m_object_uniform_buffer->beginFrame();
+
+    m_submit_frame = &frame;
+    m_submit_state = &state;
+    m_render_graph->compile(static_cast<uint32_t>(frame.viewport.first), static_cast<uint32_t>(frame.viewport.second));
+    m_render_graph->execute();
+    m_submit_frame = nullptr;
+    m_submit_state = nullptr;
+
+    // leave the defaults the window set up for everything drawn after the scene
+    state.depthMask(true);
+
+    m_object_uniform_buffer->endFrame();
+
+    updateOverdrawStats(frame.viewport);
+
+    m_frame_stats.indirect_calls = m_multi_draw->stats().indirect_calls;
+
+    m_frame_stats.state = state.stats();
+    Logger::debug("Renderer: visible: {}, culled: {}, occluded: {}, occluder triangles: {}, LOD draws: {}, opaque: {}, blended: {}, draw calls: {}, merged draws: {}, indirect calls: {}, pre-pass draw calls: {}, recorded commands: {}, command lists: {}, samples passed: {}, overdraw: {:.2f}, state calls issued: {}, skipped: {}, lights: {}, light cluster entries: {}",
+                  m_frame_stats.visible, m_frame_stats.culled, m_frame_stats.occluded, m_frame_stats.occluder_triangles, m_frame_stats.lod_draws,
+                  m_frame_stats.opaque, m_frame_stats.blended, m_frame_stats.draw_calls,
+                  m_frame_stats.merged_draws, m_frame_stats.indirect_calls, m_frame_stats.prepass_draw_calls,
+                  m_frame_stats.recorded_commands, m_frame_stats.command_lists,
+                  m_frame_stats.samples_passed, m_frame_stats.overdraw,
+                  m_frame_stats.state.issued, m_frame_stats.state.skipped,
+                  m_frame_stats.lights, m_frame_stats.light_cluster_entries);
+    for (const auto& timing : m_render_graph->timings()) {
+        Logger::debug("Renderer: pass {}: cpu: {:.3f} ms, gpu: {:.3f} ms", timing.name, timing.cpu_ms, timing.gpu_ms.value_or(0.0));
+    }
+
+    // the last references to meshes a reload or a batch rebuild replaced go away here
+    frame.draws.clear();
+}
+
+void Renderer::setGLInvoker(const GLInvoker& invoker)
+{
+    if (!invoker) {
+        m_gl_invoker = [](const std::function<void()>& job) { job(); };
+        return;
+    }
+
+    m_gl_invoker = invoker;
+}
+
+auto Renderer::frameUniforms() const -> const FrameUniforms&
+{
+    return m_frame_uniforms;
+}
+
+auto Renderer::objectUniforms() -> UniformRingBuffer&
+{
+    return *m_object_uniform_buffer;
+}
+
+auto Renderer::multiDraw() -> MultiDrawSubmitter&
+{
+    return *m_multi_draw;
+}
+
+auto Renderer::passTimings() const -> const std::vector<RenderGraph::PassTiming>&
+{
+    return m_render_graph->timings();
+}
+
+void Renderer::registerDrawCall()
+{
+    ++m_frame_stats.draw_calls;
+}
+
+auto Renderer::frameStats() const -> const FrameStats&
+{
+    return m_frame_stats;
+}
+
+void Renderer::setOcclusionCulling(bool enabled)
+{
+    if (enabled == occlusionCulling()) {
+        return;
+    }
+
+    m_occlusion_culler = enabled ? std::make_unique<OcclusionCuller>() : nullptr;
+}
+
+auto Renderer::occlusionCulling() const -> bool
+{
+    return m_occlusion_culler != nullptr;
+}
+
+void Renderer::setNullBackend(bool enabled)
+{
+    if (enabled == m_null_backend) {
+        return;
+    }
+
+    m_null_backend = enabled;
+    if (enabled) {
+        m_render_backend = std::make_unique<NullRenderBackend>();
+    } else {
+        m_render_backend = std::make_unique<GLRenderBackend>(*m_object_uniform_buffer, *m_multi_draw);
+    }
+
+    Logger::info("Renderer: {} render backend", enabled ? "null" : "GL");
+}
+
+auto Renderer::nullBackend() const -> bool
+{
+    return m_null_backend;
+}
+
+void Renderer::setLodSettings(const LodSettings& settings)
+{
+    m_lod_selector->setSettings(settings);
+}
+
+auto Renderer::lodSettings() const -> const LodSettings&
+{
+    return m_lod_selector->settings();
+}
+
+void Renderer::buildStaticBatches(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene)
+{
+    // batches take their vertex transforms from the scene index
+    scene->updateSpatialIndex();
+    m_static_batcher->build(context, scene);
+}
+
+void Renderer::collectDrawItems(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene, Frame& frame)
+{
+    frame.draws.clear();
+    m_world_bounds.clear();
+
+    for (auto node_id : m_candidates) {
+        // drawn through their batch below
+        if (m_static_batcher->isBatched(node_id)) {
+            continue;
+        }
+
+        auto node_value = scene->getNode(node_id);
+        if (!node_value.has_value() || !node_value.value()->isActive()) {
+            continue;
+        }
+
+        const auto& node = node_value.value();
+
+        auto mesh = SceneRequesterHelper::getComponent<MeshComponent>(scene, node->components());
+        auto transform = SceneRequesterHelper::getComponent<TransformComponent>(scene, node->components());
+        if (!mesh.has_value() || !mesh.value()->isActive() || !mesh.value()->isValid() ||
+            !transform.has_value() || !transform.value()->isActive() || !transform.value()->isValid()) {
+            continue;
+        }
+
+        auto mesh_data = context->meshStore->get(mesh.value()->meshId());
+        if (!mesh_data.has_value()) {
+            continue;
+        }
+
+        // the index already holds the world model, sprite scale included
+        auto indexed = scene->indexedNode(node_id);
+        if (!indexed.has_value()) {
+            continue;
+        }
+        const auto& model = indexed->model;
+
+        auto draw_mesh = mesh_data.value();
+        const auto level = m_lod_selector->select(node_id, *draw_mesh, model);
+        if (level > 0) {
+            draw_mesh = draw_mesh->lods[level - 1].mesh;
+            ++frame.stats.lod_draws;
+        }
+
+        queueDraw(context, scene, frame, node, draw_mesh, model);
+    }
+
+    // batches are few and their vertices are already in world space
+    for (const auto& batch : m_static_batcher->batches()) {
+        queueDraw(context, scene, frame, batch.node, batch.mesh, glm::mat4(1.0f));
+    }
+}
+
+void Renderer::queueDraw(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene, Frame& frame,
+                         const std::shared_ptr<Node>& node, const std::shared_ptr<MeshData>& mesh, const glm::mat4& model)
+{
+    auto render_pass_component = SceneRequesterHelper::getComponent<RenderPassComponent>(scene, node->components());
+    if (!render_pass_component.has_value()) {
+        return;
+    }
+
+    auto render_pass = render_pass_component.value()->renderPass();
+    if (!render_pass.has_value()) {
+        return;
+    }
+
+    auto render_scope = SceneRequesterHelper::getComponent<RenderScopeComponent>(scene, node->components());
+    auto material = SceneRequesterHelper::getComponent<MaterialComponent>(scene, node->components());
+    const bool occluder = render_scope.has_value() && render_scope.value()->isOccluder();
+    const bool blended = material.has_value() && material.value()->isBlended();
+
+    // the recording threads only look textures up, the eviction bookkeeping stays here
+    if (material.has_value()) {
+        context->textureStore->markUsed(material.value()->textureId());
+    }
+
+    std::optional<std::shared_ptr<Shader>> shader;
+    uint32_t shader_variant = 0;
+    bool alpha_tested = false;
+    if (material.has_value()) {
+        const auto shader_id = material.value()->shaderId();
+        shader_variant = material.value()->shaderVariant();
+        static const std::string alpha_test = MaterialComponent::ALPHA_TEST_FEATURE;
+        alpha_tested = (shader_variant & context->shaderStore->variantMask(shader_id, std::span(&alpha_test, 1))) != 0;
+        shader = context->shaderStore->getVariant(shader_id, shader_variant);
+        // compiled on first use, recording only looks variants up
+        if (!shader.has_value() && shader_variant != 0) {
+            m_gl_invoker([&context, &shader, shader_id, shader_variant] {
+                shader = context->shaderStore->buildVariant(shader_id, shader_variant);
+            });
+        }
+    }
+
+    // the binding is built lazily and may log, recording threads then only look it up
+    if (shader.has_value() && render_scope.has_value()) {
+        static_cast<void>(render_scope.value()->uniformBinding(shader.value()));
+    }
+
+    bool depth_prepass = false;
+    bool mergeable = false;
+    MergeKey merge_key;
+    if (!blended && shader.has_value()) {
+        // the pre-pass writes depth for the whole triangle, an alpha tested draw would then
+        // hide what is behind its discarded texels
+        depth_prepass = shader.value()->wantsDepthPrepass() && !alpha_tested;
+        mergeable = shader.value()->wantsInstancedModel() && render_scope.has_value();
+    }
+
+    if (mergeable) {
+        const auto& uniforms = render_scope.value()->uniformBlock();
+        merge_key.shader_id = material.value()->shaderId();
+        merge_key.shader_variant = shader_variant;
+        merge_key.texture_id = material.value()->textureId();
+        merge_key.arena = mesh->allocation.arena;
+        merge_key.uniforms = &uniforms;
+        merge_key.hash = mergeKeyHash(render_pass.value().get(), merge_key);
+    }
+
+    const auto sphere = transformSphere(model, mesh->sphere_center, mesh->sphere_radius);
+    m_world_bounds.add(glm::vec3(sphere), sphere.w);
+
+    frame.draws.push_back({ render_pass.value(), { node, mesh, model }, occluder, blended, depth_prepass, mergeable, merge_key });
+}
+
+void Renderer::cullDrawItems(const Frustum& frustum, Frame& frame)
+{
+    m_world_bounds.cull(frustum, m_visible);
+
+    // candidates that queued no draw, e.g. without a material, count as neither
+    for (auto visible : m_visible) {
+        if (visible) {
+            ++frame.stats.visible;
+        } else {
+            ++frame.stats.culled;
+        }
+    }
+}
+
+void Renderer::occludeDrawItems(const glm::mat4& view_projection, Frame& frame)
+{
+    auto& draws = frame.draws;
+
+    // meshes used as occluders for the first time are read back from the geometry pool,
+    // they occlude nothing for the few frames the copy takes
+    bool readback = false;
+    for (size_t i = 0; i < draws.size() && !readback; ++i) {
+        readback = m_visible[i] && draws[i].occluder && !draws[i].item.mesh->hasGeometry();
+    }
+    if (readback) {
+        m_gl_invoker([this, &draws] {
+            for (size_t i = 0; i < draws.size(); ++i) {
+                if (m_visible[i] && draws[i].occluder) {
+                    draws[i].item.mesh->requestGeometry();
+                }
+            }
+        });
+    }
+
+    m_occlusion_culler->beginFrame(view_projection);
+
+    for (size_t i = 0; i < draws.size(); ++i) {
+        const auto& draw = draws[i];
+        if (m_visible[i] && draw.occluder && draw.item.mesh->hasGeometry()) {
+            const auto& geometry = draw.item.mesh->geometry();
+            m_occlusion_culler->addOccluder(draw.item.model, geometry.positions, geometry.indices);
+        }
+    }
+
+    frame.stats.occluder_triangles = static_cast<uint32_t>(m_occlusion_culler->triangleCount());
+    if (frame.stats.occluder_triangles == 0) {
+        return;
+    }
+
+    m_occlusion_culler->rasterize();
+
+    for (size_t i = 0; i < draws.size(); ++i) {
+        const auto& draw = draws[i];
+        if (!m_visible[i] || draw.occluder) {
             continue;
         }
 
-        auto render_pass_component = SceneRequesterHelper::getComponent<RenderPassComponent>(scene, node->components());
-        if (!render_pass_component.has_value()) {
+        const auto box = transformAabb(draw.item.model, { draw.item.mesh->aabb_min, draw.item.mesh->aabb_max });
+        if (!m_occlusion_culler->isVisible(box)) {
+            m_visible[i] = 0;
+            --frame.stats.visible;
+            ++frame.stats.occluded;
+        }
+    }
+}
+
+void Renderer::sortDrawItems(const glm::mat4& view, Frame& frame)
+{
+    auto& draws = frame.draws;
+
+    m_opaque.clear();
+    m_blended.clear();
+
+    for (size_t i = 0; i < draws.size(); ++i) {
+        if (!m_visible[i]) {
+            continue;
+        }
+
+        auto& draw = draws[i];
+        const glm::vec4 center = draw.item.model * glm::vec4(draw.item.mesh->sphere_center, 1.0f);
+        draw.depth = -(view * center).z;
+
+        (draw.blended ? m_blended : m_opaque).push_back(static_cast<uint32_t>(i));
+    }
+
+    // ties are broken by node id so equal depths keep a stable order between frames
+    const auto closer = [&draws](uint32_t a, uint32_t b) {
+        const auto& draw_a = draws[a];
+        const auto& draw_b = draws[b];
+        if (draw_a.depth != draw_b.depth) {
+            return draw_a.depth < draw_b.depth;
+        }
+        return draw_a.item.node->id() < draw_b.item.node->id();
+    };
+
+    std::ranges::sort(m_opaque, closer);
+    std::ranges::sort(m_blended, [&closer](uint32_t a, uint32_t b) {
+        return closer(b, a);
+    });
+
+    frame.stats.opaque = static_cast<uint32_t>(m_opaque.size());
+    frame.stats.blended = static_cast<uint32_t>(m_blended.size());
+}
+
+void Renderer::mergeDrawItems(Frame& frame)
+{
+    const auto& draws = frame.draws;
+
+    for (size_t group = 0; group < m_opaque_group_count; ++group) {
+        m_opaque_groups[group].clear();
+    }
+    m_opaque_group_count = 0;
+    m_open_groups.clear();
+
+    const auto new_group = [this](uint32_t index) -> size_t {
+        if (m_opaque_group_count == m_opaque_groups.size()) {
+            m_opaque_groups.emplace_back();
+        }
+        m_opaque_groups[m_opaque_group_count].push_back(index);
+        return m_opaque_group_count++;
+    };
+
+    // a group is drawn at the position of its closest member, which keeps
+    // the front to back order for the rest of the opaque draws
+    for (auto index : m_opaque) {
+        const auto& draw = draws[index];
+        if (!draw.mergeable) {
+            new_group(index);
             continue;
         }
 
-        auto render_pass_name = render_pass_component.value()->renderPassName();
-        auto render_pass = context->renderPassStore->get(render_pass_name);
-        if (!render_pass.has_value()) {
+        auto& candidates = m_open_groups[draw.merge_key.hash];
+        bool merged = false;
+        for (auto group : candidates) {
+            const auto& first = draws[m_opaque_groups[group].front()];
+            if (first.render_pass == draw.render_pass && sameMergeKey(first.merge_key, draw.merge_key)) {
+                m_opaque_groups[group].push_back(index);
+                ++frame.stats.merged_draws;
+                merged = true;
+                break;
+            }
+        }
+
+        if (!merged) {
+            candidates.push_back(new_group(index));
+        }
+    }
+}
+
+auto Renderer::mergeKeyHash(const RenderPass* render_pass, const MergeKey& key) -> size_t
+{
+    size_t hash = std::hash<const void*>{}(render_pass);
+    hash = hash * 31 + key.shader_id;
+    hash = hash * 31 + key.shader_variant;
+    hash = hash * 31 + key.texture_id;
+    hash = hash * 31 + key.arena;
+    hash = hash * 31 + uniformBlockHash(*key.uniforms);
+    return hash;
+}
+
+auto Renderer::sameMergeKey(const MergeKey& a, const MergeKey& b) -> bool
+{
+    return a.hash == b.hash && a.shader_id == b.shader_id && a.shader_variant == b.shader_variant && a.texture_id == b.texture_id &&
+           a.arena == b.arena && sameUniformBlock(*a.uniforms, *b.uniforms);
+}
+
+void Renderer::buildRenderGraph()
+{
+    // nothing reads the scene offscreen yet, so its passes draw straight into the window and
+    // none of them is culled; an effect reading the scene would move them into a transient
+    // target from createTarget() and add a pass writing the backbuffer after it
+    const auto backbuffer = m_render_graph->importBackbuffer("backbuffer");
+
+    m_render_graph->addPass("depth_prepass", [backbuffer](RenderGraph::PassBuilder& builder) {
+        builder.write(backbuffer);
+    }, [this](const RenderGraph::Resources&) {
+        renderDepthPrepass(*m_submit_state);
+    });
+
+    m_render_graph->addPass("opaque", [backbuffer](RenderGraph::PassBuilder& builder) {
+        builder.read(backbuffer);
+        builder.write(backbuffer);
+    }, [this](const RenderGraph::Resources&) {
+        renderOpaque(*m_submit_state);
+    });
+
+    m_render_graph->addPass("blended", [backbuffer](RenderGraph::PassBuilder& builder) {
+        builder.read(backbuffer);
+        builder.write(backbuffer);
+    }, [this](const RenderGraph::Resources&) {
+        renderBlended(*m_submit_state);
+    });
+}
+
+void Renderer::recordDrawItems(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene,
+                               const std::shared_ptr<CameraComponent>& camera, Frame& frame)
+{
+    recordDepthPrepass(frame);
+
+    m_record_groups.clear();
+    m_record_items.clear();
+    for (size_t group = 0; group < m_opaque_group_count; ++group) {
+        const auto& indices = m_opaque_groups[group];
+        const auto& draw = frame.draws[indices.front()];
+        m_record_groups.push_back({ draw.render_pass.get(), static_cast<uint32_t>(m_record_items.size()), static_cast<uint32_t>(indices.size()), draw.depth_prepass });
+        for (auto index : indices) {
+            m_record_items.push_back(&frame.draws[index].item);
+        }
+    }
+    recordGroups(context, scene, camera, true, frame.opaque_commands);
+
+    m_record_groups.clear();
+    m_record_items.clear();
+    for (auto index : m_blended) {
+        const auto& draw = frame.draws[index];
+        m_record_groups.push_back({ draw.render_pass.get(), static_cast<uint32_t>(m_record_items.size()), 1, false });
+        m_record_items.push_back(&draw.item);
+    }
+    recordGroups(context, scene, camera, false, frame.blended_commands);
+}
+
+void Renderer::recordGroups(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene,
+                            const std::shared_ptr<CameraComponent>& camera, bool opaque, std::vector<CommandList>& lists)
+{
+    const std::span<const DrawItem* const> items(m_record_items);
+
+    m_command_recorder->record(m_record_groups.size(), [&](CommandList& commands, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& group = m_record_groups[i];
+            if (opaque) {
+                commands.setDepthState(group.depth_prepass ? GL_LEQUAL : GL_LESS, !group.depth_prepass);
+            }
+            group.render_pass->record(context, scene, items.subspan(group.first, group.count), camera, commands);
+        }
+    }, lists);
+}
+
+void Renderer::recordDepthPrepass(Frame& frame)
+{
+    // few and cheap to record, this stays on the calling thread
+    frame.prepass_commands.clear();
+
+    const auto model_location = m_depth_prepass_shader->builtinLocations().model;
+    for (auto index : m_opaque) {
+        const auto& draw = frame.draws[index];
+        if (!draw.depth_prepass) {
             continue;
         }
 
-        render_pass.value()->render(context, scene, node, camera);
+        if (frame.prepass_commands.commands().empty()) {
+            frame.prepass_commands.useProgram(*m_depth_prepass_shader);
+        }
+        frame.prepass_commands.setMatrix(*m_depth_prepass_shader, model_location, draw.item.model);
+        frame.prepass_commands.draw(*draw.item.mesh);
+    }
+}
+
+void Renderer::renderOpaque(GLStateCache& state)
+{
+    m_overdraw_meter->begin();
+
+    // opaque front to back so early depth testing rejects hidden fragments,
+    // draws covered by the pre-pass only shade the fragments that survived it
+    state.setEnabled(GL_BLEND, false);
+    m_multi_draw->resetStats();
+
+    // the chunks were recorded in parallel, replaying them in order keeps the sort
+    for (const auto& commands : m_submit_frame->opaque_commands) {
+        m_frame_stats.draw_calls += executeCommands(state, commands);
+    }
+}
+
+void Renderer::renderBlended(GLStateCache& state)
+{
+    // blended back to front over the finished opaque depth, without writing it
+    state.setEnabled(GL_BLEND, true);
+    state.depthFunc(GL_LESS);
+    state.depthMask(false);
+    for (const auto& commands : m_submit_frame->blended_commands) {
+        m_frame_stats.draw_calls += executeCommands(state, commands);
     }
+
+    m_overdraw_meter->end();
+}
+
+void Renderer::renderDepthPrepass(GLStateCache& state)
+{
+    const auto& commands = m_submit_frame->prepass_commands;
+    if (commands.commands().empty()) {
+        return;
+    }
+
+    state.colorMask(false);
+    state.setEnabled(GL_BLEND, false);
+    state.depthMask(true);
+    state.depthFunc(GL_LESS);
+
+    m_frame_stats.prepass_draw_calls += executeCommands(state, commands);
+
+    state.colorMask(true);
+}
+
+auto Renderer::executeCommands(GLStateCache& state, const CommandList& commands) -> uint32_t
+{
+    ++m_frame_stats.command_lists;
+    m_frame_stats.recorded_commands += static_cast<uint32_t>(commands.commands().size());
+    return m_render_backend->execute(state, commands);
+}
+
+void Renderer::updateOverdrawStats(const std::pair<int, int>& viewport)
+{
+    const auto samples_passed = m_overdraw_meter->samplesPassed();
+    if (!samples_passed.has_value()) {
+        return;
+    }
+
+    m_frame_stats.samples_passed = samples_passed.value();
+
+    const auto [width, height] = viewport;
+    if (width > 0 && height > 0) {
+        m_frame_stats.overdraw = static_cast<float>(static_cast<double>(samples_passed.value()) / (static_cast<double>(width) * height));
+    }
+}
+
+void Renderer::updateFrameUniforms(const std::shared_ptr<Scene>& scene, const std::shared_ptr<CameraComponent>& camera, Frame& frame)
+{
+    frame.uniforms.view = camera->getView();
+    frame.uniforms.projection = camera->getProjection();
+    frame.uniforms.camera_position = glm::vec4(camera->getPosition(), 1.0f);
+
+    m_light_registry->gather(scene, frame.lights);
+    m_light_registry->buildClusters(camera, frame.viewport, frame.lights, frame.uniforms);
+
+    frame.stats.lights = static_cast<uint32_t>(frame.lights.lights.size());
+    frame.stats.light_cluster_entries = static_cast<uint32_t>(frame.lights.light_indices.size());
 }
 
 }
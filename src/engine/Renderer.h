@@ -1,22 +1,219 @@
 #pragma once
 
+#include "UniformBuffer.h"
+#include "GLStateCache.h"
+#include "LightRegistry.h"
+#include "FrustumCulling.h"
+#include "LodSelection.h"
+#include "OcclusionCulling.h"
+#include "OverdrawMeter.h"
+#include "MultiDraw.h"
+#include "RenderGraph.h"
+#include "RenderCommands.h"
+#include "renderpasses/RenderPass.h"
+
+#include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace engine {
 
 struct Context;
 class Scene;
+class CameraComponent;
+class Node;
+class Shader;
+class StaticBatcher;
+class UniformBlock;
 
 class Renderer final {
 public:
-    Renderer() = default;
-    ~Renderer() = default;
+    struct FrameStats {
+        uint32_t draw_calls = 0;
+        uint32_t visible = 0;
+        // rejected by the frustum, by the scene index box test or the sphere test
+        uint32_t culled = 0;
+        uint32_t occluded = 0;
+        uint32_t occluder_triangles = 0;
+        // draws of a coarser LOD level than the full mesh
+        uint32_t lod_draws = 0;
+        uint32_t opaque = 0;
+        uint32_t blended = 0;
+        uint32_t prepass_draw_calls = 0;
+        // opaque draws merged into one submission, and the indirect calls issued for them
+        uint32_t merged_draws = 0;
+        uint32_t indirect_calls = 0;
+        // packets recorded for the scene passes and the lists they were recorded into
+        uint32_t recorded_commands = 0;
+        uint32_t command_lists = 0;
+        // from the newest frame the GPU finished, a few frames behind
+        uint64_t samples_passed = 0;
+        float overdraw = 0.0f;
+        uint32_t lights = 0;
+        uint32_t light_cluster_entries = 0;
+        GLStateCache::Stats state;
+    };
+
+    // One frame ready for submission: camera and lights, the visible draws and
+    // their recorded commands. prepare() fills it from the scene without GL and
+    // submit() only reads the frame, so a render thread can submit one frame
+    // while the scene already advances for the next.
+    struct Frame;
+
+    // runs GL work that prepare() can not avoid on the thread owning the context
+    using GLInvoker = std::function<void(const std::function<void()>&)>;
+
+    explicit Renderer();
+    ~Renderer();
     Renderer(const Renderer&) = delete;
     Renderer(Renderer&&) = delete;
     Renderer& operator=(const Renderer&) = delete;
     Renderer& operator=(Renderer&&) = delete;
 
-    static void render(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene);
+    // prepare() and submit() of one frame on the calling thread
+    void render(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene);
+
+    static auto createFrame() -> std::unique_ptr<Frame>;
+    void prepare(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene, Frame& frame);
+    // releases the frame's meshes afterwards, so their GL objects die on the GL thread
+    void submit(const std::shared_ptr<Context>& context, Frame& frame);
+
+    // static batch rebuilds and occluder readbacks go through it, by default they run inline
+    void setGLInvoker(const GLInvoker& invoker);
+
+    auto frameUniforms() const -> const FrameUniforms&;
+    auto objectUniforms() -> UniformRingBuffer&;
+    auto multiDraw() -> MultiDrawSubmitter&;
+    // CPU and GPU time of every pass of the frame graph
+    auto passTimings() const -> const std::vector<RenderGraph::PassTiming>&;
+
+    void registerDrawCall();
+    // of the last submitted frame, read it on the thread calling submit()
+    auto frameStats() const -> const FrameStats&;
+
+    // off by default, only pays off for dense 3D scenes with designated occluders
+    void setOcclusionCulling(bool enabled);
+    auto occlusionCulling() const -> bool;
+
+    // the null backend replays the recorded scene draws without calling GL, what is
+    // left of the frame time is traversal, culling, sorting and recording
+    void setNullBackend(bool enabled);
+    auto nullBackend() const -> bool;
+
+    // nodes of meshes with cooked LOD levels are drawn at the coarsest one whose error
+    // stays under the pixel error; batched nodes always draw their full meshes
+    void setLodSettings(const LodSettings& settings);
+    auto lodSettings() const -> const LodSettings&;
+
+    // merges static nodes up front, render() only rebuilds the batches when one of them changes
+    void buildStaticBatches(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene);
+
+private:
+    // what opaque draws of shaders reading an instanced model have to share to be merged
+    struct MergeKey {
+        uint32_t shader_id = 0;
+        uint32_t shader_variant = 0;
+        uint32_t texture_id = 0;
+        uint32_t arena = 0;
+        const UniformBlock* uniforms = nullptr;
+        size_t hash = 0;
+    };
+
+    // a range of m_record_items recorded with one RenderPass::record
+    struct RecordGroup {
+        const RenderPass* render_pass = nullptr;
+        uint32_t first = 0;
+        uint32_t count = 0;
+        bool depth_prepass = false;
+    };
+
+    struct QueuedDraw {
+        std::shared_ptr<RenderPass> render_pass;
+        DrawItem item;
+        bool occluder = false;
+        bool blended = false;
+        bool depth_prepass = false;
+        bool mergeable = false;
+        MergeKey merge_key;
+        // distance along the view direction, sort key of both passes
+        float depth = 0.0f;
+    };
+
+    void collectDrawItems(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene, Frame& frame);
+    void queueDraw(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene, Frame& frame,
+                   const std::shared_ptr<Node>& node, const std::shared_ptr<MeshData>& mesh, const glm::mat4& model);
+    void cullDrawItems(const Frustum& frustum, Frame& frame);
+    void occludeDrawItems(const glm::mat4& view_projection, Frame& frame);
+    void sortDrawItems(const glm::mat4& view, Frame& frame);
+    void mergeDrawItems(Frame& frame);
+    void recordDrawItems(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene,
+                         const std::shared_ptr<CameraComponent>& camera, Frame& frame);
+    void recordGroups(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene,
+                      const std::shared_ptr<CameraComponent>& camera, bool opaque, std::vector<CommandList>& lists);
+    void recordDepthPrepass(Frame& frame);
+    void buildRenderGraph();
+    void renderOpaque(GLStateCache& state);
+    void renderBlended(GLStateCache& state);
+    void renderDepthPrepass(GLStateCache& state);
+    auto executeCommands(GLStateCache& state, const CommandList& commands) -> uint32_t;
+    static auto mergeKeyHash(const RenderPass* render_pass, const MergeKey& key) -> size_t;
+    static auto sameMergeKey(const MergeKey& a, const MergeKey& b) -> bool;
+    void updateOverdrawStats(const std::pair<int, int>& viewport);
+
+    void updateFrameUniforms(const std::shared_ptr<Scene>& scene, const std::shared_ptr<CameraComponent>& camera, Frame& frame);
+
+    FrameUniforms m_frame_uniforms;
+    FrameStats m_frame_stats;
+
+    // scratch of prepare()
+    std::vector<uint32_t> m_candidates;
+    WorldBounds m_world_bounds;
+    std::vector<uint8_t> m_visible;
+    std::vector<uint32_t> m_opaque;
+    std::vector<uint32_t> m_blended;
+    // m_opaque in groups recorded together, ordered by their closest member
+    std::vector<std::vector<uint32_t>> m_opaque_groups;
+    size_t m_opaque_group_count = 0;
+    std::unordered_map<size_t, std::vector<size_t>> m_open_groups;
+    std::vector<RecordGroup> m_record_groups;
+    std::vector<const DrawItem*> m_record_items;
+
+    std::unique_ptr<UniformBuffer> m_frame_uniform_buffer;
+    std::unique_ptr<UniformRingBuffer> m_object_uniform_buffer;
+    std::unique_ptr<LightRegistry> m_light_registry;
+    std::unique_ptr<OcclusionCuller> m_occlusion_culler;
+    std::unique_ptr<Shader> m_depth_prepass_shader;
+    std::unique_ptr<OverdrawMeter> m_overdraw_meter;
+    std::unique_ptr<StaticBatcher> m_static_batcher;
+    std::unique_ptr<LodSelector> m_lod_selector;
+    std::unique_ptr<MultiDrawSubmitter> m_multi_draw;
+    std::unique_ptr<RenderGraph> m_render_graph;
+    std::unique_ptr<CommandRecorder> m_command_recorder;
+    std::unique_ptr<RenderBackend> m_render_backend;
+    bool m_null_backend = false;
+    GLInvoker m_gl_invoker;
+    std::unique_ptr<Frame> m_frame;
+
+    // what the graph passes draw, set for the duration of RenderGraph::execute()
+    Frame* m_submit_frame = nullptr;
+    GLStateCache* m_submit_state = nullptr;
+
+    constexpr static uint32_t OBJECT_SLOTS_PER_FRAME = 4096;
+};
+
+struct Renderer::Frame {
+    bool has_camera = false;
+    std::pair<int, int> viewport{0, 0};
+    FrameUniforms uniforms;
+    LightRegistry::Clusters lights;
+    // nodes are dropped once recorded, meshes stay referenced until the submit
+    std::vector<QueuedDraw> draws;
+    CommandList prepass_commands;
+    std::vector<CommandList> opaque_commands;
+    std::vector<CommandList> blended_commands;
+    // the part of the stats known before the submit
+    FrameStats stats;
 };
 
 }
@@ -5,14 +5,20 @@
 #include "TextureStore.h"
 #include "FileSystem.h"
 #include "Shader.h"
+#include "ShaderCompiler.h"
 #include "Texture.h"
+#include "TextureCooker.h"
+#include "TextureStreamer.h"
 #include "MeshBuilder.h"
+#include "ResourceReloader.h"
 #include "Logger.h"
 
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/prettywriter.h>
 
+#include <chrono>
+
 namespace engine {
 
 std::optional<std::shared_ptr<ResourcePackage>> buildResourcePackage(const std::filesystem::path& path)
@@ -92,37 +98,93 @@ void saveResourcePackage(const std::shared_ptr<ResourcePackage>& package, uint32
     file.writeText(buffer.GetString());
 }
 
+auto loadTexture(const std::shared_ptr<Context>& context, uint32_t id, const std::filesystem::path& path) -> TextureLoad
+{
+    if (context->textureStreamer) {
+        context->textureStreamer->request(context, id, path);
+        context->textureStore->setSourcePath(id, path);
+        return TextureLoad::Streamed;
+    }
+
+    // a cooked texture uploads its mips as stored, sources are decoded only when it is stale or missing
+    if (hasCookedTexture(path)) {
+        auto cooked = loadCookedTexture(cookedTexturePath(path));
+        if (cooked.has_value() && cookedFormatSupported(cooked->format)) {
+            context->textureStore->add(id, buildTexture(cooked.value()));
+            context->textureStore->setSourcePath(id, path);
+            return TextureLoad::Cooked;
+        }
+    }
+
+    auto new_texture = buildTexture(path);
+    if (!new_texture.has_value()) {
+        return TextureLoad::Failed;
+    }
+
+    context->textureStore->add(id, std::move(new_texture.value()));
+    context->textureStore->setSourcePath(id, path);
+    return TextureLoad::Decoded;
+}
+
 void loadResourcePackage(const std::shared_ptr<Context>& context, const std::shared_ptr<ResourcePackage>& package)
 {
     Logger::debug(__FUNCTION__);
 
+    const auto start = std::chrono::steady_clock::now();
+
+    if (context->resourceReloader) {
+        context->resourceReloader->watchPackage(package);
+    }
+
+    // the driver compiles the package's shaders while its textures and meshes load
+    ShaderCompiler shader_compiler(context->shaderStore->programCache());
     for (auto& shaderInfo : package->shaders) {
         auto shader_exist = context->shaderStore->get(shaderInfo.id);
         if (shader_exist.has_value()) {
             continue;
         }
 
-        auto new_shader = buildShader(shaderInfo.path);
-        if (!new_shader.has_value()) {
+        auto sources = readShaderSources(shaderInfo.path);
+        if (!sources.has_value()) {
             continue;
         }
 
-        context->shaderStore->add(shaderInfo.id, std::move(new_shader.value()));
+        const auto variants = readShaderVariants(sources.value());
+        if (!variants.defines.empty()) {
+            context->shaderStore->setVariantSources(shaderInfo.id, sources.value(), variants);
+            for (auto mask : variants.precompile) {
+                shader_compiler.add(shaderInfo.id, variants.sources(sources.value(), mask), mask);
+            }
+        }
+
+        shader_compiler.add(shaderInfo.id, std::move(sources.value()));
     }
 
+    uint32_t cooked_textures = 0;
+    uint32_t decoded_textures = 0;
+    uint32_t streamed_textures = 0;
+    const auto textures_start = std::chrono::steady_clock::now();
     for (auto& textureInfo : package->textures) {
         auto texture_exist = context->textureStore->get(textureInfo.id);
         if (texture_exist.has_value()) {
             continue;
         }
 
-        auto new_texture = buildTexture(textureInfo.path);
-        if (!new_texture.has_value()) {
-            continue;
+        switch (loadTexture(context, textureInfo.id, textureInfo.path)) {
+            case TextureLoad::Streamed:
+                ++streamed_textures;
+                break;
+            case TextureLoad::Cooked:
+                ++cooked_textures;
+                break;
+            case TextureLoad::Decoded:
+                ++decoded_textures;
+                break;
+            case TextureLoad::Failed:
+                break;
         }
-
-        context->textureStore->add(textureInfo.id, std::move(new_texture.value()));
     }
+    const auto textures_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - textures_start).count();
 
     for (auto& meshInfo : package->meshes) {
         auto mesh_exist = context->meshStore->get(meshInfo.id);
@@ -130,13 +192,34 @@ void loadResourcePackage(const std::shared_ptr<Context>& context, const std::sha
             continue;
         }
 
-        auto new_mesh = buildMesh(meshInfo.path);
+        auto new_mesh = buildMesh(meshInfo.path, context->meshStore->geometryPool());
         if (!new_mesh.has_value()) {
             continue;
         }
 
-        context->meshStore->add(meshInfo.id, std::move(new_mesh.value()));
+        context->meshStore->add(meshInfo.id, std::move(new_mesh.value()), package->name);
     }
+
+    for (auto& built : shader_compiler.finish()) {
+        if (built.variant == 0) {
+            context->shaderStore->add(built.id, std::move(built.shader));
+        } else {
+            context->shaderStore->addVariant(built.id, built.variant, std::move(built.shader));
+        }
+    }
+
+    const auto shader_stats = shader_compiler.stats();
+    Logger::info("{}: package {} loaded in {:.2f} ms, {} shaders in {:.2f} ms: {} from the binary cache, {} compiled, {} failed",
+                 __FUNCTION__, package->name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                 shader_stats.programs, shader_stats.cpu_ms, shader_stats.cache_hits, shader_stats.compiled, shader_stats.failed);
+
+    Logger::info("{}: package {} textures loaded in {:.2f} ms: {} cooked, {} decoded, {} streaming",
+                 __FUNCTION__, package->name, textures_ms, cooked_textures, decoded_textures, streamed_textures);
+
+    const auto pool_stats = context->meshStore->geometryPool()->stats();
+    Logger::info("{}: package {} meshes use {} GPU bytes, geometry pool: {} arenas, {} of {} bytes used",
+                 __FUNCTION__, package->name, context->meshStore->gpuBytes(package->name),
+                 pool_stats.arenas, pool_stats.used_bytes, pool_stats.reserved_bytes);
 }
 
 }
@@ -27,6 +27,16 @@ struct ResourcePackage {
 auto buildResourcePackage(const std::filesystem::path& path) -> std::optional<std::shared_ptr<ResourcePackage>>;
 void saveResourcePackage(const std::shared_ptr<ResourcePackage>& package, uint32_t id, const std::filesystem::path& path);
 
+enum class TextureLoad : uint8_t {
+    Streamed,
+    Cooked,
+    Decoded,
+    Failed
+};
+
+// GL thread, replaces what the store holds under id
+auto loadTexture(const std::shared_ptr<Context>& context, uint32_t id, const std::filesystem::path& path) -> TextureLoad;
+
 void loadResourcePackage(const std::shared_ptr<Context>& context, const std::shared_ptr<ResourcePackage>& package);
 
 }
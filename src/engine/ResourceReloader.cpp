@@ -0,0 +1,243 @@
+#include "ResourceReloader.h"
+#include "Context.h"
+#include "Logger.h"
+#include "MeshSimplifier.h"
+#include "MeshStore.h"
+#include "ResourcePackage.h"
+#include "Shader.h"
+#include "ShaderStore.h"
+#include "TextureStore.h"
+
+#include <algorithm>
+
+namespace engine {
+
+ResourceReloader::ResourceReloader(uint32_t worker_count)
+{
+    if (worker_count == 0) {
+        const uint32_t hardware_threads = std::thread::hardware_concurrency();
+        worker_count = std::clamp(hardware_threads > 1 ? hardware_threads - 1 : 1, 1u, MAX_WORKERS);
+    }
+
+    for (uint32_t i = 0; i < worker_count; ++i) {
+        m_workers.emplace_back(&ResourceReloader::workerLoop, this);
+    }
+}
+
+ResourceReloader::~ResourceReloader()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ResourceReloader::watchPackage(const std::shared_ptr<ResourcePackage>& package)
+{
+    auto watch = [this, &package](Kind kind, const std::list<ResourceInfo>& resources) {
+        for (const auto& info : resources) {
+            auto& watched = m_resources[info.path];
+            const Resource resource = { kind, info.id, package->name };
+            if (std::ranges::find(watched, resource) == watched.end()) {
+                watched.push_back(resource);
+                m_watcher.watch(info.path);
+            }
+        }
+    };
+
+    watch(Kind::Shader, package->shaders);
+    watch(Kind::Texture, package->textures);
+    watch(Kind::Mesh, package->meshes);
+}
+
+void ResourceReloader::update(const std::shared_ptr<Context>& context)
+{
+    update([&context](Kind kind, uint32_t id) {
+        switch (kind) {
+            case Kind::Shader:
+                return context->shaderStore->contains(id);
+            case Kind::Texture:
+                return context->textureStore->contains(id);
+            case Kind::Mesh:
+                return context->meshStore->get(id).has_value();
+        }
+        return false;
+    });
+}
+
+void ResourceReloader::update(const std::function<bool(Kind kind, uint32_t id)>& is_loaded)
+{
+    const auto changed = m_watcher.poll();
+    if (changed.empty()) {
+        return;
+    }
+
+    size_t queued = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto& path : changed) {
+            auto it = m_resources.find(path);
+            if (it == m_resources.end()) {
+                continue;
+            }
+
+            for (const auto& resource : it->second) {
+                // resources of packages that were never loaded stay unloaded
+                if (is_loaded(resource.kind, resource.id)) {
+                    m_jobs.push_back({ resource, path });
+                    ++queued;
+                }
+            }
+        }
+    }
+
+    if (queued > 0) {
+        m_wake.notify_all();
+    }
+}
+
+auto ResourceReloader::hasWork() const -> bool
+{
+    // the compiler is only touched by apply(), which the simulation thread waits for
+    if (m_shader_compiler && m_shader_compiler->hasPending()) {
+        return true;
+    }
+
+    std::lock_guard lock(m_mutex);
+    return !m_loaded.empty();
+}
+
+auto ResourceReloader::apply(const std::shared_ptr<Context>& context) -> bool
+{
+    std::vector<Loaded> loaded;
+    {
+        std::lock_guard lock(m_mutex);
+        loaded.swap(m_loaded);
+    }
+
+    if (!m_shader_compiler) {
+        m_shader_compiler = std::make_unique<ShaderCompiler>(context->shaderStore->programCache());
+    }
+
+    // handed to the driver by an earlier apply(), the ones it is still compiling wait for the next one
+    for (auto& built : m_shader_compiler->finishCompleted()) {
+        const auto key = (static_cast<uint64_t>(built.id) << 32) | built.variant;
+        Logger::info("ResourceReloader: reloaded shader {}", m_compiling[key].string());
+        m_compiling.erase(key);
+
+        if (built.variant == 0) {
+            context->shaderStore->add(built.id, std::move(built.shader));
+        } else {
+            context->shaderStore->addVariant(built.id, built.variant, std::move(built.shader));
+        }
+    }
+
+    if (!m_shader_compiler->hasPending()) {
+        m_compiling.clear();
+    }
+
+    bool meshes_changed = false;
+
+    for (auto& item : loaded) {
+        const auto id = item.resource.id;
+
+        if (auto* sources = std::get_if<ShaderSources>(&item.data)) {
+            // variants built from the old sources are dropped, the precompiled ones are rebuilt
+            const auto variants = readShaderVariants(*sources);
+            context->shaderStore->setVariantSources(id, *sources, variants);
+            for (auto mask : variants.precompile) {
+                m_compiling[(static_cast<uint64_t>(id) << 32) | mask] = item.path;
+                m_shader_compiler->add(id, variants.sources(*sources, mask), mask);
+            }
+
+            m_compiling[static_cast<uint64_t>(id) << 32] = item.path;
+            m_shader_compiler->add(id, std::move(*sources));
+        } else if (auto* image = std::get_if<TextureImage>(&item.data)) {
+            context->textureStore->add(id, buildTexture(*image));
+            Logger::info("ResourceReloader: reloaded texture {}", item.path.string());
+        } else if (auto* source = std::get_if<MeshSource>(&item.data)) {
+            auto mesh = buildMeshGL(*source, context->meshStore->geometryPool());
+            if (!mesh.has_value()) {
+                Logger::warning("ResourceReloader: can not upload mesh {}, keeping the loaded one", item.path.string());
+                continue;
+            }
+
+            context->meshStore->add(id, std::move(mesh.value()), item.resource.package);
+            meshes_changed = true;
+            Logger::info("ResourceReloader: reloaded mesh {}", item.path.string());
+        }
+    }
+
+    return meshes_changed;
+}
+
+void ResourceReloader::workerLoop()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] {
+                return m_stop || !m_jobs.empty();
+            });
+
+            if (m_stop) {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        auto loaded = load(job);
+        if (!loaded.has_value()) {
+            // editors may still be writing the file, its next write queues it again
+            Logger::warning("ResourceReloader: can not load {}, keeping the loaded version", job.path.string());
+            continue;
+        }
+
+        std::lock_guard lock(m_mutex);
+        m_loaded.push_back(std::move(loaded.value()));
+    }
+}
+
+auto ResourceReloader::load(const Job& job) -> std::optional<Loaded>
+{
+    switch (job.resource.kind) {
+        case Kind::Shader: {
+            auto sources = readShaderSources(job.path);
+            if (!sources.has_value()) {
+                return std::nullopt;
+            }
+            return Loaded{ job.resource, job.path, std::move(sources.value()) };
+        }
+        case Kind::Texture: {
+            auto image = loadTextureImage(job.path);
+            if (!image.has_value()) {
+                return std::nullopt;
+            }
+            return Loaded{ job.resource, job.path, std::move(image.value()) };
+        }
+        case Kind::Mesh: {
+            auto source = loadMeshSource(job.path);
+            if (!source.has_value()) {
+                return std::nullopt;
+            }
+            // the edit left the cooked levels stale, they are rebuilt here since simplifying needs no GL
+            if (source->lods.empty()) {
+                source->lods = buildLodChain(source.value());
+                Logger::info("ResourceReloader: rebuilt {} LOD levels of {}", source->lods.size(), job.path.string());
+            }
+            return Loaded{ job.resource, job.path, std::move(source.value()) };
+        }
+    }
+
+    return std::nullopt;
+}
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "FileWatcher.h"
+#include "MeshBuilder.h"
+#include "ShaderCompiler.h"
+#include "Texture.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace engine {
+
+struct Context;
+struct ResourcePackage;
+
+// Reloads the shaders, textures and meshes of loaded packages when their files
+// change. Files are read and decoded on worker threads; apply() runs between frames
+// on the GL thread, uploads what the workers finished and replaces the resources in
+// the stores under their ids. Shaders are handed to the driver there and swapped in
+// a later apply() once they finished compiling, so with KHR_parallel_shader_compile
+// no frame waits for the compiler. A resource that fails to load or compile keeps
+// its previous version.
+class ResourceReloader final {
+public:
+    // 0 picks a count from the hardware threads
+    explicit ResourceReloader(uint32_t worker_count = 0);
+    ~ResourceReloader();
+    ResourceReloader(const ResourceReloader&) = delete;
+    ResourceReloader(ResourceReloader&&) = delete;
+    ResourceReloader& operator=(const ResourceReloader&) = delete;
+    ResourceReloader& operator=(ResourceReloader&&) = delete;
+
+    enum class Kind : uint8_t {
+        Shader,
+        Texture,
+        Mesh
+    };
+
+    void watchPackage(const std::shared_ptr<ResourcePackage>& package);
+
+    // once per frame on the simulation thread, queues the changed resources that are loaded
+    void update(const std::shared_ptr<Context>& context);
+    // the same with the stores asked through is_loaded
+    void update(const std::function<bool(Kind kind, uint32_t id)>& is_loaded);
+    // whether apply() has anything to swap or compile
+    auto hasWork() const -> bool;
+    // true when a mesh was replaced, its bounds may have changed
+    auto apply(const std::shared_ptr<Context>& context) -> bool;
+
+private:
+    static constexpr uint32_t MAX_WORKERS = 2;
+
+    struct Resource {
+        Kind kind;
+        uint32_t id;
+        std::string package;
+
+        bool operator==(const Resource&) const = default;
+    };
+
+    struct Job {
+        Resource resource;
+        std::filesystem::path path;
+    };
+
+    struct Loaded {
+        Resource resource;
+        std::filesystem::path path;
+        std::variant<ShaderSources, TextureImage, MeshSource> data;
+    };
+
+    void workerLoop();
+    static auto load(const Job& job) -> std::optional<Loaded>;
+
+    FileWatcher m_watcher;
+    std::map<std::filesystem::path, std::vector<Resource>> m_resources;
+
+    std::vector<std::thread> m_workers;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Job> m_jobs;
+    std::vector<Loaded> m_loaded;
+    bool m_stop = false;
+
+    // GL thread, created by the first apply()
+    std::unique_ptr<ShaderCompiler> m_shader_compiler;
+    std::map<uint64_t, std::filesystem::path> m_compiling;
+};
+
+}
@@ -8,15 +8,48 @@
 #include "UserComponentsBuilder.h"
 #include "Utils.h"
 #include "SceneConfig.h"
+#include "TransformComponent.h"
+#include "MeshComponent.h"
+#include "MeshStore.h"
+#include "MaterialComponent.h"
+#include "RenderScopeComponent.h"
+#include "MouseEventFilterComponent.h"
 
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/prettywriter.h>
 
+#include <glm/ext/matrix_transform.hpp>
+
+#include <algorithm>
 #include <ranges>
+#include <unordered_set>
+#include <utility>
 
 namespace engine {
 
+namespace {
+
+template<typename T>
+auto findComponent(const std::unordered_map<uint32_t, std::shared_ptr<Component>>& scene_components,
+                   const std::unordered_set<uint32_t>& ids) -> std::optional<std::shared_ptr<T>>
+{
+    for (auto id : ids) {
+        auto it = scene_components.find(id);
+        if (it == scene_components.end()) {
+            continue;
+        }
+
+        if (auto typed_component = std::dynamic_pointer_cast<T>(it->second)) {
+            return typed_component;
+        }
+    }
+
+    return std::nullopt;
+}
+
+}
+
 Scene::Scene(const std::shared_ptr<Context>& context, uint32_t id, std::string name) :
     m_context(context),
     m_id(id),
@@ -98,16 +131,19 @@ auto Scene::createRootNode(const std::string& name) -> std::optional<std::shared
 
 bool Scene::addComponent(uint32_t id, const std::shared_ptr<Component>& component)
 {
+    markStructureChanged();
     return m_components.insert({id, component}).second;
 }
 
 bool Scene::addNode(uint32_t id, const std::shared_ptr<Node>& node)
 {
+    markStructureChanged();
     return m_nodes.insert({id, node}).second;
 }
 
 bool Scene::removeComponent(uint32_t id)
 {
+    markStructureChanged();
     return m_components.erase(id) == 1;
 }
 
@@ -115,6 +151,8 @@ bool Scene::removeNode(uint32_t id)
 {
     auto it = m_nodes.find(id);
     if (it != m_nodes.end()) {
+        markStructureChanged();
+
         auto node = it->second;
         m_nodes.erase(it);
 
@@ -238,6 +276,300 @@ void Scene::setResources(std::vector<uint32_t> ids)
     setDirty(true);
 }
 
+void Scene::updateSpatialIndex()
+{
+    if (m_spatial_structure_dirty) {
+        syncSpatialEntries();
+        m_spatial_structure_dirty = false;
+        return;
+    }
+
+    // a component changed several times, or several components of one entry, still queue the entry once
+    m_spatial_changes_read.clear();
+    m_spatial_changes->swap(m_spatial_changes_read);
+    for (auto key : m_spatial_changes_read) {
+        const auto& dependency = m_spatial_dependencies[key];
+        for (uint32_t i = dependency.first; i < dependency.first + dependency.count; ++i) {
+            const auto& dependent = m_spatial_dependents[i];
+            auto& entry = m_spatial_entries[dependent.slot];
+            if (entry.changes == 0) {
+                m_spatial_dirty.push_back(dependent.slot);
+            }
+            entry.changes |= dependent.change;
+        }
+    }
+
+    for (auto slot : m_spatial_dirty) {
+        refitSpatialEntry(slot, false);
+    }
+    m_spatial_dirty.clear();
+
+    auto unresolved = std::move(m_spatial_unresolved);
+    m_spatial_unresolved.clear();
+    for (auto slot : unresolved) {
+        m_spatial_entries[slot].unresolved = false;
+        refitSpatialEntry(slot, false);
+    }
+
+    m_spatial_index.commit();
+}
+
+void Scene::invalidateSpatialIndex()
+{
+    markStructureChanged();
+}
+
+void Scene::markStructureChanged()
+{
+    m_spatial_structure_dirty = true;
+    ++m_structure_version;
+}
+
+auto Scene::structureVersion() const -> uint64_t
+{
+    return m_structure_version;
+}
+
+void Scene::queryNodes(const Frustum& frustum, std::vector<uint32_t>& node_ids) const
+{
+    m_spatial_index.queryFrustum(frustum, node_ids);
+}
+
+void Scene::queryNodes(const Aabb& box, std::vector<uint32_t>& node_ids) const
+{
+    m_spatial_index.queryAabb(box, node_ids);
+}
+
+void Scene::queryNodesInRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& node_ids) const
+{
+    m_spatial_index.queryRadius(center, radius, node_ids);
+}
+
+auto Scene::raycastNodes(const glm::vec3& origin, const glm::vec3& direction, float max_distance) const -> std::optional<SpatialIndex::RayHit>
+{
+    return m_spatial_index.raycast(origin, direction, max_distance);
+}
+
+auto Scene::spatialIndexSize() const -> size_t
+{
+    return m_spatial_index.size();
+}
+
+auto Scene::spatialMeshCount() const -> size_t
+{
+    return m_spatial_index.size() - m_spatial_texture_rects;
+}
+
+auto Scene::indexedNode(uint32_t node_id) const -> std::optional<IndexedNode>
+{
+    auto it = m_spatial_slots.find(node_id);
+    if (it == m_spatial_slots.end() || m_spatial_entries[it->second].proxy == SpatialIndex::NULL_PROXY) {
+        return std::nullopt;
+    }
+
+    return m_spatial_entries[it->second].placement;
+}
+
+void Scene::syncSpatialEntries()
+{
+    // nodes still indexed keep their proxy and placement version, the others leave the index below
+    auto previous_entries = std::move(m_spatial_entries);
+    auto previous_slots = std::move(m_spatial_slots);
+    m_spatial_entries.clear();
+    m_spatial_slots.clear();
+
+    // a new log detaches the components no longer indexed, changes logged until now are covered by the forced refit
+    m_spatial_changes = std::make_shared<Component::ChangeLog>();
+    m_spatial_dependencies.clear();
+    m_spatial_dependents.clear();
+    m_spatial_dirty.clear();
+    m_spatial_unresolved.clear();
+
+    // component id -> change log key, and the dependents of every key, grouped by key once all are known
+    std::unordered_map<uint32_t, uint32_t> keys;
+    std::vector<std::pair<uint32_t, SpatialDependent>> dependents;
+    auto depend = [&](const std::shared_ptr<Component>& component, uint32_t slot, uint8_t change) {
+        auto [it, inserted] = keys.try_emplace(component->id(), static_cast<uint32_t>(keys.size()));
+        if (inserted) {
+            component->setChangeLog(m_spatial_changes, it->second);
+        }
+        dependents.emplace_back(it->second, SpatialDependent{ slot, change });
+    };
+
+    for (const auto& [id, node] : m_nodes) {
+        const auto components = node->components();
+        auto mesh = findComponent<MeshComponent>(m_components, components);
+        auto transform = findComponent<TransformComponent>(m_components, components);
+        auto material = findComponent<MaterialComponent>(m_components, components);
+        if (!transform.has_value()) {
+            continue;
+        }
+
+        // nodes filtering mouse events without a mesh are picked by the rect of their texture
+        const bool texture_rect = !mesh.has_value() && material.has_value() &&
+                                  findComponent<MouseEventFilterComponent>(m_components, components).has_value();
+        if (!mesh.has_value() && !texture_rect) {
+            continue;
+        }
+
+        const auto slot = static_cast<uint32_t>(m_spatial_entries.size());
+        m_spatial_slots[id] = slot;
+        auto& entry = m_spatial_entries.emplace_back();
+        if (auto it = previous_slots.find(id); it != previous_slots.end()) {
+            auto& previous = previous_entries[it->second];
+            entry.proxy = std::exchange(previous.proxy, SpatialIndex::NULL_PROXY);
+            entry.placement = previous.placement;
+        }
+        entry.node_id = id;
+        entry.mesh = mesh.value_or(nullptr);
+
+        entry.transforms.push_back(transform.value());
+        for (auto parent = getNode(node->getParentId()); parent.has_value(); parent = getNode(parent.value()->getParentId())) {
+            auto parent_transform = findComponent<TransformComponent>(m_components, parent.value()->components());
+            if (!parent_transform.has_value()) {
+                continue;
+            }
+            if (!parent_transform.value()->isActive()) {
+                break;
+            }
+            entry.transforms.push_back(parent_transform.value());
+        }
+
+        auto render_scope = findComponent<RenderScopeComponent>(m_components, components);
+        const bool sprite = render_scope.has_value() && render_scope.value()->isSprite() && material.has_value();
+        if (sprite || texture_rect) {
+            entry.material = material.value();
+        }
+
+        depend(entry.transforms.front(), slot, SPATIAL_CHANGE_MODEL);
+        for (size_t i = 1; i < entry.transforms.size(); ++i) {
+            depend(entry.transforms[i], slot, SPATIAL_CHANGE_PARENTS);
+        }
+        if (entry.mesh) {
+            depend(entry.mesh, slot, SPATIAL_CHANGE_BOUNDS);
+        }
+        if (entry.material) {
+            depend(entry.material, slot, SPATIAL_CHANGE_BOUNDS);
+        }
+
+        refitSpatialEntry(slot, true);
+    }
+
+    for (const auto& previous : previous_entries) {
+        if (previous.proxy != SpatialIndex::NULL_PROXY) {
+            m_spatial_index.remove(previous.proxy);
+        }
+    }
+
+    m_spatial_texture_rects = static_cast<size_t>(std::ranges::count_if(m_spatial_entries, [](const auto& entry) {
+        return !entry.mesh;
+    }));
+
+    m_spatial_dependencies.resize(keys.size());
+    for (const auto& [key, dependent] : dependents) {
+        ++m_spatial_dependencies[key].count;
+    }
+    uint32_t first = 0;
+    for (auto& dependency : m_spatial_dependencies) {
+        dependency.first = first;
+        first += dependency.count;
+        dependency.count = 0;
+    }
+    m_spatial_dependents.resize(dependents.size());
+    for (const auto& [key, dependent] : dependents) {
+        auto& dependency = m_spatial_dependencies[key];
+        m_spatial_dependents[dependency.first + dependency.count++] = dependent;
+    }
+
+    m_spatial_index.commit();
+}
+
+void Scene::refitSpatialEntry(uint32_t slot, bool force)
+{
+    auto& entry = m_spatial_entries[slot];
+    const uint8_t changes = entry.changes;
+    entry.changes = 0;
+
+    // a moved node keeps its local bounds, the mesh store and the texture are only asked when they changed
+    const bool placed = entry.proxy != SpatialIndex::NULL_PROXY;
+    bool resized = false;
+    if (force || !placed || (changes & SPATIAL_CHANGE_BOUNDS) != 0) {
+        const uint32_t mesh_id = entry.mesh ? entry.mesh->meshId() : 0;
+        if (entry.mesh && (force || !placed || mesh_id != entry.mesh_id)) {
+            auto context = m_context.lock();
+            if (!context) {
+                return;
+            }
+
+            // a node without mesh data leaves the index and is retried every frame until it resolves
+            auto mesh_data = context->meshStore->get(mesh_id);
+            if (!mesh_data.has_value()) {
+                if (placed) {
+                    m_spatial_index.remove(entry.proxy);
+                    entry.proxy = SpatialIndex::NULL_PROXY;
+                }
+                if (!entry.unresolved) {
+                    entry.unresolved = true;
+                    m_spatial_unresolved.push_back(slot);
+                }
+                return;
+            }
+
+            entry.mesh_id = mesh_id;
+            entry.placement.local_bounds = { mesh_data.value()->aabb_min, mesh_data.value()->aabb_max };
+            entry.placement.mesh_id = mesh_id;
+            resized = true;
+        }
+
+        // sprites are unit quads scaled to their texture size at draw time, a texture
+        // rect is the texture size centered on the node
+        const uint64_t material_revision = entry.material ? entry.material->revision() : 0;
+        if (force || material_revision != entry.material_revision) {
+            entry.material_revision = material_revision;
+            entry.sprite_scale = glm::vec3(1.0f);
+            if (entry.material) {
+                const auto texture_size = entry.material->textureSize();
+                const glm::vec3 size(texture_size.first, texture_size.second, 1.0f);
+                if (entry.mesh) {
+                    entry.sprite_scale = size;
+                } else {
+                    const glm::vec3 half_size(size.x / 2.0f, size.y / 2.0f, 0.0f);
+                    entry.placement.local_bounds = { -half_size, half_size };
+                }
+            }
+            resized = true;
+        }
+    }
+
+    if (!force && !resized && (changes & (SPATIAL_CHANGE_MODEL | SPATIAL_CHANGE_PARENTS)) == 0) {
+        return;
+    }
+
+    // the parents are only multiplied again when one of them moved
+    if (force || (changes & SPATIAL_CHANGE_PARENTS) != 0) {
+        entry.parent_model = glm::mat4(1.0f);
+        for (size_t i = 1; i < entry.transforms.size(); ++i) {
+            entry.parent_model = entry.transforms[i]->getModel() * entry.parent_model;
+        }
+    }
+
+    glm::mat4 model = entry.transforms.front()->getModel();
+    if (entry.transforms.size() > 1) {
+        model = entry.parent_model * model;
+    }
+    model = glm::scale(model, entry.sprite_scale);
+
+    entry.placement.model = model;
+    ++entry.placement.version;
+
+    const Aabb box = transformAabb(model, entry.placement.local_bounds);
+    if (entry.proxy == SpatialIndex::NULL_PROXY) {
+        entry.proxy = m_spatial_index.insert(box, entry.node_id);
+    } else {
+        m_spatial_index.move(entry.proxy, box);
+    }
+}
+
 auto saveSceneToFile(const std::shared_ptr<Scene>& scene, const std::filesystem::path& path) -> bool
 {
     if (FileSystem::exists(path)) {
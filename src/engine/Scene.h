@@ -1,5 +1,10 @@
 #pragma once
 
+#include "Component.h"
+#include "SpatialIndex.h"
+
+#include <glm/glm.hpp>
+
 #include <memory>
 #include <unordered_map>
 #include <string>
@@ -10,9 +15,12 @@
 namespace engine {
 
 struct Context;
-class Component;
 class Node;
 class SceneConfig;
+class TransformComponent;
+class MeshComponent;
+class MaterialComponent;
+class Frustum;
 
 class Scene {
 public:
@@ -56,7 +64,83 @@ public:
     void addResource(uint32_t id);
     void setResources(std::vector<uint32_t> ids);
 
+    // indexes the nodes with a mesh and, by the rect of their texture, the nodes filtering mouse events
+    // without one; refits the world bounds of nodes whose transform chain, mesh or texture changed since
+    // the last call, the cost follows the number of changed transforms rather than the number of indexed nodes
+    void updateSpatialIndex();
+    // forces a full resync of the indexed nodes, e.g. after meshes were reloaded
+    void invalidateSpatialIndex();
+
+    // bumped whenever nodes or components are added or removed, or a node flag
+    // affecting what derived render data is built from (static) changes
+    void markStructureChanged();
+    auto structureVersion() const -> uint64_t;
+
+    void queryNodes(const Frustum& frustum, std::vector<uint32_t>& node_ids) const;
+    void queryNodes(const Aabb& box, std::vector<uint32_t>& node_ids) const;
+    void queryNodesInRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& node_ids) const;
+    auto raycastNodes(const glm::vec3& origin, const glm::vec3& direction, float max_distance) const -> std::optional<SpatialIndex::RayHit>;
+
+    auto spatialIndexSize() const -> size_t;
+    // indexed nodes with a mesh, the others are texture rects only used for picking
+    auto spatialMeshCount() const -> size_t;
+
+    struct IndexedNode {
+        // world model including the sprite scale
+        glm::mat4 model{1.0f};
+        Aabb local_bounds;
+        // 0 for a texture rect
+        uint32_t mesh_id = 0;
+        // changes whenever the model does
+        uint64_t version = 0;
+    };
+
+    // world placement cached by the last updateSpatialIndex()
+    auto indexedNode(uint32_t node_id) const -> std::optional<IndexedNode>;
+
 private:
+    // what a changed component feeds into the world bounds of an entry: its own transform, a parent
+    // transform, or the mesh or texture sizing it
+    static constexpr uint8_t SPATIAL_CHANGE_MODEL = 1;
+    static constexpr uint8_t SPATIAL_CHANGE_PARENTS = 2;
+    static constexpr uint8_t SPATIAL_CHANGE_BOUNDS = 4;
+
+    struct SpatialEntry {
+        int32_t proxy = SpatialIndex::NULL_PROXY;
+        uint32_t node_id = 0;
+        // null for a node picked by its texture rect
+        std::shared_ptr<MeshComponent> mesh;
+        uint32_t mesh_id = 0;
+        // own transform first, then the transforms of the parents
+        std::vector<std::shared_ptr<TransformComponent>> transforms;
+        // product of the parent transforms, kept while only the own transform moves
+        glm::mat4 parent_model{1.0f};
+        // set for sprites and texture rects, which are sized by its texture
+        std::shared_ptr<MaterialComponent> material;
+        uint64_t material_revision = 0;
+        glm::vec3 sprite_scale{1.0f};
+        IndexedNode placement;
+        // SPATIAL_CHANGE bits gathered since the last refit, non zero while queued in m_spatial_dirty
+        uint8_t changes = 0;
+        // queued in m_spatial_unresolved
+        bool unresolved = false;
+    };
+
+    // entries depending on one component, the component logs its changes by its position in m_spatial_dependencies
+    struct SpatialDependency {
+        // range of m_spatial_dependents
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    struct SpatialDependent {
+        uint32_t slot = 0;
+        uint8_t change = SPATIAL_CHANGE_MODEL;
+    };
+
+    void syncSpatialEntries();
+    void refitSpatialEntry(uint32_t slot, bool force);
+
     uint32_t m_id;
     std::string m_name;
 
@@ -71,6 +155,26 @@ private:
     std::unordered_map<uint32_t, std::shared_ptr<Node>> m_nodes;
 
     std::vector<uint32_t> m_resources_id;
+
+    SpatialIndex m_spatial_index;
+    // texture rects are always placed, counted at each sync
+    size_t m_spatial_texture_rects = 0;
+    // dense, indexed by slot; m_spatial_slots maps node ids to slots
+    std::vector<SpatialEntry> m_spatial_entries;
+    std::unordered_map<uint32_t, uint32_t> m_spatial_slots;
+    // the indexed transforms, meshes and sprite materials report their changes here, so a refit only visits
+    // the entries that depend on them instead of every indexed node; replaced on every sync, which detaches
+    // the components no longer indexed
+    std::shared_ptr<Component::ChangeLog> m_spatial_changes = std::make_shared<Component::ChangeLog>();
+    Component::ChangeLog m_spatial_changes_read;
+    std::vector<SpatialDependency> m_spatial_dependencies;
+    std::vector<SpatialDependent> m_spatial_dependents;
+    // slots with pending changes, each queued once
+    std::vector<uint32_t> m_spatial_dirty;
+    // slots whose mesh data was not loaded yet, retried every update
+    std::vector<uint32_t> m_spatial_unresolved;
+    bool m_spatial_structure_dirty = true;
+    uint64_t m_structure_version = 0;
 };
 
 auto saveSceneToFile(const std::shared_ptr<Scene>& scene, const std::filesystem::path& path) -> bool;
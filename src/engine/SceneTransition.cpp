@@ -11,6 +11,7 @@
 #include "Component.h"
 #include "ResourcePackage.h"
 #include "SceneConfig.h"
+#include "Renderer.h"
 
 #include <algorithm>
 #include <ranges>
@@ -77,10 +78,15 @@ bool SceneTransition::transition(const std::unordered_map<uint32_t, std::shared_
     uint32_t scene_id = scene_to.value()->id();
     m_context->sceneStore->add(scene_id, std::move(scene_to.value()));
 
-    for (auto& component : m_context->sceneStore->get(scene_id).value()->getComponents() | std::views::values) {
+    auto scene = m_context->sceneStore->get(scene_id).value();
+    for (auto& component : scene->getComponents() | std::views::values) {
         component->init();
     }
 
+    if (m_context->renderer) {
+        m_context->renderer->buildStaticBatches(m_context, scene);
+    }
+
     return true;
 }
 
@@ -1,11 +1,18 @@
 #include "Shader.h"
+#include "ShaderCompiler.h"
 #include "FileSystem.h"
 #include "Logger.h"
+#include "UniformBuffer.h"
+#include "GLStateCache.h"
+#include "LightRegistry.h"
 
 #include <glm/gtc/type_ptr.hpp>
 
 #include <rapidjson/document.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace engine {
 
 Shader::Shader(const std::string& name, const std::string& vertexShader, const std::string& fragmentShader, const std::string& config) :
@@ -58,44 +65,249 @@ Shader::Shader(const std::string& name, const std::string& vertexShader, const s
     glDeleteShader(vertex);
     glDeleteShader(fragment);
 
+    initialize(config);
+}
+
+Shader::Shader(const std::string& name, GLuint program, const std::string& config) :
+    m_name(name),
+    m_program(program)
+{
+    Logger::debug(__FUNCTION__);
+
+    initialize(config);
+}
+
+void Shader::initialize(const std::string& config)
+{
+    introspectUniforms();
+    bindUniformBlocks();
+    checkDeclaredUniforms(config);
+    readOptions(config);
+    readObjectBlockDefaults(config);
+}
+
+void Shader::bindUniformBlocks()
+{
+    auto bind_block = [this](const char* block_name, GLuint binding) {
+        GLuint index = glGetUniformBlockIndex(m_program, block_name);
+        if (index == GL_INVALID_INDEX) {
+            return false;
+        }
+        glUniformBlockBinding(m_program, index, binding);
+        return true;
+    };
+
+    m_uses_frame_block = bind_block(FRAME_UNIFORMS_BLOCK, FRAME_UNIFORMS_BINDING);
+    m_uses_object_block = bind_block(OBJECT_UNIFORMS_BLOCK, OBJECT_UNIFORMS_BINDING);
+    bind_block(LIGHT_UNIFORMS_BLOCK, LIGHT_UNIFORMS_BINDING);
+
+    if (m_uses_object_block) {
+        GLuint index = glGetUniformBlockIndex(m_program, OBJECT_UNIFORMS_BLOCK);
+        glGetActiveUniformBlockiv(m_program, index, GL_UNIFORM_BLOCK_DATA_SIZE, &m_object_block_size);
+
+        if (m_object_block_size > static_cast<GLint>(OBJECT_UNIFORMS_MAX_SIZE)) {
+            Logger::error("ERROR::SHADER::UNIFORM_BLOCK::TOO_LARGE, shader: {}, size: {}, max: {}", m_name, m_object_block_size, OBJECT_UNIFORMS_MAX_SIZE);
+            m_uses_object_block = false;
+        }
+    }
+}
+
+void Shader::introspectUniforms()
+{
+    GLint uniforms_count = 0;
+    GLint max_name_length = 0;
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &uniforms_count);
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    std::vector<GLchar> name_buffer(std::max(max_name_length, 1));
+    GLint sampler_unit = 0;
+
+    const GLuint object_block_index = glGetUniformBlockIndex(m_program, OBJECT_UNIFORMS_BLOCK);
+
+    glUseProgram(m_program);
+
+    for (GLint i = 0; i < uniforms_count; ++i) {
+        GLsizei name_length = 0;
+        GLint size = 0;
+        GLenum gl_type = 0;
+        glGetActiveUniform(m_program, i, static_cast<GLsizei>(name_buffer.size()), &name_length, &size, &gl_type, name_buffer.data());
+
+        std::string name(name_buffer.data(), name_length);
+        if (name.starts_with("gl_")) {
+            continue;
+        }
+
+        if (name.ends_with("[0]")) {
+            name.resize(name.size() - 3);
+        }
+
+        auto type = uniformTypeFromGL(gl_type);
+        if (!type.has_value()) {
+            Logger::debug("SHADER::UNIFORM::UNSUPPORTED, shader: {}, name: {}, type: {}", m_name, name, gl_type);
+            continue;
+        }
+
+        // members of uniform blocks have no location, only the per-object block layout is kept
+        GLint location = glGetUniformLocation(m_program, name_buffer.data());
+        if (location < 0) {
+            const GLuint uniform_index = i;
+            GLint block_index = -1;
+            glGetActiveUniformsiv(m_program, 1, &uniform_index, GL_UNIFORM_BLOCK_INDEX, &block_index);
+            if (object_block_index != GL_INVALID_INDEX && block_index == static_cast<GLint>(object_block_index)) {
+                GLint offset = 0;
+                GLint matrix_stride = 0;
+                glGetActiveUniformsiv(m_program, 1, &uniform_index, GL_UNIFORM_OFFSET, &offset);
+                glGetActiveUniformsiv(m_program, 1, &uniform_index, GL_UNIFORM_MATRIX_STRIDE, &matrix_stride);
+                m_object_block_members.push_back({ name, type.value(), offset, matrix_stride });
+            }
+            continue;
+        }
+
+        // samplers never change their unit, so they are bound once here instead of per draw
+        if (isSamplerType(gl_type)) {
+            if (name == LIGHT_CLUSTERS_SAMPLER) {
+                glUniform1i(location, LIGHT_CLUSTERS_TEXTURE_UNIT);
+            } else if (name == LIGHT_INDICES_SAMPLER) {
+                glUniform1i(location, LIGHT_INDICES_TEXTURE_UNIT);
+            } else {
+                glUniform1i(location, sampler_unit++);
+            }
+        }
+
+        m_uniform_locations[name] = location;
+        m_uniforms.push_back({ name, location, type.value() });
+    }
+
+    glUseProgram(0);
+
+    m_builtin_locations.model = uniformLocation("model");
+    m_builtin_locations.view = uniformLocation("view");
+    m_builtin_locations.projection = uniformLocation("projection");
+    m_builtin_locations.texture1 = uniformLocation("texture1");
+}
+
+void Shader::checkDeclaredUniforms(const std::string& config) const
+{
+    if (config.empty()) {
+        return;
+    }
+
+    rapidjson::Document configJson = rapidjson::Document();
+    configJson.Parse(config.c_str());
+
+    if (configJson.HasParseError() || !configJson.IsObject() || !configJson.HasMember("uniforms") || !configJson["uniforms"].IsArray()) {
+        return;
+    }
+
+    for (const auto& uniform : configJson["uniforms"].GetArray()) {
+        if (!uniform.IsObject() || !uniform.HasMember("name") || !uniform["name"].IsString()) {
+            continue;
+        }
+
+        std::string name = uniform["name"].GetString();
+        if (!m_uniform_locations.contains(name)) {
+            Logger::debug("SHADER::UNIFORM::INACTIVE, shader: {}, name: {}", m_name, name);
+        }
+    }
+}
+
+void Shader::readOptions(const std::string& config)
+{
+    if (config.empty()) {
+        return;
+    }
+
+    rapidjson::Document configJson = rapidjson::Document();
+    configJson.Parse(config.c_str());
+
+    if (configJson.HasParseError() || !configJson.IsObject()) {
+        return;
+    }
+
+    if (configJson.HasMember("depth_prepass") && configJson["depth_prepass"].IsBool()) {
+        m_depth_prepass = configJson["depth_prepass"].GetBool();
+    }
+
+    if (configJson.HasMember("instanced_model") && configJson["instanced_model"].IsBool()) {
+        m_instanced_model = configJson["instanced_model"].GetBool();
+    }
+}
+
+void Shader::readObjectBlockDefaults(const std::string& config)
+{
+    if (!m_uses_object_block) {
+        return;
+    }
+
+    m_object_block_defaults.assign(m_object_block_size, std::byte{ 0 });
+
+    if (config.empty()) {
+        return;
+    }
+
     rapidjson::Document configJson = rapidjson::Document();
     configJson.Parse(config.c_str());
 
-    if (configJson.HasMember("uniforms")) {
-        auto uniforms = configJson["uniforms"].GetArray();
-        for (const auto& uniform : uniforms) {
-            if (uniform.IsObject() && uniform.HasMember("name") && uniform["name"].IsString() && uniform.HasMember("type") && uniform["type"].IsString()) {
-                std::string name = uniform["name"].GetString();
-                std::string type = uniform["type"].GetString();
-                Uniform::Type uniformType;
-                if (type == "Float") {
-                    uniformType = Uniform::Type::Float;
-                } else if (type == "Double") {
-                    uniformType = Uniform::Type::Double;
-                } else if (type == "Int") {
-                    uniformType = Uniform::Type::Int;
-                } else if (type == "UInt") {
-                    uniformType = Uniform::Type::UInt;
-                } else if (type == "Bool") {
-                    uniformType = Uniform::Type::Bool;
-                } else if (type == "Vec2") {
-                    uniformType = Uniform::Type::Vec2;
-                } else if (type == "Vec3") {
-                    uniformType = Uniform::Type::Vec3;
-                } else if (type == "Vec4") {
-                    uniformType = Uniform::Type::Vec4;
-                } else if (type == "Mat2") {
-                    uniformType = Uniform::Type::Mat2;
-                } else if (type == "Mat3") {
-                    uniformType = Uniform::Type::Mat3;
-                } else if (type == "Mat4") {
-                    uniformType = Uniform::Type::Mat4;
-                } else {
-                    Logger::error("ERROR::SHADER::UNIFORM::INVALID, name: {}, type: {}", name, type);
-                    continue;
-                }
-
-                m_uniforms.push_back({ name, glGetUniformLocation(m_program, name.c_str()), uniformType });
+    if (configJson.HasParseError() || !configJson.IsObject() || !configJson.HasMember("uniforms") || !configJson["uniforms"].IsArray()) {
+        return;
+    }
+
+    for (const auto& uniform : configJson["uniforms"].GetArray()) {
+        if (!uniform.IsObject() || !uniform.HasMember("name") || !uniform["name"].IsString() || !uniform.HasMember("default")) {
+            continue;
+        }
+
+        const std::string name = uniform["name"].GetString();
+        auto member = std::ranges::find(m_object_block_members, name, &BlockMember::name);
+        if (member == m_object_block_members.end()) {
+            continue;
+        }
+
+        std::vector<const rapidjson::Value*> components;
+        const auto& value = uniform["default"];
+        if (value.IsArray()) {
+            for (const auto& component : value.GetArray()) {
+                components.push_back(&component);
+            }
+        } else {
+            components.push_back(&value);
+        }
+
+        size_t expected = 0;
+        switch (member->type) {
+            case Uniform::Type::Float:
+            case Uniform::Type::Int:
+            case Uniform::Type::UInt:
+            case Uniform::Type::Bool: expected = 1; break;
+            case Uniform::Type::Vec2: expected = 2; break;
+            case Uniform::Type::Vec3: expected = 3; break;
+            case Uniform::Type::Vec4: expected = 4; break;
+            default: break;
+        }
+
+        const bool valid = expected == components.size() && std::ranges::all_of(components, [](const rapidjson::Value* component) {
+            return component->IsNumber() || component->IsBool();
+        });
+        if (!valid) {
+            Logger::warning("SHADER::UNIFORM::DEFAULT_IGNORED, shader: {}, name: {}", m_name, name);
+            continue;
+        }
+
+        // every supported type stores 4 byte components, packed from the member offset in std140
+        auto* dst = m_object_block_defaults.data() + member->offset;
+        for (size_t i = 0; i < components.size(); ++i) {
+            const auto& component = *components[i];
+            const double number = component.IsBool() ? (component.GetBool() ? 1.0 : 0.0) : component.GetDouble();
+
+            if (member->type == Uniform::Type::Int || member->type == Uniform::Type::Bool) {
+                const auto packed = static_cast<int32_t>(number);
+                std::memcpy(dst + i * sizeof(packed), &packed, sizeof(packed));
+            } else if (member->type == Uniform::Type::UInt) {
+                const auto packed = static_cast<uint32_t>(number);
+                std::memcpy(dst + i * sizeof(packed), &packed, sizeof(packed));
+            } else {
+                const auto packed = static_cast<float>(number);
+                std::memcpy(dst + i * sizeof(packed), &packed, sizeof(packed));
             }
         }
     }
@@ -111,9 +323,9 @@ auto Shader::name() const -> std::string
     return m_name;
 }
 
-void Shader::use() const
+void Shader::use(GLStateCache& state) const
 {
-    glUseProgram(m_program);
+    state.useProgram(m_program);
 }
 
 auto Shader::uniforms() const -> const std::vector<Uniform>&
@@ -121,67 +333,176 @@ auto Shader::uniforms() const -> const std::vector<Uniform>&
     return m_uniforms;
 }
 
+auto Shader::uniformLocation(const std::string& name) const -> GLint
+{
+    auto it = m_uniform_locations.find(name);
+    if (it == m_uniform_locations.end()) {
+        return -1;
+    }
+    return it->second;
+}
+
+auto Shader::builtinLocations() const -> const BuiltinLocations&
+{
+    return m_builtin_locations;
+}
+
+auto Shader::usesFrameBlock() const -> bool
+{
+    return m_uses_frame_block;
+}
+
+auto Shader::usesObjectBlock() const -> bool
+{
+    return m_uses_object_block;
+}
+
+auto Shader::objectBlockMembers() const -> const std::vector<BlockMember>&
+{
+    return m_object_block_members;
+}
+
+auto Shader::objectBlockSize() const -> GLint
+{
+    return m_object_block_size;
+}
+
+auto Shader::objectBlockDefaults() const -> const std::vector<std::byte>&
+{
+    return m_object_block_defaults;
+}
+
+auto Shader::wantsDepthPrepass() const -> bool
+{
+    return m_depth_prepass;
+}
+
+auto Shader::wantsInstancedModel() const -> bool
+{
+    return m_instanced_model;
+}
+
 void Shader::setUniform4mat(const std::string& name, const glm::mat4& value) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(m_program, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    setUniform4mat(uniformLocation(name), value);
 }
 
 void Shader::setUniform3mat(const std::string& name, const glm::mat3& value) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(m_program, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    setUniform3mat(uniformLocation(name), value);
 }
 
 void Shader::setUniform2mat(const std::string& name, const glm::mat2& value) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(m_program, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    setUniform2mat(uniformLocation(name), value);
 }
 
 void Shader::setUniform4vec(const std::string& name, const glm::vec4& value) const
 {
-    glUniform4fv(glGetUniformLocation(m_program, name.c_str()), 1, glm::value_ptr(value));
+    setUniform4vec(uniformLocation(name), value);
 }
 
 void Shader::setUniform3vec(const std::string& name, const glm::vec3& value) const
 {
-    glUniform3fv(glGetUniformLocation(m_program, name.c_str()), 1, glm::value_ptr(value));
+    setUniform3vec(uniformLocation(name), value);
 }
 
 void Shader::setUniform2vec(const std::string& name, const glm::vec2& value) const
 {
-    glUniform2fv(glGetUniformLocation(m_program, name.c_str()), 1, glm::value_ptr(value));
+    setUniform2vec(uniformLocation(name), value);
 }
 
 void Shader::setUniform1vec(const std::string& name, const glm::vec1& value) const
 {
-    glUniform1fv(glGetUniformLocation(m_program, name.c_str()), 1, glm::value_ptr(value));
+    setUniform1vec(uniformLocation(name), value);
 }
 
 void Shader::setUniform1f(const std::string& name, float value) const
 {
-    glUniform1f(glGetUniformLocation(m_program, name.c_str()), value);
+    setUniform1f(uniformLocation(name), value);
 }
 
 void Shader::setUniform1d(const std::string& name, double value) const
 {
-    glUniform1d(glGetUniformLocation(m_program, name.c_str()), value);
+    setUniform1d(uniformLocation(name), value);
 }
 
 void Shader::setUniform1ui(const std::string& name, uint32_t value) const
 {
-    glUniform1ui(glGetUniformLocation(m_program, name.c_str()), value);
+    setUniform1ui(uniformLocation(name), value);
 }
 
 void Shader::setUniform1b(const std::string& name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(m_program, name.c_str()), value ? 1 : 0);
+    setUniform1b(uniformLocation(name), value);
 }
 
 void Shader::setUniform1i(const std::string& name, int value) const
 {
-    glUniform1i(glGetUniformLocation(m_program, name.c_str()), value);
+    setUniform1i(uniformLocation(name), value);
+}
+
+void Shader::setUniform4mat(GLint location, const glm::mat4& value) const
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::setUniform3mat(GLint location, const glm::mat3& value) const
+{
+    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::setUniform2mat(GLint location, const glm::mat2& value) const
+{
+    glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
-auto buildShader(const std::filesystem::path& path) -> std::optional<std::unique_ptr<Shader>>
+void Shader::setUniform4vec(GLint location, const glm::vec4& value) const
+{
+    glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::setUniform3vec(GLint location, const glm::vec3& value) const
+{
+    glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::setUniform2vec(GLint location, const glm::vec2& value) const
+{
+    glUniform2fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::setUniform1vec(GLint location, const glm::vec1& value) const
+{
+    glUniform1fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::setUniform1f(GLint location, float value) const
+{
+    glUniform1f(location, value);
+}
+
+void Shader::setUniform1d(GLint location, double value) const
+{
+    glUniform1d(location, value);
+}
+
+void Shader::setUniform1ui(GLint location, uint32_t value) const
+{
+    glUniform1ui(location, value);
+}
+
+void Shader::setUniform1b(GLint location, bool value) const
+{
+    glUniform1i(location, value ? 1 : 0);
+}
+
+void Shader::setUniform1i(GLint location, int value) const
+{
+    glUniform1i(location, value);
+}
+
+auto readShaderSources(const std::filesystem::path& path) -> std::optional<ShaderSources>
 {
     Logger::debug(__FUNCTION__);
 
@@ -197,17 +518,22 @@ auto buildShader(const std::filesystem::path& path) -> std::optional<std::unique
     auto configPath = shaderDirectory.path() / "config.json";
 
     if (!FileSystem::exists(vertexShaderPath) || !FileSystem::isFile(vertexShaderPath) ||
-        !FileSystem::exists(fragmentShaderPath) || !FileSystem::isFile(fragmentShaderPath) ||
-        !FileSystem::exists(configPath) || !FileSystem::isFile(configPath))
+        !FileSystem::exists(fragmentShaderPath) || !FileSystem::isFile(fragmentShaderPath))
     {
         return std::nullopt;
     }
 
-    auto vertexShaderSource = FileSystem::file(vertexShaderPath, std::ios::in).readText();
-    auto fragmentShaderSource = FileSystem::file(fragmentShaderPath, std::ios::in).readText();
-    auto configSource = FileSystem::file(configPath, std::ios::in).readText();
+    ShaderSources sources;
+    sources.name = path.stem().string();
+    sources.vertex = FileSystem::file(vertexShaderPath, std::ios::in).readText();
+    sources.fragment = FileSystem::file(fragmentShaderPath, std::ios::in).readText();
 
-    return std::make_unique<Shader>(path.stem().string(), vertexShaderSource, fragmentShaderSource, configSource);
+    // uniforms are discovered from the linked program, config.json is optional
+    if (FileSystem::exists(configPath) && FileSystem::isFile(configPath)) {
+        sources.config = FileSystem::file(configPath, std::ios::in).readText();
+    }
+
+    return sources;
 }
 
-}
\ No newline at end of file
+}
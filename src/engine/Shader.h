@@ -4,16 +4,38 @@
 
 #include <glm/glm.hpp>
 
+#include <cstddef>
 #include <string>
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace engine {
 
+class GLStateCache;
+struct ShaderSources;
+
 class Shader {
 public:
+    struct BuiltinLocations {
+        GLint model = -1;
+        GLint view = -1;
+        GLint projection = -1;
+        GLint texture1 = -1;
+    };
+
+    struct BlockMember {
+        std::string name;
+        Uniform::Type type;
+        GLint offset;
+        GLint matrix_stride;
+    };
+
     explicit Shader(const std::string& name, const std::string& vertexShader, const std::string& fragmentShader, const std::string& config);
+    // takes over a program that linked, see ShaderCompiler
+    explicit Shader(const std::string& name, GLuint program, const std::string& config);
     ~Shader();
     Shader(const Shader&) = delete;
     Shader& operator=(const Shader&) = delete;
@@ -22,10 +44,27 @@ public:
 
     auto name() const -> std::string;
 
-    void use() const;
+    void use(GLStateCache& state) const;
 
     auto uniforms() const -> const std::vector<Uniform>&;
 
+    auto uniformLocation(const std::string& name) const -> GLint;
+    auto builtinLocations() const -> const BuiltinLocations&;
+
+    auto usesFrameBlock() const -> bool;
+    auto usesObjectBlock() const -> bool;
+
+    auto objectBlockMembers() const -> const std::vector<BlockMember>&;
+    auto objectBlockSize() const -> GLint;
+    // the per-object block with the "default" values of config.json written in, zero elsewhere
+    auto objectBlockDefaults() const -> const std::vector<std::byte>&;
+
+    // "depth_prepass" in config.json, for heavy fragment shaders without discard
+    auto wantsDepthPrepass() const -> bool;
+    // "instanced_model" in config.json, the vertex shader reads the model matrix from
+    // "layout (location = 3) in mat4 aModel" so draws sharing a material can be merged
+    auto wantsInstancedModel() const -> bool;
+
     void setUniform4mat(const std::string& name, const glm::mat4& value) const;
     void setUniform3mat(const std::string& name, const glm::mat3& value) const;
     void setUniform2mat(const std::string& name, const glm::mat2& value) const;
@@ -39,14 +78,48 @@ public:
     void setUniform1ui(const std::string& name, uint32_t value) const;
     void setUniform1b(const std::string& name, bool value) const;
 
+    void setUniform4mat(GLint location, const glm::mat4& value) const;
+    void setUniform3mat(GLint location, const glm::mat3& value) const;
+    void setUniform2mat(GLint location, const glm::mat2& value) const;
+    void setUniform4vec(GLint location, const glm::vec4& value) const;
+    void setUniform3vec(GLint location, const glm::vec3& value) const;
+    void setUniform2vec(GLint location, const glm::vec2& value) const;
+    void setUniform1vec(GLint location, const glm::vec1& value) const;
+    void setUniform1f(GLint location, float value) const;
+    void setUniform1d(GLint location, double value) const;
+    void setUniform1i(GLint location, int value) const;
+    void setUniform1ui(GLint location, uint32_t value) const;
+    void setUniform1b(GLint location, bool value) const;
+
 private:
+    void initialize(const std::string& config);
+    void introspectUniforms();
+    void bindUniformBlocks();
+    void checkDeclaredUniforms(const std::string& config) const;
+    void readOptions(const std::string& config);
+    void readObjectBlockDefaults(const std::string& config);
+
     std::string m_name;
 
-    GLuint m_program;
+    GLuint m_program = 0;
 
     std::vector<Uniform> m_uniforms{};
+    std::unordered_map<std::string, GLint> m_uniform_locations{};
+
+    BuiltinLocations m_builtin_locations{};
+
+    bool m_uses_frame_block = false;
+    bool m_uses_object_block = false;
+
+    std::vector<BlockMember> m_object_block_members{};
+    GLint m_object_block_size = 0;
+    std::vector<std::byte> m_object_block_defaults{};
+
+    bool m_depth_prepass = false;
+    bool m_instanced_model = false;
 };
 
-auto buildShader(const std::filesystem::path& path) -> std::optional<std::unique_ptr<Shader>>;
+// reads vert.glsl, frag.glsl and the optional config.json of a shader directory
+auto readShaderSources(const std::filesystem::path& path) -> std::optional<ShaderSources>;
 
 }
\ No newline at end of file
@@ -0,0 +1,451 @@
+#include "ShaderCompiler.h"
+#include "FileSystem.h"
+#include "Logger.h"
+#include "Shader.h"
+#include "UtilGL.h"
+
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <thread>
+
+namespace engine {
+
+namespace {
+
+// KHR_parallel_shader_compile and its ARB twin, glad was generated without them
+constexpr GLenum COMPLETION_STATUS = 0x91B1;
+
+constexpr uint32_t BINARY_MAGIC = 0x50524742; // "PRGB"
+
+struct BinaryHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint64_t key;
+    uint32_t length;
+};
+
+auto hashBytes(uint64_t hash, const std::string& bytes) -> uint64_t
+{
+    // FNV-1a, the extra round at the end separates consecutive strings
+    for (const char c : bytes) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+    }
+    return hash * 0x100000001b3ull;
+}
+
+auto glString(GLenum name) -> std::string
+{
+    const auto* value = glGetString(name);
+    return value != nullptr ? reinterpret_cast<const char*>(value) : "";
+}
+
+auto compileStage(GLenum stage, const std::string& source) -> GLuint
+{
+    GLuint shader = glCreateShader(stage);
+    const char* shader_source = source.c_str();
+    glShaderSource(shader, 1, &shader_source, nullptr);
+    glCompileShader(shader);
+    return shader;
+}
+
+auto elapsedMs(std::chrono::steady_clock::time_point start) -> double
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+auto ShaderVariants::mask(std::span<const std::string> features) const -> uint32_t
+{
+    uint32_t result = 0;
+    for (const auto& feature : features) {
+        const auto it = std::ranges::find(defines, feature);
+        // features the shader does not declare cost nothing and are left out
+        if (it != defines.end()) {
+            result |= 1u << static_cast<uint32_t>(it - defines.begin());
+        }
+    }
+    return result;
+}
+
+auto ShaderVariants::sources(const ShaderSources& base, uint32_t mask) const -> ShaderSources
+{
+    std::string define_lines;
+    std::string suffix;
+    for (size_t i = 0; i < defines.size(); ++i) {
+        if ((mask & (1u << i)) != 0) {
+            define_lines += "#define " + defines[i] + "\n";
+            suffix += (suffix.empty() ? "" : ",") + defines[i];
+        }
+    }
+
+    // the defines go after #version, which has to stay the first statement
+    auto inject = [&define_lines](const std::string& source) {
+        const auto version = source.find("#version");
+        if (version == std::string::npos) {
+            return define_lines + source;
+        }
+        const auto line_end = source.find('\n', version);
+        if (line_end == std::string::npos) {
+            return source + "\n" + define_lines;
+        }
+        return source.substr(0, line_end + 1) + define_lines + source.substr(line_end + 1);
+    };
+
+    ShaderSources variant;
+    variant.name = mask == 0 ? base.name : base.name + "[" + suffix + "]";
+    variant.vertex = inject(base.vertex);
+    variant.fragment = inject(base.fragment);
+    variant.config = base.config;
+    return variant;
+}
+
+auto readShaderVariants(const ShaderSources& sources) -> ShaderVariants
+{
+    ShaderVariants variants;
+    if (sources.config.empty()) {
+        return variants;
+    }
+
+    rapidjson::Document configJson = rapidjson::Document();
+    configJson.Parse(sources.config.c_str());
+
+    if (configJson.HasParseError() || !configJson.IsObject() || !configJson.HasMember("variants") || !configJson["variants"].IsObject()) {
+        return variants;
+    }
+
+    const auto& variantsJson = configJson["variants"];
+    if (variantsJson.HasMember("defines") && variantsJson["defines"].IsArray()) {
+        for (const auto& define : variantsJson["defines"].GetArray()) {
+            if (!define.IsString()) {
+                continue;
+            }
+            if (variants.defines.size() == ShaderVariants::MAX_DEFINES) {
+                Logger::warning("SHADER::VARIANTS::TOO_MANY_DEFINES, shader: {}, ignored: {}", sources.name, define.GetString());
+                continue;
+            }
+            variants.defines.emplace_back(define.GetString());
+        }
+    }
+
+    if (variantsJson.HasMember("precompile") && variantsJson["precompile"].IsArray()) {
+        for (const auto& variant : variantsJson["precompile"].GetArray()) {
+            if (!variant.IsArray()) {
+                continue;
+            }
+
+            std::vector<std::string> features;
+            for (const auto& feature : variant.GetArray()) {
+                if (feature.IsString()) {
+                    features.emplace_back(feature.GetString());
+                }
+            }
+
+            const auto mask = variants.mask(features);
+            if (mask != 0 && std::ranges::find(variants.precompile, mask) == variants.precompile.end()) {
+                variants.precompile.push_back(mask);
+            }
+        }
+    }
+
+    return variants;
+}
+
+ProgramBinaryCache::ProgramBinaryCache(const std::filesystem::path& directory) :
+    m_directory(directory)
+{
+}
+
+auto ProgramBinaryCache::enabled() -> bool
+{
+    if (m_initialized) {
+        return m_enabled;
+    }
+    m_initialized = true;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    m_driver = glString(GL_VENDOR) + "/" + glString(GL_RENDERER) + "/" + glString(GL_VERSION);
+
+    if (formats <= 0) {
+        Logger::info("ProgramBinaryCache: driver offers no program binary formats, cache disabled");
+        return false;
+    }
+
+    if (!FileSystem::exists(m_directory) && !FileSystem::createDirectories(m_directory)) {
+        Logger::warning("ProgramBinaryCache: can not create {}, cache disabled", m_directory.string());
+        return false;
+    }
+
+    m_enabled = true;
+    Logger::info("ProgramBinaryCache: {} for {}", m_directory.string(), m_driver);
+
+    return true;
+}
+
+auto ProgramBinaryCache::load(const ShaderSources& sources) -> GLuint
+{
+    if (!enabled()) {
+        return 0;
+    }
+
+    const auto cache_key = key(sources);
+    const auto file_path = path(cache_key);
+    if (!FileSystem::exists(file_path) || !FileSystem::isFile(file_path)) {
+        return 0;
+    }
+
+    const auto bytes = FileSystem::file(file_path, std::ios::in | std::ios::binary).readBinary();
+
+    BinaryHeader header{};
+    if (bytes.size() >= sizeof(header)) {
+        std::memcpy(&header, bytes.data(), sizeof(header));
+    }
+
+    if (header.magic != BINARY_MAGIC || header.key != cache_key || header.length != bytes.size() - sizeof(header)) {
+        Logger::warning("ProgramBinaryCache: dropping malformed {}", file_path.string());
+        FileSystem::removeFile(file_path);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, bytes.data() + sizeof(header), static_cast<GLsizei>(header.length));
+
+    // the driver may still reject a binary when its version string stayed the same
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        Logger::info("ProgramBinaryCache: driver rejected the binary of {}, recompiling", sources.name);
+        glDeleteProgram(program);
+        FileSystem::removeFile(file_path);
+        return 0;
+    }
+
+    return program;
+}
+
+void ProgramBinaryCache::store(const ShaderSources& sources, GLuint program)
+{
+    if (!enabled()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<uint8_t> bytes(sizeof(BinaryHeader) + length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, bytes.data() + sizeof(BinaryHeader));
+    if (written <= 0) {
+        return;
+    }
+
+    const auto cache_key = key(sources);
+    const BinaryHeader header = { BINARY_MAGIC, format, cache_key, static_cast<uint32_t>(written) };
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    bytes.resize(sizeof(header) + written);
+
+    FileSystem::file(path(cache_key), std::ios::out | std::ios::binary | std::ios::trunc).writeBinary(bytes);
+}
+
+auto ProgramBinaryCache::key(const ShaderSources& sources) const -> uint64_t
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashBytes(hash, m_driver);
+    hash = hashBytes(hash, sources.vertex);
+    hash = hashBytes(hash, sources.fragment);
+    return hash;
+}
+
+auto ProgramBinaryCache::path(uint64_t key) const -> std::filesystem::path
+{
+    return m_directory / std::format("{:016x}.bin", key);
+}
+
+ShaderCompiler::ShaderCompiler(ProgramBinaryCache* cache) :
+    m_cache(cache),
+    m_parallel(parallelCompileSupported())
+{
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+    for (auto& pending : m_pending) {
+        release(pending);
+    }
+}
+
+void ShaderCompiler::add(uint32_t id, ShaderSources sources, uint32_t variant)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    Pending pending;
+    pending.id = id;
+    pending.variant = variant;
+    pending.sources = std::move(sources);
+
+    if (m_cache != nullptr) {
+        pending.program = m_cache->load(pending.sources);
+    }
+
+    if (pending.program != 0) {
+        pending.cached = true;
+        ++m_stats.cache_hits;
+    } else {
+        pending.vertex = compileStage(GL_VERTEX_SHADER, pending.sources.vertex);
+        pending.fragment = compileStage(GL_FRAGMENT_SHADER, pending.sources.fragment);
+
+        pending.program = glCreateProgram();
+        glAttachShader(pending.program, pending.vertex);
+        glAttachShader(pending.program, pending.fragment);
+        if (m_cache != nullptr && m_cache->enabled()) {
+            glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        // a stage that failed to compile fails the link, finish() reports which one
+        glLinkProgram(pending.program);
+        ++m_stats.compiled;
+    }
+
+    m_pending.push_back(std::move(pending));
+
+    m_stats.cpu_ms += elapsedMs(start);
+}
+
+auto ShaderCompiler::finish() -> std::vector<Built>
+{
+    std::vector<Built> shaders;
+    shaders.reserve(m_pending.size());
+
+    while (!m_pending.empty()) {
+        auto completed = finishCompleted();
+        if (completed.empty()) {
+            std::this_thread::yield();
+        }
+        std::ranges::move(completed, std::back_inserter(shaders));
+    }
+
+    return shaders;
+}
+
+auto ShaderCompiler::finishCompleted() -> std::vector<Built>
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<Built> shaders;
+
+    for (size_t i = 0; i < m_pending.size();) {
+        if (!isComplete(m_pending[i])) {
+            ++i;
+            continue;
+        }
+
+        auto shader = finishPending(m_pending[i]);
+        if (shader) {
+            shaders.push_back({ m_pending[i].id, m_pending[i].variant, std::move(shader) });
+        }
+        m_pending.erase(m_pending.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+
+    m_stats.cpu_ms += elapsedMs(start);
+
+    return shaders;
+}
+
+auto ShaderCompiler::hasPending() const -> bool
+{
+    return !m_pending.empty();
+}
+
+auto ShaderCompiler::stats() const -> const Stats&
+{
+    return m_stats;
+}
+
+auto ShaderCompiler::parallelCompileSupported() -> bool
+{
+    return hasGLExtension("GL_KHR_parallel_shader_compile") || hasGLExtension("GL_ARB_parallel_shader_compile");
+}
+
+auto ShaderCompiler::isComplete(const Pending& pending) const -> bool
+{
+    // without the extension the status queries in finishPending() wait for the driver
+    if (!m_parallel || pending.cached) {
+        return true;
+    }
+
+    GLint complete = GL_FALSE;
+    glGetProgramiv(pending.program, COMPLETION_STATUS, &complete);
+    return complete != GL_FALSE;
+}
+
+auto ShaderCompiler::finishPending(Pending& pending) -> std::unique_ptr<Shader>
+{
+    ++m_stats.programs;
+
+    GLint success = 0;
+    GLchar infoLog[512];
+
+    glGetProgramiv(pending.program, GL_LINK_STATUS, &success);
+    if (!success) {
+        bool stage_failed = false;
+        for (const auto& [stage, stage_name] : { std::pair{ pending.vertex, "VERTEX" }, std::pair{ pending.fragment, "FRAGMENT" } }) {
+            glGetShaderiv(stage, GL_COMPILE_STATUS, &success);
+            if (!success) {
+                glGetShaderInfoLog(stage, 512, nullptr, infoLog);
+                Logger::error("ERROR::SHADER::{}::COMPILATION_FAILED, shader: {}, info: {}", stage_name, pending.sources.name, infoLog);
+                stage_failed = true;
+            }
+        }
+
+        if (!stage_failed) {
+            glGetProgramInfoLog(pending.program, 512, nullptr, infoLog);
+            Logger::error("ERROR::SHADER::PROGRAM::LINKING_FAILED, shader: {}, info: {}", pending.sources.name, infoLog);
+        }
+
+        ++m_stats.failed;
+        release(pending);
+        return nullptr;
+    }
+
+    if (!pending.cached && m_cache != nullptr) {
+        m_cache->store(pending.sources, pending.program);
+    }
+
+    // detached so the driver frees the stages now rather than with the program,
+    // a program loaded from the binary cache never had stages attached
+    const GLuint program = pending.program;
+    if (!pending.cached) {
+        glDetachShader(program, pending.vertex);
+        glDetachShader(program, pending.fragment);
+    }
+    pending.program = 0;
+    release(pending);
+
+    return std::make_unique<Shader>(pending.sources.name, program, pending.sources.config);
+}
+
+void ShaderCompiler::release(Pending& pending)
+{
+    if (pending.program != 0) {
+        glDeleteProgram(pending.program);
+        pending.program = 0;
+    }
+    for (auto* stage : { &pending.vertex, &pending.fragment }) {
+        if (*stage != 0) {
+            glDeleteShader(*stage);
+            *stage = 0;
+        }
+    }
+}
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+class Shader;
+
+struct ShaderSources {
+    std::string name;
+    std::string vertex;
+    std::string fragment;
+    std::string config;
+};
+
+// "variants" in config.json, e.g. {"defines": ["ALPHA_TEST", "LIT"], "precompile": [["LIT"]]}.
+// Bit i of a variant mask #defines defines[i] in both stages, mask 0 is the shader as
+// written. Precompiled variants are built with the package, the rest on first use.
+struct ShaderVariants {
+    static constexpr size_t MAX_DEFINES = 32;
+
+    std::vector<std::string> defines;
+    std::vector<uint32_t> precompile;
+
+    auto mask(std::span<const std::string> features) const -> uint32_t;
+    auto sources(const ShaderSources& base, uint32_t mask) const -> ShaderSources;
+};
+
+auto readShaderVariants(const ShaderSources& sources) -> ShaderVariants;
+
+// Linked program binaries on disk, one file per program named after a hash of its
+// sources and the driver string, so a driver update misses instead of loading a
+// binary the driver would reject.
+class ProgramBinaryCache final {
+public:
+    explicit ProgramBinaryCache(const std::filesystem::path& directory);
+    ~ProgramBinaryCache() = default;
+    ProgramBinaryCache(const ProgramBinaryCache&) = delete;
+    ProgramBinaryCache(ProgramBinaryCache&&) = delete;
+    ProgramBinaryCache& operator=(const ProgramBinaryCache&) = delete;
+    ProgramBinaryCache& operator=(ProgramBinaryCache&&) = delete;
+
+    // asks the driver on the first call, needs a current GL context
+    auto enabled() -> bool;
+
+    // a linked program or 0 on a miss
+    auto load(const ShaderSources& sources) -> GLuint;
+    void store(const ShaderSources& sources, GLuint program);
+
+private:
+    auto key(const ShaderSources& sources) const -> uint64_t;
+    auto path(uint64_t key) const -> std::filesystem::path;
+
+    std::filesystem::path m_directory;
+    std::string m_driver;
+    bool m_initialized = false;
+    bool m_enabled = false;
+};
+
+// Builds the programs of a resource package together. add() loads a cached binary
+// or hands both stages and the link to the driver without asking for their status,
+// finish() collects the results, so the driver compiles while the package's
+// textures and meshes load. With KHR_parallel_shader_compile finish() picks up
+// programs in the order the driver completes them.
+class ShaderCompiler final {
+public:
+    struct Built {
+        uint32_t id = 0;
+        uint32_t variant = 0;
+        std::unique_ptr<Shader> shader;
+    };
+
+    struct Stats {
+        uint32_t programs = 0;
+        uint32_t cache_hits = 0;
+        uint32_t compiled = 0;
+        uint32_t failed = 0;
+        // spent in add() and finish(), the time between them overlaps with other loading
+        double cpu_ms = 0.0;
+    };
+
+    // cache may be null
+    explicit ShaderCompiler(ProgramBinaryCache* cache);
+    ~ShaderCompiler();
+    ShaderCompiler(const ShaderCompiler&) = delete;
+    ShaderCompiler(ShaderCompiler&&) = delete;
+    ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+    ShaderCompiler& operator=(ShaderCompiler&&) = delete;
+
+    void add(uint32_t id, ShaderSources sources, uint32_t variant = 0);
+    // programs that failed are logged and left out
+    auto finish() -> std::vector<Built>;
+    // like finish() but only takes the programs the driver is done with, so with
+    // KHR_parallel_shader_compile it never waits; without it everything is done
+    auto finishCompleted() -> std::vector<Built>;
+    auto hasPending() const -> bool;
+
+    auto stats() const -> const Stats&;
+
+    static auto parallelCompileSupported() -> bool;
+
+private:
+    struct Pending {
+        uint32_t id = 0;
+        uint32_t variant = 0;
+        ShaderSources sources;
+        GLuint vertex = 0;
+        GLuint fragment = 0;
+        GLuint program = 0;
+        bool cached = false;
+    };
+
+    auto isComplete(const Pending& pending) const -> bool;
+    auto finishPending(Pending& pending) -> std::unique_ptr<Shader>;
+    void release(Pending& pending);
+
+    ProgramBinaryCache* m_cache;
+    bool m_parallel;
+    std::vector<Pending> m_pending;
+    Stats m_stats;
+};
+
+}
@@ -1,10 +1,21 @@
 #include "ShaderStore.h"
 #include "Shader.h"
+#include "ShaderCompiler.h"
+#include "Logger.h"
 
 #include <algorithm>
 
 namespace engine {
 
+struct ShaderStore::VariantSource {
+    ShaderSources sources;
+    ShaderVariants variants;
+};
+
+ShaderStore::ShaderStore() = default;
+
+ShaderStore::~ShaderStore() = default;
+
 auto ShaderStore::get(uint32_t id) const -> std::optional<std::shared_ptr<Shader>>
 {
     auto it = m_shaders.find(id);
@@ -45,6 +56,13 @@ void ShaderStore::add(uint32_t id, std::unique_ptr<Shader> shader)
 void ShaderStore::remove(uint32_t id)
 {
     m_shaders.erase(id);
+    m_variant_sources.erase(id);
+    std::erase_if(m_variants, [id](const auto& variant) {
+        return (variant.first >> 32) == id;
+    });
+    std::erase_if(m_failed_variants, [id](uint64_t key) {
+        return (key >> 32) == id;
+    });
 }
 
 bool ShaderStore::contains(uint32_t id) const
@@ -61,4 +79,100 @@ auto ShaderStore::names() const -> std::vector<std::string>
     return names;
 }
 
+void ShaderStore::setVariantSources(uint32_t id, const ShaderSources& sources, const ShaderVariants& variants)
+{
+    std::erase_if(m_variants, [id](const auto& variant) {
+        return (variant.first >> 32) == id;
+    });
+    std::erase_if(m_failed_variants, [id](uint64_t key) {
+        return (key >> 32) == id;
+    });
+
+    m_variant_sources[id] = std::make_unique<VariantSource>(VariantSource{ sources, variants });
+}
+
+auto ShaderStore::variantMask(uint32_t id, std::span<const std::string> features) const -> uint32_t
+{
+    if (features.empty()) {
+        return 0;
+    }
+
+    auto it = m_variant_sources.find(id);
+    if (it == m_variant_sources.end()) {
+        return 0;
+    }
+    return it->second->variants.mask(features);
+}
+
+auto ShaderStore::getVariant(uint32_t id, uint32_t mask) const -> std::optional<std::shared_ptr<Shader>>
+{
+    if (mask == 0) {
+        return get(id);
+    }
+
+    const auto key = variantKey(id, mask);
+    auto it = m_variants.find(key);
+    if (it != m_variants.end()) {
+        return it->second;
+    }
+
+    if (m_failed_variants.contains(key)) {
+        return get(id);
+    }
+    return std::nullopt;
+}
+
+void ShaderStore::addVariant(uint32_t id, uint32_t mask, std::unique_ptr<Shader> shader)
+{
+    m_variants[variantKey(id, mask)] = std::move(shader);
+}
+
+auto ShaderStore::buildVariant(uint32_t id, uint32_t mask) -> std::optional<std::shared_ptr<Shader>>
+{
+    auto variant = getVariant(id, mask);
+    if (variant.has_value()) {
+        return variant;
+    }
+
+    auto it = m_variant_sources.find(id);
+    if (it == m_variant_sources.end()) {
+        return std::nullopt;
+    }
+
+    const auto& source = *it->second;
+    auto sources = source.variants.sources(source.sources, mask);
+    const auto name = sources.name;
+
+    ShaderCompiler compiler(m_program_cache.get());
+    compiler.add(id, std::move(sources), mask);
+
+    auto built = compiler.finish();
+    if (built.empty()) {
+        Logger::warning("ShaderStore: variant {} failed to build, using {}", name, source.sources.name);
+        m_failed_variants.insert(variantKey(id, mask));
+        return get(id);
+    }
+
+    Logger::info("ShaderStore: built variant {} on first use in {:.2f} ms", name, compiler.stats().cpu_ms);
+
+    auto shader = std::shared_ptr<Shader>(std::move(built.front().shader));
+    m_variants[variantKey(id, mask)] = shader;
+    return shader;
+}
+
+auto ShaderStore::variantKey(uint32_t id, uint32_t mask) -> uint64_t
+{
+    return (static_cast<uint64_t>(id) << 32) | mask;
+}
+
+void ShaderStore::setProgramCache(std::unique_ptr<ProgramBinaryCache> cache)
+{
+    m_program_cache = std::move(cache);
+}
+
+auto ShaderStore::programCache() const -> ProgramBinaryCache*
+{
+    return m_program_cache.get();
+}
+
 }
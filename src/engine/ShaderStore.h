@@ -3,17 +3,22 @@
 #include <unordered_map>
 #include <optional>
 #include <memory>
+#include <span>
+#include <unordered_set>
 #include <string>
 #include <vector>
 
 namespace engine {
 
 class Shader;
+class ProgramBinaryCache;
+struct ShaderSources;
+struct ShaderVariants;
 
 class ShaderStore {
 public:
-    ShaderStore() = default;
-    ~ShaderStore() = default;
+    ShaderStore();
+    ~ShaderStore();
 
     ShaderStore(const ShaderStore&) = delete;
     ShaderStore& operator=(const ShaderStore&) = delete;
@@ -29,8 +34,30 @@ public:
     bool contains(uint32_t id) const;
     auto names() const -> std::vector<std::string>;
 
+    // sources of a shader declaring variants, drops the variants built from older ones
+    void setVariantSources(uint32_t id, const ShaderSources& sources, const ShaderVariants& variants);
+    // the mask of the declared defines among features, 0 for shaders without variants
+    auto variantMask(uint32_t id, std::span<const std::string> features) const -> uint32_t;
+    // never compiles, a variant that failed to build falls back to the shader itself
+    auto getVariant(uint32_t id, uint32_t mask) const -> std::optional<std::shared_ptr<Shader>>;
+    void addVariant(uint32_t id, uint32_t mask, std::unique_ptr<Shader> shader);
+    // compiles a missing variant on first use, needs the GL context
+    auto buildVariant(uint32_t id, uint32_t mask) -> std::optional<std::shared_ptr<Shader>>;
+
+    // null until a cache directory is configured
+    void setProgramCache(std::unique_ptr<ProgramBinaryCache> cache);
+    auto programCache() const -> ProgramBinaryCache*;
+
 private:
     std::unordered_map<uint32_t, std::shared_ptr<Shader>> m_shaders;
+    std::unique_ptr<ProgramBinaryCache> m_program_cache;
+
+    struct VariantSource;
+    static auto variantKey(uint32_t id, uint32_t mask) -> uint64_t;
+
+    std::unordered_map<uint32_t, std::unique_ptr<VariantSource>> m_variant_sources;
+    std::unordered_map<uint64_t, std::shared_ptr<Shader>> m_variants;
+    std::unordered_set<uint64_t> m_failed_variants;
 };
 
 }
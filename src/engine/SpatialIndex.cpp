@@ -0,0 +1,692 @@
+#include "SpatialIndex.h"
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <utility>
+
+namespace engine {
+
+namespace {
+
+enum class FrustumTest {
+    Outside,
+    Intersects,
+    Inside,
+};
+
+auto testFrustum(const Frustum& frustum, const Aabb& box) -> FrustumTest
+{
+    bool inside = true;
+    for (const auto& plane : frustum.planes()) {
+        const glm::vec3 normal(plane);
+        const glm::vec3 positive = glm::mix(box.min, box.max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+        if (glm::dot(normal, positive) + plane.w < 0.0f) {
+            return FrustumTest::Outside;
+        }
+
+        const glm::vec3 negative = glm::mix(box.max, box.min, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+        if (glm::dot(normal, negative) + plane.w < 0.0f) {
+            inside = false;
+        }
+    }
+    return inside ? FrustumTest::Inside : FrustumTest::Intersects;
+}
+
+auto distanceSquared(const Aabb& box, const glm::vec3& point) -> float
+{
+    const glm::vec3 closest = glm::clamp(point, box.min, box.max);
+    const glm::vec3 delta = point - closest;
+    return glm::dot(delta, delta);
+}
+
+// slab test, returns the entry distance along the ray
+auto intersectRay(const Aabb& box, const glm::vec3& origin, const glm::vec3& inverse_direction, float max_distance) -> std::optional<float>
+{
+    const glm::vec3 t1 = (box.min - origin) * inverse_direction;
+    const glm::vec3 t2 = (box.max - origin) * inverse_direction;
+    const glm::vec3 t_min = glm::min(t1, t2);
+    const glm::vec3 t_max = glm::max(t1, t2);
+
+    const float enter = std::max({ t_min.x, t_min.y, t_min.z, 0.0f });
+    const float exit = std::min({ t_max.x, t_max.y, t_max.z, max_distance });
+    if (enter > exit) {
+        return std::nullopt;
+    }
+    return enter;
+}
+
+}
+
+auto SpatialIndex::insert(const Aabb& box, uint32_t user_data) -> int32_t
+{
+    int32_t proxy = NULL_PROXY;
+    if (m_free_proxies.empty()) {
+        proxy = static_cast<int32_t>(m_proxies.size());
+        m_proxies.emplace_back();
+    } else {
+        proxy = m_free_proxies.back();
+        m_free_proxies.pop_back();
+    }
+
+    auto& item = m_proxies[proxy];
+    item.tight = box;
+    item.user_data = user_data;
+    item.pending = true;
+
+    m_pending.push_back(proxy);
+    ++m_size;
+
+    return proxy;
+}
+
+void SpatialIndex::remove(int32_t proxy)
+{
+    auto& item = m_proxies[proxy];
+    if (item.node != NULL_PROXY) {
+        removeLeaf(item.node);
+        freeNode(item.node);
+    }
+    item = Proxy{};
+
+    m_free_proxies.push_back(proxy);
+    --m_size;
+}
+
+bool SpatialIndex::move(int32_t proxy, const Aabb& box)
+{
+    auto& item = m_proxies[proxy];
+    item.tight = box;
+    if (item.pending) {
+        return true;
+    }
+    if (item.fat.contains(box)) {
+        return false;
+    }
+
+    item.pending = true;
+    m_pending.push_back(proxy);
+
+    return true;
+}
+
+void SpatialIndex::commit()
+{
+    if (m_pending.empty()) {
+        return;
+    }
+
+    if (m_pending.size() * REBUILD_SHARE > m_size) {
+        rebuild();
+        m_pending.clear();
+        return;
+    }
+
+    for (auto proxy : m_pending) {
+        auto& item = m_proxies[proxy];
+        if (!item.pending) {
+            continue;
+        }
+        item.pending = false;
+        item.fat = fatten(item.tight);
+
+        if (item.node == NULL_PROXY) {
+            item.node = allocateNode();
+            auto& node = m_nodes[item.node];
+            node.user_data = item.user_data;
+            node.proxy = proxy;
+        } else {
+            removeLeaf(item.node);
+        }
+        m_nodes[item.node].box = item.fat;
+        insertLeaf(item.node);
+    }
+    m_pending.clear();
+}
+
+void SpatialIndex::clear()
+{
+    m_nodes.clear();
+    m_root = NULL_PROXY;
+    m_free_list = NULL_PROXY;
+    m_size = 0;
+    m_proxies.clear();
+    m_free_proxies.clear();
+    m_pending.clear();
+}
+
+auto SpatialIndex::bounds(int32_t proxy) const -> const Aabb&
+{
+    return m_proxies[proxy].tight;
+}
+
+auto SpatialIndex::userData(int32_t proxy) const -> uint32_t
+{
+    return m_proxies[proxy].user_data;
+}
+
+auto SpatialIndex::size() const -> size_t
+{
+    return m_size;
+}
+
+auto SpatialIndex::height() const -> int32_t
+{
+    return m_root == NULL_PROXY ? 0 : m_nodes[m_root].height;
+}
+
+void SpatialIndex::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const
+{
+    if (m_root == NULL_PROXY) {
+        return;
+    }
+
+    m_stack.clear();
+    m_stack.push_back(m_root);
+
+    // nodes of a subtree found fully inside are pushed complemented and skip the plane tests
+    while (!m_stack.empty()) {
+        const int32_t entry = m_stack.back();
+        m_stack.pop_back();
+
+        const bool inside = entry < 0;
+        const int32_t index = inside ? ~entry : entry;
+        const auto& node = m_nodes[index];
+
+        auto test = FrustumTest::Inside;
+        if (!inside) {
+            test = testFrustum(frustum, node.isLeaf() ? m_proxies[node.proxy].tight : node.box);
+            if (test == FrustumTest::Outside) {
+                continue;
+            }
+        }
+
+        if (node.isLeaf()) {
+            result.push_back(node.user_data);
+        } else if (test == FrustumTest::Inside) {
+            m_stack.push_back(~node.child2);
+            m_stack.push_back(~node.child1);
+        } else {
+            m_stack.push_back(node.child2);
+            m_stack.push_back(node.child1);
+        }
+    }
+}
+
+void SpatialIndex::queryAabb(const Aabb& box, std::vector<uint32_t>& result) const
+{
+    if (m_root == NULL_PROXY) {
+        return;
+    }
+
+    m_stack.clear();
+    m_stack.push_back(m_root);
+
+    while (!m_stack.empty()) {
+        const int32_t index = m_stack.back();
+        m_stack.pop_back();
+
+        const auto& node = m_nodes[index];
+        if (!node.box.overlaps(box)) {
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            if (m_proxies[node.proxy].tight.overlaps(box)) {
+                result.push_back(node.user_data);
+            }
+        } else {
+            m_stack.push_back(node.child2);
+            m_stack.push_back(node.child1);
+        }
+    }
+}
+
+void SpatialIndex::queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& result) const
+{
+    if (m_root == NULL_PROXY) {
+        return;
+    }
+
+    const float radius_squared = radius * radius;
+
+    m_stack.clear();
+    m_stack.push_back(m_root);
+
+    while (!m_stack.empty()) {
+        const int32_t index = m_stack.back();
+        m_stack.pop_back();
+
+        const auto& node = m_nodes[index];
+        if (distanceSquared(node.box, center) > radius_squared) {
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            if (distanceSquared(m_proxies[node.proxy].tight, center) <= radius_squared) {
+                result.push_back(node.user_data);
+            }
+        } else {
+            m_stack.push_back(node.child2);
+            m_stack.push_back(node.child1);
+        }
+    }
+}
+
+auto SpatialIndex::raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance) const -> std::optional<RayHit>
+{
+    if (m_root == NULL_PROXY) {
+        return std::nullopt;
+    }
+
+    const glm::vec3 inverse_direction = 1.0f / direction;
+
+    std::optional<RayHit> closest;
+    float best = max_distance;
+
+    m_stack.clear();
+    m_stack.push_back(m_root);
+
+    while (!m_stack.empty()) {
+        const int32_t index = m_stack.back();
+        m_stack.pop_back();
+
+        const auto& node = m_nodes[index];
+        if (!intersectRay(node.box, origin, inverse_direction, best).has_value()) {
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            auto distance = intersectRay(m_proxies[node.proxy].tight, origin, inverse_direction, best);
+            if (distance.has_value()) {
+                best = distance.value();
+                closest = RayHit{ node.user_data, best };
+            }
+        } else {
+            m_stack.push_back(node.child2);
+            m_stack.push_back(node.child1);
+        }
+    }
+
+    return closest;
+}
+
+auto SpatialIndex::allocateNode() -> int32_t
+{
+    if (m_free_list == NULL_PROXY) {
+        const auto old_capacity = static_cast<int32_t>(m_nodes.size());
+        const auto new_capacity = std::max<int32_t>(16, old_capacity * 2);
+        m_nodes.resize(new_capacity);
+
+        for (int32_t i = old_capacity; i < new_capacity - 1; ++i) {
+            m_nodes[i].parent = i + 1;
+            m_nodes[i].height = -1;
+        }
+        m_nodes[new_capacity - 1].parent = NULL_PROXY;
+        m_nodes[new_capacity - 1].height = -1;
+        m_free_list = old_capacity;
+    }
+
+    const int32_t index = m_free_list;
+    auto& node = m_nodes[index];
+    m_free_list = node.parent;
+
+    node.parent = NULL_PROXY;
+    node.child1 = NULL_PROXY;
+    node.child2 = NULL_PROXY;
+    node.height = 0;
+    node.user_data = 0;
+    node.proxy = NULL_PROXY;
+
+    return index;
+}
+
+void SpatialIndex::freeNode(int32_t node)
+{
+    m_nodes[node].parent = m_free_list;
+    m_nodes[node].height = -1;
+    m_free_list = node;
+}
+
+void SpatialIndex::insertLeaf(int32_t leaf)
+{
+    if (m_root == NULL_PROXY) {
+        m_root = leaf;
+        m_nodes[leaf].parent = NULL_PROXY;
+        return;
+    }
+
+    // descend to the sibling with the lowest surface area cost
+    const Aabb leaf_box = m_nodes[leaf].box;
+    int32_t index = m_root;
+    while (!m_nodes[index].isLeaf()) {
+        const auto& node = m_nodes[index];
+
+        const float area = node.box.surfaceArea();
+        const float combined_area = mergeAabb(node.box, leaf_box).surfaceArea();
+
+        const float cost = 2.0f * combined_area;
+        const float inheritance_cost = 2.0f * (combined_area - area);
+
+        auto child_cost = [&](int32_t child) {
+            const auto& child_node = m_nodes[child];
+            const float merged_area = mergeAabb(leaf_box, child_node.box).surfaceArea();
+            if (child_node.isLeaf()) {
+                return merged_area + inheritance_cost;
+            }
+            return merged_area - child_node.box.surfaceArea() + inheritance_cost;
+        };
+
+        const float cost1 = child_cost(node.child1);
+        const float cost2 = child_cost(node.child2);
+
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int32_t sibling = index;
+    const int32_t old_parent = m_nodes[sibling].parent;
+    const int32_t new_parent = allocateNode();
+
+    auto& parent_node = m_nodes[new_parent];
+    parent_node.parent = old_parent;
+    parent_node.box = mergeAabb(leaf_box, m_nodes[sibling].box);
+    parent_node.height = m_nodes[sibling].height + 1;
+    parent_node.child1 = sibling;
+    parent_node.child2 = leaf;
+
+    if (old_parent != NULL_PROXY) {
+        if (m_nodes[old_parent].child1 == sibling) {
+            m_nodes[old_parent].child1 = new_parent;
+        } else {
+            m_nodes[old_parent].child2 = new_parent;
+        }
+    } else {
+        m_root = new_parent;
+    }
+
+    m_nodes[sibling].parent = new_parent;
+    m_nodes[leaf].parent = new_parent;
+
+    refitUpwards(m_nodes[leaf].parent);
+}
+
+void SpatialIndex::removeLeaf(int32_t leaf)
+{
+    if (leaf == m_root) {
+        m_root = NULL_PROXY;
+        return;
+    }
+
+    const int32_t parent = m_nodes[leaf].parent;
+    const int32_t grand_parent = m_nodes[parent].parent;
+    const int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    if (grand_parent != NULL_PROXY) {
+        if (m_nodes[grand_parent].child1 == parent) {
+            m_nodes[grand_parent].child1 = sibling;
+        } else {
+            m_nodes[grand_parent].child2 = sibling;
+        }
+        m_nodes[sibling].parent = grand_parent;
+        freeNode(parent);
+
+        refitUpwards(grand_parent);
+    } else {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_PROXY;
+        freeNode(parent);
+    }
+}
+
+// rebuilt into m_rebuilt depth first from the proxies alone, which keeps the nodes of a subtree close in memory
+void SpatialIndex::rebuild()
+{
+    m_sorted.clear();
+    m_root = NULL_PROXY;
+    m_free_list = NULL_PROXY;
+
+    Aabb centers{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+    for (int32_t proxy = 0; proxy < static_cast<int32_t>(m_proxies.size()); ++proxy) {
+        auto& item = m_proxies[proxy];
+        if (item.node == NULL_PROXY && !item.pending) {
+            continue;
+        }
+        if (item.pending) {
+            item.pending = false;
+            item.fat = fatten(item.tight);
+        }
+        m_sorted.push_back({ 0, proxy });
+
+        const glm::vec3 center = (item.fat.min + item.fat.max) * 0.5f;
+        centers.min = glm::min(centers.min, center);
+        centers.max = glm::max(centers.max, center);
+    }
+
+    if (m_sorted.empty()) {
+        m_nodes.clear();
+        return;
+    }
+
+    // 10 bits per axis of the center within the bounds of all centers, interleaved
+    auto spread = [](uint32_t value) {
+        value = (value | (value << 16)) & 0x030000ffu;
+        value = (value | (value << 8)) & 0x0300f00fu;
+        value = (value | (value << 4)) & 0x030c30c3u;
+        value = (value | (value << 2)) & 0x09249249u;
+        return value;
+    };
+    const glm::vec3 extent = centers.max - centers.min;
+    const glm::vec3 scale = glm::mix(glm::vec3(0.0f), 1023.0f / extent, glm::greaterThan(extent, glm::vec3(0.0f)));
+    for (auto& leaf : m_sorted) {
+        const auto& fat = m_proxies[leaf.proxy].fat;
+        const glm::uvec3 cell(glm::clamp((fat.min + fat.max) * 0.5f - centers.min, glm::vec3(0.0f), extent) * scale);
+        leaf.code = (spread(cell.x) << 2) | (spread(cell.y) << 1) | spread(cell.z);
+    }
+
+    // radix sort, 10 bits per pass
+    m_sort_buffer.resize(m_sorted.size());
+    for (uint32_t shift = 0; shift < 30; shift += 10) {
+        std::array<uint32_t, 1024> offsets{};
+        for (const auto& leaf : m_sorted) {
+            ++offsets[(leaf.code >> shift) & 1023];
+        }
+        uint32_t offset = 0;
+        for (auto& count : offsets) {
+            offset += std::exchange(count, offset);
+        }
+        for (const auto& leaf : m_sorted) {
+            m_sort_buffer[offsets[(leaf.code >> shift) & 1023]++] = leaf;
+        }
+        m_sorted.swap(m_sort_buffer);
+    }
+
+    m_rebuilt.clear();
+    m_rebuilt.reserve(m_nodes.size());
+    m_root = buildRange(0, static_cast<uint32_t>(m_sorted.size()));
+    m_rebuilt[m_root].parent = NULL_PROXY;
+
+    // the rest of the capacity is free
+    const auto used = static_cast<int32_t>(m_rebuilt.size());
+    m_rebuilt.resize(std::max(m_nodes.size(), m_rebuilt.size()));
+    for (auto index = static_cast<int32_t>(m_rebuilt.size()) - 1; index >= used; --index) {
+        m_rebuilt[index].height = -1;
+        m_rebuilt[index].parent = m_free_list;
+        m_free_list = index;
+    }
+    m_nodes.swap(m_rebuilt);
+}
+
+// splits where the highest bit differing between the codes of the range flips, in the middle of equal codes
+auto SpatialIndex::buildRange(uint32_t begin, uint32_t end) -> int32_t
+{
+    const auto index = static_cast<int32_t>(m_rebuilt.size());
+    if (end - begin == 1) {
+        auto& item = m_proxies[m_sorted[begin].proxy];
+        item.node = index;
+
+        auto& leaf = m_rebuilt.emplace_back();
+        leaf.box = item.fat;
+        leaf.height = 0;
+        leaf.user_data = item.user_data;
+        leaf.proxy = m_sorted[begin].proxy;
+        return index;
+    }
+
+    const uint32_t first_code = m_sorted[begin].code;
+    const uint32_t last_code = m_sorted[end - 1].code;
+
+    uint32_t split = (begin + end) / 2;
+    if (first_code != last_code) {
+        const int common_prefix = std::countl_zero(first_code ^ last_code);
+
+        // the last code still sharing more than the common prefix with the first ends the left half
+        uint32_t last_left = begin;
+        uint32_t step = end - 1 - begin;
+        do {
+            step = (step + 1) / 2;
+            const uint32_t candidate = last_left + step;
+            if (candidate < end - 1 && std::countl_zero(first_code ^ m_sorted[candidate].code) > common_prefix) {
+                last_left = candidate;
+            }
+        } while (step > 1);
+        split = last_left + 1;
+    }
+
+    m_rebuilt.emplace_back();
+    const int32_t child1 = buildRange(begin, split);
+    const int32_t child2 = buildRange(split, end);
+
+    auto& node = m_rebuilt[index];
+    node.child1 = child1;
+    node.child2 = child2;
+    node.box = mergeAabb(m_rebuilt[child1].box, m_rebuilt[child2].box);
+    node.height = 1 + std::max(m_rebuilt[child1].height, m_rebuilt[child2].height);
+    m_rebuilt[child1].parent = index;
+    m_rebuilt[child2].parent = index;
+
+    return index;
+}
+
+void SpatialIndex::refitUpwards(int32_t index)
+{
+    while (index != NULL_PROXY) {
+        index = balance(index);
+
+        auto& node = m_nodes[index];
+        const auto& child1 = m_nodes[node.child1];
+        const auto& child2 = m_nodes[node.child2];
+
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.box = mergeAabb(child1.box, child2.box);
+
+        index = node.parent;
+    }
+}
+
+// rotates the taller grandchild up when the children heights differ by more than one
+auto SpatialIndex::balance(int32_t index_a) -> int32_t
+{
+    auto& a = m_nodes[index_a];
+    if (a.isLeaf() || a.height < 2) {
+        return index_a;
+    }
+
+    const int32_t index_b = a.child1;
+    const int32_t index_c = a.child2;
+    auto& b = m_nodes[index_b];
+    auto& c = m_nodes[index_c];
+
+    const int32_t difference = c.height - b.height;
+
+    auto replaceInParent = [this](int32_t old_child, int32_t new_child, int32_t parent) {
+        if (parent == NULL_PROXY) {
+            m_root = new_child;
+        } else if (m_nodes[parent].child1 == old_child) {
+            m_nodes[parent].child1 = new_child;
+        } else {
+            m_nodes[parent].child2 = new_child;
+        }
+    };
+
+    if (difference > 1) {
+        const int32_t index_f = c.child1;
+        const int32_t index_g = c.child2;
+        auto& f = m_nodes[index_f];
+        auto& g = m_nodes[index_g];
+
+        c.child1 = index_a;
+        c.parent = a.parent;
+        a.parent = index_c;
+        replaceInParent(index_a, index_c, c.parent);
+
+        if (f.height > g.height) {
+            c.child2 = index_f;
+            a.child2 = index_g;
+            g.parent = index_a;
+            a.box = mergeAabb(b.box, g.box);
+            c.box = mergeAabb(a.box, f.box);
+            a.height = 1 + std::max(b.height, g.height);
+            c.height = 1 + std::max(a.height, f.height);
+        } else {
+            c.child2 = index_g;
+            a.child2 = index_f;
+            f.parent = index_a;
+            a.box = mergeAabb(b.box, f.box);
+            c.box = mergeAabb(a.box, g.box);
+            a.height = 1 + std::max(b.height, f.height);
+            c.height = 1 + std::max(a.height, g.height);
+        }
+
+        return index_c;
+    }
+
+    if (difference < -1) {
+        const int32_t index_d = b.child1;
+        const int32_t index_e = b.child2;
+        auto& d = m_nodes[index_d];
+        auto& e = m_nodes[index_e];
+
+        b.child1 = index_a;
+        b.parent = a.parent;
+        a.parent = index_b;
+        replaceInParent(index_a, index_b, b.parent);
+
+        if (d.height > e.height) {
+            b.child2 = index_d;
+            a.child1 = index_e;
+            e.parent = index_a;
+            a.box = mergeAabb(c.box, e.box);
+            b.box = mergeAabb(a.box, d.box);
+            a.height = 1 + std::max(c.height, e.height);
+            b.height = 1 + std::max(a.height, d.height);
+        } else {
+            b.child2 = index_e;
+            a.child1 = index_d;
+            d.parent = index_a;
+            a.box = mergeAabb(c.box, d.box);
+            b.box = mergeAabb(a.box, e.box);
+            a.height = 1 + std::max(c.height, d.height);
+            b.height = 1 + std::max(a.height, e.height);
+        }
+
+        return index_b;
+    }
+
+    return index_a;
+}
+
+auto SpatialIndex::fatten(const Aabb& box) -> Aabb
+{
+    // from the longest side, flat sprites would otherwise leave their fat box on every move along their normal
+    const glm::vec3 size = box.max - box.min;
+    const float margin = std::max(std::max(size.x, std::max(size.y, size.z)) * FAT_MARGIN_RATIO, FAT_MARGIN_MIN);
+    return { box.min - glm::vec3(margin), box.max + glm::vec3(margin) };
+}
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Bounds.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace engine {
+
+class Frustum;
+
+// Dynamic AABB tree. Leaves sit in the tree with an enlarged ("fat") box of the
+// object, so small moves only update the tight box kept with the proxy and
+// reinsertion happens once an object leaves its fat box. The tree is kept
+// balanced by rotations on the way up after every insert and remove.
+// Inserted proxies and proxies leaving their fat box wait for commit(), which
+// inserts them one by one, or rebuilds the tree along a Morton curve when they
+// are a large share of it; queries are only exact after commit(). A rebuild lays
+// the nodes out depth first, proxies stay valid as they only point at their leaf.
+class SpatialIndex final {
+public:
+    static constexpr int32_t NULL_PROXY = -1;
+
+    struct RayHit {
+        uint32_t user_data;
+        float distance;
+    };
+
+    SpatialIndex() = default;
+    ~SpatialIndex() = default;
+    SpatialIndex(const SpatialIndex&) = delete;
+    SpatialIndex(SpatialIndex&&) = delete;
+    SpatialIndex& operator=(const SpatialIndex&) = delete;
+    SpatialIndex& operator=(SpatialIndex&&) = delete;
+
+    auto insert(const Aabb& box, uint32_t user_data) -> int32_t;
+    void remove(int32_t proxy);
+    // returns true when the proxy left its fat box and waits for commit()
+    bool move(int32_t proxy, const Aabb& box);
+    void commit();
+    void clear();
+
+    auto bounds(int32_t proxy) const -> const Aabb&;
+    auto userData(int32_t proxy) const -> uint32_t;
+    auto size() const -> size_t;
+    auto height() const -> int32_t;
+
+    void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const;
+    void queryAabb(const Aabb& box, std::vector<uint32_t>& result) const;
+    void queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& result) const;
+    auto raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance) const -> std::optional<RayHit>;
+
+private:
+    struct TreeNode {
+        // fat box for leaves, union of the children for internal nodes
+        Aabb box;
+
+        // parent while in the tree, next free node while in the free list
+        int32_t parent = NULL_PROXY;
+        int32_t child1 = NULL_PROXY;
+        int32_t child2 = NULL_PROXY;
+
+        // leaf = 0, free = -1
+        int32_t height = -1;
+
+        uint32_t user_data = 0;
+        // of a leaf
+        int32_t proxy = NULL_PROXY;
+
+        auto isLeaf() const -> bool
+        {
+            return child1 == NULL_PROXY;
+        }
+    };
+
+    struct Proxy {
+        // leaf, NULL_PROXY until the first commit() and while the proxy is free
+        int32_t node = NULL_PROXY;
+        uint32_t user_data = 0;
+        Aabb tight;
+        // box of the leaf, kept here so a move does not touch the tree
+        Aabb fat;
+        // waits in m_pending to be (re)inserted
+        bool pending = false;
+    };
+
+    struct MortonLeaf {
+        uint32_t code;
+        int32_t proxy;
+    };
+
+    auto allocateNode() -> int32_t;
+    void freeNode(int32_t node);
+
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    void rebuild();
+    auto buildRange(uint32_t begin, uint32_t end) -> int32_t;
+    auto balance(int32_t node) -> int32_t;
+    void refitUpwards(int32_t node);
+
+    static auto fatten(const Aabb& box) -> Aabb;
+
+    std::vector<TreeNode> m_nodes;
+    int32_t m_root = NULL_PROXY;
+    int32_t m_free_list = NULL_PROXY;
+    size_t m_size = 0;
+
+    std::vector<Proxy> m_proxies;
+    std::vector<int32_t> m_free_proxies;
+
+    // may hold proxies removed or committed since, their pending flag tells
+    std::vector<int32_t> m_pending;
+    std::vector<MortonLeaf> m_sorted;
+    std::vector<MortonLeaf> m_sort_buffer;
+    std::vector<TreeNode> m_rebuilt;
+
+    mutable std::vector<int32_t> m_stack;
+
+    static constexpr float FAT_MARGIN_RATIO = 0.1f;
+    static constexpr float FAT_MARGIN_MIN = 0.05f;
+    // rebuild once more than 1 / REBUILD_SHARE of the leaves are pending, rebuilding
+    // costs about as much as reinserting a sixteenth of the leaves one by one
+    static constexpr size_t REBUILD_SHARE = 16;
+};
+
+}
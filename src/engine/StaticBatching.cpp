@@ -0,0 +1,310 @@
+#include "StaticBatching.h"
+#include "Context.h"
+#include "Logger.h"
+#include "MaterialComponent.h"
+#include "MeshBuilder.h"
+#include "MeshComponent.h"
+#include "MeshStore.h"
+#include "Node.h"
+#include "RenderPassComponent.h"
+#include "RenderScopeComponent.h"
+#include "Scene.h"
+#include "SceneRequesterHelper.h"
+#include "TransformComponent.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <map>
+#include <ranges>
+
+namespace engine {
+
+namespace {
+
+auto describe(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene, const std::shared_ptr<Node>& node) -> std::optional<std::string>
+{
+    if (!node->isActive()) {
+        return std::nullopt;
+    }
+
+    const auto components = node->components();
+    auto mesh = SceneRequesterHelper::getComponent<MeshComponent>(scene, components);
+    auto material = SceneRequesterHelper::getComponent<MaterialComponent>(scene, components);
+    auto transform = SceneRequesterHelper::getComponent<TransformComponent>(scene, components);
+    auto render_scope = SceneRequesterHelper::getComponent<RenderScopeComponent>(scene, components);
+    auto render_pass = SceneRequesterHelper::getComponent<RenderPassComponent>(scene, components);
+
+    const auto usable = [](const auto& component) {
+        return component.has_value() && component.value()->isActive() && component.value()->isValid();
+    };
+    if (!usable(mesh) || !usable(material) || !usable(transform) || !usable(render_scope) || !usable(render_pass)) {
+        return std::nullopt;
+    }
+
+    auto indexed = scene->indexedNode(node->id());
+    auto mesh_data = context->meshStore->get(mesh.value()->meshId());
+    if (!indexed.has_value() || !mesh_data.has_value() || mesh_data.value()->indexCount() == 0 ||
+        !mesh_data.value()->layout().vertices_offset.has_value()) {
+        return std::nullopt;
+    }
+
+    // everything a merged draw has to share, the vertex layout included
+    const auto& layout = mesh_data.value()->layout();
+    std::string key = render_pass.value()->renderPassName();
+    key += '|' + std::to_string(material.value()->shaderId());
+    key += '|' + std::to_string(material.value()->shaderVariant());
+    key += '|' + std::to_string(material.value()->textureId());
+    key += '|' + std::to_string(static_cast<int>(material.value()->blendMode()));
+    key += '|' + std::to_string(render_scope.value()->isOccluder());
+    key += '|' + std::to_string(layout.stride);
+    key += '|' + std::to_string(layout.vertices_offset.value_or(~0u)) + ',' + std::to_string(layout.vertices_size.value_or(0));
+    key += '|' + std::to_string(layout.texture_coords_offset.value_or(~0u)) + ',' + std::to_string(layout.texture_coords_size.value_or(0));
+    key += '|' + std::to_string(layout.normals_offset.value_or(~0u)) + ',' + std::to_string(layout.normals_size.value_or(0));
+    key += '|' + std::string(vertexFormatName(layout.vertices_format)) + ',' + std::string(vertexFormatName(layout.texture_coords_format)) +
+           ',' + std::string(vertexFormatName(layout.normals_format));
+
+    const auto& uniform_block = render_scope.value()->uniformBlock();
+    for (const auto& entry : uniform_block.entries()) {
+        key += '|' + entry.name;
+    }
+    key += '|';
+    key.append(reinterpret_cast<const char*>(uniform_block.data()), uniform_block.size());
+
+    return key;
+}
+
+}
+
+void StaticBatcher::build(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene)
+{
+    clear();
+
+    m_scene_id = scene->id();
+    m_structure_version = scene->structureVersion();
+    m_built = true;
+    m_candidates = collectCandidates(context, scene);
+
+    std::map<std::string, std::vector<uint32_t>> groups;
+    for (const auto& candidate : m_candidates) {
+        if (!candidate.key.empty()) {
+            groups[candidate.key].push_back(candidate.node_id);
+        }
+    }
+
+    // the member meshes only live on the GPU, the batches are built once all their read backs landed
+    for (const auto& members : groups | std::views::values) {
+        if (members.size() < 2) {
+            continue;
+        }
+
+        for (auto node_id : members) {
+            auto indexed = scene->indexedNode(node_id);
+            auto mesh_data = indexed.has_value() ? context->meshStore->get(indexed.value().mesh_id) : std::nullopt;
+            if (mesh_data.has_value()) {
+                mesh_data.value()->requestGeometry();
+                m_waiting = m_waiting || !mesh_data.value()->hasGeometry();
+            }
+        }
+    }
+
+    if (m_waiting) {
+        Logger::debug("{}: waiting for the geometry of the static candidates", __FUNCTION__);
+        return;
+    }
+
+    for (const auto& members : groups | std::views::values) {
+        // a single mesh gains nothing from being copied
+        if (members.size() < 2) {
+            continue;
+        }
+
+        auto batch = buildBatch(context, scene, members, m_batches.size());
+        if (!batch.has_value()) {
+            continue;
+        }
+
+        m_batched.insert(members.begin(), members.end());
+        m_batches.push_back(std::move(batch.value()));
+    }
+
+    Logger::debug("{}: static candidates: {}, batches: {}, batched nodes: {}", __FUNCTION__, m_candidates.size(), m_batches.size(), m_batched.size());
+}
+
+void StaticBatcher::update(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene)
+{
+    if (needsRebuild(scene)) {
+        build(context, scene);
+    }
+}
+
+auto StaticBatcher::needsRebuild(const std::shared_ptr<Scene>& scene) const -> bool
+{
+    if (!m_built || m_waiting || m_scene_id != scene->id() || m_structure_version != scene->structureVersion()) {
+        return true;
+    }
+
+    // the structure did not change, so the set of static nodes and their components are the same,
+    // any setter or activation change of a component bumps its revision
+    for (const auto& candidate : m_candidates) {
+        if (revisionOf(candidate) != candidate.revision) {
+            return true;
+        }
+
+        auto indexed = scene->indexedNode(candidate.node_id);
+        if ((indexed.has_value() ? indexed->version : 0) != candidate.version) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto StaticBatcher::revisionOf(const Candidate& candidate) -> uint64_t
+{
+    uint64_t revision = 0;
+    for (const auto& component : candidate.components) {
+        if (component) {
+            revision += component->revision();
+        }
+    }
+    return revision;
+}
+
+void StaticBatcher::clear()
+{
+    m_built = false;
+    m_waiting = false;
+    m_candidates.clear();
+    m_batches.clear();
+    m_batched.clear();
+}
+
+auto StaticBatcher::batches() const -> const std::vector<Batch>&
+{
+    return m_batches;
+}
+
+auto StaticBatcher::isBatched(uint32_t node_id) const -> bool
+{
+    return m_batched.contains(node_id);
+}
+
+auto StaticBatcher::collectCandidates(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene) const -> std::vector<Candidate>
+{
+    std::vector<Candidate> candidates;
+
+    for (const auto& [id, node] : scene->getNodes()) {
+        if (!node->isStatic()) {
+            continue;
+        }
+
+        const auto components = node->components();
+        Candidate candidate{ id, std::string(), {}, 0, 0 };
+        candidate.components = {
+            SceneRequesterHelper::getComponent<MeshComponent>(scene, components).value_or(nullptr),
+            SceneRequesterHelper::getComponent<MaterialComponent>(scene, components).value_or(nullptr),
+            SceneRequesterHelper::getComponent<TransformComponent>(scene, components).value_or(nullptr),
+            SceneRequesterHelper::getComponent<RenderScopeComponent>(scene, components).value_or(nullptr),
+            SceneRequesterHelper::getComponent<RenderPassComponent>(scene, components).value_or(nullptr),
+        };
+        candidate.revision = revisionOf(candidate);
+
+        auto indexed = scene->indexedNode(id);
+        candidate.version = indexed.has_value() ? indexed->version : 0;
+
+        // nodes that can not be batched right now are kept with an empty key to notice when they can
+        auto key = describe(context, scene, node);
+        if (key.has_value()) {
+            candidate.key = std::move(key.value());
+        }
+
+        candidates.push_back(std::move(candidate));
+    }
+
+    std::ranges::sort(candidates, {}, &Candidate::node_id);
+
+    return candidates;
+}
+
+auto StaticBatcher::buildBatch(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene,
+                               const std::vector<uint32_t>& members, size_t batch_index) const -> std::optional<Batch>
+{
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    MeshConfig layout{};
+
+    for (auto node_id : members) {
+        auto node = scene->getNode(node_id);
+        auto indexed = scene->indexedNode(node_id);
+        if (!node.has_value() || !indexed.has_value()) {
+            return std::nullopt;
+        }
+
+        auto mesh_data = context->meshStore->get(indexed.value().mesh_id);
+        if (!mesh_data.has_value()) {
+            return std::nullopt;
+        }
+
+        const auto& mesh = *mesh_data.value();
+        const auto& source_vertices = mesh.geometry().vertices;
+        const auto& source_indices = mesh.geometry().indices;
+        if (source_vertices.empty() || source_indices.empty()) {
+            return std::nullopt;
+        }
+        layout = mesh.layout();
+
+        const size_t stride = layout.stride;
+        const size_t base_vertex = vertices.size() / stride;
+        const size_t vertex_count = source_vertices.size() / stride;
+
+        const glm::mat4& model = indexed.value().model;
+        const glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+        const size_t first = vertices.size();
+        vertices.insert(vertices.end(), source_vertices.begin(), source_vertices.begin() + vertex_count * stride);
+
+        const size_t position_offset = layout.vertices_offset.value();
+        const size_t position_size = std::min<size_t>(layout.vertices_size.value_or(3), 3);
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+            GLfloat* data = vertices.data() + first + vertex * stride;
+
+            glm::vec3 position(0.0f);
+            for (size_t i = 0; i < position_size; ++i) {
+                position[i] = data[position_offset + i];
+            }
+            position = glm::vec3(model * glm::vec4(position, 1.0f));
+            for (size_t i = 0; i < position_size; ++i) {
+                data[position_offset + i] = position[i];
+            }
+
+            if (layout.normals_offset.has_value() && layout.normals_size.value_or(0) >= 3) {
+                GLfloat* normal_data = data + layout.normals_offset.value();
+                const glm::vec3 normal = glm::normalize(normal_matrix * glm::vec3(normal_data[0], normal_data[1], normal_data[2]));
+                normal_data[0] = normal.x;
+                normal_data[1] = normal.y;
+                normal_data[2] = normal.z;
+            }
+        }
+
+        for (auto index : source_indices) {
+            indices.push_back(static_cast<GLuint>(base_vertex + index));
+        }
+    }
+
+    // world space positions can leave the range the meshes' position format was picked for
+    layout.vertices_format = VertexFormat::Float;
+    auto mesh = buildMeshGL("static_batch_" + std::to_string(batch_index), vertices, indices, layout, context->meshStore->geometryPool());
+    if (!mesh.has_value()) {
+        return std::nullopt;
+    }
+
+    Batch batch;
+    batch.node = scene->getNode(members.front()).value();
+    batch.mesh = std::move(mesh.value());
+    batch.members = members;
+
+    return batch;
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace engine {
+
+struct Context;
+struct MeshData;
+class Scene;
+class Node;
+class Component;
+
+// Merges the meshes of static nodes sharing material, render scope and render pass
+// into pre-transformed vertex and index buffers, one draw per group. Batches are
+// rebuilt only when the scene structure changes or a batched node moves or changes
+// its material, mesh or render data, which is noticed through the revisions of the
+// node's components and the version of its world placement.
+class StaticBatcher final {
+public:
+    struct Batch {
+        // first member, supplies material, render scope and render pass when drawing
+        std::shared_ptr<Node> node;
+        std::shared_ptr<MeshData> mesh;
+        std::vector<uint32_t> members;
+    };
+
+    StaticBatcher() = default;
+    ~StaticBatcher() = default;
+    StaticBatcher(const StaticBatcher&) = delete;
+    StaticBatcher(StaticBatcher&&) = delete;
+    StaticBatcher& operator=(const StaticBatcher&) = delete;
+    StaticBatcher& operator=(StaticBatcher&&) = delete;
+
+    void build(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene);
+    // cheap check of the static nodes, rebuilds when one of them changed
+    void update(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene);
+    // the check alone, it does not touch GL
+    auto needsRebuild(const std::shared_ptr<Scene>& scene) const -> bool;
+    void clear();
+
+    auto batches() const -> const std::vector<Batch>&;
+    auto isBatched(uint32_t node_id) const -> bool;
+
+private:
+    struct Candidate {
+        uint32_t node_id;
+        std::string key;
+        // the components the key is built from, null where the node has none, and the
+        // sum of their revisions, which only ever grows, when the key was built
+        std::array<std::shared_ptr<Component>, 5> components;
+        uint64_t revision;
+        // of the world placement, 0 while the node is not indexed
+        uint64_t version;
+    };
+
+    static auto revisionOf(const Candidate& candidate) -> uint64_t;
+
+    auto collectCandidates(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene) const -> std::vector<Candidate>;
+    auto buildBatch(const std::shared_ptr<Context>& context, const std::shared_ptr<Scene>& scene,
+                    const std::vector<uint32_t>& members, size_t batch_index) const -> std::optional<Batch>;
+
+    uint32_t m_scene_id = 0;
+    uint64_t m_structure_version = 0;
+    bool m_built = false;
+    // a member mesh was still being read back, the build is retried next frame
+    bool m_waiting = false;
+
+    // every static candidate seen at the last build, batched or not
+    std::vector<Candidate> m_candidates;
+
+    std::vector<Batch> m_batches;
+    std::unordered_set<uint32_t> m_batched;
+};
+
+}
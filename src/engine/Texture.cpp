@@ -1,5 +1,9 @@
 #include "Texture.h"
 #include "FileSystem.h"
+#include "GLStateCache.h"
+#include "TextureCooker.h"
+
+#include <algorithm>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
@@ -12,7 +16,7 @@ Texture::Texture(const std::string& name) :
     glGenTextures(1, &m_texture);
 }
 
-Texture::Texture(const std::string& name, void* data, GLsizei width, GLsizei height, GLint channels) :
+Texture::Texture(const std::string& name, const void* data, GLsizei width, GLsizei height, GLint channels) :
     m_name(name),
     m_width(width),
     m_height(height)
@@ -25,10 +29,57 @@ Texture::Texture(const std::string& name, void* data, GLsizei width, GLsizei hei
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
+    // RGB rows of odd widths are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexImage2D(GL_TEXTURE_2D, 0, channels == 3 ? GL_RGB : GL_RGBA, width, height, 0, channels == 3 ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     glGenerateMipmap(GL_TEXTURE_2D);
 
     glBindTexture(GL_TEXTURE_2D, 0);
+
+    const size_t level_bytes = static_cast<size_t>(width) * static_cast<size_t>(height) * (channels == 3 ? 3 : 4);
+    m_gpu_bytes = level_bytes + level_bytes / 3;
+
+    if (data != nullptr) {
+        const auto flags = scanAlpha(static_cast<const unsigned char*>(data), width, height, channels);
+        m_translucent = flags.translucent;
+        m_transparent_texels = flags.transparent_texels;
+    }
+}
+
+Texture::Texture(const CookedTexture& cooked) :
+    Texture(cooked.name,
+            cooked.mips.empty() ? 0 : static_cast<GLsizei>(cooked.mips.front().width),
+            cooked.mips.empty() ? 0 : static_cast<GLsizei>(cooked.mips.front().height),
+            static_cast<GLint>(cooked.mips.size()),
+            { cooked.translucent, cooked.transparent_texels })
+{
+    for (size_t level = cooked.mips.size(); level-- > 0;) {
+        const auto& mip = cooked.mips[level];
+        uploadLevel(static_cast<GLint>(level), cooked.format, static_cast<GLsizei>(mip.width), static_cast<GLsizei>(mip.height),
+                    mip.data.data(), static_cast<GLsizei>(mip.data.size()));
+    }
+}
+
+Texture::Texture(const std::string& name, GLsizei width, GLsizei height, GLint levels, const AlphaFlags& alpha) :
+    m_name(name),
+    m_width(width),
+    m_height(height),
+    m_base_level(std::max(levels, 1) - 1),
+    m_translucent(alpha.translucent),
+    m_transparent_texels(alpha.transparent_texels)
+{
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, m_base_level);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_base_level);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 Texture::~Texture()
@@ -41,15 +92,55 @@ std::string Texture::name() const
     return m_name;
 }
 
-void Texture::bind() const
+void Texture::bind(GLStateCache& state, uint32_t unit) const
 {
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    state.bindTexture(unit, GL_TEXTURE_2D, m_texture);
+}
+void Texture::unbind(GLStateCache& state, uint32_t unit) const
+{
+    state.bindTexture(unit, GL_TEXTURE_2D, 0);
 }
-void Texture::unbind() const
+
+void Texture::uploadLevel(GLint level, CookedFormat format, GLsizei width, GLsizei height, const void* pixels, GLsizei size)
 {
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    switch (format) {
+        case CookedFormat::RGB8:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+            break;
+        case CookedFormat::RGBA8:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            break;
+        case CookedFormat::BC1:
+        case CookedFormat::BC3:
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, format == CookedFormat::BC1 ? COMPRESSED_RGB_S3TC_DXT1 : COMPRESSED_RGBA_S3TC_DXT5,
+                                   width, height, 0, size, pixels);
+            break;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    m_gpu_bytes += static_cast<size_t>(size);
+
+    // levels come coarse to fine, the finer ones are not defined yet and must not be sampled
+    if (level < m_base_level) {
+        m_base_level = level;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, m_base_level);
+    }
+
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+auto Texture::baseLevel() const -> GLint
+{
+    return m_base_level;
+}
+
+auto Texture::gpuBytes() const -> size_t
+{
+    return m_gpu_bytes;
+}
+
 GLuint Texture::width() const
 {
     return m_width;
@@ -60,7 +151,34 @@ GLuint Texture::height() const
     return m_height;
 }
 
-auto buildTexture(const std::filesystem::path& path) -> std::optional<std::unique_ptr<Texture>>
+bool Texture::isTranslucent() const
+{
+    return m_translucent;
+}
+
+bool Texture::hasTransparentTexels() const
+{
+    return m_transparent_texels;
+}
+
+auto Texture::scanAlpha(const unsigned char* texels, GLsizei width, GLsizei height, GLint channels) -> AlphaFlags
+{
+    AlphaFlags flags;
+    if (channels != 4) {
+        return flags;
+    }
+
+    const size_t texel_count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    for (size_t i = 0; i < texel_count && !flags.translucent; ++i) {
+        const unsigned char alpha = texels[i * 4 + 3];
+        flags.translucent = alpha != 0 && alpha != 255;
+        flags.transparent_texels = flags.transparent_texels || alpha != 255;
+    }
+
+    return flags;
+}
+
+auto loadTextureImage(const std::filesystem::path& path) -> std::optional<TextureImage>
 {
     auto file = FileSystem::file(path, std::ios::in | std::ios::binary);
     auto data = file.readBinary();
@@ -70,8 +188,39 @@ auto buildTexture(const std::filesystem::path& path) -> std::optional<std::uniqu
 
     int widthTex, heightTex, nrChannels;
     unsigned char* image = stbi_load_from_memory(data.data(), data.size(), &widthTex, &heightTex, &nrChannels, 0);
+    if (image == nullptr) {
+        return std::nullopt;
+    }
+
+    TextureImage result;
+    result.name = path.stem().string();
+    result.texels.assign(image, image + static_cast<size_t>(widthTex) * heightTex * nrChannels);
+    result.width = widthTex;
+    result.height = heightTex;
+    result.channels = nrChannels;
+    stbi_image_free(image);
+
+    return result;
+}
+
+auto buildTexture(const TextureImage& image) -> std::unique_ptr<Texture>
+{
+    return std::make_unique<Texture>(image.name, image.texels.data(), image.width, image.height, image.channels);
+}
+
+auto buildTexture(const CookedTexture& cooked) -> std::unique_ptr<Texture>
+{
+    return std::make_unique<Texture>(cooked);
+}
+
+auto buildTexture(const std::filesystem::path& path) -> std::optional<std::unique_ptr<Texture>>
+{
+    auto image = loadTextureImage(path);
+    if (!image.has_value()) {
+        return std::nullopt;
+    }
 
-    return std::make_unique<Texture>(path.stem().string(), image, widthTex, heightTex, nrChannels);
+    return buildTexture(image.value());
 }
 
 }
@@ -2,18 +2,33 @@
 
 #include <glad/glad.h>
 
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace engine
 {
 
+class GLStateCache;
+struct CookedTexture;
+enum class CookedFormat : uint32_t;
+
 class Texture final {
 public:
+    struct AlphaFlags {
+        bool translucent = false;
+        bool transparent_texels = false;
+    };
+
     explicit Texture(const std::string& name);
-    explicit Texture(const std::string& name, void* data, GLsizei width, GLsizei height, GLint channels);
+    explicit Texture(const std::string& name, const void* data, GLsizei width, GLsizei height, GLint channels);
+    // uploads the cooked mips as they are, see TextureCooker
+    explicit Texture(const CookedTexture& cooked);
+    // room for levels mips that arrive through uploadLevel(), see TextureStreamer
+    explicit Texture(const std::string& name, GLsizei width, GLsizei height, GLint levels, const AlphaFlags& alpha);
     ~Texture();
     Texture(const Texture&) = delete;
     Texture(Texture&&) = delete;
@@ -22,11 +37,26 @@ public:
 
     std::string name() const;
 
-    void bind() const;
-    void unbind() const;
+    void bind(GLStateCache& state, uint32_t unit = 0) const;
+    void unbind(GLStateCache& state, uint32_t unit = 0) const;
 
     GLuint width() const;
     GLuint height() const;
+    // the levels uploaded so far, generated mips are estimated
+    auto gpuBytes() const -> size_t;
+
+    // true when some texel has an alpha strictly between 0 and 1, fully transparent
+    // texels alone are handled by discard in the shaders and do not need blending
+    bool isTranslucent() const;
+    // true when some texel is not fully opaque, shaders then need their alpha test
+    bool hasTransparentTexels() const;
+
+    // pixels is an offset into the bound GL_PIXEL_UNPACK_BUFFER when there is one;
+    // sampling starts at the finest level uploaded so far
+    void uploadLevel(GLint level, CookedFormat format, GLsizei width, GLsizei height, const void* pixels, GLsizei size);
+    auto baseLevel() const -> GLint;
+
+    static auto scanAlpha(const unsigned char* texels, GLsizei width, GLsizei height, GLint channels) -> AlphaFlags;
 
 private:
     std::string m_name;
@@ -35,8 +65,26 @@ private:
 
     GLuint m_width = 0;
     GLuint m_height = 0;
+
+    GLint m_base_level = 0;
+    size_t m_gpu_bytes = 0;
+
+    bool m_translucent = false;
+    bool m_transparent_texels = false;
+};
+
+// decoded texels of a texture file, loading them needs no GL context
+struct TextureImage {
+    std::string name;
+    std::vector<unsigned char> texels;
+    GLsizei width = 0;
+    GLsizei height = 0;
+    GLint channels = 0;
 };
 
+auto loadTextureImage(const std::filesystem::path& path) -> std::optional<TextureImage>;
+auto buildTexture(const TextureImage& image) -> std::unique_ptr<Texture>;
+auto buildTexture(const CookedTexture& cooked) -> std::unique_ptr<Texture>;
 auto buildTexture(const std::filesystem::path& path) -> std::optional<std::unique_ptr<Texture>>;
 
 }
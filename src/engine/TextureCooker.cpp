@@ -0,0 +1,324 @@
+#include "TextureCooker.h"
+#include "FileSystem.h"
+#include "Logger.h"
+#include "ResourcePackage.h"
+#include "Texture.h"
+#include "UtilGL.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb/stb_image_resize2.h>
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb/stb_dxt.h>
+
+namespace engine {
+
+namespace {
+
+constexpr uint32_t COOKED_MAGIC = 0x58455443; // "CTEX"
+constexpr uint32_t COOKED_VERSION = 1;
+
+constexpr uint32_t FLAG_TRANSLUCENT = 1u << 0;
+constexpr uint32_t FLAG_TRANSPARENT_TEXELS = 1u << 1;
+
+struct CookedHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t mip_count;
+    uint32_t flags;
+};
+
+struct CookedMipHeader {
+    uint32_t width;
+    uint32_t height;
+    uint32_t size;
+};
+
+// grey images are widened so every mip is RGB or RGBA
+auto expandChannels(const TextureImage& image) -> std::vector<unsigned char>
+{
+    if (image.channels == 3 || image.channels == 4) {
+        return image.texels;
+    }
+
+    const size_t texel_count = static_cast<size_t>(image.width) * static_cast<size_t>(image.height);
+    const size_t channels = image.channels == 2 ? 4 : 3;
+    std::vector<unsigned char> texels(texel_count * channels);
+    for (size_t i = 0; i < texel_count; ++i) {
+        const unsigned char grey = image.texels[i * image.channels];
+        texels[i * channels + 0] = grey;
+        texels[i * channels + 1] = grey;
+        texels[i * channels + 2] = grey;
+        if (channels == 4) {
+            texels[i * channels + 3] = image.texels[i * image.channels + 1];
+        }
+    }
+    return texels;
+}
+
+// 4x4 texel blocks, edge blocks of levels smaller than a block repeat their last texels
+auto compressBlocks(const std::vector<unsigned char>& texels, uint32_t width, uint32_t height, uint32_t channels, bool alpha) -> std::vector<unsigned char>
+{
+    const uint32_t blocks_x = (width + 3) / 4;
+    const uint32_t blocks_y = (height + 3) / 4;
+    const size_t block_size = alpha ? 16 : 8;
+
+    std::vector<unsigned char> blocks(static_cast<size_t>(blocks_x) * blocks_y * block_size);
+    unsigned char block[16 * 4];
+
+    for (uint32_t by = 0; by < blocks_y; ++by) {
+        for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+            for (uint32_t y = 0; y < 4; ++y) {
+                for (uint32_t x = 0; x < 4; ++x) {
+                    const uint32_t sx = std::min(bx * 4 + x, width - 1);
+                    const uint32_t sy = std::min(by * 4 + y, height - 1);
+                    const unsigned char* texel = texels.data() + (static_cast<size_t>(sy) * width + sx) * channels;
+                    unsigned char* out = block + (y * 4 + x) * 4;
+                    out[0] = texel[0];
+                    out[1] = texel[1];
+                    out[2] = texel[2];
+                    out[3] = channels == 4 ? texel[3] : 255;
+                }
+            }
+
+            unsigned char* dest = blocks.data() + (static_cast<size_t>(by) * blocks_x + bx) * block_size;
+            stb_compress_dxt_block(dest, block, alpha ? 1 : 0, STB_DXT_HIGHQUAL);
+        }
+    }
+
+    return blocks;
+}
+
+auto elapsedMs(std::chrono::steady_clock::time_point start) -> double
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+auto CookedTexture::bytes() const -> size_t
+{
+    size_t total = 0;
+    for (const auto& mip : mips) {
+        total += mip.data.size();
+    }
+    return total;
+}
+
+auto cookTexture(const TextureImage& image, const TextureCookOptions& options) -> CookedTexture
+{
+    CookedTexture cooked;
+    cooked.name = image.name;
+
+    auto texels = expandChannels(image);
+    const uint32_t channels = image.channels == 2 || image.channels == 4 ? 4 : 3;
+
+    const auto flags = Texture::scanAlpha(texels.data(), image.width, image.height, static_cast<GLint>(channels));
+    cooked.translucent = flags.translucent;
+    cooked.transparent_texels = flags.transparent_texels;
+
+    if (options.compress) {
+        // fully opaque alpha is dropped, BC1 is half the size of BC3
+        cooked.format = flags.transparent_texels ? CookedFormat::BC3 : CookedFormat::BC1;
+    } else {
+        cooked.format = channels == 4 ? CookedFormat::RGBA8 : CookedFormat::RGB8;
+    }
+
+    uint32_t width = static_cast<uint32_t>(image.width);
+    uint32_t height = static_cast<uint32_t>(image.height);
+    const auto layout = channels == 4 ? STBIR_RGBA : STBIR_RGB;
+
+    while (true) {
+        CookedTexture::Mip mip;
+        mip.width = width;
+        mip.height = height;
+        if (options.compress) {
+            mip.data = compressBlocks(texels, width, height, channels, cooked.format == CookedFormat::BC3);
+        } else {
+            mip.data = texels;
+        }
+        cooked.mips.push_back(std::move(mip));
+
+        if (width == 1 && height == 1) {
+            break;
+        }
+
+        // every level is filtered from the one above, like glGenerateMipmap does
+        const uint32_t next_width = std::max(width / 2, 1u);
+        const uint32_t next_height = std::max(height / 2, 1u);
+        std::vector<unsigned char> next(static_cast<size_t>(next_width) * next_height * channels);
+        stbir_resize_uint8_linear(texels.data(), static_cast<int>(width), static_cast<int>(height), 0,
+                                  next.data(), static_cast<int>(next_width), static_cast<int>(next_height), 0, layout);
+
+        texels = std::move(next);
+        width = next_width;
+        height = next_height;
+    }
+
+    return cooked;
+}
+
+auto cookedTexturePath(const std::filesystem::path& source) -> std::filesystem::path
+{
+    auto path = source;
+    path += ".ctex";
+    return path;
+}
+
+auto hasCookedTexture(const std::filesystem::path& source) -> bool
+{
+    std::error_code error;
+    const auto cooked_time = std::filesystem::last_write_time(cookedTexturePath(source), error);
+    if (error) {
+        return false;
+    }
+
+    const auto source_time = std::filesystem::last_write_time(source, error);
+    return !error && cooked_time >= source_time;
+}
+
+auto saveCookedTexture(const CookedTexture& texture, const std::filesystem::path& path) -> bool
+{
+    uint32_t flags = 0;
+    flags |= texture.translucent ? FLAG_TRANSLUCENT : 0;
+    flags |= texture.transparent_texels ? FLAG_TRANSPARENT_TEXELS : 0;
+
+    const CookedHeader header = { COOKED_MAGIC, COOKED_VERSION, static_cast<uint32_t>(texture.format), static_cast<uint32_t>(texture.mips.size()), flags };
+
+    std::vector<uint8_t> bytes(sizeof(header));
+    bytes.reserve(sizeof(header) + texture.mips.size() * sizeof(CookedMipHeader) + texture.bytes());
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    for (const auto& mip : texture.mips) {
+        const CookedMipHeader mip_header = { mip.width, mip.height, static_cast<uint32_t>(mip.data.size()) };
+        const auto offset = bytes.size();
+        bytes.resize(offset + sizeof(mip_header));
+        std::memcpy(bytes.data() + offset, &mip_header, sizeof(mip_header));
+        bytes.insert(bytes.end(), mip.data.begin(), mip.data.end());
+    }
+
+    return FileSystem::file(path, std::ios::out | std::ios::binary | std::ios::trunc).writeBinary(bytes);
+}
+
+auto loadCookedTexture(const std::filesystem::path& path) -> std::optional<CookedTexture>
+{
+    const auto bytes = FileSystem::file(path, std::ios::in | std::ios::binary).readBinary();
+
+    CookedHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    if (header.magic != COOKED_MAGIC || header.version != COOKED_VERSION || header.format > static_cast<uint32_t>(CookedFormat::BC3)) {
+        Logger::warning("loadCookedTexture: {} is not a cooked texture of version {}", path.string(), COOKED_VERSION);
+        return std::nullopt;
+    }
+
+    CookedTexture texture;
+    // "wall.jpg.ctex" keeps the name of "wall.jpg"
+    texture.name = path.stem().stem().string();
+    texture.format = static_cast<CookedFormat>(header.format);
+    texture.translucent = (header.flags & FLAG_TRANSLUCENT) != 0;
+    texture.transparent_texels = (header.flags & FLAG_TRANSPARENT_TEXELS) != 0;
+    texture.mips.resize(header.mip_count);
+
+    size_t offset = sizeof(header);
+    for (auto& mip : texture.mips) {
+        CookedMipHeader mip_header{};
+        if (bytes.size() - offset < sizeof(mip_header)) {
+            Logger::warning("loadCookedTexture: {} is truncated", path.string());
+            return std::nullopt;
+        }
+        std::memcpy(&mip_header, bytes.data() + offset, sizeof(mip_header));
+        offset += sizeof(mip_header);
+
+        if (bytes.size() - offset < mip_header.size) {
+            Logger::warning("loadCookedTexture: {} is truncated", path.string());
+            return std::nullopt;
+        }
+
+        mip.width = mip_header.width;
+        mip.height = mip_header.height;
+        mip.data.assign(bytes.begin() + static_cast<std::ptrdiff_t>(offset), bytes.begin() + static_cast<std::ptrdiff_t>(offset + mip_header.size));
+        offset += mip_header.size;
+    }
+
+    if (texture.mips.empty()) {
+        return std::nullopt;
+    }
+
+    return texture;
+}
+
+auto cookedFormatSupported(CookedFormat format) -> bool
+{
+    switch (format) {
+        case CookedFormat::RGB8:
+        case CookedFormat::RGBA8:
+            return true;
+        case CookedFormat::BC1:
+        case CookedFormat::BC3: {
+            static const bool s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+            return s3tc;
+        }
+    }
+
+    return false;
+}
+
+auto cookPackageTextures(const ResourcePackage& package, const TextureCookOptions& options) -> TextureCookStats
+{
+    TextureCookStats stats;
+
+    for (const auto& textureInfo : package.textures) {
+        auto decode_start = std::chrono::steady_clock::now();
+        auto image = loadTextureImage(textureInfo.path);
+        const double decode_ms = elapsedMs(decode_start);
+        if (!image.has_value()) {
+            Logger::warning("cookPackageTextures: can not decode {}", textureInfo.path.string());
+            ++stats.failed;
+            continue;
+        }
+
+        const auto cooked_path = cookedTexturePath(textureInfo.path);
+        if (!saveCookedTexture(cookTexture(image.value(), options), cooked_path)) {
+            Logger::warning("cookPackageTextures: can not write {}", cooked_path.string());
+            ++stats.failed;
+            continue;
+        }
+
+        // what loading costs at startup from now on, read back the way loadResourcePackage reads it
+        auto load_start = std::chrono::steady_clock::now();
+        auto cooked = loadCookedTexture(cooked_path);
+        const double cooked_load_ms = elapsedMs(load_start);
+        if (!cooked.has_value()) {
+            ++stats.failed;
+            continue;
+        }
+
+        const size_t level_bytes = static_cast<size_t>(image->width) * static_cast<size_t>(image->height) * (image->channels == 3 ? 3 : 4);
+        const size_t decoded_gpu_bytes = level_bytes + level_bytes / 3;
+
+        Logger::info("cookPackageTextures: {} {}x{}, decode {:.2f} ms, cooked load {:.2f} ms, {} -> {} GPU bytes",
+                     textureInfo.path.string(), image->width, image->height, decode_ms, cooked_load_ms, decoded_gpu_bytes, cooked->bytes());
+
+        ++stats.textures;
+        stats.decode_ms += decode_ms;
+        stats.cooked_load_ms += cooked_load_ms;
+        stats.decoded_gpu_bytes += decoded_gpu_bytes;
+        stats.cooked_gpu_bytes += cooked->bytes();
+    }
+
+    Logger::info("cookPackageTextures: package {}, {} textures cooked, {} failed, decode {:.2f} ms vs cooked load {:.2f} ms, {} vs {} GPU bytes",
+                 package.name, stats.textures, stats.failed, stats.decode_ms, stats.cooked_load_ms, stats.decoded_gpu_bytes, stats.cooked_gpu_bytes);
+
+    return stats;
+}
+
+}
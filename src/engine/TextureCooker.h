@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace engine {
+
+struct ResourcePackage;
+struct TextureImage;
+
+// EXT_texture_compression_s3tc, not part of the generated GL headers
+constexpr uint32_t COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+constexpr uint32_t COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+
+enum class CookedFormat : uint32_t {
+    RGB8,
+    RGBA8,
+    // S3TC, 4 bits per texel without alpha
+    BC1,
+    // S3TC, 8 bits per texel with interpolated alpha
+    BC3
+};
+
+// A texture ready for upload: the whole mip chain down to 1x1, optionally block
+// compressed, with the alpha flags of the source since compressed texels can not
+// be scanned at load time.
+struct CookedTexture {
+    struct Mip {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<unsigned char> data;
+    };
+
+    std::string name;
+    CookedFormat format = CookedFormat::RGBA8;
+    bool translucent = false;
+    bool transparent_texels = false;
+    std::vector<Mip> mips;
+
+    auto bytes() const -> size_t;
+};
+
+struct TextureCookOptions {
+    bool compress = true;
+};
+
+struct TextureCookStats {
+    uint32_t textures = 0;
+    uint32_t failed = 0;
+    double decode_ms = 0.0;
+    double cooked_load_ms = 0.0;
+    // level 0 plus a third for the mips glGenerateMipmap adds
+    size_t decoded_gpu_bytes = 0;
+    size_t cooked_gpu_bytes = 0;
+};
+
+auto cookTexture(const TextureImage& image, const TextureCookOptions& options) -> CookedTexture;
+
+// "wall.jpg" is cooked into "wall.jpg.ctex" next to it
+auto cookedTexturePath(const std::filesystem::path& source) -> std::filesystem::path;
+// a cooked file at least as new as its source
+auto hasCookedTexture(const std::filesystem::path& source) -> bool;
+
+auto saveCookedTexture(const CookedTexture& texture, const std::filesystem::path& path) -> bool;
+// reads the mips as stored, nothing is decoded
+auto loadCookedTexture(const std::filesystem::path& path) -> std::optional<CookedTexture>;
+
+// needs a current context, BC formats depend on EXT_texture_compression_s3tc
+auto cookedFormatSupported(CookedFormat format) -> bool;
+
+// cooks every texture of the package and compares loading the result with decoding the source
+auto cookPackageTextures(const ResourcePackage& package, const TextureCookOptions& options) -> TextureCookStats;
+
+}
@@ -1,34 +1,51 @@
 #include "TextureStore.h"
 #include "Texture.h"
+#include "TextureCooker.h"
+#include "Logger.h"
 
 #include <algorithm>
 
 namespace engine {
 
+namespace {
+
+auto makeStandIn(const Texture& texture) -> std::shared_ptr<Texture>
+{
+    static constexpr unsigned char STAND_IN_TEXEL[] = { 128, 128, 128, 255 };
+
+    // one 1x1 level, sprites keep the size of the texture it stands in for
+    auto stand_in = std::make_shared<Texture>(texture.name(), static_cast<GLsizei>(texture.width()), static_cast<GLsizei>(texture.height()), 1,
+                                              Texture::AlphaFlags{ texture.isTranslucent(), texture.hasTransparentTexels() });
+    stand_in->uploadLevel(0, CookedFormat::RGBA8, 1, 1, STAND_IN_TEXEL, sizeof(STAND_IN_TEXEL));
+    return stand_in;
+}
+
+}
+
 auto TextureStore::get(uint32_t id) const -> std::optional<std::shared_ptr<Texture>>
 {
     auto it = m_textures.find(id);
     if (it == m_textures.end()) {
-            return std::nullopt;
+        return std::nullopt;
     }
-    return it->second;
+    return it->second.texture;
 }
 
 auto TextureStore::get(const std::string& name) const -> std::optional<std::shared_ptr<Texture>>
 {
     auto it = std::ranges::find_if(m_textures, [&](const auto& texture) {
-        return texture.second->name() == name;
+        return texture.second.texture->name() == name;
     });
     if (it == m_textures.end()) {
         return std::nullopt;
     }
-    return it->second;
+    return it->second.texture;
 }
 
 auto TextureStore::getIdByName(const std::string& name) const -> std::optional<uint32_t>
 {
     auto it = std::ranges::find_if(m_textures, [&](const auto& texture) {
-        return texture.second->name() == name;
+        return texture.second.texture->name() == name;
     });
     if (it == m_textures.end()) {
         return std::nullopt;
@@ -38,7 +55,16 @@ auto TextureStore::getIdByName(const std::string& name) const -> std::optional<u
 
 void TextureStore::add(uint32_t id, std::unique_ptr<Texture> texture)
 {
-    m_textures[id] = std::move(texture);
+    add(id, std::shared_ptr<Texture>(std::move(texture)));
+}
+
+void TextureStore::add(uint32_t id, std::shared_ptr<Texture> texture)
+{
+    // a replaced texture keeps its source and recency
+    auto& entry = m_textures[id];
+    entry.texture = std::move(texture);
+    entry.evicted = false;
+    entry.missed = false;
 }
 
 void TextureStore::remove(uint32_t id)
@@ -54,10 +80,133 @@ bool TextureStore::contains(uint32_t id) const
 auto TextureStore::names() const -> std::vector<std::string>
 {
     std::vector<std::string> names;
-    for (const auto& [id, texture] : m_textures) {
-        names.push_back(texture->name());
+    for (const auto& [id, entry] : m_textures) {
+        names.push_back(entry.texture->name());
     }
     return names;
 }
 
+void TextureStore::setSourcePath(uint32_t id, const std::filesystem::path& path)
+{
+    auto it = m_textures.find(id);
+    if (it != m_textures.end()) {
+        it->second.source = path;
+    }
+}
+
+auto TextureStore::sourcePath(uint32_t id) const -> std::optional<std::filesystem::path>
+{
+    auto it = m_textures.find(id);
+    if (it == m_textures.end() || it->second.source.empty()) {
+        return std::nullopt;
+    }
+    return it->second.source;
+}
+
+void TextureStore::setBudget(size_t bytes)
+{
+    m_budget = bytes;
+}
+
+void TextureStore::beginFrame()
+{
+    ++m_frame;
+}
+
+void TextureStore::markUsed(uint32_t id)
+{
+    auto it = m_textures.find(id);
+    if (it == m_textures.end()) {
+        return;
+    }
+
+    auto& entry = it->second;
+    entry.last_used = m_frame;
+    if (entry.evicted && !entry.missed) {
+        entry.missed = true;
+        m_misses.push_back(id);
+        ++m_miss_count;
+    }
+}
+
+auto TextureStore::overBudget() const -> bool
+{
+    return m_budget > 0 && m_frame >= m_next_evict_frame && residentBytes() > m_budget;
+}
+
+void TextureStore::evict()
+{
+    size_t resident = residentBytes();
+    if (m_budget == 0 || resident <= m_budget) {
+        return;
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> candidates;
+    for (const auto& [id, entry] : m_textures) {
+        if (!entry.evicted && !entry.source.empty() && entry.last_used + 1 < m_frame) {
+            candidates.emplace_back(entry.last_used, id);
+        }
+    }
+    std::ranges::sort(candidates);
+
+    uint32_t evicted = 0;
+    for (const auto& [last_used, id] : candidates) {
+        if (resident <= m_budget) {
+            break;
+        }
+
+        auto& entry = m_textures[id];
+        auto stand_in = makeStandIn(*entry.texture);
+        resident -= entry.texture->gpuBytes() - stand_in->gpuBytes();
+        entry.texture = std::move(stand_in);
+        entry.evicted = true;
+        ++evicted;
+    }
+    m_eviction_count += evicted;
+
+    if (resident > m_budget) {
+        // the recently drawn textures alone exceed the budget, checking again every frame would not help
+        m_next_evict_frame = m_frame + EVICT_RETRY_FRAMES;
+        Logger::warning("TextureStore: recently drawn textures need {} bytes, more than the budget of {}", resident, m_budget);
+    }
+
+    if (evicted == 0) {
+        return;
+    }
+
+    const auto current = stats();
+    Logger::info("TextureStore: evicted {} textures, {} of {} bytes resident, {} misses and {} evictions so far",
+                 evicted, current.resident_bytes, current.budget_bytes, current.misses, current.evictions);
+}
+
+auto TextureStore::takeMisses() -> std::vector<uint32_t>
+{
+    std::vector<uint32_t> misses;
+    misses.swap(m_misses);
+    return misses;
+}
+
+auto TextureStore::stats() const -> Stats
+{
+    Stats stats;
+    stats.resident_bytes = residentBytes();
+    stats.budget_bytes = m_budget;
+    stats.textures = static_cast<uint32_t>(m_textures.size());
+    stats.evicted = static_cast<uint32_t>(std::ranges::count_if(m_textures, [](const auto& texture) {
+        return texture.second.evicted;
+    }));
+    stats.misses = m_miss_count;
+    stats.evictions = m_eviction_count;
+    return stats;
+}
+
+auto TextureStore::residentBytes() const -> size_t
+{
+    size_t bytes = 0;
+    for (const auto& [id, entry] : m_textures) {
+        bytes += entry.texture->gpuBytes();
+    }
+    return bytes;
+}
+
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <filesystem>
 #include <unordered_map>
 #include <memory>
 #include <optional>
@@ -10,8 +12,23 @@ namespace engine {
 
 class Texture;
 
+// Besides holding the textures by id, keeps the resident ones within a GPU memory
+// budget. The renderer marks the textures it queues for drawing with markUsed() on
+// the simulation thread, the recording threads only call get(). evict() swaps the
+// least recently used ones for a 1x1 stand-in that keeps their size and alpha
+// flags. Drawing an evicted texture counts a miss and queues it, takeMisses()
+// hands the queue to whoever reloads it from its source path.
 class TextureStore final {
 public:
+    struct Stats {
+        size_t resident_bytes = 0;
+        size_t budget_bytes = 0;
+        uint32_t textures = 0;
+        uint32_t evicted = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
     TextureStore() = default;
     ~TextureStore() = default;
     TextureStore(const TextureStore&) = delete;
@@ -23,12 +40,50 @@ public:
     auto get(const std::string& name) const -> std::optional<std::shared_ptr<Texture>>;
     auto getIdByName(const std::string& name) const -> std::optional<uint32_t>;
     void add(uint32_t id, std::unique_ptr<Texture> texture);
+    void add(uint32_t id, std::shared_ptr<Texture> texture);
     void remove(uint32_t id);
     bool contains(uint32_t id) const;
     auto names() const -> std::vector<std::string>;
 
+    // textures without a source path are never evicted
+    void setSourcePath(uint32_t id, const std::filesystem::path& path);
+    auto sourcePath(uint32_t id) const -> std::optional<std::filesystem::path>;
+
+    // 0 keeps every texture resident
+    void setBudget(size_t bytes);
+
+    void beginFrame();
+    void markUsed(uint32_t id);
+
+    auto overBudget() const -> bool;
+    // GL thread, textures used in the last frame stay
+    void evict();
+    // evicted textures drawn since the last call, each once
+    auto takeMisses() -> std::vector<uint32_t>;
+
+    auto stats() const -> Stats;
+
 private:
-    std::unordered_map<uint32_t, std::shared_ptr<Texture>> m_textures;
+    static constexpr uint64_t EVICT_RETRY_FRAMES = 60;
+
+    struct Entry {
+        std::shared_ptr<Texture> texture;
+        std::filesystem::path source;
+        uint64_t last_used = 0;
+        bool evicted = false;
+        bool missed = false;
+    };
+
+    auto residentBytes() const -> size_t;
+
+    std::unordered_map<uint32_t, Entry> m_textures;
+
+    size_t m_budget = 0;
+    uint64_t m_frame = 0;
+    uint64_t m_next_evict_frame = 0;
+    std::vector<uint32_t> m_misses;
+    uint64_t m_miss_count = 0;
+    uint64_t m_eviction_count = 0;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,264 @@
+#include "TextureStreamer.h"
+#include "Context.h"
+#include "Logger.h"
+#include "Texture.h"
+#include "TextureStore.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace engine {
+
+TextureStreamer::TextureStreamer(size_t upload_budget, uint32_t worker_count) :
+    m_upload_budget(upload_budget)
+{
+    if (worker_count == 0) {
+        const uint32_t hardware_threads = std::thread::hardware_concurrency();
+        worker_count = std::clamp(hardware_threads > 1 ? hardware_threads - 1 : 1, 1u, MAX_WORKERS);
+    }
+
+    for (uint32_t i = 0; i < worker_count; ++i) {
+        m_workers.emplace_back(&TextureStreamer::workerLoop, this);
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+
+    if (m_pbo != 0) {
+        glDeleteBuffers(1, &m_pbo);
+    }
+}
+
+void TextureStreamer::request(const std::shared_ptr<Context>& context, uint32_t id, const std::filesystem::path& path)
+{
+    // an evicted texture already has a stand-in of its size
+    auto existing = context->textureStore->get(id);
+    std::shared_ptr<Texture> placeholder;
+    if (existing.has_value()) {
+        placeholder = existing.value();
+    } else {
+        static constexpr unsigned char PLACEHOLDER_TEXEL[] = { 128, 128, 128, 255 };
+        placeholder = std::make_shared<Texture>(path.stem().string(), PLACEHOLDER_TEXEL, 1, 1, 4);
+        context->textureStore->add(id, placeholder);
+    }
+
+    const uint64_t ticket = m_next_ticket++;
+    m_placeholders.emplace(ticket, std::move(placeholder));
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_jobs.push_back({ id, ticket, path, cookedFormatSupported(CookedFormat::BC1) });
+    }
+    m_wake.notify_one();
+}
+
+auto TextureStreamer::hasWork() const -> bool
+{
+    // m_streaming is only touched by upload(), which the simulation thread waits for
+    if (!m_streaming.empty()) {
+        return true;
+    }
+
+    std::lock_guard lock(m_mutex);
+    return !m_decoded.empty();
+}
+
+auto TextureStreamer::upload(const std::shared_ptr<Context>& context) -> bool
+{
+    std::vector<Streaming> decoded;
+    {
+        std::lock_guard lock(m_mutex);
+        decoded.swap(m_decoded);
+    }
+
+    // a failed texture keeps its placeholder in the store, only this reference to it goes
+    for (auto& streaming : decoded) {
+        auto placeholder = m_placeholders.find(streaming.ticket);
+        if (placeholder == m_placeholders.end()) {
+            continue;
+        }
+        streaming.current = std::move(placeholder->second);
+        m_placeholders.erase(placeholder);
+
+        if (!streaming.cooked.mips.empty()) {
+            m_streaming.push_back(std::move(streaming));
+        }
+    }
+
+    // a scene transition removed the texture or hot reload replaced it meanwhile
+    std::erase_if(m_streaming, [&context](const Streaming& streaming) {
+        const auto texture = context->textureStore->get(streaming.id);
+        return !texture.has_value() || texture.value() != streaming.current;
+    });
+
+    struct Upload {
+        Streaming* streaming;
+        int32_t level;
+        size_t offset;
+    };
+
+    // one level always goes, a level larger than the budget would never fit otherwise
+    std::vector<Upload> uploads;
+    size_t bytes = 0;
+    while (auto* streaming = nextUpload()) {
+        const auto size = streaming->cooked.mips[streaming->next_level].data.size();
+        if (!uploads.empty() && bytes + size > m_upload_budget) {
+            break;
+        }
+
+        uploads.push_back({ streaming, streaming->next_level, bytes });
+        bytes += size;
+        --streaming->next_level;
+    }
+
+    if (uploads.empty()) {
+        return false;
+    }
+
+    if (m_pbo == 0) {
+        glGenBuffers(1, &m_pbo);
+    }
+
+    // orphaning hands the previous frame's storage back to the driver instead of waiting for its copies
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_DRAW);
+    auto* mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+                                                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (mapped != nullptr) {
+        for (const auto& upload : uploads) {
+            const auto& data = upload.streaming->cooked.mips[upload.level].data;
+            std::memcpy(mapped + upload.offset, data.data(), data.size());
+        }
+    }
+
+    const bool from_pbo = mapped != nullptr && glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+    if (!from_pbo) {
+        Logger::warning("TextureStreamer: can not map the unpack buffer, uploading from client memory");
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    bool swapped = false;
+    for (const auto& upload : uploads) {
+        auto& streaming = *upload.streaming;
+        auto& mip = streaming.cooked.mips[upload.level];
+
+        if (!streaming.texture) {
+            const Texture::AlphaFlags alpha = { streaming.cooked.translucent, streaming.cooked.transparent_texels };
+            const auto& base = streaming.cooked.mips.front();
+            streaming.texture = std::make_shared<Texture>(streaming.cooked.name, static_cast<GLsizei>(base.width), static_cast<GLsizei>(base.height),
+                                                          static_cast<GLint>(streaming.cooked.mips.size()), alpha);
+        }
+
+        const void* pixels = from_pbo ? reinterpret_cast<const void*>(upload.offset) : mip.data.data();
+        streaming.texture->uploadLevel(upload.level, streaming.cooked.format, static_cast<GLsizei>(mip.width), static_cast<GLsizei>(mip.height),
+                                       pixels, static_cast<GLsizei>(mip.data.size()));
+
+        // the coarsest level replaces the placeholder, the finer ones sharpen the texture in place
+        if (streaming.current != streaming.texture) {
+            context->textureStore->add(streaming.id, streaming.texture);
+            streaming.current = streaming.texture;
+            swapped = true;
+        }
+
+        std::vector<unsigned char>().swap(mip.data);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    std::erase_if(m_streaming, [](const Streaming& streaming) {
+        if (streaming.next_level >= 0) {
+            return false;
+        }
+
+        Logger::info("TextureStreamer: {} resident, {} levels", streaming.path.string(), streaming.cooked.mips.size());
+        return true;
+    });
+
+    return swapped;
+}
+
+auto TextureStreamer::nextUpload() -> Streaming*
+{
+    Streaming* next = nullptr;
+    size_t next_size = 0;
+    for (auto& streaming : m_streaming) {
+        if (streaming.next_level < 0) {
+            continue;
+        }
+
+        const auto size = streaming.cooked.mips[streaming.next_level].data.size();
+        if (next == nullptr || size < next_size) {
+            next = &streaming;
+            next_size = size;
+        }
+    }
+    return next;
+}
+
+void TextureStreamer::workerLoop()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] {
+                return m_stop || !m_jobs.empty();
+            });
+
+            if (m_stop) {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        auto cooked = decode(job);
+
+        // failures go back too, so upload() lets go of their placeholder
+        Streaming streaming;
+        streaming.id = job.id;
+        streaming.ticket = job.ticket;
+        streaming.path = std::move(job.path);
+        if (cooked.has_value() && !cooked->mips.empty()) {
+            streaming.next_level = static_cast<int32_t>(cooked->mips.size()) - 1;
+            streaming.cooked = std::move(cooked.value());
+        } else {
+            Logger::warning("TextureStreamer: can not load {}, keeping the placeholder", streaming.path.string());
+        }
+
+        std::lock_guard lock(m_mutex);
+        m_decoded.push_back(std::move(streaming));
+    }
+}
+
+auto TextureStreamer::decode(const Job& job) -> std::optional<CookedTexture>
+{
+    if (hasCookedTexture(job.path)) {
+        auto cooked = loadCookedTexture(cookedTexturePath(job.path));
+        const bool compressed = cooked.has_value() && (cooked->format == CookedFormat::BC1 || cooked->format == CookedFormat::BC3);
+        if (cooked.has_value() && (!compressed || job.compressed_supported)) {
+            return cooked;
+        }
+    }
+
+    // uncooked sources get their mips filtered here, glGenerateMipmap would need every level at once
+    auto image = loadTextureImage(job.path);
+    if (!image.has_value()) {
+        return std::nullopt;
+    }
+
+    return cookTexture(image.value(), { .compress = false });
+}
+
+}
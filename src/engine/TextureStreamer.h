@@ -0,0 +1,99 @@
+#pragma once
+
+#include "TextureCooker.h"
+
+#include <glad/glad.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+
+struct Context;
+class Texture;
+
+// Loads package textures without blocking the package load. request() puts a 1x1
+// placeholder under the texture's id, workers read the cooked file or decode the
+// source and filter its mips, and upload() copies at most budget bytes a frame
+// through a pixel unpack buffer. The coarsest levels of all textures go first; a
+// texture replaces its placeholder with its smallest mip and sharpens as the finer
+// ones follow.
+class TextureStreamer final {
+public:
+    static constexpr size_t DEFAULT_UPLOAD_BUDGET = 4 * 1024 * 1024;
+
+    // 0 picks a count from the hardware threads
+    explicit TextureStreamer(size_t upload_budget = DEFAULT_UPLOAD_BUDGET, uint32_t worker_count = 0);
+    ~TextureStreamer();
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer(TextureStreamer&&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(TextureStreamer&&) = delete;
+
+    // GL thread, the placeholder is in the store when it returns; a texture already
+    // stored under id, like an evicted one's stand-in, is kept as the placeholder
+    void request(const std::shared_ptr<Context>& context, uint32_t id, const std::filesystem::path& path);
+
+    // whether upload() has decoded mips waiting
+    auto hasWork() const -> bool;
+    // GL thread, once per frame; true when a placeholder was replaced, sprite sizes changed
+    auto upload(const std::shared_ptr<Context>& context) -> bool;
+
+private:
+    static constexpr uint32_t MAX_WORKERS = 2;
+
+    // no GL objects, a worker releasing the last reference of one would delete it without a context
+    struct Job {
+        uint32_t id;
+        // finds the placeholder in m_placeholders
+        uint64_t ticket;
+        std::filesystem::path path;
+        // BC formats, without S3TC cooked files of them are ignored and the source is decoded
+        bool compressed_supported;
+    };
+
+    // decoded by a worker, without mips when decoding failed
+    struct Streaming {
+        uint32_t id;
+        uint64_t ticket = 0;
+        std::filesystem::path path;
+        // what the store holds under id, anything else means the texture was removed or reloaded
+        std::shared_ptr<Texture> current;
+        CookedTexture cooked;
+        std::shared_ptr<Texture> texture;
+        // the next level to upload, counting down to 0, -1 once all are resident
+        int32_t next_level = -1;
+    };
+
+    void workerLoop();
+    static auto decode(const Job& job) -> std::optional<CookedTexture>;
+    // the texture whose next level is the smallest, so coarse levels of all textures go first
+    auto nextUpload() -> Streaming*;
+
+    size_t m_upload_budget = DEFAULT_UPLOAD_BUDGET;
+
+    std::vector<std::thread> m_workers;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Job> m_jobs;
+    std::vector<Streaming> m_decoded;
+    bool m_stop = false;
+
+    // GL thread
+    std::vector<Streaming> m_streaming;
+    // placeholders of the jobs in flight by ticket, upload() hands them to their decoded textures
+    std::unordered_map<uint64_t, std::shared_ptr<Texture>> m_placeholders;
+    uint64_t m_next_ticket = 0;
+    GLuint m_pbo = 0;
+};
+
+}
@@ -1,4 +1,7 @@
 #include "TransformComponent.h"
+#include "Context.h"
+#include "SceneStore.h"
+#include "Scene.h"
 #include "Utils.h"
 
 #include <glm/ext/matrix_transform.hpp>
@@ -34,6 +37,8 @@ bool TransformComponent::isDirty() const
 void TransformComponent::markDirty()
 {
     m_dirty = true;
+    ++m_version;
+    logChange();
 }
 
 void TransformComponent::clearDirty()
@@ -67,9 +72,16 @@ glm::mat4 TransformComponent::getModel()
         m_dirty = false;
         m_model = glm::mat4(1.0f);
         m_model = glm::translate(m_model, m_position);
-        m_model = glm::rotate(m_model, glm::radians(m_rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-        m_model = glm::rotate(m_model, glm::radians(m_rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-        m_model = glm::rotate(m_model, glm::radians(m_rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+        // most nodes turn about one axis if at all, a zero angle is an identity rotation
+        if (m_rotation.x != 0.0f) {
+            m_model = glm::rotate(m_model, glm::radians(m_rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+        }
+        if (m_rotation.y != 0.0f) {
+            m_model = glm::rotate(m_model, glm::radians(m_rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        if (m_rotation.z != 0.0f) {
+            m_model = glm::rotate(m_model, glm::radians(m_rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+        }
         m_model = glm::scale(m_model, m_scale);
 
         clearDirty();
@@ -111,4 +123,23 @@ glm::vec3 TransformComponent::getScale() const
     return m_scale;
 }
 
+auto TransformComponent::version() const -> uint64_t
+{
+    return m_version;
+}
+
+void TransformComponent::onActiveChange(bool active)
+{
+    // the spatial index chains parent transforms up to the first inactive one
+    auto ctx = context().lock();
+    if (!ctx) {
+        return;
+    }
+
+    auto scene = ctx->sceneStore->get(ownerScene());
+    if (scene.has_value() && scene.value()) {
+        scene.value()->markStructureChanged();
+    }
+}
+
 }
@@ -35,8 +35,15 @@ public:
     glm::vec3 getRotation() const;
     glm::vec3 getScale() const;
 
+    // bumped on every change, lets caches of derived data (world bounds) detect moves
+    auto version() const -> uint64_t;
+
+protected:
+    void onActiveChange(bool active) override;
+
 private:
     bool m_dirty;
+    uint64_t m_version = 0;
 
     glm::mat4 m_model;
 
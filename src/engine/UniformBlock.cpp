@@ -0,0 +1,190 @@
+#include "UniformBlock.h"
+#include "Shader.h"
+#include "Logger.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace engine {
+
+namespace {
+
+template<typename T>
+bool packValue(const std::any& value, Uniform::Type type, std::vector<std::byte>& data, std::vector<UniformBlock::Entry>& entries, const std::string& name)
+{
+    if (value.type() != typeid(T)) {
+        return false;
+    }
+
+    constexpr size_t alignment = std::is_same_v<T, bool> ? alignof(int32_t) : alignof(T);
+    const auto offset = static_cast<uint32_t>((data.size() + alignment - 1) / alignment * alignment);
+    data.resize(offset + uniformTypeSize(type));
+
+    if constexpr (std::is_same_v<T, bool>) {
+        const int32_t int_value = std::any_cast<bool>(value) ? 1 : 0;
+        std::memcpy(data.data() + offset, &int_value, sizeof(int_value));
+    } else {
+        const T typed_value = std::any_cast<T>(value);
+        std::memcpy(data.data() + offset, &typed_value, sizeof(T));
+    }
+
+    entries.push_back({ name, type, offset });
+    return true;
+}
+
+}
+
+auto uniformTypeSize(Uniform::Type type) -> uint32_t
+{
+    switch (type) {
+        case Uniform::Type::Float: return sizeof(float);
+        case Uniform::Type::Double: return sizeof(double);
+        case Uniform::Type::Int: return sizeof(int32_t);
+        case Uniform::Type::UInt: return sizeof(uint32_t);
+        case Uniform::Type::Bool: return sizeof(int32_t);
+        case Uniform::Type::Vec2: return sizeof(glm::vec2);
+        case Uniform::Type::Vec3: return sizeof(glm::vec3);
+        case Uniform::Type::Vec4: return sizeof(glm::vec4);
+        case Uniform::Type::Mat2: return sizeof(glm::mat2);
+        case Uniform::Type::Mat3: return sizeof(glm::mat3);
+        case Uniform::Type::Mat4: return sizeof(glm::mat4);
+    }
+    return 0;
+}
+
+UniformBlock::UniformBlock(const std::unordered_map<std::string, std::any>& values)
+{
+    m_entries.reserve(values.size());
+
+    for (const auto& [name, value] : values) {
+        bool packed = packValue<float>(value, Uniform::Type::Float, m_data, m_entries, name) ||
+                      packValue<double>(value, Uniform::Type::Double, m_data, m_entries, name) ||
+                      packValue<int>(value, Uniform::Type::Int, m_data, m_entries, name) ||
+                      packValue<uint32_t>(value, Uniform::Type::UInt, m_data, m_entries, name) ||
+                      packValue<bool>(value, Uniform::Type::Bool, m_data, m_entries, name) ||
+                      packValue<glm::vec2>(value, Uniform::Type::Vec2, m_data, m_entries, name) ||
+                      packValue<glm::vec3>(value, Uniform::Type::Vec3, m_data, m_entries, name) ||
+                      packValue<glm::vec4>(value, Uniform::Type::Vec4, m_data, m_entries, name) ||
+                      packValue<glm::mat2>(value, Uniform::Type::Mat2, m_data, m_entries, name) ||
+                      packValue<glm::mat3>(value, Uniform::Type::Mat3, m_data, m_entries, name) ||
+                      packValue<glm::mat4>(value, Uniform::Type::Mat4, m_data, m_entries, name);
+        if (!packed) {
+            Logger::warning("UniformBlock: unsupported value type for uniform {}", name);
+        }
+    }
+}
+
+auto UniformBlock::entries() const -> const std::vector<Entry>&
+{
+    return m_entries;
+}
+
+auto UniformBlock::find(const std::string& name) const -> const Entry*
+{
+    auto it = std::ranges::find_if(m_entries, [&name](const Entry& entry) {
+        return entry.name == name;
+    });
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+auto UniformBlock::data() const -> const std::byte*
+{
+    return m_data.data();
+}
+
+auto UniformBlock::size() const -> size_t
+{
+    return m_data.size();
+}
+
+UniformBlockBinding::UniformBlockBinding(const UniformBlock& block, const Shader& shader)
+{
+    if (shader.usesObjectBlock()) {
+        // members the render data leaves out keep the shader's default instead of zero
+        m_object_data = shader.objectBlockDefaults();
+
+        for (const auto& member : shader.objectBlockMembers()) {
+            if (member.name == "model") {
+                m_model_offset = member.offset;
+                continue;
+            }
+
+            const auto* entry = block.find(member.name);
+            if (!entry || entry->type != member.type) {
+                Logger::debug("UniformBlockBinding: shader {} member {} has no matching render data, using the default", shader.name(), member.name);
+                continue;
+            }
+
+            auto* dst = m_object_data.data() + member.offset;
+            const auto* src = block.data() + entry->offset;
+
+            // std140 pads every matrix column to a vec4
+            if (member.type == Uniform::Type::Mat2 || member.type == Uniform::Type::Mat3) {
+                const uint32_t columns = member.type == Uniform::Type::Mat2 ? 2 : 3;
+                const uint32_t column_size = columns * sizeof(float);
+                for (uint32_t column = 0; column < columns; ++column) {
+                    std::memcpy(dst + column * member.matrix_stride, src + column * column_size, column_size);
+                }
+            } else {
+                std::memcpy(dst, src, uniformTypeSize(member.type));
+            }
+        }
+    }
+
+    for (const auto& uniform : shader.uniforms()) {
+        const auto* entry = block.find(uniform.name);
+        if (!entry || entry->type != uniform.type) {
+            continue;
+        }
+        m_uploads.push_back({ uniform.location, uniform.type, entry->offset });
+    }
+}
+
+auto UniformBlockBinding::objectData() const -> const std::vector<std::byte>&
+{
+    return m_object_data;
+}
+
+auto UniformBlockBinding::modelOffset() const -> GLint
+{
+    return m_model_offset;
+}
+
+void UniformBlockBinding::upload(const UniformBlock& block) const
+{
+    for (const auto& upload : m_uploads) {
+        uploadValue(upload.location, upload.type, block.data() + upload.offset);
+    }
+}
+
+auto UniformBlockBinding::uploads() const -> const std::vector<Upload>&
+{
+    return m_uploads;
+}
+
+void UniformBlockBinding::uploadValue(GLint location, Uniform::Type type, const std::byte* value)
+{
+    const auto* float_value = reinterpret_cast<const GLfloat*>(value);
+
+    switch (type) {
+        case Uniform::Type::Float: glUniform1fv(location, 1, float_value); break;
+        case Uniform::Type::Double: glUniform1dv(location, 1, reinterpret_cast<const GLdouble*>(value)); break;
+        case Uniform::Type::Int: glUniform1iv(location, 1, reinterpret_cast<const GLint*>(value)); break;
+        case Uniform::Type::UInt: glUniform1uiv(location, 1, reinterpret_cast<const GLuint*>(value)); break;
+        case Uniform::Type::Bool: glUniform1iv(location, 1, reinterpret_cast<const GLint*>(value)); break;
+        case Uniform::Type::Vec2: glUniform2fv(location, 1, float_value); break;
+        case Uniform::Type::Vec3: glUniform3fv(location, 1, float_value); break;
+        case Uniform::Type::Vec4: glUniform4fv(location, 1, float_value); break;
+        case Uniform::Type::Mat2: glUniformMatrix2fv(location, 1, GL_FALSE, float_value); break;
+        case Uniform::Type::Mat3: glUniformMatrix3fv(location, 1, GL_FALSE, float_value); break;
+        case Uniform::Type::Mat4: glUniformMatrix4fv(location, 1, GL_FALSE, float_value); break;
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "UtilGL.h"
+
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+
+class Shader;
+
+// Render data uniforms packed into one contiguous POD buffer
+class UniformBlock final {
+public:
+    struct Entry {
+        std::string name;
+        Uniform::Type type;
+        uint32_t offset;
+    };
+
+    UniformBlock() = default;
+    explicit UniformBlock(const std::unordered_map<std::string, std::any>& values);
+
+    auto entries() const -> const std::vector<Entry>&;
+    auto find(const std::string& name) const -> const Entry*;
+
+    auto data() const -> const std::byte*;
+    auto size() const -> size_t;
+
+private:
+    std::vector<Entry> m_entries;
+    std::vector<std::byte> m_data;
+};
+
+// UniformBlock layout resolved against one shader program: values living in the
+// ObjectData block are pre-packed as std140 bytes, the rest keep their locations
+class UniformBlockBinding final {
+public:
+    struct Upload {
+        GLint location;
+        Uniform::Type type;
+        uint32_t offset;
+    };
+
+    UniformBlockBinding() = default;
+    explicit UniformBlockBinding(const UniformBlock& block, const Shader& shader);
+
+    auto objectData() const -> const std::vector<std::byte>&;
+    auto modelOffset() const -> GLint;
+
+    void upload(const UniformBlock& block) const;
+
+    auto uploads() const -> const std::vector<Upload>&;
+    // one value of the types a render data uniform can have
+    static void uploadValue(GLint location, Uniform::Type type, const std::byte* value);
+
+private:
+    std::vector<std::byte> m_object_data;
+    GLint m_model_offset = -1;
+
+    std::vector<Upload> m_uploads;
+};
+
+auto uniformTypeSize(Uniform::Type type) -> uint32_t;
+
+}
@@ -0,0 +1,136 @@
+#include "UniformBuffer.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace engine {
+
+UniformBuffer::UniformBuffer(GLsizeiptr size, GLuint binding) :
+    m_size(size),
+    m_binding(binding)
+{
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, m_size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    bind();
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    glDeleteBuffers(1, &m_buffer);
+}
+
+void UniformBuffer::update(const void* data, GLsizeiptr size) const
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, std::min(size, m_size), data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::bind() const
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_buffer);
+}
+
+UniformRingBuffer::UniformRingBuffer(GLsizeiptr slot_size, uint32_t slots_per_frame, GLuint binding) :
+    m_binding(binding),
+    m_slots_per_frame(slots_per_frame)
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_slot_stride = (slot_size + alignment - 1) / alignment * alignment;
+
+    const GLsizeiptr size = m_slot_stride * m_slots_per_frame * FRAMES_IN_FLIGHT;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+
+    if (GLAD_GL_VERSION_4_4) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+        m_mapped = static_cast<uint8_t*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+    } else {
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    Logger::debug("UniformRingBuffer: stride: {}, slots per frame: {}, persistent: {}", m_slot_stride, m_slots_per_frame, isPersistent());
+}
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+    for (auto& fence : m_fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+
+    if (m_mapped) {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    glDeleteBuffers(1, &m_buffer);
+}
+
+void UniformRingBuffer::beginFrame()
+{
+    m_frame = (m_frame + 1) % FRAMES_IN_FLIGHT;
+    m_slot = 0;
+
+    auto& fence = m_fences[m_frame];
+    if (fence) {
+        // the region was last written FRAMES_IN_FLIGHT frames ago, normally already signaled
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void UniformRingBuffer::endFrame()
+{
+    // glBufferSubData is ordered against the draws by the driver, only mapped writes need a fence
+    if (m_slot == 0 || !m_mapped) {
+        return;
+    }
+
+    m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+auto UniformRingBuffer::push(const void* data, GLsizeiptr size) -> std::optional<GLintptr>
+{
+    if (m_slot >= m_slots_per_frame || size > m_slot_stride) {
+        if (!m_overflow_reported) {
+            Logger::warning("UniformRingBuffer: frame capacity of {} slots exceeded", m_slots_per_frame);
+            m_overflow_reported = true;
+        }
+        return std::nullopt;
+    }
+
+    const GLintptr offset = (static_cast<GLintptr>(m_frame) * m_slots_per_frame + m_slot) * m_slot_stride;
+    ++m_slot;
+
+    // binding the range also makes the buffer current on the generic target for the sub data upload
+    glBindBufferRange(GL_UNIFORM_BUFFER, m_binding, m_buffer, offset, size);
+
+    if (m_mapped) {
+        std::memcpy(m_mapped + offset, data, size);
+    } else {
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    }
+
+    return offset;
+}
+
+auto UniformRingBuffer::isPersistent() const -> bool
+{
+    return m_mapped != nullptr;
+}
+
+}
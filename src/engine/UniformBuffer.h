@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace engine {
+
+constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+constexpr GLuint OBJECT_UNIFORMS_BINDING = 1;
+
+constexpr const char* FRAME_UNIFORMS_BLOCK = "FrameData";
+constexpr const char* OBJECT_UNIFORMS_BLOCK = "ObjectData";
+
+// std140 layout of the FrameData block, shared by every program
+struct FrameUniforms {
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::vec4 camera_position{0.0f};
+    glm::vec4 ambient_color{0.0f};
+    // xy - clusters per pixel, z - depth slice scale, w - depth slice bias
+    glm::vec4 cluster_scale{0.0f};
+    // xyz - cluster grid size, w - 1 for logarithmic depth slices
+    glm::uvec4 cluster_size{0};
+};
+
+// ObjectData starts with the model matrix, the rest is laid out by the shader
+// and filled from the RenderScopeComponent uniforms, one slot per draw
+constexpr uint32_t OBJECT_UNIFORMS_MAX_SIZE = 256;
+
+class UniformBuffer final {
+public:
+    explicit UniformBuffer(GLsizeiptr size, GLuint binding);
+    ~UniformBuffer();
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer(UniformBuffer&&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(UniformBuffer&&) = delete;
+
+    void update(const void* data, GLsizeiptr size) const;
+    void bind() const;
+
+private:
+    GLuint m_buffer = 0;
+    GLsizeiptr m_size = 0;
+    GLuint m_binding = 0;
+};
+
+// Per-draw uniform data streamed into one buffer split into FRAMES_IN_FLIGHT regions.
+// With GL 4.4 the buffer is persistently mapped and guarded by fences, on older
+// contexts each slot is written with glBufferSubData into the region of the current
+// frame, which the driver synchronizes without fences.
+class UniformRingBuffer final {
+public:
+    static constexpr uint32_t FRAMES_IN_FLIGHT = 3;
+
+    explicit UniformRingBuffer(GLsizeiptr slot_size, uint32_t slots_per_frame, GLuint binding);
+    ~UniformRingBuffer();
+    UniformRingBuffer(const UniformRingBuffer&) = delete;
+    UniformRingBuffer(UniformRingBuffer&&) = delete;
+    UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+    UniformRingBuffer& operator=(UniformRingBuffer&&) = delete;
+
+    void beginFrame();
+    void endFrame();
+
+    // copies data into the next slot and binds it, returns the slot offset
+    auto push(const void* data, GLsizeiptr size) -> std::optional<GLintptr>;
+
+    auto isPersistent() const -> bool;
+
+private:
+    GLuint m_buffer = 0;
+    GLuint m_binding = 0;
+
+    GLsizeiptr m_slot_stride = 0;
+    uint32_t m_slots_per_frame = 0;
+
+    uint32_t m_frame = 0;
+    uint32_t m_slot = 0;
+
+    uint8_t* m_mapped = nullptr;
+
+    std::array<GLsync, FRAMES_IN_FLIGHT> m_fences{};
+
+    bool m_overflow_reported = false;
+};
+
+}
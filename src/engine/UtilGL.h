@@ -3,6 +3,8 @@
 #include <glad/glad.h>
 
 #include <string>
+#include <string_view>
+#include <optional>
 
 namespace engine {
 
@@ -26,4 +28,49 @@ struct Uniform {
     Type type;
 };
 
-}
\ No newline at end of file
+inline auto uniformTypeFromGL(GLenum type) -> std::optional<Uniform::Type>
+{
+    switch (type) {
+        case GL_FLOAT: return Uniform::Type::Float;
+        case GL_DOUBLE: return Uniform::Type::Double;
+        case GL_INT: return Uniform::Type::Int;
+        case GL_UNSIGNED_INT: return Uniform::Type::UInt;
+        case GL_BOOL: return Uniform::Type::Bool;
+        case GL_FLOAT_VEC2: return Uniform::Type::Vec2;
+        case GL_FLOAT_VEC3: return Uniform::Type::Vec3;
+        case GL_FLOAT_VEC4: return Uniform::Type::Vec4;
+        case GL_FLOAT_MAT2: return Uniform::Type::Mat2;
+        case GL_FLOAT_MAT3: return Uniform::Type::Mat3;
+        case GL_FLOAT_MAT4: return Uniform::Type::Mat4;
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_BUFFER:
+        case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+            return Uniform::Type::Int;
+        default:
+            return std::nullopt;
+    }
+}
+
+inline auto isSamplerType(GLenum type) -> bool
+{
+    return type == GL_SAMPLER_2D || type == GL_SAMPLER_BUFFER || type == GL_INT_SAMPLER_BUFFER || type == GL_UNSIGNED_INT_SAMPLER_BUFFER;
+}
+
+// for extensions the loaded glad does not know about, needs a current context
+inline auto hasGLExtension(std::string_view name) -> bool
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (GLint i = 0; i < count; ++i) {
+        const auto* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension != nullptr && name == extension) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,301 @@
+#include "VertexFormat.h"
+#include "GeometryPool.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace engine {
+
+namespace {
+
+struct Attribute {
+    GLuint location;
+    GLuint offset;
+    GLuint size;
+    VertexFormat format;
+};
+
+constexpr std::array<std::pair<std::string_view, VertexFormat>, 7> FORMAT_NAMES = { {
+    { "float", VertexFormat::Float },
+    { "half", VertexFormat::Half },
+    { "snorm16", VertexFormat::Snorm16 },
+    { "unorm16", VertexFormat::Unorm16 },
+    { "snorm8", VertexFormat::Snorm8 },
+    { "unorm8", VertexFormat::Unorm8 },
+    { "snorm10_10_10_2", VertexFormat::Snorm10_10_10_2 },
+} };
+
+auto attributes(const MeshConfig& config) -> std::vector<Attribute>
+{
+    std::vector<Attribute> result;
+    if (config.vertices_offset.has_value() && config.vertices_size.has_value()) {
+        result.push_back({ 0, config.vertices_offset.value(), config.vertices_size.value(), config.vertices_format });
+    }
+    if (config.texture_coords_offset.has_value() && config.texture_coords_size.has_value()) {
+        result.push_back({ 1, config.texture_coords_offset.value(), config.texture_coords_size.value(), config.texture_coords_format });
+    }
+    if (config.normals_offset.has_value() && config.normals_size.has_value()) {
+        result.push_back({ 2, config.normals_offset.value(), config.normals_size.value(), config.normals_format });
+    }
+    return result;
+}
+
+// all float layouts are uploaded as they are, floats no attribute reads included
+auto isFloatLayout(const MeshConfig& config) -> bool
+{
+    return config.vertices_format == VertexFormat::Float &&
+           config.texture_coords_format == VertexFormat::Float &&
+           config.normals_format == VertexFormat::Float;
+}
+
+auto componentSize(VertexFormat format) -> size_t
+{
+    switch (format) {
+        case VertexFormat::Float:
+            return sizeof(GLfloat);
+        case VertexFormat::Half:
+        case VertexFormat::Snorm16:
+        case VertexFormat::Unorm16:
+            return sizeof(uint16_t);
+        case VertexFormat::Snorm8:
+        case VertexFormat::Unorm8:
+            return sizeof(uint8_t);
+        case VertexFormat::Snorm10_10_10_2:
+            return 0;
+    }
+    return sizeof(GLfloat);
+}
+
+auto attributeSize(const Attribute& attribute) -> size_t
+{
+    if (attribute.format == VertexFormat::Snorm10_10_10_2) {
+        return sizeof(uint32_t);
+    }
+    return (attribute.size * componentSize(attribute.format) + 3) & ~size_t(3);
+}
+
+void packAttribute(const GLfloat* source, const Attribute& attribute, std::byte* target)
+{
+    auto store = [&target](auto value, size_t index) {
+        std::memcpy(target + index * sizeof(value), &value, sizeof(value));
+    };
+
+    if (attribute.format == VertexFormat::Snorm10_10_10_2) {
+        const glm::vec4 value(source[0],
+            attribute.size > 1 ? source[1] : 0.0f,
+            attribute.size > 2 ? source[2] : 0.0f,
+            attribute.size > 3 ? source[3] : 0.0f);
+        store(glm::packSnorm3x10_1x2(value), 0);
+        return;
+    }
+
+    for (GLuint i = 0; i < attribute.size; ++i) {
+        const float value = source[i];
+        switch (attribute.format) {
+            case VertexFormat::Float:
+                store(value, i);
+                break;
+            case VertexFormat::Half:
+                store(glm::packHalf1x16(value), i);
+                break;
+            case VertexFormat::Snorm16:
+                store(glm::packSnorm1x16(value), i);
+                break;
+            case VertexFormat::Unorm16:
+                store(glm::packUnorm1x16(value), i);
+                break;
+            case VertexFormat::Snorm8:
+                store(glm::packSnorm1x8(value), i);
+                break;
+            case VertexFormat::Unorm8:
+                store(glm::packUnorm1x8(value), i);
+                break;
+            case VertexFormat::Snorm10_10_10_2:
+                break;
+        }
+    }
+}
+
+void unpackAttribute(const std::byte* source, const Attribute& attribute, GLfloat* target)
+{
+    auto load = [&source]<typename T>(T, size_t index) {
+        T value;
+        std::memcpy(&value, source + index * sizeof(T), sizeof(T));
+        return value;
+    };
+
+    if (attribute.format == VertexFormat::Snorm10_10_10_2) {
+        const auto value = glm::unpackSnorm3x10_1x2(load(uint32_t{}, 0));
+        for (GLuint i = 0; i < std::min<GLuint>(attribute.size, 4); ++i) {
+            target[i] = value[static_cast<glm::length_t>(i)];
+        }
+        return;
+    }
+
+    for (GLuint i = 0; i < attribute.size; ++i) {
+        switch (attribute.format) {
+            case VertexFormat::Float:
+                target[i] = load(float{}, i);
+                break;
+            case VertexFormat::Half:
+                target[i] = glm::unpackHalf1x16(load(uint16_t{}, i));
+                break;
+            case VertexFormat::Snorm16:
+                target[i] = glm::unpackSnorm1x16(load(uint16_t{}, i));
+                break;
+            case VertexFormat::Unorm16:
+                target[i] = glm::unpackUnorm1x16(load(uint16_t{}, i));
+                break;
+            case VertexFormat::Snorm8:
+                target[i] = glm::unpackSnorm1x8(load(uint8_t{}, i));
+                break;
+            case VertexFormat::Unorm8:
+                target[i] = glm::unpackUnorm1x8(load(uint8_t{}, i));
+                break;
+            case VertexFormat::Snorm10_10_10_2:
+                break;
+        }
+    }
+}
+
+}
+
+auto parseVertexFormat(std::string_view name) -> std::optional<VertexFormat>
+{
+    for (const auto& [format_name, format] : FORMAT_NAMES) {
+        if (format_name == name) {
+            return format;
+        }
+    }
+    return std::nullopt;
+}
+
+auto vertexFormatName(VertexFormat format) -> std::string_view
+{
+    for (const auto& [format_name, value] : FORMAT_NAMES) {
+        if (value == format) {
+            return format_name;
+        }
+    }
+    return "float";
+}
+
+auto packedVertexSize(const MeshConfig& config) -> size_t
+{
+    if (isFloatLayout(config)) {
+        return static_cast<size_t>(config.stride) * sizeof(GLfloat);
+    }
+
+    size_t size = 0;
+    for (const auto& attribute : attributes(config)) {
+        size += attributeSize(attribute);
+    }
+    return size;
+}
+
+auto packVertices(std::span<const GLfloat> vertices, const MeshConfig& config) -> std::vector<std::byte>
+{
+    std::vector<std::byte> packed;
+    if (config.stride == 0) {
+        return packed;
+    }
+
+    if (isFloatLayout(config)) {
+        const auto bytes = std::as_bytes(vertices);
+        packed.assign(bytes.begin(), bytes.end());
+        return packed;
+    }
+
+    const auto layout = attributes(config);
+    const size_t vertex_size = packedVertexSize(config);
+    const size_t vertex_count = vertices.size() / config.stride;
+    packed.resize(vertex_count * vertex_size);
+
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        const GLfloat* source = vertices.data() + vertex * config.stride;
+        std::byte* target = packed.data() + vertex * vertex_size;
+        for (const auto& attribute : layout) {
+            packAttribute(source + attribute.offset, attribute, target);
+            target += attributeSize(attribute);
+        }
+    }
+
+    return packed;
+}
+
+auto unpackVertices(std::span<const std::byte> packed, const MeshConfig& config) -> std::vector<GLfloat>
+{
+    std::vector<GLfloat> vertices;
+    const size_t vertex_size = packedVertexSize(config);
+    if (vertex_size == 0) {
+        return vertices;
+    }
+
+    if (isFloatLayout(config)) {
+        vertices.resize(packed.size() / sizeof(GLfloat));
+        std::memcpy(vertices.data(), packed.data(), vertices.size() * sizeof(GLfloat));
+        return vertices;
+    }
+
+    const auto layout = attributes(config);
+    const size_t vertex_count = packed.size() / vertex_size;
+    vertices.resize(vertex_count * config.stride, 0.0f);
+
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        const std::byte* source = packed.data() + vertex * vertex_size;
+        GLfloat* target = vertices.data() + vertex * config.stride;
+        for (const auto& attribute : layout) {
+            unpackAttribute(source, attribute, target + attribute.offset);
+            source += attributeSize(attribute);
+        }
+    }
+
+    return vertices;
+}
+
+void setVertexAttributes(const MeshConfig& config)
+{
+    const auto stride = static_cast<GLsizei>(packedVertexSize(config));
+    const bool float_layout = isFloatLayout(config);
+
+    size_t offset = 0;
+    for (const auto& attribute : attributes(config)) {
+        if (float_layout) {
+            offset = attribute.offset * sizeof(GLfloat);
+        }
+        const auto* pointer = reinterpret_cast<const void*>(static_cast<uintptr_t>(offset));
+
+        switch (attribute.format) {
+            case VertexFormat::Float:
+                glVertexAttribPointer(attribute.location, attribute.size, GL_FLOAT, GL_FALSE, stride, pointer);
+                break;
+            case VertexFormat::Half:
+                glVertexAttribPointer(attribute.location, attribute.size, GL_HALF_FLOAT, GL_FALSE, stride, pointer);
+                break;
+            case VertexFormat::Snorm16:
+                glVertexAttribPointer(attribute.location, attribute.size, GL_SHORT, GL_TRUE, stride, pointer);
+                break;
+            case VertexFormat::Unorm16:
+                glVertexAttribPointer(attribute.location, attribute.size, GL_UNSIGNED_SHORT, GL_TRUE, stride, pointer);
+                break;
+            case VertexFormat::Snorm8:
+                glVertexAttribPointer(attribute.location, attribute.size, GL_BYTE, GL_TRUE, stride, pointer);
+                break;
+            case VertexFormat::Unorm8:
+                glVertexAttribPointer(attribute.location, attribute.size, GL_UNSIGNED_BYTE, GL_TRUE, stride, pointer);
+                break;
+            case VertexFormat::Snorm10_10_10_2:
+                // the packed type only comes with four components, shaders reading a vec3 ignore the fourth
+                glVertexAttribPointer(attribute.location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, pointer);
+                break;
+        }
+        glEnableVertexAttribArray(attribute.location);
+
+        offset += attributeSize(attribute);
+    }
+}
+
+}
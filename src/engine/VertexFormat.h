@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace engine {
+
+struct MeshConfig;
+
+// How one vertex attribute is stored on the GPU. Meshes keep their vertices as
+// floats on the CPU, the pool packs them on upload and unpacks them on read back.
+// The normalized formats clamp to [-1, 1] or [0, 1].
+enum class VertexFormat : uint8_t {
+    Float,
+    Half,
+    Snorm16,
+    Unorm16,
+    Snorm8,
+    Unorm8,
+    // three signed 10-bit components and a 2-bit one, for normals
+    Snorm10_10_10_2
+};
+
+// the names used in the mesh config.json, "float", "half", "snorm16", ...
+auto parseVertexFormat(std::string_view name) -> std::optional<VertexFormat>;
+auto vertexFormatName(VertexFormat format) -> std::string_view;
+
+// bytes one vertex takes in the GPU buffer, attributes start at 4 byte boundaries
+auto packedVertexSize(const MeshConfig& config) -> size_t;
+
+auto packVertices(std::span<const GLfloat> vertices, const MeshConfig& config) -> std::vector<std::byte>;
+// gives back the float layout of the config, floats no attribute covers come back as 0
+auto unpackVertices(std::span<const std::byte> packed, const MeshConfig& config) -> std::vector<GLfloat>;
+
+// glVertexAttribPointer for locations 0, 1 and 2 of the bound VAO and GL_ARRAY_BUFFER
+void setVertexAttributes(const MeshConfig& config);
+
+}
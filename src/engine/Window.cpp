@@ -99,6 +99,16 @@ void Window::swapBuffer()
     glfwSwapBuffers(m_window);
 }
 
+void Window::makeContextCurrent()
+{
+    glfwMakeContextCurrent(m_window);
+}
+
+void Window::releaseContext()
+{
+    glfwMakeContextCurrent(nullptr);
+}
+
 auto Window::size() const -> std::pair<int, int>
 {
     int width, height;
@@ -28,6 +28,10 @@ public:
 
     void swapBuffer();
 
+    // the GL context is current on one thread at a time, the render thread takes it over
+    void makeContextCurrent();
+    void releaseContext();
+
     auto size() const -> std::pair<int, int> ;
 
     std::string title() const;
@@ -6,13 +6,17 @@ namespace engine {
 
 class BaseLightRenderPass final : public RenderPass {
 public:
-    explicit BaseLightRenderPass() = default;
+    explicit BaseLightRenderPass(const std::shared_ptr<RenderPass>& base_render_pass);
     ~BaseLightRenderPass() override = default;
 
-    void render(const std::shared_ptr<Context>& context,
+    void record(const std::shared_ptr<Context>& context,
                 const std::shared_ptr<Scene>& scene,
-                const std::shared_ptr<Node>& node,
-                const std::shared_ptr<CameraComponent>& camera) const override;
+                std::span<const DrawItem* const> items,
+                const std::shared_ptr<CameraComponent>& camera,
+                CommandList& commands) const override;
+
+private:
+    std::shared_ptr<RenderPass> m_base_render_pass;
 };
 
 }
@@ -1,12 +1,9 @@
 #include "BaseRenderPass.h"
 
-#include "Logger.h"
 #include "Context.h"
 #include "Scene.h"
 #include "Node.h"
-#include "MeshComponent.h"
 #include "MaterialComponent.h"
-#include "TransformComponent.h"
 #include "CameraComponent.h"
 #include "RenderScopeComponent.h"
 #include "ShaderStore.h"
@@ -14,35 +11,34 @@
 #include "TextureStore.h"
 #include "Texture.h"
 #include "MeshStore.h"
+#include "UniformBuffer.h"
+#include "RenderCommands.h"
 
-#include <glm/ext/matrix_transform.hpp>
+#include <array>
+#include <cstring>
 
 namespace engine {
 
-glm::mat4 transformTune(const glm::mat4& transform, GLuint width, GLuint height)
-{
-    return glm::scale(transform, glm::vec3(width, height, 1.0f));
-}
-
-void BaseRenderPass::render(const std::shared_ptr<Context>& context,
+void BaseRenderPass::record(const std::shared_ptr<Context>& context,
                             const std::shared_ptr<Scene>& scene,
-                            const std::shared_ptr<Node>& node,
-                            const std::shared_ptr<CameraComponent>& camera) const
+                            std::span<const DrawItem* const> items,
+                            const std::shared_ptr<CameraComponent>& camera,
+                            CommandList& commands) const
 {
-    Logger::info(__FUNCTION__);
+    if (items.empty()) {
+        return;
+    }
 
-    auto mesh = SceneRequesterHelper::getComponent<MeshComponent>(scene, node->components());
+    // the renderer only groups items with the same material and render data
+    const auto& node = items.front()->node;
     auto material = SceneRequesterHelper::getComponent<MaterialComponent>(scene, node->components());
-    auto transform = SceneRequesterHelper::getComponent<TransformComponent>(scene, node->components());
-
-    if (!mesh.has_value() || !mesh.value()->isActive() || !mesh.value()->isValid() ||
-        !material.has_value() || !material.value()->isActive() || !material.value()->isValid() ||
-        !transform.has_value() || !transform.value()->isActive() || !transform.value()->isValid()) {
+    if (!material.has_value() || !material.value()->isActive() || !material.value()->isValid()) {
         return;
     }
 
+    // the renderer built the variant when it queued the draw
     auto shader_id = material.value()->shaderId();
-    auto shader_program = context->shaderStore->get(shader_id);
+    auto shader_program = context->shaderStore->getVariant(shader_id, material.value()->shaderVariant());
     if (!shader_program.has_value()) {
         return;
     }
@@ -55,103 +51,57 @@ void BaseRenderPass::render(const std::shared_ptr<Context>& context,
         return;
     }
 
-    auto model_mtx = transform.value()->getModel();
-
-    glm::vec3 absolute_node_position = transform.value()->getPosition();
-
-    auto parent = node->getParentNode();
-    while (parent.has_value()) {
-        if (!parent.value()->hasComponent<TransformComponent>()) {
-            parent = parent.value()->getParentNode();
-            continue;
-        }
-
-        auto transform_parent = parent.value()->getComponent<TransformComponent>();
-        if (!transform_parent.has_value() || !transform_parent.value()->isActive()) {
-            break;
-        }
-
-        model_mtx = transform_parent.value()->getModel() * model_mtx;
-        absolute_node_position += transform_parent.value()->getPosition();
-        parent = parent.value()->getParentNode();
+    auto render_scope_component = SceneRequesterHelper::getComponent<RenderScopeComponent>(scene, node->components());
+    if (!render_scope_component.has_value()) {
+        return;
     }
 
-    auto node_scale = transform.value()->getScale();
-    auto texture_size = material.value()->textureSize();
-    texture_size.first *= std::fabs(node_scale.x) / 2.0f;
-    texture_size.second *= std::fabs(node_scale.y) / 2.0f;
+    const auto& builtin_locations = shader_program_value->builtinLocations();
+    const auto& render_scope = render_scope_component.value();
+    // already built by the renderer, this only looks it up
+    const auto& uniform_binding = render_scope->uniformBinding(shader_program_value);
 
-    float absoluteNodePositionX = absolute_node_position.x - camera->getPosition().x;
-    float absoluteNodePositionY = absolute_node_position.y - camera->getPosition().y;
+    commands.useProgram(*shader_program_value);
 
-    if (camera->projectionType() == CameraComponent::ProjectionType::Orthographic) {
-        auto ortho = camera->getOrtho();
+    auto set_model = [&](const glm::mat4& model) {
+        if (shader_program_value->usesObjectBlock()) {
+            alignas(16) std::array<std::byte, OBJECT_UNIFORMS_MAX_SIZE> object_data;
+            const auto& object_data_template = uniform_binding.objectData();
+            std::memcpy(object_data.data(), object_data_template.data(), object_data_template.size());
+            if (uniform_binding.modelOffset() >= 0) {
+                std::memcpy(object_data.data() + uniform_binding.modelOffset(), &model, sizeof(glm::mat4));
+            }
 
-        if ((absoluteNodePositionX + texture_size.first < 0 || absoluteNodePositionX - texture_size.first > (ortho.right)) ||
-            (absoluteNodePositionY + texture_size.second < 0 || absoluteNodePositionY - texture_size.second > (ortho.top))) {
-            Logger::info("skip render node: {}", node->name());
+            commands.pushObjectData(object_data.data(), object_data_template.size());
             return;
         }
-    }
 
-    auto render_scope_component = SceneRequesterHelper::getComponent<RenderScopeComponent>(scene, node->components());
-    if (!render_scope_component.has_value()) {
-        return;
-    }
+        commands.setMatrix(*shader_program_value, builtin_locations.model, model);
+    };
 
-    auto transform_mtx = model_mtx;
-    if (render_scope_component.value()->isSprite()) {
-        transform_mtx = transformTune(model_mtx, texture.value()->width(), texture.value()->height());
+    // programs without the FrameData block still get camera matrices the old way
+    if (!shader_program_value->usesFrameBlock()) {
+        commands.setMatrix(*shader_program_value, builtin_locations.view, camera->getView());
+        commands.setMatrix(*shader_program_value, builtin_locations.projection, camera->getProjection());
     }
 
-    shader_program_value->use();
-    shader_program_value->setUniform4mat("model", transform_mtx);
-    shader_program_value->setUniform4mat("view", camera->getView());
-    shader_program_value->setUniform4mat("projection", camera->getProjection());
+    commands.uploadUniforms(uniform_binding, render_scope->uniformBlock());
 
-    for (const auto& uniform : shader_program_value->uniforms()) {
-        const auto uniform_value_opt = render_scope_component.value()->renderData(uniform.name);
-        if (!uniform_value_opt.has_value()) {
-            continue;
-        }
-        const auto& uniform_value = uniform_value_opt.value();
-        if (uniform.type == Uniform::Type::Float && uniform_value.type() == typeid(float)) {
-            shader_program_value->setUniform1f(uniform.name, std::any_cast<float>(uniform_value));
-        } else if (uniform.type == Uniform::Type::Double && uniform_value.type() == typeid(double)) {
-            shader_program_value->setUniform1d(uniform.name, std::any_cast<double>(uniform_value));
-        } else if (uniform.type == Uniform::Type::Int && uniform_value.type() == typeid(int)) {
-            shader_program_value->setUniform1i(uniform.name, std::any_cast<int>(uniform_value));
-        } else if (uniform.type == Uniform::Type::UInt && uniform_value.type() == typeid(uint32_t)) {
-            shader_program_value->setUniform1ui(uniform.name, std::any_cast<uint32_t>(uniform_value));
-        } else if (uniform.type == Uniform::Type::Bool && uniform_value.type() == typeid(bool)) {
-            shader_program_value->setUniform1b(uniform.name, std::any_cast<bool>(uniform_value));
-        } else if (uniform.type == Uniform::Type::Vec2 && uniform_value.type() == typeid(glm::vec2)) {
-            shader_program_value->setUniform2vec(uniform.name, std::any_cast<glm::vec2>(uniform_value));
-        } else if (uniform.type == Uniform::Type::Vec3 && uniform_value.type() == typeid(glm::vec3)) {
-            shader_program_value->setUniform3vec(uniform.name, std::any_cast<glm::vec3>(uniform_value));
-        } else if (uniform.type == Uniform::Type::Vec4 && uniform_value.type() == typeid(glm::vec4)) {
-            shader_program_value->setUniform4vec(uniform.name, std::any_cast<glm::vec4>(uniform_value));
-        } else if (uniform.type == Uniform::Type::Mat2 && uniform_value.type() == typeid(glm::mat2)) {
-            shader_program_value->setUniform2mat(uniform.name, std::any_cast<glm::mat2>(uniform_value));
-        } else if (uniform.type == Uniform::Type::Mat3 && uniform_value.type() == typeid(glm::mat3)) {
-                shader_program_value->setUniform3mat(uniform.name, std::any_cast<glm::mat3>(uniform_value));
-        } else if (uniform.type == Uniform::Type::Mat4 && uniform_value.type() == typeid(glm::mat4)) {
-            shader_program_value->setUniform4mat(uniform.name, std::any_cast<glm::mat4>(uniform_value));
-        }
-    }
-
-    glActiveTexture(GL_TEXTURE0);
-    texture.value()->bind();
-    shader_program_value->setUniform1i("texture1", 0);
+    commands.bindTexture(*texture.value());
 
-    mesh.value()->bind();
-
-    auto mesh_data = context->meshStore->get(mesh.value()->meshId());
-    if (!mesh_data.has_value()) {
+    if (shader_program_value->wantsInstancedModel()) {
+        // the model comes from the instance attribute, the object block is shared by the group
+        if (shader_program_value->usesObjectBlock()) {
+            set_model(items.front()->model);
+        }
+        commands.multiDraw(items);
         return;
     }
 
-    glDrawElements(GL_TRIANGLES, mesh_data.value()->indices.size(),  GL_UNSIGNED_INT, nullptr);
+    for (const auto* item : items) {
+        set_model(item->model);
+        commands.draw(*item->mesh);
+    }
 }
 
 }
@@ -9,10 +9,11 @@ public:
     explicit BaseRenderPass() = default;
     ~BaseRenderPass() override = default;
 
-    void render(const std::shared_ptr<Context>& context,
+    void record(const std::shared_ptr<Context>& context,
                 const std::shared_ptr<Scene>& scene,
-                const std::shared_ptr<Node>& node,
-                const std::shared_ptr<CameraComponent>& camera) const override;
+                std::span<const DrawItem* const> items,
+                const std::shared_ptr<CameraComponent>& camera,
+                CommandList& commands) const override;
 };
 
 }
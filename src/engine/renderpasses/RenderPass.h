@@ -1,6 +1,9 @@
 #pragma once
 
+#include <glm/glm.hpp>
+
 #include <memory>
+#include <span>
 
 namespace engine {
 
@@ -8,16 +11,29 @@ class Node;
 struct Context;
 class Scene;
 class CameraComponent;
+struct MeshData;
+class CommandList;
+
+// node prepared by the Renderer: world transform resolved and already frustum tested
+struct DrawItem {
+    std::shared_ptr<Node> node;
+    std::shared_ptr<MeshData> mesh;
+    glm::mat4 model{1.0f};
+};
 
 class RenderPass {
 public:
     explicit RenderPass() = default;
     virtual ~RenderPass() = default;
 
-    virtual void render(const std::shared_ptr<Context>& context,
+    // records the GL work for items sharing program, material, render data and
+    // geometry arena; runs on the renderer's recording threads for disjoint items,
+    // so it must not call GL, the renderer resolves uniform bindings beforehand
+    virtual void record(const std::shared_ptr<Context>& context,
                         const std::shared_ptr<Scene>& scene,
-                        const std::shared_ptr<Node>& node,
-                        const std::shared_ptr<CameraComponent>& camera) const = 0;
+                        std::span<const DrawItem* const> items,
+                        const std::shared_ptr<CameraComponent>& camera,
+                        CommandList& commands) const = 0;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "TestCheck.h"
+
+#include "RenderCommands.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+
+// each item records its index as object data, the replayed lists must give back 0, 1, 2, ...
+auto replay(const std::vector<CommandList>& lists) -> std::vector<uint32_t>
+{
+    std::vector<uint32_t> order;
+    for (const auto& commands : lists) {
+        for (const auto& command : commands.commands()) {
+            uint32_t index = 0;
+            std::memcpy(&index, commands.data(command), sizeof(index));
+            order.push_back(index);
+        }
+    }
+    return order;
+}
+
+void testOrderAndChunks(uint32_t worker_count)
+{
+    CommandRecorder recorder(worker_count);
+    std::vector<CommandList> lists;
+    std::atomic<uint32_t> chunks = 0;
+
+    const CommandRecorder::Job job = [&chunks](CommandList& commands, size_t begin, size_t end) {
+        ++chunks;
+        for (size_t i = begin; i < end; ++i) {
+            const auto index = static_cast<uint32_t>(i);
+            commands.pushObjectData(&index, sizeof(index));
+        }
+    };
+
+    // the same recorder and lists are reused, like from frame to frame
+    for (size_t count = 0; count <= 1000; count += (count < 200 ? 1 : 37)) {
+        chunks = 0;
+        recorder.record(count, job, lists);
+
+        const auto order = replay(lists);
+        CHECK(order.size() == count);
+        for (size_t i = 0; i < order.size(); ++i) {
+            CHECK(order[i] == i);
+        }
+
+        // chunks of at least 64 items, one per thread at most
+        const size_t expected_lists = std::min<size_t>(std::max<size_t>(1, count / 64), worker_count + 1);
+        CHECK(lists.size() == expected_lists);
+        CHECK(chunks == (count == 0 ? 0 : expected_lists));
+
+        if (engine::test::failures != 0) {
+            return;
+        }
+    }
+}
+
+}
+
+int main()
+{
+    for (uint32_t worker_count : { 1u, 2u, 3u }) {
+        testOrderAndChunks(worker_count);
+    }
+
+    return engine::test::result();
+}
@@ -0,0 +1,216 @@
+#include "TestCheck.h"
+
+#include "LodSelection.h"
+#include "MeshBuilder.h"
+#include "MeshCooker.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <utility>
+
+using namespace engine;
+
+namespace {
+
+// a closed sphere without seams, 20 * 4^subdivisions triangles
+auto makeIcosphere(uint32_t subdivisions) -> MeshSource
+{
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> positions = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 },
+    };
+    std::vector<GLuint> indices = {
+        0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+        1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+        3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+        4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+    };
+
+    for (uint32_t subdivision = 0; subdivision < subdivisions; ++subdivision) {
+        std::map<std::pair<GLuint, GLuint>, GLuint> midpoints;
+        auto midpoint = [&positions, &midpoints](GLuint a, GLuint b) {
+            const auto key = std::minmax(a, b);
+            auto [it, inserted] = midpoints.emplace(key, static_cast<GLuint>(positions.size()));
+            if (inserted) {
+                positions.push_back(glm::normalize(positions[a] + positions[b]));
+            }
+            return it->second;
+        };
+
+        std::vector<GLuint> subdivided;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            const GLuint a = indices[i];
+            const GLuint b = indices[i + 1];
+            const GLuint c = indices[i + 2];
+            const GLuint ab = midpoint(a, b);
+            const GLuint bc = midpoint(b, c);
+            const GLuint ca = midpoint(c, a);
+            subdivided.insert(subdivided.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+        }
+        indices = std::move(subdivided);
+    }
+
+    MeshSource source;
+    source.name = "icosphere";
+    source.config.stride = 3;
+    source.config.vertices_offset = 0;
+    source.config.vertices_size = 3;
+    for (const auto& position : positions) {
+        const auto normalized = glm::normalize(position);
+        source.vertices.insert(source.vertices.end(), { normalized.x, normalized.y, normalized.z });
+    }
+    source.indices = std::move(indices);
+
+    return source;
+}
+
+// every edge is shared by exactly two triangles running it in opposite directions, no triangle is degenerate
+auto isClosedManifold(const std::vector<GLuint>& indices) -> bool
+{
+    std::map<std::pair<GLuint, GLuint>, int> edges;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const std::array<GLuint, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+        if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0]) {
+            return false;
+        }
+        for (size_t corner = 0; corner < 3; ++corner) {
+            if (++edges[{ triangle[corner], triangle[(corner + 1) % 3] }] > 1) {
+                return false;
+            }
+        }
+    }
+
+    return std::ranges::all_of(edges, [&edges](const auto& edge) {
+        return edges.contains({ edge.first.second, edge.first.first });
+    });
+}
+
+void testSimplifyIsDeterministic()
+{
+    const auto source = makeIcosphere(4);
+    const std::array<size_t, 2> targets = { source.indices.size() / 2, source.indices.size() / 4 };
+
+    const auto first = simplifyMesh(source, targets);
+    const auto second = simplifyMesh(source, targets);
+
+    CHECK(first.size() == targets.size());
+    CHECK(first.size() == second.size());
+    for (size_t level = 0; level < std::min(first.size(), second.size()); ++level) {
+        CHECK(first[level].indices == second[level].indices);
+        CHECK(first[level].error == second[level].error);
+    }
+}
+
+void testLodChain()
+{
+    const auto source = makeIcosphere(4);
+    const auto lods = buildLodChain(source);
+
+    CHECK(lods.size() == MAX_LOD_LEVELS);
+
+    size_t previous_triangles = source.indices.size() / 3;
+    float previous_error = 0.0f;
+    for (const auto& lod : lods) {
+        const size_t triangles = lod.indices.size() / 3;
+        CHECK(triangles < previous_triangles);
+        CHECK(triangles >= MIN_LOD_TRIANGLES);
+        CHECK(lod.error >= previous_error);
+        CHECK(isClosedManifold(lod.indices));
+        CHECK(std::ranges::all_of(lod.indices, [&lod](GLuint index) { return index < lod.vertices.size() / 3; }));
+        previous_triangles = triangles;
+        previous_error = lod.error;
+    }
+
+    // too small to have levels
+    CHECK(buildLodChain(makeIcosphere(1)).empty());
+}
+
+void testCookRoundTrip()
+{
+    const auto directory = std::filesystem::temp_directory_path() / "engine_mesh_lod_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    auto source = makeIcosphere(4);
+    source.lods = buildLodChain(source);
+    const auto path = cookedMeshPath(directory);
+
+    // levels of an earlier cook that reached further
+    for (uint32_t level = 1; level <= MAX_LOD_LEVELS + 2; ++level) {
+        std::ofstream(cookedLodPath(directory, level)) << "stale";
+    }
+
+    CHECK(saveCookedMesh(source, path));
+    CHECK(std::filesystem::exists(cookedLodPath(directory, MAX_LOD_LEVELS)));
+    CHECK(!std::filesystem::exists(cookedLodPath(directory, MAX_LOD_LEVELS + 1)));
+    CHECK(!std::filesystem::exists(cookedLodPath(directory, MAX_LOD_LEVELS + 2)));
+
+    MeshSource loaded;
+    loaded.config = source.config;
+    CHECK(loadCookedMesh(path, loaded));
+    CHECK(loaded.vertices == source.vertices);
+    CHECK(loaded.indices == source.indices);
+    CHECK(loaded.lods.size() == source.lods.size());
+    for (size_t level = 0; level < std::min(loaded.lods.size(), source.lods.size()); ++level) {
+        CHECK(loaded.lods[level].vertices == source.lods[level].vertices);
+        CHECK(loaded.lods[level].indices == source.lods[level].indices);
+        CHECK(loaded.lods[level].error == source.lods[level].error);
+    }
+
+    // a cook with fewer levels removes the ones it did not reach
+    source.lods.resize(1);
+    CHECK(saveCookedMesh(source, path));
+    CHECK(!std::filesystem::exists(cookedLodPath(directory, 2)));
+    CHECK(loadCookedMesh(path, loaded));
+    CHECK(loaded.lods.size() == 1);
+
+    std::filesystem::remove_all(directory);
+}
+
+void testSelectLod()
+{
+    const std::array<float, 4> errors = { 0.0f, 0.1f, 0.2f, 0.4f };
+    const LodSettings settings{ 1.0f, 0.25f };
+
+    // on screen the levels stray 0, 0.4, 0.8 and 1.6 pixels: level 2 fits, level 1 fits with the margin
+    constexpr float pixels_per_unit = 4.0f;
+    CHECK(selectLod(errors, pixels_per_unit, NO_LOD, settings) == 2);
+    CHECK(selectLod(errors, pixels_per_unit, 0, settings) == 1);
+    CHECK(selectLod(errors, pixels_per_unit, 1, settings) == 1);
+    CHECK(selectLod(errors, pixels_per_unit, 2, settings) == 2);
+    // moving finer needs no margin
+    CHECK(selectLod(errors, pixels_per_unit, 3, settings) == 2);
+
+    // further away every level fits, with and without the margin
+    CHECK(selectLod(errors, 1.0f, 0, settings) == 3);
+    CHECK(selectLod(errors, 1.0f, NO_LOD, settings) == 3);
+
+    // close up only the full mesh fits, whatever was drawn before
+    CHECK(selectLod(errors, 100.0f, 3, settings) == 0);
+    CHECK(selectLod(errors, 100.0f, NO_LOD, settings) == 0);
+
+    // without hysteresis the margin is gone
+    CHECK(selectLod(errors, pixels_per_unit, 0, LodSettings{ 1.0f, 0.0f }) == 2);
+    // a pixel error of 0 always draws the full mesh
+    CHECK(selectLod(errors, 1.0f, NO_LOD, LodSettings{ 0.0f, 0.25f }) == 0);
+    CHECK(selectLod({}, 1.0f, NO_LOD, settings) == 0);
+}
+
+}
+
+int main()
+{
+    testSimplifyIsDeterministic();
+    testLodChain();
+    testCookRoundTrip();
+    testSelectLod();
+
+    return engine::test::result();
+}
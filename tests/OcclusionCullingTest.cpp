@@ -0,0 +1,121 @@
+#include "TestCheck.h"
+
+#include "OcclusionCulling.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+
+auto viewProjection() -> glm::mat4
+{
+    const auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    const auto view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return projection * view;
+}
+
+// a 2x2 quad facing the camera at z = 0, and a tilted one at the side
+void addOccluders(OcclusionCuller& culler)
+{
+    const std::vector<glm::vec3> quad = { { -1, -1, 0 }, { 1, -1, 0 }, { 1, 1, 0 }, { -1, 1, 0 } };
+    const std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+    culler.addOccluder(glm::mat4(1.0f), quad, indices);
+
+    auto tilted = glm::translate(glm::mat4(1.0f), glm::vec3(-3.0f, 0.5f, -1.0f));
+    tilted = glm::rotate(tilted, glm::radians(40.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    culler.addOccluder(tilted, quad, indices);
+}
+
+auto rasterize(uint32_t worker_count, OcclusionCuller::Path path) -> std::vector<float>
+{
+    OcclusionCuller culler(worker_count, path);
+    culler.beginFrame(viewProjection());
+    addOccluders(culler);
+    culler.rasterize();
+    return culler.depth();
+}
+
+void testBandsAgree(OcclusionCuller::Path path)
+{
+    // every band split rasterizes the same buffer, bit for bit
+    const auto single = rasterize(0, path);
+    for (uint32_t workers : { 1u, 2u, 3u }) {
+        CHECK(rasterize(workers, path) == single);
+    }
+}
+
+void testPathsAgree()
+{
+    // the compiler may contract the scalar multiply-adds, so allow for rounding
+    const auto simd = rasterize(1, OcclusionCuller::Path::Simd);
+    const auto scalar = rasterize(1, OcclusionCuller::Path::Scalar);
+    CHECK(simd.size() == scalar.size());
+
+    uint32_t different = 0;
+    for (size_t i = 0; i < simd.size() && i < scalar.size(); ++i) {
+        different += std::fabs(simd[i] - scalar[i]) > 1e-6f ? 1 : 0;
+    }
+    CHECK(different == 0);
+}
+
+void testDepth(OcclusionCuller::Path path)
+{
+    OcclusionCuller culler(1, path);
+    culler.beginFrame(viewProjection());
+    addOccluders(culler);
+    culler.rasterize();
+    CHECK(culler.triangleCount() == 4);
+
+    // the facing quad has one depth, the one the GPU would write for its plane
+    const glm::vec4 clip = viewProjection() * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const float expected = clip.z / clip.w * 0.5f + 0.5f;
+    const auto& depth = culler.depth();
+    const auto at = [&depth](uint32_t x, uint32_t y) { return depth[y * OcclusionCuller::WIDTH + x]; };
+
+    CHECK(std::fabs(at(OcclusionCuller::WIDTH / 2, OcclusionCuller::HEIGHT / 2) - expected) < 1e-4f);
+    CHECK(std::fabs(at(OcclusionCuller::WIDTH / 2 + 10, OcclusionCuller::HEIGHT / 2 - 10) - expected) < 1e-4f);
+    CHECK(at(0, 0) == 1.0f);
+    CHECK(at(OcclusionCuller::WIDTH - 1, OcclusionCuller::HEIGHT - 1) == 1.0f);
+}
+
+void testVisibility(OcclusionCuller::Path path)
+{
+    OcclusionCuller culler(1, path);
+    culler.beginFrame(viewProjection());
+    addOccluders(culler);
+    culler.rasterize();
+
+    // behind the facing quad
+    CHECK(!culler.isVisible({ { -0.2f, -0.2f, -3.0f }, { 0.2f, 0.2f, -2.0f } }));
+    // in front of it
+    CHECK(culler.isVisible({ { -0.2f, -0.2f, 1.0f }, { 0.2f, 0.2f, 2.0f } }));
+    // beside it
+    CHECK(culler.isVisible({ { 2.0f, -0.2f, -3.0f }, { 2.5f, 0.2f, -2.0f } }));
+    // partly uncovered
+    CHECK(culler.isVisible({ { 0.5f, -0.2f, -1.0f }, { 1.5f, 0.2f, -0.5f } }));
+    // reaching the near plane
+    CHECK(culler.isVisible({ { -0.2f, -0.2f, 4.0f }, { 0.2f, 0.2f, 6.0f } }));
+
+    // nothing rasterized hides nothing
+    culler.beginFrame(viewProjection());
+    culler.rasterize();
+    CHECK(culler.isVisible({ { -0.2f, -0.2f, -3.0f }, { 0.2f, 0.2f, -2.0f } }));
+}
+
+}
+
+int main()
+{
+    for (auto path : { OcclusionCuller::Path::Simd, OcclusionCuller::Path::Scalar }) {
+        testBandsAgree(path);
+        testDepth(path);
+        testVisibility(path);
+    }
+    testPathsAgree();
+
+    return engine::test::result();
+}
@@ -0,0 +1,265 @@
+#include "TestCheck.h"
+
+#include "CameraComponent.h"
+#include "Context.h"
+#include "Engine.h"
+#include "GLStateCache.h"
+#include "InputManager.h"
+#include "MaterialComponent.h"
+#include "MeshComponent.h"
+#include "MeshStore.h"
+#include "MouseEventFilterComponent.h"
+#include "Node.h"
+#include "PickingService.h"
+#include "RenderPassStore.h"
+#include "Renderer.h"
+#include "ResourcePackageStore.h"
+#include "ResourceReloader.h"
+#include "Scene.h"
+#include "SceneStore.h"
+#include "ShaderStore.h"
+#include "Texture.h"
+#include "TextureStore.h"
+#include "TextureStreamer.h"
+#include "TransformComponent.h"
+#include "UserComponentsBuilder.h"
+#include "Window.h"
+
+#include <vector>
+
+using namespace engine;
+
+namespace {
+
+// textures are only created for their size, ids are all these need without a context
+GLuint next_texture = 1;
+
+void APIENTRY fakeGenTextures(GLsizei count, GLuint* textures)
+{
+    for (GLsizei i = 0; i < count; ++i) {
+        textures[i] = next_texture++;
+    }
+}
+
+void APIENTRY fakeDeleteTextures(GLsizei, const GLuint*) {}
+void APIENTRY fakeBindTexture(GLenum, GLuint) {}
+void APIENTRY fakeTexParameteri(GLenum, GLenum, GLint) {}
+
+void installFakeGL()
+{
+    glad_glGenTextures = fakeGenTextures;
+    glad_glDeleteTextures = fakeDeleteTextures;
+    glad_glBindTexture = fakeBindTexture;
+    glad_glTexParameteri = fakeTexParameteri;
+}
+
+constexpr uint32_t SCENE_ID = 1;
+constexpr uint32_t QUAD_MESH = 1;
+constexpr int KEY = 0;
+constexpr int ACTION = 1;
+
+constexpr uint32_t BUTTON_TEXTURE = 1;
+constexpr uint32_t WIDE_BUTTON_TEXTURE = 2;
+constexpr uint32_t BACKGROUND_TEXTURE = 3;
+
+// nodes stacked on (100, 100): a mesh quad on top, a rotated button without a mesh
+// under it and a background without a mesh at the bottom
+constexpr uint32_t PANEL = 10;
+constexpr uint32_t BUTTON = 11;
+constexpr uint32_t BACKGROUND = 12;
+
+struct Fixture {
+    std::shared_ptr<Context> context = std::make_shared<Context>();
+    std::shared_ptr<Scene> scene;
+    std::shared_ptr<MaterialComponent> button_material;
+    std::vector<uint32_t> clicked;
+    uint32_t next_component = 100;
+
+    Fixture()
+    {
+        context->meshStore = std::make_unique<MeshStore>();
+        context->textureStore = std::make_unique<TextureStore>();
+        context->sceneStore = std::make_unique<SceneStore>();
+        context->picking = std::make_unique<PickingService>(context);
+
+        auto quad = std::make_shared<MeshData>();
+        quad->aabb_min = glm::vec3(-0.5f, -0.5f, 0.0f);
+        quad->aabb_max = glm::vec3(0.5f, 0.5f, 0.0f);
+        context->meshStore->add(QUAD_MESH, quad);
+
+        const Texture::AlphaFlags alpha{};
+        context->textureStore->add(BUTTON_TEXTURE, std::make_unique<Texture>("button", 40, 10, 1, alpha));
+        context->textureStore->add(WIDE_BUTTON_TEXTURE, std::make_unique<Texture>("wide_button", 80, 10, 1, alpha));
+        context->textureStore->add(BACKGROUND_TEXTURE, std::make_unique<Texture>("background", 80, 80, 1, alpha));
+
+        scene = std::make_shared<Scene>(context, SCENE_ID, "picking");
+        scene->setActive(true);
+        context->sceneStore->add(SCENE_ID, scene);
+
+        scene->addNode(1, std::make_shared<Node>(1, "root", 0, SCENE_ID));
+        scene->setRoot(1);
+
+        // clicks are relative to the camera position
+        auto camera = addNode(2, glm::vec3(0.0f));
+        addComponent(camera, std::make_shared<CameraComponent>(next_component++, "camera", 2, SCENE_ID));
+
+        auto panel = addNode(PANEL, glm::vec3(100.0f, 100.0f, 2.0f));
+        panel->setScale(glm::vec3(20.0f, 20.0f, 1.0f));
+        auto mesh = std::make_shared<MeshComponent>(next_component++, "mesh", PANEL, SCENE_ID);
+        mesh->setMesh(QUAD_MESH);
+        addComponent(panel, mesh);
+        addFilter(panel);
+
+        // 40x10, turned upright
+        auto button = addNode(BUTTON, glm::vec3(100.0f, 100.0f, 1.0f));
+        button->setRotation(glm::vec3(0.0f, 0.0f, 90.0f));
+        button_material = addMaterial(button, BUTTON_TEXTURE);
+        addFilter(button);
+
+        auto background = addNode(BACKGROUND, glm::vec3(100.0f, 100.0f, 0.0f));
+        addMaterial(background, BACKGROUND_TEXTURE);
+        addFilter(background);
+
+        scene->updateSpatialIndex();
+    }
+
+    auto addNode(uint32_t node_id, const glm::vec3& position, uint32_t parent_id = 1) -> std::shared_ptr<TransformComponent>
+    {
+        scene->addNode(node_id, std::make_shared<Node>(node_id, "node", parent_id, SCENE_ID));
+        auto transform = std::make_shared<TransformComponent>(next_component++, "transform", node_id, SCENE_ID);
+        transform->setPosition(position);
+        addComponent(transform, transform);
+        return transform;
+    }
+
+    void addComponent(const std::shared_ptr<Component>& owner, const std::shared_ptr<Component>& component)
+    {
+        component->setContext(context);
+        scene->getNode(owner->ownerNode()).value()->addComponent(component->id());
+        scene->addComponent(component->id(), component);
+    }
+
+    auto addMaterial(const std::shared_ptr<Component>& owner, uint32_t texture_id) -> std::shared_ptr<MaterialComponent>
+    {
+        auto material = std::make_shared<MaterialComponent>(next_component++, "material", owner->ownerNode(), SCENE_ID);
+        addComponent(owner, material);
+        material->setTexture(texture_id);
+        return material;
+    }
+
+    void addFilter(const std::shared_ptr<Component>& owner)
+    {
+        const uint32_t node_id = owner->ownerNode();
+        auto filter = std::make_shared<MouseEventFilterComponent>(next_component++, "filter", node_id, SCENE_ID);
+        addComponent(owner, filter);
+        filter->setAction(ACTION);
+        filter->setKey(KEY);
+        filter->setMouseClickCallback([this, node_id](int, int) {
+            clicked.push_back(node_id);
+        });
+    }
+
+    auto click(int x, int y) -> std::vector<uint32_t>
+    {
+        clicked.clear();
+        context->picking->pick(KEY, ACTION, x, y);
+        return clicked;
+    }
+};
+
+void testIndexesTextureRects()
+{
+    Fixture fixture;
+
+    // the camera has no mesh and no filter, the two texture rects are indexed
+    CHECK(fixture.scene->spatialIndexSize() == 3);
+    CHECK(fixture.scene->spatialMeshCount() == 1);
+
+    const auto button = fixture.scene->indexedNode(BUTTON);
+    CHECK(button.has_value());
+    CHECK(button.has_value() && button->mesh_id == 0);
+    CHECK(button.has_value() && button->local_bounds.min == glm::vec3(-20.0f, -5.0f, 0.0f));
+    CHECK(button.has_value() && button->local_bounds.max == glm::vec3(20.0f, 5.0f, 0.0f));
+}
+
+void testDispatchesTopmostFirst()
+{
+    Fixture fixture;
+
+    CHECK(fixture.click(100, 100) == std::vector<uint32_t>({ PANEL, BUTTON, BACKGROUND }));
+    CHECK(fixture.click(300, 300).empty());
+}
+
+void testPicksRotatedRects()
+{
+    Fixture fixture;
+
+    // the button is 10 wide and 40 tall once turned, the panel 20 by 20
+    CHECK(fixture.click(115, 100) == std::vector<uint32_t>({ BACKGROUND }));
+    CHECK(fixture.click(100, 115) == std::vector<uint32_t>({ BUTTON, BACKGROUND }));
+    CHECK(fixture.click(104, 119) == std::vector<uint32_t>({ BUTTON, BACKGROUND }));
+    CHECK(fixture.click(106, 119) == std::vector<uint32_t>({ BACKGROUND }));
+}
+
+void testFollowsTextureChanges()
+{
+    Fixture fixture;
+
+    CHECK(fixture.click(100, 130) == std::vector<uint32_t>({ BACKGROUND }));
+
+    // a refit, not a structural change, picks up the size of the new texture
+    fixture.button_material->setTexture(WIDE_BUTTON_TEXTURE);
+    fixture.scene->updateSpatialIndex();
+
+    CHECK(fixture.click(100, 130) == std::vector<uint32_t>({ BUTTON, BACKGROUND }));
+}
+
+void testSkipsInactiveNodes()
+{
+    Fixture fixture;
+
+    fixture.scene->getNode(PANEL).value()->setActive(false);
+    CHECK(fixture.click(100, 100) == std::vector<uint32_t>({ BUTTON, BACKGROUND }));
+}
+
+void testFollowsParentTransforms()
+{
+    Fixture fixture;
+
+    constexpr uint32_t GROUP = 13;
+    constexpr uint32_t ICON = 14;
+    auto group = fixture.addNode(GROUP, glm::vec3(300.0f, 300.0f, 0.0f));
+    auto icon = fixture.addNode(ICON, glm::vec3(0.0f, 0.0f, 3.0f), GROUP);
+    fixture.addMaterial(icon, BUTTON_TEXTURE);
+    fixture.addFilter(icon);
+    fixture.scene->updateSpatialIndex();
+
+    CHECK(fixture.click(300, 300) == std::vector<uint32_t>({ ICON }));
+
+    // an inactive parent transform no longer places its children
+    group->setActive(false);
+    fixture.scene->updateSpatialIndex();
+    CHECK(fixture.click(300, 300).empty());
+    CHECK(fixture.click(0, 0) == std::vector<uint32_t>({ ICON }));
+
+    group->setActive(true);
+    fixture.scene->updateSpatialIndex();
+    CHECK(fixture.click(300, 300) == std::vector<uint32_t>({ ICON }));
+    CHECK(fixture.click(0, 0).empty());
+}
+
+}
+
+int main()
+{
+    installFakeGL();
+
+    testIndexesTextureRects();
+    testDispatchesTopmostFirst();
+    testPicksRotatedRects();
+    testFollowsTextureChanges();
+    testSkipsInactiveNodes();
+    testFollowsParentTransforms();
+
+    return engine::test::result();
+}
@@ -0,0 +1,114 @@
+#include "TestCheck.h"
+
+#include "RangeAllocator.h"
+
+#include <random>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+
+void testFirstFit()
+{
+    RangeAllocator allocator(100);
+
+    CHECK(allocator.allocate(30) == 0u);
+    CHECK(allocator.allocate(30) == 30u);
+    CHECK(allocator.allocate(30) == 60u);
+    CHECK(!allocator.allocate(20).has_value());
+    CHECK(allocator.used() == 90);
+
+    // the freed middle range is the first one large enough
+    allocator.release(30, 30);
+    CHECK(allocator.allocate(20) == 30u);
+    CHECK(allocator.allocate(10) == 50u);
+    CHECK(allocator.allocate(10) == 90u);
+    CHECK(allocator.used() == 100);
+    CHECK(!allocator.allocate(1).has_value());
+}
+
+void testCoalesce()
+{
+    RangeAllocator allocator(90);
+    const auto a = allocator.allocate(30);
+    const auto b = allocator.allocate(30);
+    const auto c = allocator.allocate(30);
+    CHECK(a.has_value() && b.has_value() && c.has_value());
+
+    // merges with the next range, then with the previous one
+    allocator.release(c.value(), 30);
+    allocator.release(a.value(), 30);
+    CHECK(!allocator.allocate(60).has_value());
+    allocator.release(b.value(), 30);
+
+    CHECK(allocator.used() == 0);
+    CHECK(allocator.allocate(90) == 0u);
+}
+
+// random allocations and releases against a slot by slot model of the same policy
+void testAgainstModel()
+{
+    constexpr uint32_t capacity = 512;
+    RangeAllocator allocator(capacity);
+    std::vector<bool> taken(capacity, false);
+
+    struct Range {
+        uint32_t offset;
+        uint32_t size;
+    };
+    std::vector<Range> live;
+
+    std::mt19937 random(7);
+    for (int step = 0; step < 20000; ++step) {
+        if (live.empty() || random() % 3 != 0) {
+            const uint32_t size = 1 + random() % 32;
+
+            std::optional<uint32_t> expected;
+            uint32_t run = 0;
+            for (uint32_t slot = 0; slot < capacity && !expected.has_value(); ++slot) {
+                run = taken[slot] ? 0 : run + 1;
+                if (run == size) {
+                    expected = slot + 1 - size;
+                }
+            }
+
+            const auto offset = allocator.allocate(size);
+            CHECK(offset == expected);
+            if (offset.has_value()) {
+                for (uint32_t slot = offset.value(); slot < offset.value() + size; ++slot) {
+                    taken[slot] = true;
+                }
+                live.push_back({ offset.value(), size });
+            }
+        } else {
+            const size_t index = random() % live.size();
+            const auto range = live[index];
+            live.erase(live.begin() + static_cast<std::ptrdiff_t>(index));
+            allocator.release(range.offset, range.size);
+            for (uint32_t slot = range.offset; slot < range.offset + range.size; ++slot) {
+                taken[slot] = false;
+            }
+        }
+
+        uint32_t used = 0;
+        for (const auto& range : live) {
+            used += range.size;
+        }
+        CHECK(allocator.used() == used);
+        if (engine::test::failures != 0) {
+            return;
+        }
+    }
+}
+
+}
+
+int main()
+{
+    testFirstFit();
+    testCoalesce();
+    testAgainstModel();
+
+    return engine::test::result();
+}
@@ -0,0 +1,271 @@
+#include "TestCheck.h"
+
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+
+// the graph only creates, binds and deletes objects and reads timer queries, ids are all these need without a context
+GLuint next_object = 1;
+GLuint bound_framebuffer = 0;
+uint32_t framebuffers_created = 0;
+uint32_t framebuffers_deleted = 0;
+
+constexpr GLuint64 GPU_NANOSECONDS = 2'000'000;
+
+void APIENTRY fakeGen(GLsizei count, GLuint* objects)
+{
+    for (GLsizei i = 0; i < count; ++i) {
+        objects[i] = next_object++;
+    }
+}
+
+void APIENTRY fakeGenFramebuffers(GLsizei count, GLuint* framebuffers)
+{
+    framebuffers_created += static_cast<uint32_t>(count);
+    fakeGen(count, framebuffers);
+}
+
+void APIENTRY fakeDeleteFramebuffers(GLsizei count, const GLuint*)
+{
+    framebuffers_deleted += static_cast<uint32_t>(count);
+}
+
+void APIENTRY fakeBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    if (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER) {
+        bound_framebuffer = framebuffer;
+    }
+}
+
+void APIENTRY fakeDelete(GLsizei, const GLuint*) {}
+void APIENTRY fakeBind(GLenum, GLuint) {}
+void APIENTRY fakeTexParameteri(GLenum, GLenum, GLint) {}
+void APIENTRY fakeTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void*) {}
+void APIENTRY fakeFramebufferTexture2D(GLenum, GLenum, GLenum, GLuint, GLint) {}
+void APIENTRY fakeRenderbufferStorage(GLenum, GLenum, GLsizei, GLsizei) {}
+void APIENTRY fakeFramebufferRenderbuffer(GLenum, GLenum, GLenum, GLuint) {}
+void APIENTRY fakeViewport(GLint, GLint, GLsizei, GLsizei) {}
+void APIENTRY fakeEndQuery(GLenum) {}
+
+GLenum APIENTRY fakeCheckFramebufferStatus(GLenum)
+{
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void APIENTRY fakeGetQueryObjectiv(GLuint, GLenum, GLint* value)
+{
+    *value = 1;
+}
+
+void APIENTRY fakeGetQueryObjectui64v(GLuint, GLenum, GLuint64* value)
+{
+    *value = GPU_NANOSECONDS;
+}
+
+void installFakeGL()
+{
+    glad_glGenQueries = fakeGen;
+    glad_glDeleteQueries = fakeDelete;
+    glad_glBeginQuery = fakeBind;
+    glad_glEndQuery = fakeEndQuery;
+    glad_glGetQueryObjectiv = fakeGetQueryObjectiv;
+    glad_glGetQueryObjectui64v = fakeGetQueryObjectui64v;
+    glad_glGenTextures = fakeGen;
+    glad_glDeleteTextures = fakeDelete;
+    glad_glBindTexture = fakeBind;
+    glad_glTexParameteri = fakeTexParameteri;
+    glad_glTexImage2D = fakeTexImage2D;
+    glad_glGenFramebuffers = fakeGenFramebuffers;
+    glad_glDeleteFramebuffers = fakeDeleteFramebuffers;
+    glad_glBindFramebuffer = fakeBindFramebuffer;
+    glad_glFramebufferTexture2D = fakeFramebufferTexture2D;
+    glad_glCheckFramebufferStatus = fakeCheckFramebufferStatus;
+    glad_glGenRenderbuffers = fakeGen;
+    glad_glDeleteRenderbuffers = fakeDelete;
+    glad_glBindRenderbuffer = fakeBind;
+    glad_glRenderbufferStorage = fakeRenderbufferStorage;
+    glad_glFramebufferRenderbuffer = fakeFramebufferRenderbuffer;
+    glad_glViewport = fakeViewport;
+}
+
+struct Executed {
+    std::string pass;
+    GLuint bound = 0;
+};
+
+// shadow -> blur -> lit -> present, plus a debug view and its overlay nobody reads and a kept readback
+struct Graph {
+    RenderGraph graph;
+    std::vector<Executed> executed;
+
+    RenderGraph::ResourceId shadow = 0;
+    RenderGraph::ResourceId blurred = 0;
+    RenderGraph::ResourceId lit = 0;
+    RenderGraph::ResourceId debug = 0;
+    RenderGraph::ResourceId overlay = 0;
+    RenderGraph::ResourceId readback = 0;
+
+    GLuint shadow_framebuffer = 0;
+    GLuint lit_framebuffer = 0;
+    GLuint blurred_framebuffer = 0;
+
+    Graph()
+    {
+        const RenderGraph::TargetDesc square{ 256, 256, GL_RGBA8, true };
+        const RenderGraph::TargetDesc screen{};
+
+        const auto backbuffer = graph.importBackbuffer("backbuffer");
+
+        add("shadow", [this, square](RenderGraph::PassBuilder& builder) {
+            shadow = builder.createTarget("shadow", square);
+        });
+        add("blur", [this, screen](RenderGraph::PassBuilder& builder) {
+            builder.read(shadow);
+            blurred = builder.createTarget("blurred", screen);
+        });
+        // the same description as the shadow target, whose last reader ran before
+        add("lit", [this, square](RenderGraph::PassBuilder& builder) {
+            builder.read(blurred);
+            lit = builder.createTarget("lit", square);
+        });
+        add("debug", [this, screen](RenderGraph::PassBuilder& builder) {
+            builder.read(shadow);
+            debug = builder.createTarget("debug", screen);
+        });
+        add("overlay", [this, screen](RenderGraph::PassBuilder& builder) {
+            builder.read(debug);
+            overlay = builder.createTarget("overlay", screen);
+        });
+        add("readback", [this, square](RenderGraph::PassBuilder& builder) {
+            builder.read(lit);
+            readback = builder.createTarget("readback", square);
+            builder.setSideEffect();
+        });
+        add("present", [this, backbuffer](RenderGraph::PassBuilder& builder) {
+            builder.read(lit);
+            builder.write(backbuffer);
+        });
+    }
+
+    void add(const std::string& name, const RenderGraph::Setup& setup)
+    {
+        graph.addPass(name, setup, [this, name](const RenderGraph::Resources& resources) {
+            executed.push_back({ name, bound_framebuffer });
+            shadow_framebuffer = resources.framebuffer(shadow);
+            blurred_framebuffer = resources.framebuffer(blurred);
+            lit_framebuffer = resources.framebuffer(lit);
+        });
+    }
+
+    auto names() const -> std::vector<std::string>
+    {
+        std::vector<std::string> result;
+        for (const auto& pass : executed) {
+            result.push_back(pass.pass);
+        }
+        return result;
+    }
+};
+
+void testCullsUnreadPasses()
+{
+    Graph graph;
+    graph.graph.compile(800, 600);
+
+    const auto& stats = graph.graph.stats();
+    CHECK(stats.passes == 7);
+    // the overlay nobody reads, then the debug view only it read
+    CHECK(stats.culled_passes == 2);
+
+    graph.graph.execute();
+    CHECK(graph.names() == std::vector<std::string>({ "shadow", "blur", "lit", "readback", "present" }));
+
+    const auto& timings = graph.graph.timings();
+    CHECK(timings.size() == 5);
+    CHECK(std::ranges::none_of(timings, [](const auto& timing) {
+        return timing.name == "debug" || timing.name == "overlay";
+    }));
+}
+
+void testAliasesTransientTargets()
+{
+    framebuffers_created = 0;
+
+    Graph graph;
+    graph.graph.compile(800, 600);
+
+    const auto& stats = graph.graph.stats();
+    // shadow, blurred, lit and readback, the culled passes allocate nothing
+    CHECK(stats.transient_targets == 4);
+    // lit takes over the shadow framebuffer, readback overlaps lit
+    CHECK(stats.physical_targets == 3);
+    CHECK(framebuffers_created == 3);
+
+    graph.graph.execute();
+    CHECK(graph.shadow_framebuffer != 0);
+    CHECK(graph.lit_framebuffer == graph.shadow_framebuffer);
+    CHECK(graph.blurred_framebuffer != graph.shadow_framebuffer);
+
+    // every pass renders into the first target it writes, present into the window
+    CHECK(graph.executed.size() == 5);
+    CHECK(graph.executed[0].bound == graph.shadow_framebuffer);
+    CHECK(graph.executed[1].bound == graph.blurred_framebuffer);
+    CHECK(graph.executed[2].bound == graph.lit_framebuffer);
+    CHECK(graph.executed[3].bound != 0 && graph.executed[3].bound != graph.lit_framebuffer);
+    CHECK(graph.executed.back().bound == 0);
+    CHECK(bound_framebuffer == 0);
+}
+
+void testRecompilesOnResize()
+{
+    framebuffers_created = 0;
+    framebuffers_deleted = 0;
+
+    Graph graph;
+    graph.graph.compile(800, 600);
+    graph.graph.compile(800, 600);
+    CHECK(framebuffers_created == 3);
+    CHECK(framebuffers_deleted == 0);
+
+    graph.graph.compile(1024, 768);
+    CHECK(framebuffers_created == 6);
+    CHECK(framebuffers_deleted == 3);
+    CHECK(graph.graph.stats().culled_passes == 2);
+}
+
+void testMeasuresPasses()
+{
+    Graph graph;
+    graph.graph.compile(800, 600);
+
+    // the first frame has nothing finished yet, the second reads it back
+    graph.graph.execute();
+    CHECK(std::ranges::none_of(graph.graph.timings(), [](const auto& timing) {
+        return timing.gpu_ms.has_value();
+    }));
+
+    graph.graph.execute();
+    CHECK(std::ranges::all_of(graph.graph.timings(), [](const auto& timing) {
+        return timing.gpu_ms == static_cast<double>(GPU_NANOSECONDS) / 1'000'000.0 && timing.cpu_ms >= 0.0;
+    }));
+}
+
+}
+
+int main()
+{
+    installFakeGL();
+
+    testCullsUnreadPasses();
+    testAliasesTransientTargets();
+    testRecompilesOnResize();
+    testMeasuresPasses();
+
+    return engine::test::result();
+}
@@ -0,0 +1,111 @@
+#include "TestCheck.h"
+
+#include "RenderThread.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+using namespace engine;
+
+namespace {
+
+enum class Owner {
+    None,
+    Caller,
+    RenderThread
+};
+
+// stands in for the window and the renderer, checks the hand-off from both sides
+struct FakeGL {
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<Owner> owner = Owner::Caller;
+
+    std::mutex mutex;
+    // acquired and not presented yet, in submission order
+    std::deque<const Renderer::Frame*> in_flight;
+    uint32_t presented = 0;
+
+    auto callbacks() -> RenderThread::Callbacks
+    {
+        return {
+            [this] {
+                CHECK(owner == Owner::None);
+                owner = std::this_thread::get_id() == caller ? Owner::Caller : Owner::RenderThread;
+            },
+            [this] {
+                owner = Owner::None;
+            },
+            [this](Renderer::Frame& frame) {
+                CHECK(owner == Owner::RenderThread);
+                CHECK(std::this_thread::get_id() != caller);
+
+                std::lock_guard lock(mutex);
+                // frames are presented in the order they were submitted
+                CHECK(!in_flight.empty() && in_flight.front() == &frame);
+                if (!in_flight.empty()) {
+                    in_flight.pop_front();
+                }
+                ++presented;
+            },
+        };
+    }
+};
+
+void testHandOff(uint32_t latency)
+{
+    FakeGL gl;
+    constexpr uint32_t frame_count = 2000;
+
+    {
+        RenderThread render_thread(latency, gl.callbacks());
+        CHECK(gl.owner != Owner::Caller);
+
+        for (uint32_t i = 0; i < frame_count; ++i) {
+            auto& frame = render_thread.acquireFrame();
+            {
+                std::lock_guard lock(gl.mutex);
+                // a frame is reused only once it was presented, and no more than latency wait
+                for (const auto* queued : gl.in_flight) {
+                    CHECK(queued != &frame);
+                }
+                CHECK(gl.in_flight.size() <= latency);
+                gl.in_flight.push_back(&frame);
+            }
+            render_thread.submitFrame();
+
+            if (i % 100 == 0) {
+                uint32_t presented = 0;
+                render_thread.invoke([&gl, &presented] {
+                    CHECK(gl.owner == Owner::RenderThread);
+                    std::lock_guard lock(gl.mutex);
+                    presented = gl.presented;
+                });
+                // jobs run after the frames submitted before them
+                CHECK(presented == i + 1);
+            }
+
+            if (engine::test::failures != 0) {
+                return;
+            }
+        }
+    }
+
+    // every queued frame is presented before the context comes back
+    CHECK(gl.presented == frame_count);
+    CHECK(gl.in_flight.empty());
+    CHECK(gl.owner == Owner::Caller);
+}
+
+}
+
+int main()
+{
+    for (uint32_t latency : { 1u, 2u, 3u }) {
+        testHandOff(latency);
+    }
+
+    return engine::test::result();
+}
@@ -0,0 +1,156 @@
+#include "TestCheck.h"
+
+#include "FileWatcher.h"
+#include "ResourcePackage.h"
+#include "ResourceReloader.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+using namespace engine;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// editors save either in place or through a temporary file renamed over the original
+void writeInPlace(const fs::path& path, const std::string& text)
+{
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+void writeThroughRename(const fs::path& path, const std::string& text)
+{
+    const auto temporary = path.parent_path() / (path.filename().string() + ".tmp");
+    std::ofstream(temporary, std::ios::binary) << text;
+    fs::rename(temporary, path);
+}
+
+// polls the reloader like the frame loop does until its workers finished something
+auto waitForWork(ResourceReloader& reloader, const std::function<bool(ResourceReloader::Kind, uint32_t)>& is_loaded,
+    std::chrono::milliseconds timeout) -> bool
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        reloader.update(is_loaded);
+        if (reloader.hasWork()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+struct Fixture {
+    fs::path directory = fs::temp_directory_path() / "engine_resource_reloader_test";
+    fs::path shader = directory / "flat_color";
+    fs::path texture = directory / "awesomeface.png";
+    std::shared_ptr<ResourcePackage> package = std::make_shared<ResourcePackage>();
+
+    Fixture()
+    {
+        fs::remove_all(directory);
+        fs::create_directories(directory);
+        fs::copy("shaders/flat_color", shader);
+        fs::copy("textures/awesomeface.png", texture);
+
+        package->name = "test";
+        package->shaders.push_back({ 1, shader });
+        package->textures.push_back({ 2, texture });
+    }
+
+    ~Fixture()
+    {
+        fs::remove_all(directory);
+    }
+};
+
+#ifdef __linux__
+void testWatcherReportsChanges()
+{
+    Fixture fixture;
+    const auto other = fixture.directory / "other.png";
+    writeInPlace(other, "a");
+
+    FileWatcher watcher;
+    watcher.watch(fixture.texture);
+    watcher.watch(fixture.shader);
+    CHECK(watcher.poll().empty());
+
+    // a file next to a watched one
+    writeInPlace(other, "b");
+    CHECK(watcher.poll().empty());
+
+    // two writes before a poll are reported once
+    writeInPlace(fixture.texture, "b");
+    writeInPlace(fixture.texture, "c");
+    auto changed = watcher.poll();
+    CHECK(changed.size() == 1 && changed.front() == fixture.texture);
+    CHECK(watcher.poll().empty());
+
+    writeThroughRename(fixture.texture, "d");
+    changed = watcher.poll();
+    CHECK(changed.size() == 1 && changed.front() == fixture.texture);
+
+    // any file of a watched directory reports the directory
+    writeThroughRename(fixture.shader / "frag.glsl", "void main() {}");
+    changed = watcher.poll();
+    CHECK(changed.size() == 1 && changed.front() == fixture.shader);
+}
+#endif
+
+void testReloaderQueuesLoadedResources()
+{
+    Fixture fixture;
+    ResourceReloader reloader(1);
+    reloader.watchPackage(fixture.package);
+
+    // only the shader is in its store
+    auto is_loaded = [](ResourceReloader::Kind kind, uint32_t id) {
+        return kind == ResourceReloader::Kind::Shader && id == 1;
+    };
+
+    reloader.update(is_loaded);
+    CHECK(!reloader.hasWork());
+
+    fs::copy_file("textures/container.jpg", fixture.texture, fs::copy_options::overwrite_existing);
+    CHECK(!waitForWork(reloader, is_loaded, std::chrono::milliseconds(200)));
+
+    writeThroughRename(fixture.shader / "frag.glsl", "#version 410 core\nout vec4 FragColor;\nvoid main() { FragColor = vec4(1.0); }\n");
+    CHECK(waitForWork(reloader, is_loaded, std::chrono::seconds(5)));
+}
+
+void testReloaderKeepsFailedLoads()
+{
+    Fixture fixture;
+    ResourceReloader reloader(1);
+    reloader.watchPackage(fixture.package);
+
+    auto is_loaded = [](ResourceReloader::Kind, uint32_t) {
+        return true;
+    };
+
+    // a half written image fails to decode and nothing is swapped in
+    writeInPlace(fixture.texture, "not an image");
+    CHECK(!waitForWork(reloader, is_loaded, std::chrono::milliseconds(200)));
+
+    // the finished write is picked up
+    fs::copy_file("textures/container.jpg", fixture.texture, fs::copy_options::overwrite_existing);
+    CHECK(waitForWork(reloader, is_loaded, std::chrono::seconds(5)));
+}
+
+}
+
+int main()
+{
+#ifdef __linux__
+    testWatcherReportsChanges();
+#endif
+    testReloaderQueuesLoadedResources();
+    testReloaderKeepsFailedLoads();
+
+    return engine::test::result();
+}
@@ -0,0 +1,209 @@
+#include "TestCheck.h"
+
+#include "Context.h"
+#include "Engine.h"
+#include "FrustumCulling.h"
+#include "GLStateCache.h"
+#include "InputManager.h"
+#include "MeshComponent.h"
+#include "MeshStore.h"
+#include "Node.h"
+#include "PickingService.h"
+#include "RenderPassStore.h"
+#include "Renderer.h"
+#include "ResourcePackageStore.h"
+#include "ResourceReloader.h"
+#include "Scene.h"
+#include "SceneStore.h"
+#include "ShaderStore.h"
+#include "TextureStore.h"
+#include "TextureStreamer.h"
+#include "TransformComponent.h"
+#include "UserComponentsBuilder.h"
+#include "Window.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using namespace engine;
+
+// Measures Scene::updateSpatialIndex() and the frustum query over 100k indexed nodes
+// with a growing share of them moving every frame, and checks the index against the
+// transforms and a brute force frustum test. Prints the median of a few frames; built
+// with ENABLE_BENCHMARKS, run by "ctest -L benchmark -V" or the executable alone.
+// An update costs from about a microsecond per scattered moving node down to a few
+// hundred nanoseconds when most of them move and the tree is rebuilt instead, so a
+// millisecond is reached around a thousand; the refit itself is bound by reading the
+// transforms. A query costs about 50 ns per returned node.
+namespace {
+
+constexpr uint32_t NODE_COUNT = 100000;
+constexpr uint32_t FRAMES = 15;
+constexpr uint32_t MESH_ID = 1;
+constexpr uint32_t FIRST_NODE = 2;
+constexpr uint32_t FIRST_COMPONENT = 1000000;
+
+using Clock = std::chrono::steady_clock;
+
+struct Bench {
+    std::shared_ptr<Context> context = std::make_shared<Context>();
+    std::shared_ptr<Scene> scene;
+    std::vector<std::shared_ptr<TransformComponent>> transforms;
+    std::mt19937 random{ 7 };
+
+    Bench()
+    {
+        context->meshStore = std::make_unique<MeshStore>();
+        auto quad = std::make_shared<MeshData>();
+        quad->aabb_min = glm::vec3(-0.5f, -0.5f, 0.0f);
+        quad->aabb_max = glm::vec3(0.5f, 0.5f, 0.0f);
+        context->meshStore->add(MESH_ID, quad);
+
+        scene = std::make_shared<Scene>(context, 1, "benchmark");
+        scene->addNode(1, std::make_shared<Node>(1, "root", 0, scene->id()));
+        scene->setRoot(1);
+
+        // a 50 x 50 x 40 grid, 4 units apart
+        for (uint32_t i = 0; i < NODE_COUNT; ++i) {
+            const uint32_t node_id = FIRST_NODE + i;
+            const uint32_t transform_id = FIRST_COMPONENT + i * 2;
+            const uint32_t mesh_id = transform_id + 1;
+
+            auto node = std::make_shared<Node>(node_id, "node", 1, scene->id());
+            node->addComponent(transform_id);
+            node->addComponent(mesh_id);
+
+            auto transform = std::make_shared<TransformComponent>(transform_id, "transform", node_id, scene->id());
+            transform->setPosition(glm::vec3(i % 50, (i / 50) % 50, i / 2500) * 4.0f);
+            auto mesh = std::make_shared<MeshComponent>(mesh_id, "mesh", node_id, scene->id());
+            mesh->setMesh(MESH_ID);
+
+            scene->addNode(node_id, node);
+            scene->addComponent(transform_id, transform);
+            scene->addComponent(mesh_id, mesh);
+            transforms.push_back(transform);
+        }
+    }
+
+    // small moves stay within the fat box, large ones reinsert the leaf
+    void move(uint32_t count, float distance)
+    {
+        std::uniform_int_distribution<uint32_t> pick(0, NODE_COUNT - 1);
+        std::uniform_real_distribution<float> offset(-distance, distance);
+        for (uint32_t i = 0; i < count; ++i) {
+            auto& transform = transforms[count == NODE_COUNT ? i : pick(random)];
+            transform->setPosition(transform->getPosition() + glm::vec3(offset(random), offset(random), offset(random)));
+        }
+    }
+};
+
+auto median(std::vector<double> samples) -> double
+{
+    std::ranges::sort(samples);
+    return samples[samples.size() / 2];
+}
+
+auto milliseconds(Clock::duration duration) -> double
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+auto insideFrustum(const Frustum& frustum, const Aabb& box) -> bool
+{
+    for (const auto& plane : frustum.planes()) {
+        const glm::vec3 normal(plane);
+        const glm::vec3 positive = glm::mix(box.min, box.max, glm::vec3(glm::greaterThanEqual(normal, glm::vec3(0.0f))));
+        if (glm::dot(normal, positive) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// every placement follows its transform, nothing moved was missed by the refit
+void checkPlacements(Bench& bench)
+{
+    uint32_t stale = 0;
+    for (uint32_t i = 0; i < NODE_COUNT; ++i) {
+        const auto indexed = bench.scene->indexedNode(FIRST_NODE + i);
+        if (!indexed.has_value() || indexed->model != bench.transforms[i]->getModel()) {
+            ++stale;
+        }
+    }
+    CHECK(stale == 0);
+}
+
+void benchmarkUpdate(Bench& bench, uint32_t moving, float distance)
+{
+    std::vector<double> samples;
+    for (uint32_t frame = 0; frame < FRAMES; ++frame) {
+        bench.move(moving, distance);
+
+        const auto start = Clock::now();
+        bench.scene->updateSpatialIndex();
+        samples.push_back(milliseconds(Clock::now() - start));
+    }
+
+    checkPlacements(bench);
+    std::printf("SpatialIndexBenchmark: %u nodes, %6u moving %s: update %.3f ms\n", NODE_COUNT, moving,
+                distance < 1.0f ? "a little" : "far     ", median(samples));
+}
+
+void benchmarkQuery(Bench& bench)
+{
+    const auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+    const auto view = glm::lookAt(glm::vec3(100.0f, 100.0f, -30.0f), glm::vec3(100.0f, 100.0f, 80.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum(projection * view);
+
+    std::vector<uint32_t> candidates;
+    std::vector<double> samples;
+    for (uint32_t frame = 0; frame < FRAMES; ++frame) {
+        candidates.clear();
+        const auto start = Clock::now();
+        bench.scene->queryNodes(frustum, candidates);
+        samples.push_back(milliseconds(Clock::now() - start));
+    }
+
+    // the index answers with fat boxes, so it may return a few more than the brute force test
+    const std::unordered_set<uint32_t> found(candidates.begin(), candidates.end());
+    uint32_t inside = 0;
+    uint32_t missed = 0;
+    for (uint32_t i = 0; i < NODE_COUNT; ++i) {
+        const auto indexed = bench.scene->indexedNode(FIRST_NODE + i);
+        if (indexed.has_value() && insideFrustum(frustum, transformAabb(indexed->model, indexed->local_bounds))) {
+            ++inside;
+            missed += found.contains(FIRST_NODE + i) ? 0 : 1;
+        }
+    }
+    CHECK(inside > 0);
+    CHECK(missed == 0);
+
+    std::printf("SpatialIndexBenchmark: %u nodes, frustum query of %zu candidates: %.3f ms\n", NODE_COUNT, candidates.size(), median(samples));
+}
+
+}
+
+int main()
+{
+    Bench bench;
+
+    const auto start = Clock::now();
+    bench.scene->updateSpatialIndex();
+    std::printf("SpatialIndexBenchmark: %u nodes, build %.3f ms\n", NODE_COUNT, milliseconds(Clock::now() - start));
+    CHECK(bench.scene->spatialIndexSize() == NODE_COUNT);
+    checkPlacements(bench);
+
+    benchmarkUpdate(bench, 0, 0.1f);
+    benchmarkUpdate(bench, 1000, 0.1f);
+    benchmarkUpdate(bench, 10000, 0.1f);
+    benchmarkUpdate(bench, 1000, 20.0f);
+    benchmarkUpdate(bench, NODE_COUNT, 0.1f);
+    benchmarkQuery(bench);
+
+    return engine::test::result();
+}
@@ -0,0 +1,126 @@
+#include "TestCheck.h"
+
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+
+// unit boxes on the x axis, box i centered on (i * 2, 0, 0)
+constexpr uint32_t COUNT = 100;
+
+auto boxAt(float x) -> Aabb
+{
+    return { glm::vec3(x - 0.5f, -0.5f, -0.5f), glm::vec3(x + 0.5f, 0.5f, 0.5f) };
+}
+
+auto query(const SpatialIndex& index, const Aabb& box) -> std::vector<uint32_t>
+{
+    std::vector<uint32_t> found;
+    index.queryAabb(box, found);
+    std::ranges::sort(found);
+    return found;
+}
+
+auto fill(SpatialIndex& index) -> std::vector<int32_t>
+{
+    std::vector<int32_t> proxies;
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        proxies.push_back(index.insert(boxAt(static_cast<float>(i) * 2.0f), i));
+    }
+    index.commit();
+    return proxies;
+}
+
+void testBuild()
+{
+    SpatialIndex index;
+    fill(index);
+
+    CHECK(index.size() == COUNT);
+    CHECK(query(index, boxAt(10.0f)) == std::vector<uint32_t>({ 5 }));
+    CHECK(query(index, { glm::vec3(3.0f, -1.0f, -1.0f), glm::vec3(9.0f, 1.0f, 1.0f) }) == std::vector<uint32_t>({ 2, 3, 4 }));
+    CHECK(query(index, boxAt(-10.0f)).empty());
+}
+
+void testReinsertsFewMoves()
+{
+    SpatialIndex index;
+    const auto proxies = fill(index);
+
+    // too few to rebuild, left their fat box
+    CHECK(index.move(proxies[3], boxAt(500.0f)));
+    CHECK(index.move(proxies[4], boxAt(-500.0f)));
+    CHECK(!index.move(proxies[5], boxAt(10.05f)));
+    index.commit();
+
+    CHECK(query(index, boxAt(500.0f)) == std::vector<uint32_t>({ 3 }));
+    CHECK(query(index, boxAt(-500.0f)) == std::vector<uint32_t>({ 4 }));
+    CHECK(query(index, { glm::vec3(5.0f, -1.0f, -1.0f), glm::vec3(11.0f, 1.0f, 1.0f) }) == std::vector<uint32_t>({ 5 }));
+    CHECK(index.bounds(proxies[5]).min.x == boxAt(10.05f).min.x);
+}
+
+void testRebuildsManyMoves()
+{
+    SpatialIndex index;
+    const auto proxies = fill(index);
+
+    // every box swaps to the mirrored position, along y
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        const float x = static_cast<float>(COUNT - 1 - i) * 2.0f;
+        index.move(proxies[i], { glm::vec3(x - 0.5f, 9.5f, -0.5f), glm::vec3(x + 0.5f, 10.5f, 0.5f) });
+    }
+    index.commit();
+
+    CHECK(index.size() == COUNT);
+    CHECK(query(index, boxAt(10.0f)).empty());
+    CHECK(query(index, { glm::vec3(9.5f, 9.5f, -0.5f), glm::vec3(10.5f, 10.5f, 0.5f) }) == std::vector<uint32_t>({ COUNT - 1 - 5 }));
+
+    std::vector<uint32_t> near;
+    index.queryRadius(glm::vec3(0.0f, 10.0f, 0.0f), 2.5f, near);
+    std::ranges::sort(near);
+    CHECK(near == std::vector<uint32_t>({ COUNT - 2, COUNT - 1 }));
+
+    const auto hit = index.raycast(glm::vec3(-10.0f, 10.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f);
+    CHECK(hit.has_value() && hit->user_data == COUNT - 1);
+    CHECK(hit.has_value() && hit->distance == 9.5f);
+}
+
+void testRemovesPendingProxies()
+{
+    SpatialIndex index;
+    const auto proxies = fill(index);
+
+    // removed while waiting for the commit, and one never committed
+    index.move(proxies[7], boxAt(300.0f));
+    index.remove(proxies[7]);
+    const int32_t added = index.insert(boxAt(400.0f), 1000);
+    index.remove(added);
+    index.commit();
+
+    CHECK(index.size() == COUNT - 1);
+    CHECK(query(index, boxAt(300.0f)).empty());
+    CHECK(query(index, boxAt(400.0f)).empty());
+    CHECK(query(index, boxAt(14.0f)).empty());
+
+    // freed proxies are handed out again
+    const int32_t reused = index.insert(boxAt(14.0f), 2000);
+    CHECK(reused == added || reused == proxies[7]);
+    index.commit();
+    CHECK(query(index, boxAt(14.0f)) == std::vector<uint32_t>({ 2000 }));
+}
+
+}
+
+int main()
+{
+    testBuild();
+    testReinsertsFewMoves();
+    testRebuildsManyMoves();
+    testRemovesPendingProxies();
+
+    return engine::test::result();
+}
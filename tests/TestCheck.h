@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the engine tests. Every test is a plain executable run by
+// ctest, it reports each failed check and exits non-zero when there was one.
+namespace engine::test {
+
+inline int failures = 0;
+
+inline auto result() -> int
+{
+    if (failures != 0) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
+
+}
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);     \
+            ++engine::test::failures;                                                     \
+        }                                                                                 \
+    } while (false)
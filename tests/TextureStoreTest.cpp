@@ -0,0 +1,146 @@
+#include "TestCheck.h"
+
+#include "RenderCommands.h"
+#include "Texture.h"
+#include "TextureCooker.h"
+#include "TextureStore.h"
+
+#include <atomic>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+
+// the store only creates, fills and deletes textures, ids are all these need without a context
+std::atomic<GLuint> next_texture = 1;
+
+void APIENTRY fakeGenTextures(GLsizei count, GLuint* textures)
+{
+    for (GLsizei i = 0; i < count; ++i) {
+        textures[i] = next_texture++;
+    }
+}
+
+void APIENTRY fakeDeleteTextures(GLsizei, const GLuint*) {}
+void APIENTRY fakeBindTexture(GLenum, GLuint) {}
+void APIENTRY fakeTexParameteri(GLenum, GLenum, GLint) {}
+void APIENTRY fakePixelStorei(GLenum, GLint) {}
+void APIENTRY fakeTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void*) {}
+
+void installFakeGL()
+{
+    glad_glGenTextures = fakeGenTextures;
+    glad_glDeleteTextures = fakeDeleteTextures;
+    glad_glBindTexture = fakeBindTexture;
+    glad_glTexParameteri = fakeTexParameteri;
+    glad_glPixelStorei = fakePixelStorei;
+    glad_glTexImage2D = fakeTexImage2D;
+}
+
+constexpr GLsizei TEXTURE_SIZE = 64;
+constexpr size_t TEXTURE_BYTES = TEXTURE_SIZE * TEXTURE_SIZE * 4;
+
+void addTexture(TextureStore& store, uint32_t id)
+{
+    const std::vector<unsigned char> texels(TEXTURE_BYTES, 255);
+    auto texture = std::make_unique<Texture>("texture" + std::to_string(id), TEXTURE_SIZE, TEXTURE_SIZE, 1, Texture::AlphaFlags{});
+    texture->uploadLevel(0, CookedFormat::RGBA8, TEXTURE_SIZE, TEXTURE_SIZE, texels.data(), static_cast<GLsizei>(texels.size()));
+    store.add(id, std::move(texture));
+    store.setSourcePath(id, "texture" + std::to_string(id) + ".png");
+}
+
+void testEvictsLeastRecentlyUsed()
+{
+    TextureStore store;
+    for (uint32_t id = 1; id <= 3; ++id) {
+        addTexture(store, id);
+    }
+    store.setBudget(TEXTURE_BYTES * 5 / 2);
+
+    // texture 3 was queued in the first frame only
+    for (uint32_t frame = 0; frame < 3; ++frame) {
+        store.beginFrame();
+        store.markUsed(1);
+        store.markUsed(2);
+        if (frame == 0) {
+            store.markUsed(3);
+        }
+    }
+
+    CHECK(store.overBudget());
+    store.evict();
+
+    const auto stats = store.stats();
+    CHECK(stats.evicted == 1);
+    CHECK(stats.evictions == 1);
+    CHECK(stats.resident_bytes <= stats.budget_bytes);
+    CHECK(store.get(3).value()->gpuBytes() < TEXTURE_BYTES);
+    CHECK(store.get(1).value()->gpuBytes() == TEXTURE_BYTES);
+    CHECK(store.takeMisses().empty());
+}
+
+// every draw of a frame uses the same evicted texture and is recorded on several threads
+void testRecordingSharedTexture()
+{
+    TextureStore store;
+    addTexture(store, 1);
+    addTexture(store, 2);
+    store.setBudget(TEXTURE_BYTES * 3 / 2);
+
+    store.beginFrame();
+    store.markUsed(1);
+    store.beginFrame();
+    store.beginFrame();
+    store.evict();
+    CHECK(store.stats().evicted == 1);
+
+    constexpr size_t draw_count = 1000;
+    CommandRecorder recorder(3);
+    std::vector<CommandList> lists;
+    std::atomic<size_t> chunks = 0;
+
+    for (uint32_t frame = 0; frame < 2; ++frame) {
+        store.beginFrame();
+
+        // queueing the draws marks the texture, once per draw
+        for (size_t draw = 0; draw < draw_count; ++draw) {
+            store.markUsed(2);
+        }
+
+        chunks = 0;
+        recorder.record(draw_count, [&store, &chunks](CommandList& commands, size_t begin, size_t end) {
+            ++chunks;
+            for (size_t i = begin; i < end; ++i) {
+                auto texture = store.get(2);
+                const size_t bytes = texture.has_value() ? texture.value()->gpuBytes() : 0;
+                commands.pushObjectData(&bytes, sizeof(bytes));
+            }
+        }, lists);
+        CHECK(chunks > 1);
+
+        size_t recorded = 0;
+        for (const auto& commands : lists) {
+            recorded += commands.commands().size();
+        }
+        CHECK(recorded == draw_count);
+
+        // the miss is counted and queued once however many draws and chunks used the texture
+        const auto misses = store.takeMisses();
+        CHECK(store.stats().misses == 1);
+        CHECK(misses.size() == (frame == 0 ? 1 : 0));
+        CHECK(frame != 0 || misses.front() == 2);
+    }
+}
+
+}
+
+int main()
+{
+    installFakeGL();
+
+    testEvictsLeastRecentlyUsed();
+    testRecordingSharedTexture();
+
+    return engine::test::result();
+}
@@ -0,0 +1,119 @@
+#include "TestCheck.h"
+
+#include "Context.h"
+#include "Engine.h"
+#include "GLStateCache.h"
+#include "InputManager.h"
+#include "MeshStore.h"
+#include "PickingService.h"
+#include "RenderPassStore.h"
+#include "Renderer.h"
+#include "ResourcePackageStore.h"
+#include "ResourceReloader.h"
+#include "SceneStore.h"
+#include "ShaderStore.h"
+#include "Texture.h"
+#include "TextureStore.h"
+#include "TextureStreamer.h"
+#include "UserComponentsBuilder.h"
+#include "Window.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace engine;
+
+namespace {
+
+// placeholders only need ids, deletes are counted by the thread doing them
+std::atomic<GLuint> next_texture = 1;
+std::atomic<uint32_t> deleted_on_gl_thread = 0;
+std::atomic<uint32_t> deleted_elsewhere = 0;
+std::thread::id gl_thread;
+
+void APIENTRY fakeGenTextures(GLsizei count, GLuint* textures)
+{
+    for (GLsizei i = 0; i < count; ++i) {
+        textures[i] = next_texture++;
+    }
+}
+
+void APIENTRY fakeDeleteTextures(GLsizei count, const GLuint*)
+{
+    auto& deleted = std::this_thread::get_id() == gl_thread ? deleted_on_gl_thread : deleted_elsewhere;
+    deleted += static_cast<uint32_t>(count);
+}
+
+void APIENTRY fakeBindTexture(GLenum, GLuint) {}
+void APIENTRY fakeTexParameteri(GLenum, GLenum, GLint) {}
+void APIENTRY fakePixelStorei(GLenum, GLint) {}
+void APIENTRY fakeTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void*) {}
+void APIENTRY fakeGenerateMipmap(GLenum) {}
+
+void APIENTRY fakeGetIntegerv(GLenum, GLint* data)
+{
+    *data = 0;
+}
+
+void installFakeGL()
+{
+    gl_thread = std::this_thread::get_id();
+    glad_glGenTextures = fakeGenTextures;
+    glad_glDeleteTextures = fakeDeleteTextures;
+    glad_glBindTexture = fakeBindTexture;
+    glad_glTexParameteri = fakeTexParameteri;
+    glad_glPixelStorei = fakePixelStorei;
+    glad_glTexImage2D = fakeTexImage2D;
+    glad_glGenerateMipmap = fakeGenerateMipmap;
+    glad_glGetIntegerv = fakeGetIntegerv;
+}
+
+constexpr uint32_t TEXTURE_ID = 1;
+
+auto waitForWork(const TextureStreamer& streamer) -> bool
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!streamer.hasWork()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void testReleasesFailedPlaceholdersOnTheGLThread()
+{
+    auto context = std::make_shared<Context>();
+    context->textureStore = std::make_unique<TextureStore>();
+    TextureStreamer streamer(TextureStreamer::DEFAULT_UPLOAD_BUDGET, 1);
+
+    // tests run from the source directory, the file is there but is no image
+    streamer.request(context, TEXTURE_ID, "CMakeLists.txt");
+    CHECK(context->textureStore->get(TEXTURE_ID).has_value());
+
+    // a scene transition removes the texture before the worker gives up on the file,
+    // the streamer holds the last reference to the placeholder
+    context->textureStore->remove(TEXTURE_ID);
+    CHECK(deleted_on_gl_thread == 0);
+
+    CHECK(waitForWork(streamer));
+    CHECK(deleted_elsewhere == 0);
+
+    CHECK(!streamer.upload(context));
+    CHECK(deleted_on_gl_thread == 1);
+    CHECK(deleted_elsewhere == 0);
+    CHECK(!streamer.hasWork());
+}
+
+}
+
+int main()
+{
+    installFakeGL();
+
+    testReleasesFailedPlaceholdersOnTheGLThread();
+
+    return engine::test::result();
+}